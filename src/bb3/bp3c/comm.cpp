@@ -18,6 +18,12 @@
 
 #include <memory.h>
 
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#endif
+
 #if defined(EEZ_PLATFORM_STM32)
 #include <main.h>
 #include <crc.h>
@@ -43,6 +49,74 @@ namespace eez {
 namespace bp3c {
 namespace comm {
 
+static TransferStatistics g_transferStatistics[NUM_SLOTS];
+
+static uint32_t g_paramsGeneration[NUM_SLOTS];
+static uint32_t g_paramsTransferredGeneration[NUM_SLOTS];
+
+#if defined(EEZ_PLATFORM_STM32)
+static osEventFlagsId_t g_paramsTransferredEventFlags;
+#elif !defined(__EMSCRIPTEN__)
+static std::mutex g_paramsTransferredMutex;
+static std::condition_variable g_paramsTransferredCondition;
+#endif
+
+static void countTransfer(int slotIndex) {
+    auto &stats = g_transferStatistics[slotIndex];
+
+    stats.numTransfers++;
+
+    uint32_t time = millis();
+    uint32_t diff = time - stats.windowStartTime;
+    if (diff >= 1000) {
+        stats.transfersPerSecond = diff < 2000 ? stats.numWindowTransfers * 1000 / diff : 0;
+        stats.windowStartTime = time;
+        stats.numWindowTransfers = 0;
+    }
+    stats.numWindowTransfers++;
+}
+
+const TransferStatistics &getTransferStatistics(int slotIndex) {
+    return g_transferStatistics[slotIndex];
+}
+
+uint32_t getTransfersPerSecond(int slotIndex) {
+    auto &stats = g_transferStatistics[slotIndex];
+    if (millis() - stats.windowStartTime >= 2000) {
+        // no transfers in the last window
+        return 0;
+    }
+    return stats.transfersPerSecond;
+}
+
+void reportRetry(int slotIndex) {
+    g_transferStatistics[slotIndex].numRetries++;
+}
+
+void reportTransferError(int slotIndex, int status) {
+    if (status == TRANSFER_STATUS_CRC_ERROR) {
+        g_transferStatistics[slotIndex].numCrcErrors++;
+    } else {
+        g_transferStatistics[slotIndex].numTransferErrors++;
+    }
+}
+
+void setFusedProtocol(int slotIndex, bool fusedProtocol) {
+    g_transferStatistics[slotIndex].fusedProtocol = fusedProtocol;
+}
+
+void reportCommandDone(int slotIndex, bool isSuccess) {
+    auto &stats = g_transferStatistics[slotIndex];
+    stats.numCommands++;
+    if (!isSuccess) {
+        stats.numFailedCommands++;
+    }
+}
+
+void reportFusedCommand(int slotIndex) {
+    g_transferStatistics[slotIndex].numFusedCommands++;
+}
+
 bool masterSynchro(int slotIndex) {
     auto &slot = *g_slots[slotIndex];
 
@@ -100,6 +174,8 @@ bool masterSynchro(int slotIndex) {
 }
 
 TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize) {
+    countTransfer(slotIndex);
+
 #if defined(EEZ_PLATFORM_STM32)
     spi::handle[slotIndex]->ErrorCode = 0;
 
@@ -107,20 +183,27 @@ TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t
     auto result = spi::transfer(slotIndex, output, input, bufferSize);
     spi::deselect(slotIndex);
 
+    TransferResult transferResult;
     if (g_slots[slotIndex]->spiCrcCalculationEnable) {
         if (spi::handle[slotIndex]->ErrorCode == HAL_SPI_ERROR_CRC) {
-            return TRANSFER_STATUS_CRC_ERROR;
+            transferResult = TRANSFER_STATUS_CRC_ERROR;
         } else {
-            return (TransferResult)result;
+            transferResult = (TransferResult)result;
         }
     } else {
         if (result == HAL_OK) {
             uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)input, bufferSize - 4);
-            return crc == *((uint32_t *)(input + bufferSize - 4)) ? TRANSFER_STATUS_OK : TRANSFER_STATUS_CRC_ERROR;
+            transferResult = crc == *((uint32_t *)(input + bufferSize - 4)) ? TRANSFER_STATUS_OK : TRANSFER_STATUS_CRC_ERROR;
         } else {
-            return (TransferResult)result;
+            transferResult = (TransferResult)result;
         }
     }
+
+    if (transferResult != TRANSFER_STATUS_OK) {
+        reportTransferError(slotIndex, transferResult);
+    }
+
+    return transferResult;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
@@ -129,6 +212,8 @@ TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t
 }
 
 TransferResult transferDMA(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize) {
+    countTransfer(slotIndex);
+
 #if defined(EEZ_PLATFORM_STM32)
     spi::handle[slotIndex]->ErrorCode = 0;
 
@@ -149,6 +234,62 @@ void abortTransfer(int slotIndex) {
 #endif
 }
 
+static bool isParamsTransferred(int slotIndex, uint32_t generation) {
+    return (int32_t)(g_paramsTransferredGeneration[slotIndex] - generation) >= 0;
+}
+
+static bool waitParamsTransferred(int slotIndex, uint32_t generation, uint32_t timeout) {
+#if defined(EEZ_PLATFORM_STM32)
+    if (!g_paramsTransferredEventFlags) {
+        g_paramsTransferredEventFlags = osEventFlagsNew(nullptr);
+    }
+
+    uint32_t start = millis();
+    while (!isParamsTransferred(slotIndex, generation)) {
+        uint32_t elapsed = millis() - start;
+        if (elapsed > timeout) {
+            return false;
+        }
+        // flag stays set if it was set before we started to wait
+        osEventFlagsWait(g_paramsTransferredEventFlags, 1 << slotIndex, osFlagsWaitAny, timeout - elapsed + 1);
+    }
+    return true;
+#elif defined(__EMSCRIPTEN__)
+    // there is only one thread, params will be transferred in the next tick
+    return true;
+#else
+    std::unique_lock<std::mutex> lock(g_paramsTransferredMutex);
+    return g_paramsTransferredCondition.wait_for(lock, std::chrono::milliseconds(timeout), [=] {
+        return isParamsTransferred(slotIndex, generation);
+    });
+#endif
+}
+
+uint32_t getParamsGeneration(int slotIndex) {
+    return g_paramsGeneration[slotIndex];
+}
+
+void paramsTransferred(int slotIndex, uint32_t generation) {
+    if (isParamsTransferred(slotIndex, generation)) {
+        return;
+    }
+
+#if defined(EEZ_PLATFORM_STM32)
+    g_paramsTransferredGeneration[slotIndex] = generation;
+    if (g_paramsTransferredEventFlags) {
+        osEventFlagsSet(g_paramsTransferredEventFlags, 1 << slotIndex);
+    }
+#elif defined(__EMSCRIPTEN__)
+    g_paramsTransferredGeneration[slotIndex] = generation;
+#else
+    {
+        std::lock_guard<std::mutex> lock(g_paramsTransferredMutex);
+        g_paramsTransferredGeneration[slotIndex] = generation;
+    }
+    g_paramsTransferredCondition.notify_all();
+#endif
+}
+
 void updateParamsStart() {
     if (isLowPriorityThread()) {
 #if defined(EEZ_PLATFORM_STM32)        
@@ -157,23 +298,28 @@ void updateParamsStart() {
     }
 }
 
-bool updateParamsFinish(const void *updateParams, const void *lastTransferedParams, size_t paramsSize, uint32_t timeout, int *err) {
+bool updateParamsFinish(int slotIndex, uint32_t timeout, int *err) {
+    uint32_t generation;
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+    {
+        std::lock_guard<std::mutex> lock(g_paramsTransferredMutex);
+        generation = ++g_paramsGeneration[slotIndex];
+    }
+#else
+    generation = ++g_paramsGeneration[slotIndex];
+#endif
+
     if (isLowPriorityThread()) {
 #if defined(EEZ_PLATFORM_STM32)        
         taskEXIT_CRITICAL();
 #endif
 
-        uint32_t start = millis();
-        while (true) {
-            if (memcmp(updateParams, lastTransferedParams, paramsSize) == 0) {
-                return true;
-            }
-            if (millis() - start > timeout) {
-                if (err) {
-                    *err = SCPI_ERROR_TIME_OUT;
-                }
-                return false;
+        if (!waitParamsTransferred(slotIndex, generation, timeout)) {
+            if (err) {
+                *err = SCPI_ERROR_TIME_OUT;
             }
+            return false;
         }
     }
 
@@ -38,8 +38,41 @@ TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t
 TransferResult transferDMA(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize);
 void abortTransfer(int slotIndex);
 
+struct TransferStatistics {
+    uint32_t numTransfers;
+    uint32_t numRetries;
+    uint32_t numCrcErrors;
+    uint32_t numTransferErrors;
+    bool fusedProtocol; // request and response of the previous command in one transfer
+
+    // commands executed by the slot transport
+    uint32_t numCommands;
+    uint32_t numFailedCommands;
+    uint32_t numFusedCommands;
+
+    // transfers per second are counted in one second windows
+    uint32_t windowStartTime;
+    uint32_t numWindowTransfers;
+    uint32_t transfersPerSecond;
+};
+
+const TransferStatistics &getTransferStatistics(int slotIndex);
+uint32_t getTransfersPerSecond(int slotIndex);
+void reportRetry(int slotIndex);
+void reportTransferError(int slotIndex, int status);
+void setFusedProtocol(int slotIndex, bool fusedProtocol);
+void reportCommandDone(int slotIndex, bool isSuccess);
+void reportFusedCommand(int slotIndex);
+
+// Module params changed from the low priority thread are transferred by the PSU thread.
+// Every update gets the next params generation of the slot and updateParamsFinish
+// sleeps until the PSU thread reports that generation as transferred.
 void updateParamsStart();
-bool updateParamsFinish(const void *updateParams, const void *lastTransferedParams, size_t paramsSize, uint32_t timeout, int *err);
+bool updateParamsFinish(int slotIndex, uint32_t timeout, int *err);
+
+// Called from the PSU thread, generation should be taken before the params are read.
+uint32_t getParamsGeneration(int slotIndex);
+void paramsTransferred(int slotIndex, uint32_t generation);
 
 } // namespace comm
 } // namespace bp3c
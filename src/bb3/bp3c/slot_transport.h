@@ -0,0 +1,592 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory.h>
+#include <assert.h>
+
+#if defined(EEZ_PLATFORM_STM32)
+#include <main.h>
+#include <bb3/platform/stm32/spi.h>
+#endif
+
+#include <eez/core/os.h>
+
+#include <bb3/system.h>
+#include <bb3/psu/event_queue.h>
+#include <bb3/bp3c/comm.h>
+
+// Command/response transport used by the modules with slave MCU (MIO168, SMX46, MUX14D, PREL6).
+//
+// Every command is a request sent to the slave followed by the transfer in which
+// the response is received. Commands are queued per slot and executed in priority order.
+// Command that is already queued or in flight is not queued again, request is filled when its transfer
+// starts, so for example set params requested several times while get state is in flight
+// is transferred once with the latest params.
+//
+// If the slave supports fused protocol then the request of the next fusable command is sent
+// in the same transfer in which the response of the current fusable command is received.
+
+namespace eez {
+namespace bp3c {
+
+enum CommandPriority {
+    COMMAND_PRIORITY_LOW,    // periodic polling (get state, dlog data)
+    COMMAND_PRIORITY_NORMAL, // some thread is waiting for the result (disk operations)
+    COMMAND_PRIORITY_HIGH    // latency sensitive (set params, dlog start/stop)
+};
+
+enum CommandFlags {
+    COMMAND_FLAG_FUSABLE = 1 << 0,      // request can be sent together with the response of the previous command
+    COMMAND_FLAG_UNSYNCHRONIZED = 1 << 1 // can be executed while slave is not synchronized (get info)
+};
+
+static const uint32_t TRANSPORT_RESPONSE_FLAG = 0x8000;
+
+struct SlotTransportConfig {
+    uint32_t commandNone;             // request sent when only the response is expected
+    int numRequestRetries;
+    int maxDmaTransferErrors;
+    uint32_t timeoutMs;               // max. time spent waiting in one state before retry
+    uint32_t timeoutUntilOutOfSyncMs; // max. time without successful command
+};
+
+// ModuleT must have slotIndex, synchronized, powerDown, setTestResult() and
+// pollCommands(tickCountMs) which queues polling commands that are due.
+// In simulator it also must have fillSimulatorResponse(command, isRequestTransfer, response).
+template <typename ModuleT, typename RequestT, typename ResponseT, size_t BUFFER_SIZE = sizeof(RequestT)>
+struct SlotTransport {
+    struct CommandDef {
+        uint32_t command;
+        void (ModuleT::*fillRequest)(RequestT &request);
+        void (ModuleT::*done)(ResponseT &response, bool isSuccess);
+        uint8_t priority; // CommandPriority
+        uint8_t flags;    // CommandFlags
+    };
+
+    enum State {
+        STATE_IDLE,
+
+        STATE_WAIT_SLAVE_READY_BEFORE_REQUEST,
+        STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST,
+
+        STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE,
+        STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE
+    };
+
+    enum Event {
+        EVENT_SLAVE_READY,
+        EVENT_DMA_TRANSFER_COMPLETED,
+        EVENT_DMA_TRANSFER_FAILED,
+        EVENT_TIMEOUT
+    };
+
+    // Every command is at most once in the queue or in flight (see queueCommand), so the queue
+    // can't overflow as long as the module has no more than MAX_QUEUED_COMMANDS commands.
+    static const int MAX_QUEUED_COMMANDS = 16;
+
+    ModuleT *module;
+    SlotTransportConfig config;
+
+    // called for every successfully received response, before command is done
+    void (ModuleT::*onResponse)(ResponseT &response) = nullptr;
+
+    uint32_t input[(BUFFER_SIZE + 3) / 4 + 1];
+
+    // With fused protocol next request is prepared while the request
+    // of the current command is still needed, so there are two buffers.
+    uint32_t output[2][(BUFFER_SIZE + 3) / 4];
+    int outputIndex = 0;
+
+    // params generation (see comm::getParamsGeneration) at the time request was filled
+    uint32_t requestParamsGeneration[2];
+
+    bool fusedProtocol = false;
+
+    bool spiReady = false;
+    bool spiDmaTransferCompleted = false;
+    int spiDmaTransferStatus;
+
+    const CommandDef *currentCommand = nullptr;
+    const CommandDef *fusedCommand = nullptr; // its request is sent while waiting for the current command response
+
+    const CommandDef *queue[MAX_QUEUED_COMMANDS];
+    int numQueuedCommands = 0;
+
+    State state = STATE_IDLE;
+    uint32_t lastStateTransitionTime = 0;
+    uint32_t lastTransferTime = 0;
+    int retry = 0;
+
+    int numCrcErrors = 0;
+    int numTransferErrors = 0;
+
+    SlotTransport(ModuleT *module_, const SlotTransportConfig &config_)
+        : module(module_), config(config_)
+    {
+        memset(input, 0, sizeof(input));
+        memset(output, 0, sizeof(output));
+    }
+
+    ////////////////////////////////////////
+
+    // Queues command, returns false if it was already queued or is in flight.
+    // Command in flight is not queued again, pollCommands will queue it
+    // after it is done if its request is outdated by then.
+    bool queueCommand(const CommandDef *command) {
+        if (isCommandPending(command)) {
+            return false;
+        }
+        return insertCommand(command, false);
+    }
+
+    // Starts command immediately, command in flight is queued again.
+    void executeCommand(const CommandDef *command) {
+        // remove first so there is always room for the commands in flight
+        removeCommand(command);
+
+        if (fusedCommand) {
+            if (fusedCommand != command) {
+                insertCommand(fusedCommand, true);
+            }
+            fusedCommand = nullptr;
+        }
+
+        if (currentCommand && currentCommand != command) {
+            insertCommand(currentCommand, true);
+        }
+
+        currentCommand = command;
+        retry = 0;
+        setState(STATE_WAIT_SLAVE_READY_BEFORE_REQUEST);
+    }
+
+    // command is queued or in flight
+    bool isCommandPending(const CommandDef *command) {
+        if (currentCommand == command || fusedCommand == command) {
+            return true;
+        }
+        for (int i = 0; i < numQueuedCommands; i++) {
+            if (queue[i] == command) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // request of the command if it is in flight
+    RequestT *getInFlightRequest(const CommandDef *command) {
+        if (currentCommand == command) {
+            return &getRequest();
+        }
+        if (fusedCommand == command) {
+            return (RequestT *)output[1 - outputIndex];
+        }
+        return nullptr;
+    }
+
+    // request of the current command
+    RequestT &getRequest() {
+        return *(RequestT *)output[outputIndex];
+    }
+
+    uint32_t getRequestParamsGeneration() {
+        return requestParamsGeneration[outputIndex];
+    }
+
+    bool isIdle() {
+        return state == STATE_IDLE;
+    }
+
+    void setFusedProtocol(bool enabled) {
+        fusedProtocol = enabled;
+        comm::setFusedProtocol(module->slotIndex, enabled);
+    }
+
+    // Used while tick is not called periodically, i.e. from initChannels.
+    void runUntilIdle() {
+        while (state != STATE_IDLE) {
+            WATCHDOG_RESET(WATCHDOG_LONG_OPERATION);
+#if defined(EEZ_PLATFORM_STM32)
+            auto slotIndex = module->slotIndex;
+            if (HAL_GPIO_ReadPin(spi::IRQ_GPIO_Port[slotIndex], spi::IRQ_Pin[slotIndex]) == GPIO_PIN_RESET) {
+                osDelay(1);
+                if (HAL_GPIO_ReadPin(spi::IRQ_GPIO_Port[slotIndex], spi::IRQ_Pin[slotIndex]) == GPIO_PIN_RESET) {
+                    spiReady = true;
+                }
+            }
+#endif
+            module->tick();
+            osDelay(1);
+        }
+    }
+
+    void tick() {
+        pumpCurrentCommand();
+        pumpNextCommand();
+        pumpCurrentCommand();
+    }
+
+    void onSpiIrq() {
+        spiReady = true;
+    }
+
+    void onSpiDmaTransferCompleted(int status) {
+        spiDmaTransferCompleted = true;
+        spiDmaTransferStatus = status;
+    }
+
+    ////////////////////////////////////////
+
+    // Commands are sorted by priority, the same priority commands are in FIFO order
+    // unless inserted to the front (command in flight that must be executed again).
+    bool insertCommand(const CommandDef *command, bool front) {
+        assert(numQueuedCommands < MAX_QUEUED_COMMANDS);
+        if (numQueuedCommands == MAX_QUEUED_COMMANDS) {
+            return false;
+        }
+
+        int i = numQueuedCommands;
+        while (i > 0 && (queue[i - 1]->priority < command->priority || (front && queue[i - 1]->priority == command->priority))) {
+            queue[i] = queue[i - 1];
+            i--;
+        }
+        queue[i] = command;
+        numQueuedCommands++;
+
+        return true;
+    }
+
+    void removeCommand(const CommandDef *command) {
+        for (int i = 0; i < numQueuedCommands; i++) {
+            if (queue[i] == command) {
+                numQueuedCommands--;
+                for (; i < numQueuedCommands; i++) {
+                    queue[i] = queue[i + 1];
+                }
+                return;
+            }
+        }
+    }
+
+    const CommandDef *popCommand() {
+        if (numQueuedCommands == 0) {
+            return nullptr;
+        }
+        auto command = queue[0];
+        removeCommand(command);
+        return command;
+    }
+
+    ////////////////////////////////////////
+
+    bool startCommand() {
+        RequestT &request = getRequest();
+
+        request.command = currentCommand->command;
+
+        requestParamsGeneration[outputIndex] = comm::getParamsGeneration(module->slotIndex);
+        if (currentCommand->fillRequest) {
+            (module->*currentCommand->fillRequest)(request);
+        }
+
+        spiReady = false;
+        spiDmaTransferCompleted = false;
+        auto status = comm::transferDMA(module->slotIndex, (uint8_t *)&request, (uint8_t *)input, BUFFER_SIZE);
+        return status == comm::TRANSFER_STATUS_OK;
+    }
+
+    bool getCommandResult() {
+        RequestT *request;
+
+        fusedCommand = getFusedCommand();
+        if (fusedCommand) {
+            // send the request of the next command instead of command none
+            request = (RequestT *)output[1 - outputIndex];
+            request->command = fusedCommand->command;
+            requestParamsGeneration[1 - outputIndex] = comm::getParamsGeneration(module->slotIndex);
+            if (fusedCommand->fillRequest) {
+                (module->*fusedCommand->fillRequest)(*request);
+            }
+        } else {
+            request = &getRequest();
+            request->command = config.commandNone;
+        }
+
+        spiReady = false;
+        spiDmaTransferCompleted = false;
+        auto status = comm::transferDMA(module->slotIndex, (uint8_t *)request, (uint8_t *)input, BUFFER_SIZE);
+        if (status != comm::TRANSFER_STATUS_OK) {
+            if (fusedCommand) {
+                insertCommand(fusedCommand, true);
+                fusedCommand = nullptr;
+            }
+            return false;
+        }
+        return true;
+    }
+
+    const CommandDef *getFusedCommand() {
+        if (!fusedProtocol || !module->synchronized || module->powerDown || !(currentCommand->flags & COMMAND_FLAG_FUSABLE)) {
+            return nullptr;
+        }
+
+        module->pollCommands(millis());
+
+        if (numQueuedCommands > 0 && (queue[0]->flags & COMMAND_FLAG_FUSABLE)) {
+            return popCommand();
+        }
+
+        return nullptr;
+    }
+
+    // called when the response of the current command was received together with
+    // the request of the fused command, fused command now waits for its response
+    void startFusedCommand(const CommandDef *command) {
+        comm::reportFusedCommand(module->slotIndex);
+
+        currentCommand = command;
+        outputIndex = 1 - outputIndex;
+        retry = 0;
+        setState(STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE);
+    }
+
+    bool isCommandResponse() {
+        ResponseT &response = *(ResponseT *)input;
+        return response.command == (TRANSPORT_RESPONSE_FLAG | currentCommand->command);
+    }
+
+    void doRetry() {
+        comm::abortTransfer(module->slotIndex);
+        comm::reportRetry(module->slotIndex);
+
+        // slave could have received the request of the fused command or not, so execute it again
+        if (fusedCommand) {
+            insertCommand(fusedCommand, true);
+            fusedCommand = nullptr;
+        }
+
+        if (++retry < config.numRequestRetries) {
+            // try again
+            setState(STATE_WAIT_SLAVE_READY_BEFORE_REQUEST);
+        } else {
+            // give up
+            doCommandDone(false);
+        }
+    }
+
+    void doCommandDone(bool isSuccess) {
+        if (isSuccess) {
+            lastTransferTime = millis();
+        }
+
+        comm::reportCommandDone(module->slotIndex, isSuccess);
+
+        if (currentCommand->done) {
+            ResponseT &response = *(ResponseT *)input;
+            (module->*currentCommand->done)(response, isSuccess);
+        }
+
+        if (module->powerDown) {
+            module->synchronized = false;
+            module->setTestResult(TEST_FAILED);
+        }
+
+        currentCommand = nullptr;
+        setState(STATE_IDLE);
+    }
+
+    void setState(State newState) {
+        state = newState;
+        lastStateTransitionTime = millis();
+    }
+
+    void stateTransition(Event event) {
+        if (event == EVENT_DMA_TRANSFER_COMPLETED) {
+            numCrcErrors = 0;
+            numTransferErrors = 0;
+
+            if (onResponse) {
+                (module->*onResponse)(*(ResponseT *)input);
+            }
+        }
+
+        if (state == STATE_WAIT_SLAVE_READY_BEFORE_REQUEST) {
+            if (event == EVENT_TIMEOUT) {
+                doRetry();
+            } else if (event == EVENT_SLAVE_READY) {
+                if (startCommand()) {
+                    setState(STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST);
+                } else {
+                    doRetry();
+                }
+            }
+        } else if (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST) {
+            if (event == EVENT_TIMEOUT) {
+                doRetry();
+            } else if (event == EVENT_DMA_TRANSFER_COMPLETED) {
+                setState(STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE);
+            } else if (event == EVENT_DMA_TRANSFER_FAILED) {
+                doRetry();
+            }
+        } else if (state == STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE) {
+            if (event == EVENT_TIMEOUT) {
+                doRetry();
+            } else if (event == EVENT_SLAVE_READY) {
+                if (getCommandResult()) {
+                    setState(STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE);
+                } else {
+                    doRetry();
+                }
+            }
+        } else if (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE) {
+            if (event == EVENT_TIMEOUT) {
+                doRetry();
+            } else if (event == EVENT_DMA_TRANSFER_COMPLETED) {
+                if (isCommandResponse()) {
+                    auto nextCommand = fusedCommand;
+                    fusedCommand = nullptr;
+                    doCommandDone(true);
+                    if (nextCommand) {
+                        if (module->synchronized) {
+                            startFusedCommand(nextCommand);
+                        } else {
+                            // it will fail in pumpNextCommand
+                            insertCommand(nextCommand, true);
+                        }
+                    }
+                } else {
+                    doRetry();
+                }
+            } else if (event == EVENT_DMA_TRANSFER_FAILED) {
+                doRetry();
+            }
+        }
+    }
+
+    void setSyncError(int eventId) {
+        psu::event_queue::pushEvent(eventId + module->slotIndex);
+        module->synchronized = false;
+        module->setTestResult(TEST_FAILED);
+    }
+
+    void reportDmaTransferFailed(int status) {
+        comm::reportTransferError(module->slotIndex, status);
+
+        if (status == comm::TRANSFER_STATUS_CRC_ERROR) {
+            numCrcErrors++;
+            if (numCrcErrors >= config.maxDmaTransferErrors) {
+                setSyncError(psu::event_queue::EVENT_ERROR_SLOT1_CRC_CHECK_ERROR);
+            }
+        } else {
+            numTransferErrors++;
+            if (numTransferErrors >= config.maxDmaTransferErrors) {
+                setSyncError(psu::event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR);
+            }
+        }
+    }
+
+    void pumpCurrentCommand() {
+        if (!currentCommand) {
+            return;
+        }
+
+        if (!module->synchronized && !(currentCommand->flags & COMMAND_FLAG_UNSYNCHRONIZED)) {
+            doCommandDone(false);
+            return;
+        }
+
+        if (
+            state == STATE_WAIT_SLAVE_READY_BEFORE_REQUEST ||
+            state == STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE
+        ) {
+#if defined(EEZ_PLATFORM_STM32)
+            if (spiReady) {
+                stateTransition(EVENT_SLAVE_READY);
+            }
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+            stateTransition(EVENT_SLAVE_READY);
+#endif
+        }
+
+        if (
+            state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST ||
+            state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE
+        ) {
+#if defined(EEZ_PLATFORM_STM32)
+            if (spiDmaTransferCompleted) {
+                if (spiDmaTransferStatus == comm::TRANSFER_STATUS_OK) {
+                    stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
+                } else {
+                    reportDmaTransferFailed(spiDmaTransferStatus);
+                    stateTransition(EVENT_DMA_TRANSFER_FAILED);
+                }
+            }
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+            ResponseT &response = *(ResponseT *)input;
+            response.command = TRANSPORT_RESPONSE_FLAG | currentCommand->command;
+            module->fillSimulatorResponse(currentCommand, state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST, response);
+            stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
+#endif
+        }
+
+        if (currentCommand && millis() - lastStateTransitionTime >= config.timeoutMs) {
+            stateTransition(EVENT_TIMEOUT);
+        }
+    }
+
+    void pumpNextCommand() {
+        if (currentCommand) {
+            return;
+        }
+
+        uint32_t tickCountMs = millis();
+
+        if (module->synchronized && tickCountMs - lastTransferTime >= config.timeoutUntilOutOfSyncMs) {
+#if defined(EEZ_PLATFORM_STM32)
+            setSyncError(psu::event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR);
+#endif
+        }
+
+        module->pollCommands(tickCountMs);
+
+        while (!currentCommand) {
+            auto command = popCommand();
+            if (!command) {
+                break;
+            }
+
+            executeCommand(command);
+
+            if (!module->synchronized && !(command->flags & COMMAND_FLAG_UNSYNCHRONIZED)) {
+                // report failure to whoever is waiting for this command
+                doCommandDone(false);
+            }
+        }
+    }
+};
+
+} // namespace bp3c
+} // namespace eez
@@ -52,6 +52,7 @@
 #include <bb3/psu/gui/animations.h>
 #include <bb3/bp3c/comm.h>
 #include <bb3/bp3c/flash_slave.h>
+#include <bb3/bp3c/slot_transport.h>
 
 #include <bb3/function_generator.h>
 
@@ -161,8 +162,24 @@ enum Command {
     COMMAND_DISK_DRIVE_IOCTL = 0x22cc23c8
 };
 
+static const bp3c::SlotTransportConfig TRANSPORT_CONFIG = {
+    COMMAND_NONE,
+    NUM_REQUEST_RETRIES,
+    MAX_DMA_TRANSFER_ERRORS,
+    TIMEOUT_TIME_MS,
+    TIMEOUT_UNTIL_OUT_OF_SYNC_MS
+};
+
 #define GET_STATE_COMMAND_FLAG_SD_CARD_PRESENT (1 << 0)
 
+// Protocol features are negotiated with COMMAND_GET_INFO, features field
+// is valid only if the magic matches (older firmware leaves garbage there).
+#define PROTOCOL_FEATURES_MAGIC 0x4f7a3c15
+
+// Request of the next command and response of the previous command
+// are exchanged in the same transfer.
+#define PROTOCOL_FEATURE_FUSED_RESPONSE (1 << 0)
+
 #define DLOG_STATE_IDLE 0
 #define DLOG_STATE_EXECUTING 1
 #define DLOG_STATE_FINISH_RESULT_OK 2
@@ -242,6 +259,11 @@ struct Request {
     uint32_t command;
 
     union {
+        struct {
+            uint32_t protocolFeaturesMagic;
+            uint32_t protocolFeatures; // PROTOCOL_FEATURE_...
+        } getInfo;
+
         struct {
             uint32_t fatTime;
         } getState;
@@ -278,6 +300,8 @@ struct Response {
             uint32_t idw1;
             uint32_t idw2;
             uint8_t afeVersion;
+            uint32_t protocolFeaturesMagic;
+            uint32_t protocolFeatures; // PROTOCOL_FEATURE_...
         } getInfo;
 
         struct {
@@ -498,7 +522,7 @@ struct DinChannel {
         for (int i = 0; i < 8; i++) {
             char propName[32];
             snprintf(propName, sizeof(propName), "din_pin%dLabel", i);
-            READ_STRING_PROPERTY(propName, parameters.pinLabels + i * (CHANNEL_LABEL_MAX_LENGTH + 1), CHANNEL_LABEL_MAX_LENGTH);
+            READ_STRING_PROPERTY_BY_NAME(propName, parameters.pinLabels + i * (CHANNEL_LABEL_MAX_LENGTH + 1), CHANNEL_LABEL_MAX_LENGTH);
         }
         return false;
     }
@@ -598,10 +622,10 @@ struct DoutChannel {
             char propName[32];
 
             snprintf(propName, sizeof(propName), "dout_pin%d_label", i);
-            READ_STRING_PROPERTY(propName, parameters.pinLabels + i * (CHANNEL_LABEL_MAX_LENGTH + 1), CHANNEL_LABEL_MAX_LENGTH);
+            READ_STRING_PROPERTY_BY_NAME(propName, parameters.pinLabels + i * (CHANNEL_LABEL_MAX_LENGTH + 1), CHANNEL_LABEL_MAX_LENGTH);
 
             snprintf(propName, sizeof(propName), "dout_pin%d_triggerMode", i);
-            READ_PROPERTY(propName, parameters.triggerMode[i]);
+            READ_PROPERTY_BY_NAME(propName, parameters.triggerMode[i]);
         }
 
         return false;
@@ -901,19 +925,19 @@ public:
         char propName[32];
 
         snprintf(propName, sizeof(propName), "ain_%d_mode", i+1);
-        READ_PROPERTY(propName, parameters.mode);
+        READ_PROPERTY_BY_NAME(propName, parameters.mode);
 
         snprintf(propName, sizeof(propName), "ain_%d_currentRange", i+1);
-        READ_PROPERTY(propName, parameters.currentRange);
+        READ_PROPERTY_BY_NAME(propName, parameters.currentRange);
 
 		snprintf(propName, sizeof(propName), "ain_%d_voltageRange", i + 1);
-		READ_PROPERTY(propName, parameters.voltageRange);
+		READ_PROPERTY_BY_NAME(propName, parameters.voltageRange);
 		
 		snprintf(propName, sizeof(propName), "ain_%d_nplc", i + 1);
-		READ_PROPERTY(propName, parameters.nplc);
+		READ_PROPERTY_BY_NAME(propName, parameters.nplc);
 
 		snprintf(propName, sizeof(propName), "ain_%d_label", i+1);
-        READ_STRING_PROPERTY(propName, parameters.label, CHANNEL_LABEL_MAX_LENGTH);
+        READ_STRING_PROPERTY_BY_NAME(propName, parameters.label, CHANNEL_LABEL_MAX_LENGTH);
 
         return false;
     }
@@ -1643,28 +1667,28 @@ public:
         char propName[64];
 
         snprintf(propName, sizeof(propName), "aout_dac7760_%d_outputEnabled", i+1);
-        READ_PROPERTY(propName, parameters.outputEnabled);
+        READ_PROPERTY_BY_NAME(propName, parameters.outputEnabled);
 
         snprintf(propName, sizeof(propName), "aout_dac7760_%d_mode", i+1);
-        READ_PROPERTY(propName, parameters.mode);
+        READ_PROPERTY_BY_NAME(propName, parameters.mode);
 
         snprintf(propName, sizeof(propName), "aout_dac7760_%d_currentRange", i+1);
-        READ_PROPERTY(propName, parameters.currentRange);
+        READ_PROPERTY_BY_NAME(propName, parameters.currentRange);
 
         snprintf(propName, sizeof(propName), "aout_dac7760_%d_voltageRange", i+1);
-        READ_PROPERTY(propName, parameters.voltageRange);
+        READ_PROPERTY_BY_NAME(propName, parameters.voltageRange);
 
         snprintf(propName, sizeof(propName), "aout_dac7760_%d_currentValue", i+1);
-        READ_PROPERTY(propName, parameters.currentValue);
+        READ_PROPERTY_BY_NAME(propName, parameters.currentValue);
 
         snprintf(propName, sizeof(propName), "aout_dac7760_%d_voltageValue", i+1);
-        READ_PROPERTY(propName, parameters.voltageValue);
+        READ_PROPERTY_BY_NAME(propName, parameters.voltageValue);
 
         snprintf(propName, sizeof(propName), "aout_dac7760_%d_label", i+1);
-        READ_STRING_PROPERTY(propName, parameters.label, CHANNEL_LABEL_MAX_LENGTH);
+        READ_STRING_PROPERTY_BY_NAME(propName, parameters.label, CHANNEL_LABEL_MAX_LENGTH);
 
         snprintf(propName, sizeof(propName), "aout_dac7760_%d_triggerMode", i+1);
-        READ_PROPERTY(propName, parameters.triggerMode);
+        READ_PROPERTY_BY_NAME(propName, parameters.triggerMode);
 
         return false;
     }
@@ -1969,13 +1993,13 @@ struct AoutDac7563Channel {
         char propName[32];
 
         snprintf(propName, sizeof(propName), "aout_dac7563_%d_value", i+1);
-        READ_PROPERTY(propName, parameters.value);
+        READ_PROPERTY_BY_NAME(propName, parameters.value);
 
         snprintf(propName, sizeof(propName), "aout_dac7563_%d_label", i+1);
-        READ_STRING_PROPERTY(propName, parameters.label, CHANNEL_LABEL_MAX_LENGTH);
+        READ_STRING_PROPERTY_BY_NAME(propName, parameters.label, CHANNEL_LABEL_MAX_LENGTH);
 
         snprintf(propName, sizeof(propName), "aout_dac7563_%d_triggerMode", i+1);
-        READ_PROPERTY(propName, parameters.triggerMode);
+        READ_PROPERTY_BY_NAME(propName, parameters.triggerMode);
 
         return false;
     }
@@ -2070,13 +2094,13 @@ struct PwmChannel {
         char propName[32];
 
         snprintf(propName, sizeof(propName), "pwm_%d_freq", i+1);
-        READ_PROPERTY(propName, parameters.freq);
+        READ_PROPERTY_BY_NAME(propName, parameters.freq);
 
         snprintf(propName, sizeof(propName), "pwm_%d_duty", i+1);
-        READ_PROPERTY(propName, parameters.duty);
+        READ_PROPERTY_BY_NAME(propName, parameters.duty);
 
         snprintf(propName, sizeof(propName), "pwm_%d_label", i+1);
-        READ_STRING_PROPERTY(propName, parameters.label, CHANNEL_LABEL_MAX_LENGTH);
+        READ_STRING_PROPERTY_BY_NAME(propName, parameters.label, CHANNEL_LABEL_MAX_LENGTH);
 
         return false;
     }
@@ -2100,22 +2124,12 @@ public:
     bool powerDown = false;
     bool synchronized = false;
 
-    uint32_t input[(sizeof(Request) + 3) / 4 + 1];
-    uint32_t output[(sizeof(Request) + 3) / 4];
+    typedef bp3c::SlotTransport<Mio168Module, Request, Response> Transport;
+    typedef Transport::CommandDef CommandDef;
 
-    bool spiReady = false;
-    bool spiDmaTransferCompleted = false;
-    int spiDmaTransferStatus;
+    Transport transport;
 
-    uint32_t lastTransferTime = 0;
 	SetParams lastTransferredParams;
-    bool forceTransferSetParams;
-
-	struct CommandDef {
-		uint32_t command;
-		void (Mio168Module::*fillRequest)(Request &request);
-		void (Mio168Module::*done)(Response &response, bool isSuccess);
-	};
 
     static const CommandDef getInfo_command;
     static const CommandDef getState_command;
@@ -2131,29 +2145,8 @@ public:
     static const CommandDef diskDriveWrite_command;
     static const CommandDef diskDriveIoctl_command;
 
-    enum State {
-        STATE_IDLE,
-
-        STATE_WAIT_SLAVE_READY_BEFORE_REQUEST,
-        STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST,
-
-        STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE,
-        STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE
-    };
-
-    enum Event {
-        EVENT_SLAVE_READY,
-        EVENT_DMA_TRANSFER_COMPLETED,
-        EVENT_DMA_TRANSFER_FAILED,
-        EVENT_TIMEOUT
-    };
-
-    const CommandDef *currentCommand = nullptr;
     uint32_t refreshStartTime;
-    State state;
-    uint32_t lastStateTransitionTime;
     uint32_t lastRefreshTime;
-    int retry;
 
 	struct ExecuteDiskDriveOperationParams {
         const CommandDef *command;
@@ -2231,9 +2224,11 @@ public:
     uint8_t acChannel = AC_ANALYSIS_CHANNEL_P1;
     uint8_t acEfficiencyFormula = AC_EFFICIENCY_FORMULA_NONE;
 
-    Mio168Module() {
+    Mio168Module() : transport(this, TRANSPORT_CONFIG) {
 		assert(sizeof(Request) == sizeof(Response));
 
+        transport.onResponse = &Mio168Module::onTransportResponse;
+
         moduleType = MODULE_TYPE_DIB_MIO168;
         moduleName = "MIO168";
         moduleBrand = "Envox";
@@ -2251,9 +2246,6 @@ public:
         isResyncSupported = true;
 
         resetConfiguration();
-
-        memset(input, 0, sizeof(input));
-        memset(output, 0, sizeof(output));
     }
 
     Module *createModule() override {
@@ -2273,25 +2265,10 @@ public:
         if (!synchronized) {
             setTestResult(TEST_CONNECTING);
 
-			executeCommand(&getInfo_command);
+			transport.executeCommand(&getInfo_command);
+            transport.runUntilIdle();
 
-//			if (!g_isBooted) {
-				while (state != STATE_IDLE) {
-                    WATCHDOG_RESET(WATCHDOG_LONG_OPERATION);
-#if defined(EEZ_PLATFORM_STM32)
-					if (HAL_GPIO_ReadPin(spi::IRQ_GPIO_Port[slotIndex], spi::IRQ_Pin[slotIndex]) == GPIO_PIN_RESET) {
-                        osDelay(1);
-                        if (HAL_GPIO_ReadPin(spi::IRQ_GPIO_Port[slotIndex], spi::IRQ_Pin[slotIndex]) == GPIO_PIN_RESET) {
-						    spiReady = true;
-                        }
-					}
-#endif
-					tick();
-                    osDelay(1);
-				}
-//			}
-
-            forceTransferSetParams = true;
+            transport.queueCommand(&setParams_command);
         }
 
         if (synchronized) {
@@ -2304,10 +2281,20 @@ public:
 
     ////////////////////////////////////////
 
+    void Command_GetInfo_FillRequest(Request &request) {
+        request.getInfo.protocolFeaturesMagic = PROTOCOL_FEATURES_MAGIC;
+        request.getInfo.protocolFeatures = PROTOCOL_FEATURE_FUSED_RESPONSE;
+    }
+
     void Command_GetInfo_Done(Response &response, bool isSuccess) {
         if (isSuccess) {
             auto &data = response.getInfo;
 
+            transport.setFusedProtocol(
+                data.protocolFeaturesMagic == PROTOCOL_FEATURES_MAGIC &&
+                (data.protocolFeatures & PROTOCOL_FEATURE_FUSED_RESPONSE) != 0
+            );
+
             firmwareMajorVersion = data.firmwareMajorVersion;
             firmwareMinorVersion = data.firmwareMinorVersion;
             idw0 = data.idw0;
@@ -2325,6 +2312,7 @@ public:
             setTestResult(TEST_OK);
         } else {
             synchronized = false;
+            transport.setFusedProtocol(false);
             if (firmwareInstalled) {
                 event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR + slotIndex);
             }
@@ -2536,7 +2524,7 @@ public:
         if (isSuccess) {
             auto &data = response.setParams;
             if (data.result) {
-                memcpy(&lastTransferredParams, &((Request *)output)->setParams, sizeof(SetParams));
+                memcpy(&lastTransferredParams, &transport.getRequest().setParams, sizeof(SetParams));
             }
         }
     }
@@ -2556,6 +2544,13 @@ public:
 
     ////////////////////////////////////////
 
+    // slave can send dlog data in the response of any command
+    void onTransportResponse(Response &response) {
+        if (response.command == (bp3c::TRANSPORT_RESPONSE_FLAG | COMMAND_DLOG_RECORDING_DATA)) {
+            Command_DlogRecordingData_OnResponse(response);
+        }
+    }
+
     void Command_DlogRecordingData_OnResponse(Response &response) {
         if (isModuleControlledRecordingExecuting()) {
             auto &dlogRecordingData = response.dlogRecordingData;
@@ -2767,334 +2762,108 @@ public:
 			dlog_record::isModuleControlledRecording();
     }
 
-    void executeCommand(const CommandDef *command) {
-        currentCommand = command;
-        retry = 0;
-        setState(STATE_WAIT_SLAVE_READY_BEFORE_REQUEST);
-	}
-
-    bool startCommand() {
-		Request &request = *(Request *)output;
-
-		request.command = currentCommand->command;
-
-		if (currentCommand->fillRequest) {
-			(this->*currentCommand->fillRequest)(request);
-		}
-        spiReady = false;
-        spiDmaTransferCompleted = false;
-        auto status = bp3c::comm::transferDMA(slotIndex, (uint8_t *)output, (uint8_t *)input, sizeof(Request));
-        return status == bp3c::comm::TRANSFER_STATUS_OK;
-    }
-
-    bool getCommandResult() {
-        Request &request = *(Request *)output;
-        request.command = COMMAND_NONE;
-        spiReady = false;
-        spiDmaTransferCompleted = false;
-        auto status = bp3c::comm::transferDMA(slotIndex, (uint8_t *)output, (uint8_t *)input, sizeof(Request));
-        return status == bp3c::comm::TRANSFER_STATUS_OK;
-    }
-
-    bool isCommandResponse() {
-        Response &response = *(Response *)input;
-        return response.command == (0x8000 | currentCommand->command);
-    }
+    void pollCommands(uint32_t tickCountMs) {
+        if (nextDlogCommand) {
+            memcpy(&dlogRecordingStart, &nextDlogRecordingStart, sizeof(DlogRecordingStart));
+            transport.queueCommand(nextDlogCommand);
+            nextDlogCommand = nullptr;
+        }
 
-    void doRetry() {
-    	bp3c::comm::abortTransfer(slotIndex);
-        
-        if (++retry < NUM_REQUEST_RETRIES) {
-            // try again
-            setState(STATE_WAIT_SLAVE_READY_BEFORE_REQUEST);
-        } else {
-            // give up
-            doCommandDone(false);
+        if (diskOperationStatus == DISK_OPERATION_NOT_FINISHED && !transport.isCommandPending(diskOperationParams.command)) {
+            transport.queueCommand(diskOperationParams.command);
         }
-    }
 
-    void doCommandDone(bool isSuccess) {
-        if (isSuccess) {
-            lastTransferTime = millis();
+        if (!synchronized) {
+            return;
         }
 
-		if (currentCommand->done) {
-			Response &response = *(Response *)input;
-			(this->*currentCommand->done)(response, isSuccess);
-		}
+        // if set params is in flight compare with what is being transferred
+        auto request = transport.getInFlightRequest(&setParams_command);
+        SetParams params;
+        fillSetParams(params);
+        if (memcmp(&params, request ? &request->setParams : &lastTransferredParams, sizeof(SetParams)) != 0) {
+            transport.queueCommand(&setParams_command);
+        }
 
-        if (powerDown) {
-            synchronized = false;
-            setTestResult(TEST_FAILED);
+        if (tickCountMs - lastRefreshTime >= getRefreshTimeMs() && !transport.isCommandPending(&getState_command)) {
+            refreshStartTime = tickCountMs;
+            transport.queueCommand(&getState_command);
         }
 
-		currentCommand = nullptr;
-        setState(STATE_IDLE);
+        if (isModuleControlledRecordingExecuting()) {
+            transport.queueCommand(&dlogRecordingData_command);
+        }
     }
 
-    void setState(State newState) {
-        state = newState;
-        lastStateTransitionTime = millis();
-    }
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    void fillSimulatorResponse(const CommandDef *command, bool isRequestTransfer, Response &response) {
+        if (command->command == COMMAND_GET_INFO) {
+            response.getInfo.firmwareMajorVersion = 1;
+            response.getInfo.firmwareMinorVersion = 0;
+            response.getInfo.idw0 = 0;
+            response.getInfo.idw1 = 0;
+            response.getInfo.idw2 = 0;
+            response.getInfo.afeVersion = simulatorAfeVersion;
+            response.getInfo.protocolFeaturesMagic = PROTOCOL_FEATURES_MAGIC;
+            response.getInfo.protocolFeatures = PROTOCOL_FEATURE_FUSED_RESPONSE;
+        } else if (command->command == COMMAND_GET_STATE) {
+            memset(&response.getState, 0, sizeof(response.getState));
+            response.getState.flags |= GET_STATE_COMMAND_FLAG_SD_CARD_PRESENT;
+            response.getState.ainDiagStatus = 3;
+        } else {
+            if (
+                command->command == COMMAND_DLOG_RECORDING_DATA ||
+                (isRequestTransfer && isModuleControlledRecordingExecuting())
+            ) {
+                response.command = bp3c::TRANSPORT_RESPONSE_FLAG | COMMAND_DLOG_RECORDING_DATA;
 
-    void stateTransition(Event event) {
-    	if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-            numCrcErrors = 0;
-            numTransferErrors = 0;
+                bool is24Bit = dlog_record::g_recordingParameters.period >= 1.0f / 16000;
 
-            Response &response = *(Response *)input;
-            if (response.command == (0x8000 | COMMAND_DLOG_RECORDING_DATA)) {
-                Command_DlogRecordingData_OnResponse(response);
-            }
-    	}
- 
-        if (state == STATE_WAIT_SLAVE_READY_BEFORE_REQUEST) {
-            if (event == EVENT_TIMEOUT) {
-				doRetry();
-            } else if (event == EVENT_SLAVE_READY) {
-                if (startCommand()) {
-                    setState(STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST);
-                } else {
-                    doRetry();
-                }
-            }
-        } else if (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST) {
-            if (event == EVENT_TIMEOUT) {
-                doRetry();
-            } else if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-                setState(STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE);
-            } else if (event == EVENT_DMA_TRANSFER_FAILED) {
-                doRetry();
-            }
-        } else if (state == STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE) {
-            if (event == EVENT_TIMEOUT) {
-				doRetry();
-            } else if (event == EVENT_SLAVE_READY) {
-                if (getCommandResult()) {
-                    setState(STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE);
-                } else {
-                    doRetry();
-                }
-            }
-        } else if (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE) {
-            if (event == EVENT_TIMEOUT) {
-                doRetry();
-            } else if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-                if (isCommandResponse()) {
-                    doCommandDone(true);
-                } else {
-                    doRetry();
-                }
-            } else if (event == EVENT_DMA_TRANSFER_FAILED) {
-                doRetry();
-            }
-        } 
-    }
+                response.dlogRecordingData.recordIndex = dlogDataRecordIndex;
+                response.dlogRecordingData.numRecords = (uint16_t)roundf(1.0f / dlog_record::g_recordingParameters.period / 1000);
 
-    int numCrcErrors = 0;
-    int numTransferErrors = 0;
+                static int32_t ain[4] = {
+                    ain[0] = 0x7FFFFFFF / 5,
+                    ain[1] = 0x7FFFFFFF / 5 * 2,
+                    ain[2] = 0x7FFFFFFF / 5 * 3,
+                    ain[3] = 0x7FFFFFFF / 5 * 4
+                };
 
-    void reportDmaTransferFailed(int status) {
-        if (status == bp3c::comm::TRANSFER_STATUS_CRC_ERROR) {
-            numCrcErrors++;
-            if (numCrcErrors >= MAX_DMA_TRANSFER_ERRORS) {
-                event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_CRC_CHECK_ERROR + slotIndex);
-                synchronized = false;
-                setTestResult(TEST_FAILED);
-            }
-            //else if (numCrcErrors > 5) {
-            //    DebugTrace("Slot %d CRC error no. %d\n", slotIndex + 1, numCrcErrors);
-            //}
-        } else {
-            numTransferErrors++;
-            if (numTransferErrors >= MAX_DMA_TRANSFER_ERRORS) {
-                event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR + slotIndex);
-                synchronized = false;
-                setTestResult(TEST_FAILED);
-            }
-            //else if (numTransferErrors > 5) {
-            //    DebugTrace("Slot %d SPI transfer error %d no. %d\n", slotIndex + 1, status, numTransferErrors);
-            //}
-        }
-    }
+                uint8_t *p = response.dlogRecordingData.buffer;
 
-    void pumpCurrentCommand() {
-        if (currentCommand) {
-            if (!synchronized && currentCommand->command != COMMAND_GET_INFO) {
-                doCommandDone(false);
-            } else {
-                if (
-                    state == STATE_WAIT_SLAVE_READY_BEFORE_REQUEST ||
-                    state == STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE
-                ) {
-                    #if defined(EEZ_PLATFORM_STM32)
-                	if (spiReady) {
-                		stateTransition(EVENT_SLAVE_READY);
-                	}
-                    #endif
-
-                    #if defined(EEZ_PLATFORM_SIMULATOR)
-                    stateTransition(EVENT_SLAVE_READY);
-                    #endif
-                } 
-                
-                if (
-                    state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST ||
-                    state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE
-                ) {
-                
-                    #if defined(EEZ_PLATFORM_STM32)
-                    if (spiDmaTransferCompleted) {
-                        if (spiDmaTransferStatus == bp3c::comm::TRANSFER_STATUS_OK) {
-                            stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-                        } else {
-                            reportDmaTransferFailed(spiDmaTransferStatus);
-                            stateTransition(EVENT_DMA_TRANSFER_FAILED);
+                for (int i = 0; i < response.dlogRecordingData.numRecords; i++) {
+                    if (is24Bit) {
+                        for (int j = 0; j < 4; j++) {
+                            ain[j] -= 10000;
+                            *p++ = (ain[j] >> 24) & 0xFF;
+                            *p++ = (ain[j] >> 16) & 0xFF;
+                            *p++ = (ain[j] >>  8) & 0xFF;
                         }
-                    }
-                    #endif                
-
-                    #if defined(EEZ_PLATFORM_SIMULATOR)
-                    auto response = (Response *)input;
-
-                    response->command = 0x8000 | currentCommand->command;
-
-                    if (currentCommand->command == COMMAND_GET_INFO) {
-                        response->getInfo.firmwareMajorVersion = 1;
-                        response->getInfo.firmwareMinorVersion = 0;
-                        response->getInfo.idw0 = 0;
-                        response->getInfo.idw1 = 0;
-                        response->getInfo.idw2 = 0;
-                        response->getInfo.afeVersion = simulatorAfeVersion;
-                    } else if (currentCommand->command == COMMAND_GET_STATE) {
-						memset(&response->getState, 0, sizeof(response->getState));
-                        response->getState.flags |= GET_STATE_COMMAND_FLAG_SD_CARD_PRESENT;
-						response->getState.ainDiagStatus = 3;
                     } else {
-                        if (
-                            currentCommand->command == COMMAND_DLOG_RECORDING_DATA ||
-                            (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST && isModuleControlledRecordingExecuting())
-                        ) {
-                            response->command = 0x8000 | COMMAND_DLOG_RECORDING_DATA;
-
-                            bool is24Bit = dlog_record::g_recordingParameters.period >= 1.0f / 16000;
-
-                            response->dlogRecordingData.recordIndex = dlogDataRecordIndex;
-                            response->dlogRecordingData.numRecords = (uint16_t)roundf(1.0f / dlog_record::g_recordingParameters.period / 1000);
-
-							static int32_t ain[4] = {
-								ain[0] = 0x7FFFFFFF / 5,
-								ain[1] = 0x7FFFFFFF / 5 * 2,
-								ain[2] = 0x7FFFFFFF / 5 * 3,
-								ain[3] = 0x7FFFFFFF / 5 * 4
-							};
-
-                            uint8_t *p = response->dlogRecordingData.buffer;
-
-                            for (int i = 0; i < response->dlogRecordingData.numRecords; i++) {
-                                if (is24Bit) {
-									for (int j = 0; j < 4; j++) {
-										ain[j] -= 10000;
-										*p++ = (ain[j] >> 24) & 0xFF;
-										*p++ = (ain[j] >> 16) & 0xFF;
-										*p++ = (ain[j] >>  8) & 0xFF;
-									}
-								} else {
-									for (int j = 0; j < 4; j++) {
-										ain[j] -= 10000;
-										*p++ = (ain[j] >> 24) & 0xFF;
-										*p++ = (ain[j] >> 16) & 0xFF;
-									}
-								}
-                                *p++ = 0x55;
-                                *p++ = 0xAA;
-                            }
-                        }
-                    }
-
-                    stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-                    #endif
-                } 
-                
-                uint32_t tickCountMs = millis();
-                if (tickCountMs - lastStateTransitionTime >= TIMEOUT_TIME_MS) {
-                    stateTransition(EVENT_TIMEOUT);
-                }
-            }
-        } 
-    }
-
-    void pumpNextCommand() {
-        if (!currentCommand) {
-            if (!synchronized) {
-                if (nextDlogCommand) {
-                    executeCommand(nextDlogCommand);
-                    doCommandDone(false);
-                }
-                if (diskOperationStatus == DISK_OPERATION_NOT_FINISHED) {
-                    executeCommand(diskOperationParams.command);
-                    doCommandDone(false);
-                }
-            } else {
-            	uint32_t tickCountMs = millis();
-                if (nextDlogCommand) {
-                    memcpy(&dlogRecordingStart, &nextDlogRecordingStart, sizeof(DlogRecordingStart));
-                    executeCommand(nextDlogCommand);
-                    nextDlogCommand = nullptr;
-                } else if (diskOperationStatus == DISK_OPERATION_NOT_FINISHED) {
-                    executeCommand(diskOperationParams.command);
-                } else if (tickCountMs - lastTransferTime >= TIMEOUT_UNTIL_OUT_OF_SYNC_MS) {
-#ifdef EEZ_PLATFORM_STM32
-                    event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR + slotIndex);
-                    synchronized = false;
-                    setTestResult(TEST_FAILED);
-#endif
-                } else {
-                    if (forceTransferSetParams) {
-                        forceTransferSetParams = false;
-                        executeCommand(&setParams_command);
-                    } else {
-                        SetParams params;
-                        fillSetParams(params);
-                        if (memcmp(&params, &lastTransferredParams, sizeof(SetParams)) != 0) {
-                            executeCommand(&setParams_command);
-                        } else if (tickCountMs - lastRefreshTime >= getRefreshTimeMs()) {
-                            refreshStartTime = tickCountMs;
-                            executeCommand(&getState_command);
-                        } else if (isModuleControlledRecordingExecuting()) {
-                            executeCommand(&dlogRecordingData_command);
+                        for (int j = 0; j < 4; j++) {
+                            ain[j] -= 10000;
+                            *p++ = (ain[j] >> 24) & 0xFF;
+                            *p++ = (ain[j] >> 16) & 0xFF;
                         }
                     }
+                    *p++ = 0x55;
+                    *p++ = 0xAA;
                 }
             }
         }
     }
+#endif
 
     void tick() override {
-        pumpCurrentCommand();
-        pumpNextCommand();
-        pumpCurrentCommand();
+        transport.tick();
     }
 
     void onSpiIrq() override {
-        spiReady = true;
-		// if (g_isBooted) {
-		// 	stateTransition(EVENT_SLAVE_READY);
-		// }
+        transport.onSpiIrq();
     }
 
     void onSpiDmaTransferCompleted(int status) override {
-        //  if (g_isBooted) {
-        //      if (status == bp3c::comm::TRANSFER_STATUS_OK) {
-        //          stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-        //      } else {
-        //          reportDmaTransferFailed(status);
-        //          stateTransition(EVENT_DMA_TRANSFER_FAILED);
-        //      }
-        //  } else {
-             spiDmaTransferCompleted = true;
-             spiDmaTransferStatus = status;
-        //  }
+        transport.onSpiDmaTransferCompleted(status);
     }
 
     void onPowerDown() override {
@@ -3103,7 +2872,7 @@ public:
             synchronized = false;
             setTestResult(TEST_FAILED);
         } else {
-            executeCommand(&setParams_command);
+            transport.executeCommand(&setParams_command);
         }
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
@@ -3113,7 +2882,7 @@ public:
 
     void resync() override {
         if (!synchronized) {
-            executeCommand(&getInfo_command);
+            transport.executeCommand(&getInfo_command);
         }
     }
 
@@ -5279,68 +5048,90 @@ public:
 
 const Mio168Module::CommandDef Mio168Module::getInfo_command = {
 	COMMAND_GET_INFO,
-	nullptr,
-	&Mio168Module::Command_GetInfo_Done
+	&Mio168Module::Command_GetInfo_FillRequest,
+	&Mio168Module::Command_GetInfo_Done,
+	bp3c::COMMAND_PRIORITY_HIGH,
+	bp3c::COMMAND_FLAG_UNSYNCHRONIZED
 };
 
 const Mio168Module::CommandDef Mio168Module::getState_command = {
 	COMMAND_GET_STATE,
 	&Mio168Module::Command_GetState_FillRequest,
-	&Mio168Module::Command_GetState_Done
+	&Mio168Module::Command_GetState_Done,
+	bp3c::COMMAND_PRIORITY_LOW,
+	bp3c::COMMAND_FLAG_FUSABLE
 };
 
 const Mio168Module::CommandDef Mio168Module::setParams_command = {
 	COMMAND_SET_PARAMS,
 	&Mio168Module::Command_SetParams_FillRequest,
-	&Mio168Module::Command_SetParams_Done
+	&Mio168Module::Command_SetParams_Done,
+	bp3c::COMMAND_PRIORITY_HIGH,
+	bp3c::COMMAND_FLAG_FUSABLE
 };
 
 const Mio168Module::CommandDef Mio168Module::dlogRecordingStart_command = {
 	COMMAND_DLOG_RECORDING_START,
 	&Mio168Module::Command_DlogRecordingStart_FillRequest,
-	nullptr
+	nullptr,
+	bp3c::COMMAND_PRIORITY_HIGH,
+	0
 };
 
 const Mio168Module::CommandDef Mio168Module::dlogRecordingStop_command = {
 	COMMAND_DLOG_RECORDING_STOP,
 	nullptr,
-	&Mio168Module::Command_DlogRecordingStop_Done
+	&Mio168Module::Command_DlogRecordingStop_Done,
+	bp3c::COMMAND_PRIORITY_HIGH,
+	0
 };
 
 const Mio168Module::CommandDef Mio168Module::dlogRecordingData_command = {
 	COMMAND_DLOG_RECORDING_DATA,
 	nullptr,
-    nullptr
+    nullptr,
+	bp3c::COMMAND_PRIORITY_LOW,
+	bp3c::COMMAND_FLAG_FUSABLE
 };
 
 const Mio168Module::CommandDef Mio168Module::diskDriveInitialize_command = {
 	COMMAND_DISK_DRIVE_INITIALIZE,
 	nullptr,
-	&Mio168Module::Command_DiskDriveInitialize_Done
+	&Mio168Module::Command_DiskDriveInitialize_Done,
+	bp3c::COMMAND_PRIORITY_NORMAL,
+	0
 };
 
 const Mio168Module::CommandDef Mio168Module::diskDriveStatus_command = {
 	COMMAND_DISK_DRIVE_STATUS,
 	nullptr,
-	&Mio168Module::Command_DiskDriveStatus_Done
+	&Mio168Module::Command_DiskDriveStatus_Done,
+	bp3c::COMMAND_PRIORITY_NORMAL,
+	0
 };
 
 const Mio168Module::CommandDef Mio168Module::diskDriveRead_command = {
 	COMMAND_DISK_DRIVE_READ,
 	&Mio168Module::Command_DiskDriveRead_FillRequest,
-	&Mio168Module::Command_DiskDriveRead_Done
+	&Mio168Module::Command_DiskDriveRead_Done,
+	bp3c::COMMAND_PRIORITY_NORMAL,
+	0
 };
 
 const Mio168Module::CommandDef Mio168Module::diskDriveWrite_command = {
 	COMMAND_DISK_DRIVE_WRITE,
 	&Mio168Module::Command_DiskDriveWrite_FillRequest,
-	&Mio168Module::Command_DiskDriveWrite_Done
+	&Mio168Module::Command_DiskDriveWrite_Done,
+	bp3c::COMMAND_PRIORITY_NORMAL,
+	0
 };
 
 const Mio168Module::CommandDef Mio168Module::diskDriveIoctl_command = {
 	COMMAND_DISK_DRIVE_IOCTL,
 	&Mio168Module::Command_DiskDriveIoctl_FillRequest,
-	&Mio168Module::Command_DiskDriveIoctl_Done
+	&Mio168Module::Command_DiskDriveIoctl_Done,
+	bp3c::COMMAND_PRIORITY_NORMAL,
+	0
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -41,6 +41,7 @@
 #include <bb3/psu/gui/animations.h>
 #include <bb3/bp3c/comm.h>
 #include <bb3/bp3c/flash_slave.h>
+#include <bb3/bp3c/slot_transport.h>
 
 #include "scpi/scpi.h"
 
@@ -78,6 +79,14 @@ enum Command {
     COMMAND_SET_PARAMS = 0x4B723BFF
 };
 
+static const bp3c::SlotTransportConfig TRANSPORT_CONFIG = {
+    COMMAND_NONE,
+    NUM_REQUEST_RETRIES,
+    MAX_DMA_TRANSFER_ERRORS,
+    TIMEOUT_TIME_MS,
+    TIMEOUT_UNTIL_OUT_OF_SYNC_MS
+};
+
 struct SetParams {
 	uint8_t relayStates;
 };
@@ -124,50 +133,19 @@ public:
     bool powerDown = false;
     bool synchronized = false;
 
-    uint32_t input[(BUFFER_SIZE + 3) / 4 + 1];
-    uint32_t output[(BUFFER_SIZE + 3) / 4];
+    typedef bp3c::SlotTransport<Prel6Module, Request, Response, BUFFER_SIZE> Transport;
+    typedef Transport::CommandDef CommandDef;
 
-    bool spiReady = false;
-    bool spiDmaTransferCompleted = false;
-    int spiDmaTransferStatus;
+    Transport transport;
 
-    uint32_t lastTransferTime = 0;
 	SetParams lastTransferredParams;
-    bool forceTransferSetParams;
-
-	struct CommandDef {
-		uint32_t command;
-		void (Prel6Module::*fillRequest)(Request &request);
-		void (Prel6Module::*done)(Response &response, bool isSuccess);
-	};
 
     static const CommandDef getInfo_command;
     static const CommandDef getState_command;
     static const CommandDef setParams_command;
 
-    enum State {
-        STATE_IDLE,
-
-        STATE_WAIT_SLAVE_READY_BEFORE_REQUEST,
-        STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST,
-
-        STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE,
-        STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE
-    };
-
-    enum Event {
-        EVENT_SLAVE_READY,
-        EVENT_DMA_TRANSFER_COMPLETED,
-        EVENT_DMA_TRANSFER_FAILED,
-        EVENT_TIMEOUT
-    };
-
-    const CommandDef *currentCommand = nullptr;
     uint32_t refreshStartTime;
-    State state;
-    uint32_t lastStateTransitionTime;
     uint32_t lastRefreshTime;
-    int retry;
 
     uint8_t relayStates = 0;
 
@@ -179,7 +157,7 @@ public:
     uint32_t lastWrittenRelayCycles[NUM_RELAYS];
     psu::Interval relayCyclesWriteInterval = WRITE_ONTIME_INTERVAL * MIN_TO_MS;
 
-    Prel6Module() {
+    Prel6Module() : transport(this, TRANSPORT_CONFIG) {
         assert(sizeof(Request) <= BUFFER_SIZE);
         assert(sizeof(Response) <= BUFFER_SIZE);
 
@@ -198,9 +176,6 @@ public:
         numPowerChannels = 0;
         numOtherChannels = NUM_RELAYS;
         isResyncSupported = true;
-
-        memset(input, 0, sizeof(input));
-        memset(output, 0, sizeof(output));
     }
 
     void boot() override {
@@ -219,23 +194,10 @@ public:
         if (!synchronized) {
             setTestResult(TEST_CONNECTING);
 
-			executeCommand(&getInfo_command);
-
-            while (state != STATE_IDLE) {
-                WATCHDOG_RESET(WATCHDOG_LONG_OPERATION);
-#if defined(EEZ_PLATFORM_STM32)
-                if (HAL_GPIO_ReadPin(spi::IRQ_GPIO_Port[slotIndex], spi::IRQ_Pin[slotIndex]) == GPIO_PIN_RESET) {
-                    osDelay(1);
-                    if (HAL_GPIO_ReadPin(spi::IRQ_GPIO_Port[slotIndex], spi::IRQ_Pin[slotIndex]) == GPIO_PIN_RESET) {
-                        spiReady = true;
-                    }
-                }
-#endif
-                tick();
-                osDelay(1);
-            }
+			transport.executeCommand(&getInfo_command);
+            transport.runUntilIdle();
 
-            forceTransferSetParams = true;
+            transport.queueCommand(&setParams_command);
         }
     }
 
@@ -290,7 +252,7 @@ public:
 
         relayStates = params.relayStates;
 
-        return bp3c::comm::updateParamsFinish(&params, &lastTransferredParams, sizeof(SetParams), TIMEOUT_UNTIL_OUT_OF_SYNC_MS, err);
+        return bp3c::comm::updateParamsFinish(slotIndex, TIMEOUT_UNTIL_OUT_OF_SYNC_MS, err);
     }
 
 	void fillSetParams(SetParams &params) {
@@ -308,11 +270,13 @@ public:
         if (isSuccess) {
             auto &data = response.setParams;
             if (data.result) {
-                SetParams &params = ((Request *)output)->setParams;
+                SetParams &params = transport.getRequest().setParams;
 
                 updateRelayCycles(lastTransferredParams.relayStates, params.relayStates);
 
                 memcpy(&lastTransferredParams, &params, sizeof(SetParams));
+
+                bp3c::comm::paramsTransferred(slotIndex, transport.getRequestParamsGeneration());
             }
         }
     }
@@ -323,261 +287,56 @@ public:
 		return REFRESH_TIME_MS;
 	}
 
-    void executeCommand(const CommandDef *command) {
-        currentCommand = command;
-        retry = 0;
-        setState(STATE_WAIT_SLAVE_READY_BEFORE_REQUEST);
-	}
-
-    bool startCommand() {
-		Request &request = *(Request *)output;
-
-		request.command = currentCommand->command;
-
-		if (currentCommand->fillRequest) {
-			(this->*currentCommand->fillRequest)(request);
-		}
-        spiReady = false;
-        spiDmaTransferCompleted = false;
-        auto status = bp3c::comm::transferDMA(slotIndex, (uint8_t *)output, (uint8_t *)input, BUFFER_SIZE);
-        return status == bp3c::comm::TRANSFER_STATUS_OK;
-    }
-
-    bool getCommandResult() {
-        Request &request = *(Request *)output;
-        request.command = COMMAND_NONE;
-        spiReady = false;
-        spiDmaTransferCompleted = false;
-        auto status = bp3c::comm::transferDMA(slotIndex, (uint8_t *)output, (uint8_t *)input, BUFFER_SIZE);
-        return status == bp3c::comm::TRANSFER_STATUS_OK;
-    }
-
-    bool isCommandResponse() {
-        Response &response = *(Response *)input;
-        return response.command == (0x8000 | currentCommand->command);
-    }
-
-    void doRetry() {
-    	bp3c::comm::abortTransfer(slotIndex);
-        
-        if (++retry < NUM_REQUEST_RETRIES) {
-            // try again
-            setState(STATE_WAIT_SLAVE_READY_BEFORE_REQUEST);
-        } else {
-            // give up
-            doCommandDone(false);
+    void pollCommands(uint32_t tickCountMs) {
+        if (!synchronized) {
+            return;
         }
-    }
 
-    void doCommandDone(bool isSuccess) {
-        if (isSuccess) {
-            lastTransferTime = millis();
+        // if set params is in flight compare with what is being transferred
+        auto request = transport.getInFlightRequest(&setParams_command);
+        auto paramsGeneration = bp3c::comm::getParamsGeneration(slotIndex);
+        SetParams params;
+        fillSetParams(params);
+        if (memcmp(&params, request ? &request->setParams : &lastTransferredParams, sizeof(SetParams)) != 0) {
+            transport.queueCommand(&setParams_command);
+        } else if (!request) {
+            // nothing to transfer, module already has these params
+            bp3c::comm::paramsTransferred(slotIndex, paramsGeneration);
         }
 
-		if (currentCommand->done) {
-			Response &response = *(Response *)input;
-			(this->*currentCommand->done)(response, isSuccess);
-		}
-
-        if (powerDown) {
-            synchronized = false;
-            setTestResult(TEST_FAILED);
+        if (tickCountMs - lastRefreshTime >= getRefreshTimeMs() && !transport.isCommandPending(&getState_command)) {
+            refreshStartTime = tickCountMs;
+            transport.queueCommand(&getState_command);
         }
-
-		currentCommand = nullptr;
-        setState(STATE_IDLE);
     }
 
-    void setState(State newState) {
-        state = newState;
-        lastStateTransitionTime = millis();
-    }
-
-    void stateTransition(Event event) {
-    	if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-            numCrcErrors = 0;
-            numTransferErrors = 0;
-    	}
- 
-        if (state == STATE_WAIT_SLAVE_READY_BEFORE_REQUEST) {
-            if (event == EVENT_TIMEOUT) {
-				doRetry();
-            } else if (event == EVENT_SLAVE_READY) {
-                if (startCommand()) {
-                    setState(STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST);
-                } else {
-                    doRetry();
-                }
-            }
-        } else if (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST) {
-            if (event == EVENT_TIMEOUT) {
-                doRetry();
-            } else if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-                setState(STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE);
-            } else if (event == EVENT_DMA_TRANSFER_FAILED) {
-                doRetry();
-            }
-        } else if (state == STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE) {
-            if (event == EVENT_TIMEOUT) {
-				doRetry();
-            } else if (event == EVENT_SLAVE_READY) {
-                if (getCommandResult()) {
-                    setState(STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE);
-                } else {
-                    doRetry();
-                }
-            }
-        } else if (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE) {
-            if (event == EVENT_TIMEOUT) {
-                doRetry();
-            } else if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-                if (isCommandResponse()) {
-                    doCommandDone(true);
-                } else {
-                    doRetry();
-                }
-            } else if (event == EVENT_DMA_TRANSFER_FAILED) {
-                doRetry();
-            }
-        } 
-    }
-
-    int numCrcErrors = 0;
-    int numTransferErrors = 0;
-
-    void reportDmaTransferFailed(int status) {
-        if (status == bp3c::comm::TRANSFER_STATUS_CRC_ERROR) {
-            numCrcErrors++;
-            if (numCrcErrors >= MAX_DMA_TRANSFER_ERRORS) {
-                event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_CRC_CHECK_ERROR + slotIndex);
-                synchronized = false;
-                setTestResult(TEST_FAILED);
-            }
-            //else if (numCrcErrors > 5) {
-            //    DebugTrace("Slot %d CRC error no. %d\n", slotIndex + 1, numCrcErrors);
-            //}
-        } else {
-            numTransferErrors++;
-            if (numTransferErrors >= MAX_DMA_TRANSFER_ERRORS) {
-                event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR + slotIndex);
-                synchronized = false;
-                setTestResult(TEST_FAILED);
-            }
-            //else if (numTransferErrors > 5) {
-            //    DebugTrace("Slot %d SPI transfer error %d no. %d\n", slotIndex + 1, status, numTransferErrors);
-            //}
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    void fillSimulatorResponse(const CommandDef *command, bool isRequestTransfer, Response &response) {
+        if (command->command == COMMAND_GET_INFO) {
+            response.getInfo.moduleType = MODULE_TYPE_DIB_PREL6;
+            response.getInfo.firmwareMajorVersion = 1;
+            response.getInfo.firmwareMinorVersion = 0;
+            response.getInfo.idw0 = 0;
+            response.getInfo.idw1 = 0;
+            response.getInfo.idw2 = 0;
         }
     }
+#endif
 
     void tick() override {
         if (relayCyclesWriteInterval.test()) {
             sendMessageToLowPriorityThread((LowPriorityThreadMessage)THREAD_MESSAGE_SAVE_RELAY_CYCLES, slotIndex);
         }
 
-        if (currentCommand) {
-            if (!synchronized && currentCommand->command != COMMAND_GET_INFO) {
-                doCommandDone(false);
-            } else {
-                if (
-                    state == STATE_WAIT_SLAVE_READY_BEFORE_REQUEST ||
-                    state == STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE
-                ) {
-                    #if defined(EEZ_PLATFORM_STM32)
-                	if (spiReady) {
-                		stateTransition(EVENT_SLAVE_READY);
-                	}
-                    #endif
-
-                    #if defined(EEZ_PLATFORM_SIMULATOR)
-                    stateTransition(EVENT_SLAVE_READY);
-                    #endif
-                } 
-                
-                if (
-                    state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST ||
-                    state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE
-                ) {
-                
-                    #if defined(EEZ_PLATFORM_STM32)
-                    if (spiDmaTransferCompleted) {
-                        if (spiDmaTransferStatus == bp3c::comm::TRANSFER_STATUS_OK) {
-                            stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-                        } else {
-                            reportDmaTransferFailed(spiDmaTransferStatus);
-                            stateTransition(EVENT_DMA_TRANSFER_FAILED);
-                        }
-                    }
-                    #endif                
-
-                    #if defined(EEZ_PLATFORM_SIMULATOR)
-                    auto response = (Response *)input;
-
-                    response->command = 0x8000 | currentCommand->command;
-
-                    if (currentCommand->command == COMMAND_GET_INFO) {
-						response->getInfo.moduleType = MODULE_TYPE_DIB_PREL6;
-						response->getInfo.firmwareMajorVersion = 1;
-                        response->getInfo.firmwareMinorVersion = 0;
-                        response->getInfo.idw0 = 0;
-                        response->getInfo.idw1 = 0;
-                        response->getInfo.idw2 = 0;
-                    }
-
-                    stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-                    #endif
-                } 
-                
-                uint32_t tickCountMs = millis();
-                if (tickCountMs - lastStateTransitionTime >= TIMEOUT_TIME_MS) {
-                    stateTransition(EVENT_TIMEOUT);
-                }
-            }
-        } else {
-            if (synchronized) {
-            	uint32_t tickCountMs = millis();
-                if (tickCountMs - lastTransferTime >= TIMEOUT_UNTIL_OUT_OF_SYNC_MS) {
-#ifdef EEZ_PLATFORM_STM32                
-                    event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR + slotIndex);
-                    synchronized = false;
-                    setTestResult(TEST_FAILED);
-#endif
-                } 
-                else if (tickCountMs - lastRefreshTime >= getRefreshTimeMs()) {
-                    refreshStartTime = tickCountMs;
-                    executeCommand(&getState_command);
-                } else if (forceTransferSetParams) {
-                    forceTransferSetParams = false;
-                    executeCommand(&setParams_command);
-                } else {
-                    SetParams params;
-                    fillSetParams(params);
-                    if (memcmp(&params, &lastTransferredParams, sizeof(SetParams)) != 0) {
-                        executeCommand(&setParams_command);
-                    }
-                }
-            }
-        }
+        transport.tick();
     }
 
     void onSpiIrq() override {
-        spiReady = true;
-		// if (g_isBooted) {
-		// 	stateTransition(EVENT_SLAVE_READY);
-		// }
+        transport.onSpiIrq();
     }
 
     void onSpiDmaTransferCompleted(int status) override {
-        //  if (g_isBooted) {
-        //      if (status == bp3c::comm::TRANSFER_STATUS_OK) {
-        //          stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-        //      } else {
-        //          reportDmaTransferFailed(status);
-        //          stateTransition(EVENT_DMA_TRANSFER_FAILED);
-        //      }
-        //  } else {
-             spiDmaTransferCompleted = true;
-             spiDmaTransferStatus = status;
-        //  }
+        transport.onSpiDmaTransferCompleted(status);
     }
 
     void onPowerDown() override {
@@ -586,13 +345,13 @@ public:
             synchronized = false;
             setTestResult(TEST_FAILED);
         } else {
-            executeCommand(&setParams_command);
+            transport.executeCommand(&setParams_command);
         }
     }
 
     void resync() override {
         if (!synchronized) {
-            executeCommand(&getInfo_command);
+            transport.executeCommand(&getInfo_command);
         }
     }
 
@@ -686,7 +445,7 @@ public:
         for (int i = 0; i < NUM_RELAYS; i++) {
             char propName[16];
             snprintf(propName, sizeof(propName), "channelLabel%d", i+1);
-            READ_STRING_PROPERTY(propName, parameters->relayLabels[i], RELAY_LABEL_MAX_LENGTH);
+            READ_STRING_PROPERTY_BY_NAME(propName, parameters->relayLabels[i], RELAY_LABEL_MAX_LENGTH);
         }
 
         return false;
@@ -905,19 +664,25 @@ public:
 const Prel6Module::CommandDef Prel6Module::getInfo_command = {
 	COMMAND_GET_INFO,
 	nullptr,
-	&Prel6Module::Command_GetInfo_Done
+	&Prel6Module::Command_GetInfo_Done,
+	bp3c::COMMAND_PRIORITY_HIGH,
+	bp3c::COMMAND_FLAG_UNSYNCHRONIZED
 };
 
 const Prel6Module::CommandDef Prel6Module::getState_command = {
 	COMMAND_GET_STATE,
 	nullptr,
-	&Prel6Module::Command_GetState_Done
+	&Prel6Module::Command_GetState_Done,
+	bp3c::COMMAND_PRIORITY_LOW,
+	bp3c::COMMAND_FLAG_FUSABLE
 };
 
 const Prel6Module::CommandDef Prel6Module::setParams_command = {
 	COMMAND_SET_PARAMS,
 	&Prel6Module::Command_SetParams_FillRequest,
-	&Prel6Module::Command_SetParams_Done
+	&Prel6Module::Command_SetParams_Done,
+	bp3c::COMMAND_PRIORITY_HIGH,
+	bp3c::COMMAND_FLAG_FUSABLE
 };
 
 ////////////////////////////////////////////////////////////////////////////////
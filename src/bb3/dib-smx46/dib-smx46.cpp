@@ -46,6 +46,7 @@
 #include <bb3/psu/gui/edit_mode.h>
 #include <bb3/bp3c/comm.h>
 #include <bb3/bp3c/flash_slave.h>
+#include <bb3/bp3c/slot_transport.h>
 #include <bb3/psu/gui/edit_mode.h>
 
 #include <bb3/function_generator.h>
@@ -93,6 +94,14 @@ enum Command {
     COMMAND_SET_PARAMS = 0x4B723BFF
 };
 
+static const bp3c::SlotTransportConfig TRANSPORT_CONFIG = {
+    COMMAND_NONE,
+    NUM_REQUEST_RETRIES,
+    MAX_DMA_TRANSFER_ERRORS,
+    TIMEOUT_TIME_MS,
+    TIMEOUT_UNTIL_OUT_OF_SYNC_MS
+};
+
 using function_generator::Waveform;
 
 struct WaveformParameters {
@@ -155,51 +164,19 @@ public:
     bool synchronized = false;
 
     ////////////////////////////////////////
-    uint32_t input[(sizeof(Request) + 3) / 4 + 1];
-    uint32_t output[(sizeof(Request) + 3) / 4];
+    typedef bp3c::SlotTransport<Smx46Module, Request, Response> Transport;
+    typedef Transport::CommandDef CommandDef;
 
-    bool spiReady = false;
-    bool spiDmaTransferCompleted = false;
-    int spiDmaTransferStatus;
+    Transport transport;
 
-    uint32_t lastTransferTime = 0;
 	SetParams lastTransferredParams;
-	RelayParams lastTransferredRelayParams;
-    bool forceTransferSetParams;
-
-	struct CommandDef {
-		uint32_t command;
-		void (Smx46Module::*fillRequest)(Request &request);
-		void (Smx46Module::*done)(Response &response, bool isSuccess);
-	};
 
     static const CommandDef getInfo_command;
     static const CommandDef getState_command;
     static const CommandDef setParams_command;
 
-    enum State {
-        STATE_IDLE,
-
-        STATE_WAIT_SLAVE_READY_BEFORE_REQUEST,
-        STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST,
-
-        STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE,
-        STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE
-    };
-
-    enum Event {
-        EVENT_SLAVE_READY,
-        EVENT_DMA_TRANSFER_COMPLETED,
-        EVENT_DMA_TRANSFER_FAILED,
-        EVENT_TIMEOUT
-    };
-
-    const CommandDef *currentCommand = nullptr;
     uint32_t refreshStartTime;
-    State state;
-    uint32_t lastStateTransitionTime;
     uint32_t lastRefreshTime;
-    int retry;
     ////////////////////////////////////////
 
 
@@ -226,7 +203,7 @@ public:
     uint32_t lastWrittenPowerRelayCycles;
     psu::Interval relayCyclesWriteInterval = WRITE_ONTIME_INTERVAL * MIN_TO_MS;
 
-    Smx46Module() {
+    Smx46Module() : transport(this, TRANSPORT_CONFIG) {
         moduleType = MODULE_TYPE_DIB_SMX46;
         moduleName = "SMX46";
         moduleBrand = "Envox";
@@ -244,9 +221,6 @@ public:
         isResyncSupported = true;
 
         resetConfiguration();
-
-        memset(input, 0, sizeof(input));
-        memset(output, 0, sizeof(output));
     }
 
     void boot() override {
@@ -268,23 +242,10 @@ public:
         if (!synchronized) {
             setTestResult(TEST_CONNECTING);
 
-			executeCommand(&getInfo_command);
+			transport.executeCommand(&getInfo_command);
+            transport.runUntilIdle();
 
-            while (state != STATE_IDLE) {
-                WATCHDOG_RESET(WATCHDOG_LONG_OPERATION);
-#if defined(EEZ_PLATFORM_STM32)
-                if (HAL_GPIO_ReadPin(spi::IRQ_GPIO_Port[slotIndex], spi::IRQ_Pin[slotIndex]) == GPIO_PIN_RESET) {
-                    osDelay(1);
-                    if (HAL_GPIO_ReadPin(spi::IRQ_GPIO_Port[slotIndex], spi::IRQ_Pin[slotIndex]) == GPIO_PIN_RESET) {
-                        spiReady = true;
-                    }
-                }
-#endif
-                tick();
-                osDelay(1);
-            }
-
-            forceTransferSetParams = true;
+            transport.queueCommand(&setParams_command);
         }
 
         if (synchronized) {
@@ -348,7 +309,7 @@ public:
         routes = params.routes;
 		relayOn = params.relayOn ? true : false;
 
-        return bp3c::comm::updateParamsFinish(&params, &lastTransferredRelayParams, sizeof(RelayParams), 200, err);
+        return bp3c::comm::updateParamsFinish(slotIndex, 200, err);
     }
 
 	void fillSetParams(SetParams &params) {
@@ -384,15 +345,13 @@ public:
         if (isSuccess) {
             auto &data = response.setParams;
             if (data.result) {
-                SetParams &params = ((Request *)output)->setParams;
+                SetParams &params = transport.getRequest().setParams;
 
                 updateRelayCycles(lastTransferredParams.routes, params.routes, lastTransferredParams.relayOn, params.relayOn);
 
                 memcpy(&lastTransferredParams, &params, sizeof(SetParams));
 
-                memset(&lastTransferredRelayParams, 0, sizeof(RelayParams));
-                lastTransferredRelayParams.routes = params.routes;
-                lastTransferredRelayParams.relayOn = params.relayOn;
+                bp3c::comm::paramsTransferred(slotIndex, transport.getRequestParamsGeneration());
             }
         }
     }
@@ -403,260 +362,56 @@ public:
 		return REFRESH_TIME_MS;
 	}
 
-    void executeCommand(const CommandDef *command) {
-        currentCommand = command;
-        retry = 0;
-        setState(STATE_WAIT_SLAVE_READY_BEFORE_REQUEST);
-	}
-
-    bool startCommand() {
-		Request &request = *(Request *)output;
-
-		request.command = currentCommand->command;
-
-		if (currentCommand->fillRequest) {
-			(this->*currentCommand->fillRequest)(request);
-		}
-        spiReady = false;
-        spiDmaTransferCompleted = false;
-        auto status = bp3c::comm::transferDMA(slotIndex, (uint8_t *)output, (uint8_t *)input, sizeof(Request));
-        return status == bp3c::comm::TRANSFER_STATUS_OK;
-    }
-
-    bool getCommandResult() {
-        Request &request = *(Request *)output;
-        request.command = COMMAND_NONE;
-        spiReady = false;
-        spiDmaTransferCompleted = false;
-        auto status = bp3c::comm::transferDMA(slotIndex, (uint8_t *)output, (uint8_t *)input, sizeof(Request));
-        return status == bp3c::comm::TRANSFER_STATUS_OK;
-    }
-
-    bool isCommandResponse() {
-        Response &response = *(Response *)input;
-        return response.command == (0x8000 | currentCommand->command);
-    }
-
-    void doRetry() {
-    	bp3c::comm::abortTransfer(slotIndex);
-        
-        if (++retry < NUM_REQUEST_RETRIES) {
-            // try again
-            setState(STATE_WAIT_SLAVE_READY_BEFORE_REQUEST);
-        } else {
-            // give up
-            doCommandDone(false);
+    void pollCommands(uint32_t tickCountMs) {
+        if (!synchronized) {
+            return;
         }
-    }
 
-    void doCommandDone(bool isSuccess) {
-        if (isSuccess) {
-            lastTransferTime = millis();
+        // if set params is in flight compare with what is being transferred
+        auto request = transport.getInFlightRequest(&setParams_command);
+        auto paramsGeneration = bp3c::comm::getParamsGeneration(slotIndex);
+        SetParams params;
+        fillSetParams(params);
+        if (memcmp(&params, request ? &request->setParams : &lastTransferredParams, sizeof(SetParams)) != 0) {
+            transport.queueCommand(&setParams_command);
+        } else if (!request) {
+            // nothing to transfer, module already has these params
+            bp3c::comm::paramsTransferred(slotIndex, paramsGeneration);
         }
 
-		if (currentCommand->done) {
-			Response &response = *(Response *)input;
-			(this->*currentCommand->done)(response, isSuccess);
-		}
-
-        if (powerDown) {
-            synchronized = false;
-            setTestResult(TEST_FAILED);
+        if (tickCountMs - lastRefreshTime >= getRefreshTimeMs() && !transport.isCommandPending(&getState_command)) {
+            refreshStartTime = tickCountMs;
+            transport.queueCommand(&getState_command);
         }
-
-		currentCommand = nullptr;
-        setState(STATE_IDLE);
-    }
-
-    void setState(State newState) {
-        state = newState;
-        lastStateTransitionTime = millis();
-    }
-
-    void stateTransition(Event event) {
-    	if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-            numCrcErrors = 0;
-            numTransferErrors = 0;
-    	}
- 
-        if (state == STATE_WAIT_SLAVE_READY_BEFORE_REQUEST) {
-            if (event == EVENT_TIMEOUT) {
-				doRetry();
-            } else if (event == EVENT_SLAVE_READY) {
-                if (startCommand()) {
-                    setState(STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST);
-                } else {
-                    doRetry();
-                }
-            }
-        } else if (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST) {
-            if (event == EVENT_TIMEOUT) {
-                doRetry();
-            } else if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-                setState(STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE);
-            } else if (event == EVENT_DMA_TRANSFER_FAILED) {
-                doRetry();
-            }
-        } else if (state == STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE) {
-            if (event == EVENT_TIMEOUT) {
-				doRetry();
-            } else if (event == EVENT_SLAVE_READY) {
-                if (getCommandResult()) {
-                    setState(STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE);
-                } else {
-                    doRetry();
-                }
-            }
-        } else if (state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE) {
-            if (event == EVENT_TIMEOUT) {
-                doRetry();
-            } else if (event == EVENT_DMA_TRANSFER_COMPLETED) {
-                if (isCommandResponse()) {
-                    doCommandDone(true);
-                } else {
-                    doRetry();
-                }
-            } else if (event == EVENT_DMA_TRANSFER_FAILED) {
-                doRetry();
-            }
-        } 
     }
 
-    int numCrcErrors = 0;
-    int numTransferErrors = 0;
-
-    void reportDmaTransferFailed(int status) {
-        if (status == bp3c::comm::TRANSFER_STATUS_CRC_ERROR) {
-            numCrcErrors++;
-            if (numCrcErrors >= MAX_DMA_TRANSFER_ERRORS) {
-                event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_CRC_CHECK_ERROR + slotIndex);
-                synchronized = false;
-                setTestResult(TEST_FAILED);
-            }
-            //else if (numCrcErrors > 5) {
-            //    DebugTrace("Slot %d CRC error no. %d\n", slotIndex + 1, numCrcErrors);
-            //}
-        } else {
-            numTransferErrors++;
-            if (numTransferErrors >= MAX_DMA_TRANSFER_ERRORS) {
-                event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR + slotIndex);
-                synchronized = false;
-                setTestResult(TEST_FAILED);
-            }
-            //else if (numTransferErrors > 5) {
-            //    DebugTrace("Slot %d SPI transfer error %d no. %d\n", slotIndex + 1, status, numTransferErrors);
-            //}
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    void fillSimulatorResponse(const CommandDef *command, bool isRequestTransfer, Response &response) {
+        if (command->command == COMMAND_GET_INFO) {
+            response.getInfo.moduleType = MODULE_TYPE_DIB_SMX46;
+            response.getInfo.firmwareMajorVersion = 1;
+            response.getInfo.firmwareMinorVersion = 0;
+            response.getInfo.idw0 = 0;
+            response.getInfo.idw1 = 0;
+            response.getInfo.idw2 = 0;
         }
     }
+#endif
 
     void tick() override {
         if (relayCyclesWriteInterval.test()) {
             sendMessageToLowPriorityThread((LowPriorityThreadMessage)THREAD_MESSAGE_SAVE_RELAY_CYCLES, slotIndex);
         }
 
-        if (currentCommand) {
-            if (!synchronized && currentCommand->command != COMMAND_GET_INFO) {
-                doCommandDone(false);
-            } else {
-                if (
-                    state == STATE_WAIT_SLAVE_READY_BEFORE_REQUEST ||
-                    state == STATE_WAIT_SLAVE_READY_BEFORE_RESPONSE
-                ) {
-                    #if defined(EEZ_PLATFORM_STM32)
-                	if (spiReady) {
-                		stateTransition(EVENT_SLAVE_READY);
-                	}
-                    #endif
-
-                    #if defined(EEZ_PLATFORM_SIMULATOR)
-                    stateTransition(EVENT_SLAVE_READY);
-                    #endif
-                } 
-                
-                if (
-                    state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_REQUEST ||
-                    state == STATE_WAIT_DMA_TRANSFER_COMPLETED_FOR_RESPONSE
-                ) {
-                
-                    #if defined(EEZ_PLATFORM_STM32)
-                    if (spiDmaTransferCompleted) {
-                        if (spiDmaTransferStatus == bp3c::comm::TRANSFER_STATUS_OK) {
-                            stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-                        } else {
-                            reportDmaTransferFailed(spiDmaTransferStatus);
-                            stateTransition(EVENT_DMA_TRANSFER_FAILED);
-                        }
-                    }
-                    #endif                
-
-                    #if defined(EEZ_PLATFORM_SIMULATOR)
-                    auto response = (Response *)input;
-
-                    response->command = 0x8000 | currentCommand->command;
-
-                    if (currentCommand->command == COMMAND_GET_INFO) {
-						response->getInfo.moduleType = MODULE_TYPE_DIB_SMX46;
-                        response->getInfo.firmwareMajorVersion = 1;
-                        response->getInfo.firmwareMinorVersion = 0;
-                        response->getInfo.idw0 = 0;
-                        response->getInfo.idw1 = 0;
-                        response->getInfo.idw2 = 0;
-                    }
-
-                    stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-                    #endif
-                } 
-                
-                uint32_t tickCountMs = millis();
-                if (tickCountMs - lastStateTransitionTime >= TIMEOUT_TIME_MS) {
-                    stateTransition(EVENT_TIMEOUT);
-                }
-            }
-        } else {
-            if (synchronized) {
-            	uint32_t tickCountMs = millis();
-                if (tickCountMs - lastTransferTime >= TIMEOUT_UNTIL_OUT_OF_SYNC_MS) {
-#ifdef EEZ_PLATFORM_STM32                
-                    event_queue::pushEvent(event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR + slotIndex);
-                    synchronized = false;
-                    setTestResult(TEST_FAILED);
-#endif
-                } else if (tickCountMs - lastRefreshTime >= getRefreshTimeMs()) {
-                    refreshStartTime = tickCountMs;
-                    executeCommand(&getState_command);
-                } else if (forceTransferSetParams) {
-                    forceTransferSetParams = false;
-                    executeCommand(&setParams_command);
-                } else {
-                    SetParams params;
-                    fillSetParams(params);
-                    if (memcmp(&params, &lastTransferredParams, sizeof(SetParams)) != 0) {
-                        executeCommand(&setParams_command);
-                    }
-                }
-            }
-        }
+        transport.tick();
     }
 
     void onSpiIrq() override {
-        spiReady = true;
-		// if (g_isBooted) {
-		// 	stateTransition(EVENT_SLAVE_READY);
-		// }
+        transport.onSpiIrq();
     }
 
     void onSpiDmaTransferCompleted(int status) override {
-        //  if (g_isBooted) {
-        //      if (status == bp3c::comm::TRANSFER_STATUS_OK) {
-        //          stateTransition(EVENT_DMA_TRANSFER_COMPLETED);
-        //      } else {
-        //          reportDmaTransferFailed(status);
-        //          stateTransition(EVENT_DMA_TRANSFER_FAILED);
-        //      }
-        //  } else {
-             spiDmaTransferCompleted = true;
-             spiDmaTransferStatus = status;
-        //  }
+        transport.onSpiDmaTransferCompleted(status);
     }
 
     void onPowerDown() override {
@@ -665,13 +420,13 @@ public:
             synchronized = false;
             setTestResult(TEST_FAILED);
         } else {
-            executeCommand(&setParams_command);
+            transport.executeCommand(&setParams_command);
         }
     }
 
     void resync() override {
         if (!synchronized) {
-            executeCommand(&getInfo_command);
+            transport.executeCommand(&getInfo_command);
         }
     }
 
@@ -856,13 +611,13 @@ public:
         for (int i = 0; i < NUM_COLUMNS; i++) {
             char propName[16];
             snprintf(propName, sizeof(propName), "xLabel%d", i+1);
-            READ_STRING_PROPERTY(propName, parameters->columnLabels[i], MAX_SWITCH_MATRIX_LABEL_LENGTH);
+            READ_STRING_PROPERTY_BY_NAME(propName, parameters->columnLabels[i], MAX_SWITCH_MATRIX_LABEL_LENGTH);
         }
 
         for (int i = 0; i < NUM_ROWS; i++) {
             char propName[16];
             snprintf(propName, sizeof(propName), "yLabel%d", i+1);
-            READ_STRING_PROPERTY(propName, parameters->rowLabels[i], MAX_SWITCH_MATRIX_LABEL_LENGTH);
+            READ_STRING_PROPERTY_BY_NAME(propName, parameters->rowLabels[i], MAX_SWITCH_MATRIX_LABEL_LENGTH);
         }
 
         READ_PROPERTY("aout1Value", parameters->aoutValue[0]);
@@ -1424,19 +1179,25 @@ public:
 const Smx46Module::CommandDef Smx46Module::getInfo_command = {
 	COMMAND_GET_INFO,
 	nullptr,
-	&Smx46Module::Command_GetInfo_Done
+	&Smx46Module::Command_GetInfo_Done,
+	bp3c::COMMAND_PRIORITY_HIGH,
+	bp3c::COMMAND_FLAG_UNSYNCHRONIZED
 };
 
 const Smx46Module::CommandDef Smx46Module::getState_command = {
 	COMMAND_GET_STATE,
 	nullptr,
-	&Smx46Module::Command_GetState_Done
+	&Smx46Module::Command_GetState_Done,
+	bp3c::COMMAND_PRIORITY_LOW,
+	bp3c::COMMAND_FLAG_FUSABLE
 };
 
 const Smx46Module::CommandDef Smx46Module::setParams_command = {
 	COMMAND_SET_PARAMS,
 	&Smx46Module::Command_SetParams_FillRequest,
-	&Smx46Module::Command_SetParams_Done
+	&Smx46Module::Command_SetParams_Done,
+	bp3c::COMMAND_PRIORITY_HIGH,
+	bp3c::COMMAND_FLAG_FUSABLE
 };
 
 ////////////////////////////////////////////////////////////////////////////////
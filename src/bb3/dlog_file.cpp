@@ -259,6 +259,23 @@ void Writer::writeInt24(uint8_t *value) {
 	}
 }
 
+void Writer::writeBlock(const uint8_t *data, uint32_t size) {
+    while (size > 0) {
+        uint32_t index = m_bufferIndex % m_bufferSize;
+        uint32_t n = m_bufferSize - index;
+        if (n > size) {
+            n = size;
+        }
+
+        memcpy(m_buffer + index, data, n);
+
+        data += n;
+        size -= n;
+        m_bufferIndex += n;
+        m_fileLength += n;
+    }
+}
+
 void Writer::writeUint8Field(uint8_t id, uint8_t value) {
     writeUint16(sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint8_t));
     writeUint8(id);
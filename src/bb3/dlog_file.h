@@ -214,6 +214,9 @@ public:
     void writeInt16(uint8_t *value);
     void writeInt24(uint8_t *value);
 
+    // copies raw row data into the buffer, caller must flushBits() first
+    void writeBlock(const uint8_t *data, uint32_t size);
+
     void flushBits();
 
     uint8_t *getBuffer() { return m_buffer; }
@@ -0,0 +1,433 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2022-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Native execution of the most common instrument access commands and queries
+// found in the flow SCPI component (measurements, output state, voltage and
+// current level). They are executed directly through the channel_dispatcher
+// and the result is returned as a typed Value, i.e. without round trip through
+// the low priority thread, SCPI parser and text formatting of the result.
+//
+// Anything that is not recognized here, or doesn't pass the checks, is left
+// to the SCPI parser, so the errors reported to the flow are the same.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <eez/flow/flow.h>
+
+#include <bb3/psu/psu.h>
+#include <bb3/psu/channel_dispatcher.h>
+#include <bb3/psu/trigger.h>
+#include <bb3/psu/scpi/psu.h>
+
+using namespace eez::psu;
+using namespace eez::psu::scpi;
+
+namespace eez {
+namespace flow {
+
+extern scpi_t g_scpiContext;
+
+static const int MAX_PARAMS = 2;
+
+struct InstrumentCommand {
+    const char *header;
+    size_t headerLen;
+    int numParams;
+    const char *params[MAX_PARAMS];
+    size_t paramsLen[MAX_PARAMS];
+};
+
+static const char *skipSpaces(const char *text) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    return text;
+}
+
+static size_t trimTrailingSpaces(const char *text, size_t len) {
+    while (len > 0 && (text[len - 1] == ' ' || text[len - 1] == '\t')) {
+        len--;
+    }
+    return len;
+}
+
+// Splits "HEADER param1,param2" into header and parameters. Compound commands,
+// quoted strings and expressions are not handled natively.
+static bool splitCommand(const char *text, InstrumentCommand &command) {
+    if (strpbrk(text, ";\"'#\r\n")) {
+        return false;
+    }
+
+    text = skipSpaces(text);
+
+    const char *p = text;
+    while (*p && *p != ' ' && *p != '\t') {
+        // numeric suffix in header (e.g. SOUR2:VOLT) selects the channel, leave it to the SCPI parser
+        if (isdigit(*p)) {
+            return false;
+        }
+        p++;
+    }
+
+    command.header = text;
+    command.headerLen = p - text;
+    if (command.headerLen == 0) {
+        return false;
+    }
+
+    command.numParams = 0;
+
+    p = skipSpaces(p);
+    while (*p) {
+        if (command.numParams == MAX_PARAMS) {
+            return false;
+        }
+
+        const char *param = skipSpaces(p);
+        const char *end = strchr(param, ',');
+        size_t paramLen = end ? end - param : strlen(param);
+
+        command.params[command.numParams] = param;
+        command.paramsLen[command.numParams] = trimTrailingSpaces(param, paramLen);
+        command.numParams++;
+
+        if (!end) {
+            break;
+        }
+
+        p = end + 1;
+        if (!*skipSpaces(p)) {
+            // trailing comma
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool isQuery(const InstrumentCommand &command) {
+    return command.header[command.headerLen - 1] == '?';
+}
+
+static bool matchHeader(const InstrumentCommand &command, const char *pattern) {
+    return SCPI_Match(pattern, command.header, command.headerLen);
+}
+
+static bool parseUInt(const char *text, size_t len, int &value) {
+    if (len == 0 || len > 4) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!isdigit(text[i])) {
+            return false;
+        }
+        value = value * 10 + text[i] - '0';
+    }
+    return true;
+}
+
+static bool parseFloat(const char *text, size_t len, float &value) {
+    char buffer[32];
+    if (len == 0 || len >= sizeof(buffer)) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        // no units, special numbers (MIN, MAX, ...) or non decimal numbers
+        if (!isdigit(text[i]) && !strchr("+-.eE", text[i])) {
+            return false;
+        }
+        buffer[i] = text[i];
+    }
+    buffer[len] = 0;
+
+    char *end;
+    value = strtof(buffer, &end);
+    return end == buffer + len && !isinf(value);
+}
+
+static bool parseBool(const char *text, size_t len, bool &value) {
+    if ((len == 1 && text[0] == '1') || (len == 2 && strncasecmp(text, "ON", 2) == 0)) {
+        value = true;
+        return true;
+    }
+    if ((len == 1 && text[0] == '0') || (len == 3 && strncasecmp(text, "OFF", 3) == 0)) {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+// Channel parameter is optional, CH<n> and (@<n>) forms are recognized.
+// If it is omitted, the channel selected with INSTrument[:SELect] is used.
+static bool getChannel(const InstrumentCommand &command, int paramIndex, SlotAndSubchannelIndex &slotAndSubchannelIndex) {
+    if (paramIndex >= command.numParams) {
+        auto selectedChannel = getSelectedChannel(&g_scpiContext);
+        if (!selectedChannel) {
+            return false;
+        }
+        slotAndSubchannelIndex = *selectedChannel;
+    } else {
+        const char *param = command.params[paramIndex];
+        size_t paramLen = command.paramsLen[paramIndex];
+
+        int absoluteChannelIndex;
+        if (paramLen == 3 && strncasecmp(param, "CH", 2) == 0 && param[2] >= '1' && param[2] <= '6') {
+            absoluteChannelIndex = param[2] - '1';
+        } else if (paramLen > 3 && param[0] == '(' && param[1] == '@' && param[paramLen - 1] == ')') {
+            if (!parseUInt(param + 2, paramLen - 3, absoluteChannelIndex)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+
+        if (!absoluteChannelIndexToSlotAndSubchannelIndex(absoluteChannelIndex, slotAndSubchannelIndex)) {
+            return false;
+        }
+    }
+
+    // power channel must be in good state, otherwise SCPI parser will report the error
+    auto channel = Channel::getBySlotIndex(slotAndSubchannelIndex.slotIndex, slotAndSubchannelIndex.subchannelIndex);
+    if (channel && !(g_powerIsUp && !channel->isTestFailed() && channel->isOk())) {
+        return false;
+    }
+
+    return true;
+}
+
+static Channel *getPowerChannel(const InstrumentCommand &command, int paramIndex) {
+    SlotAndSubchannelIndex slotAndSubchannelIndex;
+    if (!getChannel(command, paramIndex, slotAndSubchannelIndex)) {
+        return nullptr;
+    }
+    return Channel::getBySlotIndex(slotAndSubchannelIndex.slotIndex, slotAndSubchannelIndex.subchannelIndex);
+}
+
+// for the commands without channel parameter, i.e. [SOURce]:VOLTage and [SOURce]:CURRent
+static Channel *getSelectedPowerChannel(const InstrumentCommand &command) {
+    return getPowerChannel(command, command.numParams);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool measure(const InstrumentCommand &command, bool voltage, bool current, Value &result) {
+    if (command.numParams > 1) {
+        return false;
+    }
+
+    SlotAndSubchannelIndex slotAndSubchannelIndex;
+    if (!getChannel(command, 0, slotAndSubchannelIndex)) {
+        return false;
+    }
+
+    int err;
+
+    float u = 1.0f;
+    if (voltage && !channel_dispatcher::getMeasuredVoltage(slotAndSubchannelIndex.slotIndex, slotAndSubchannelIndex.subchannelIndex, u, &err)) {
+        return false;
+    }
+
+    float i = 1.0f;
+    if (current && !channel_dispatcher::getMeasuredCurrent(slotAndSubchannelIndex.slotIndex, slotAndSubchannelIndex.subchannelIndex, i, &err)) {
+        return false;
+    }
+
+    result = Value(u * i, VALUE_TYPE_FLOAT);
+    return true;
+}
+
+static bool measureDigital(const InstrumentCommand &command, Value &result) {
+    if (command.numParams > 1) {
+        return false;
+    }
+
+    SlotAndSubchannelIndex slotAndSubchannelIndex;
+    if (!getChannel(command, 0, slotAndSubchannelIndex)) {
+        return false;
+    }
+
+    uint8_t data;
+    int err;
+    if (!channel_dispatcher::getDigitalInputData(slotAndSubchannelIndex.slotIndex, slotAndSubchannelIndex.subchannelIndex, data, &err)) {
+        return false;
+    }
+
+    result = Value((int)data, VALUE_TYPE_INT32);
+    return true;
+}
+
+static bool getOutputState(const InstrumentCommand &command, Value &result) {
+    if (command.numParams > 1) {
+        return false;
+    }
+
+    auto channel = getPowerChannel(command, 0);
+    if (!channel) {
+        return false;
+    }
+
+    result = Value(channel->isOutputEnabled() ? 1 : 0, VALUE_TYPE_INT32);
+    return true;
+}
+
+static bool setOutputState(const InstrumentCommand &command) {
+    bool enable;
+    if (command.numParams < 1 || command.numParams > 2 || !parseBool(command.params[0], command.paramsLen[0], enable)) {
+        return false;
+    }
+
+    auto channel = getPowerChannel(command, 1);
+    if (!channel) {
+        return false;
+    }
+
+    // same as scpi_cmd_outputState: tests the calibration and the trigger state (trigger abort),
+    // nothing is changed if this fails, SCPI parser will do the same test and report the error
+    uint8_t channelIndex = channel->channelIndex;
+    int err;
+    return channel_dispatcher::outputEnable(1, &channelIndex, enable, &err);
+}
+
+static bool setVoltage(const InstrumentCommand &command) {
+    float voltage;
+    // the only parameter is the value, there is no channel parameter (as in SCPI parser)
+    if (command.numParams != 1 || !parseFloat(command.params[0], command.paramsLen[0], voltage)) {
+        return false;
+    }
+
+    auto channel = getSelectedPowerChannel(command);
+    if (!channel) {
+        return false;
+    }
+
+    if (voltage < channel_dispatcher::getUMin(*channel) || voltage > channel_dispatcher::getUMax(*channel)) {
+        return false;
+    }
+
+    if (channel_dispatcher::getVoltageTriggerMode(*channel) != TRIGGER_MODE_FIXED && !trigger::isIdle()) {
+        return false;
+    }
+
+    if (channel->isRemoteProgrammingEnabled()) {
+        return false;
+    }
+
+    if (channel->isVoltageLimitExceeded(voltage)) {
+        return false;
+    }
+
+    int err;
+    if (channel->isPowerLimitExceeded(voltage, channel_dispatcher::getISet(*channel), &err)) {
+        return false;
+    }
+
+    channel_dispatcher::setVoltage(*channel, voltage);
+    return true;
+}
+
+static bool setCurrent(const InstrumentCommand &command) {
+    float current;
+    // the only parameter is the value, there is no channel parameter (as in SCPI parser)
+    if (command.numParams != 1 || !parseFloat(command.params[0], command.paramsLen[0], current)) {
+        return false;
+    }
+
+    auto channel = getSelectedPowerChannel(command);
+    if (!channel) {
+        return false;
+    }
+
+    if (current < channel_dispatcher::getIMin(*channel) || current > channel_dispatcher::getIMax(*channel)) {
+        return false;
+    }
+
+    if (channel_dispatcher::getCurrentTriggerMode(*channel) != TRIGGER_MODE_FIXED && !trigger::isIdle()) {
+        return false;
+    }
+
+    if (channel->isCurrentLimitExceeded(current)) {
+        return false;
+    }
+
+    int err;
+    if (channel->isPowerLimitExceeded(channel_dispatcher::getUSet(*channel), current, &err)) {
+        return false;
+    }
+
+    channel_dispatcher::setCurrent(*channel, current);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool executeInstrumentQuery(const char *queryText, Value &result) {
+    InstrumentCommand command;
+    if (!splitCommand(queryText, command) || !isQuery(command)) {
+        return false;
+    }
+
+    if (matchHeader(command, "MEASure[:SCALar][:VOLTage][:DC]?")) {
+        return measure(command, true, false, result);
+    }
+
+    if (matchHeader(command, "MEASure[:SCALar]:CURRent[:DC]?")) {
+        return measure(command, false, true, result);
+    }
+
+    if (matchHeader(command, "MEASure[:SCALar]:POWer[:DC]?")) {
+        return measure(command, true, true, result);
+    }
+
+    if (matchHeader(command, "MEASure:DIGital[:BYTE]?")) {
+        return measureDigital(command, result);
+    }
+
+    if (matchHeader(command, "OUTPut[:STATe]?")) {
+        return getOutputState(command, result);
+    }
+
+    return false;
+}
+
+bool executeInstrumentCommand(const char *commandText) {
+    InstrumentCommand command;
+    if (!splitCommand(commandText, command) || isQuery(command)) {
+        return false;
+    }
+
+    if (matchHeader(command, "OUTPut[:STATe]")) {
+        return setOutputState(command);
+    }
+
+    if (matchHeader(command, "[SOURce]:VOLTage[:LEVel][:IMMediate][:AMPLitude]")) {
+        return setVoltage(command);
+    }
+
+    if (matchHeader(command, "[SOURce]:CURRent[:LEVel][:IMMediate][:AMPLitude]")) {
+        return setCurrent(command);
+    }
+
+    return false;
+}
+
+} // namespace flow
+} // namespace eez
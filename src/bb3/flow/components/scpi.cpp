@@ -214,6 +214,25 @@ struct ScpiComponentExecutionState : public ComponenentExecutionState {
 ScpiComponentExecutionState *ScpiComponentExecutionState::g_waitingForScpiResult;
 bool ScpiComponentExecutionState::g_scpiResultIsReady;
 
+// instrument.cpp
+bool executeInstrumentQuery(const char *queryText, Value &result);
+bool executeInstrumentCommand(const char *commandText);
+
+// Common queries and commands are executed natively, i.e. without going through
+// the low priority thread. This is not done while some other SCPI component
+// is waiting for the result, to keep the order of execution.
+static bool executeNatively(ScpiComponentExecutionState *scpiComponentExecutionState, Value *queryResult) {
+	if (scpiComponentExecutionState->g_waitingForScpiResult) {
+		return false;
+	}
+
+	if (queryResult) {
+		return executeInstrumentQuery(scpiComponentExecutionState->commandOrQueryText, *queryResult);
+	}
+
+	return executeInstrumentCommand(scpiComponentExecutionState->commandOrQueryText);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void scpiComponentInit() {
@@ -302,30 +321,56 @@ void executeScpiComponent(FlowState *flowState, unsigned componentIndex) {
 				logScpiQuery(flowState, componentIndex, scpiComponentExecutionState->commandOrQueryText);
 			}
 
-            auto scpiResultStatus = scpiComponentExecutionState->scpi();
-			if (scpiResultStatus != SCPI_RESULT_STATUS_READY) {
-				if (!addToQueue(flowState, componentIndex, -1, -1, -1, scpiResultStatus == SCPI_RESULT_STATUS_NOT_READY)) {
-					throwError(flowState, componentIndex, "Execution queue is full\n");
+			Value srcValue;
+			if (executeNatively(scpiComponentExecutionState, &srcValue)) {
+				if (g_debuggerIsConnected) {
+					char resultText[64];
+					srcValue.toText(resultText, sizeof(resultText));
+					logScpiQueryResult(flowState, componentIndex, resultText, strlen(resultText));
+				}
+			} else {
+				auto scpiResultStatus = scpiComponentExecutionState->scpi();
+				if (scpiResultStatus != SCPI_RESULT_STATUS_READY) {
+					if (!addToQueue(flowState, componentIndex, -1, -1, -1, scpiResultStatus == SCPI_RESULT_STATUS_NOT_READY)) {
+						throwError(flowState, componentIndex, "Execution queue is full\n");
+					}
+					return;
 				}
-				return;
-			}
 
-			const char *resultText;
-			size_t resultTextLen;
-			int err = 0;
-			if (!getLatestScpiResult(&resultText, &resultTextLen, &err)) {
-				char errorMessage[300];
-				snprintf(errorMessage, sizeof(errorMessage), "%s\n", SCPI_ErrorTranslate(err));
+				const char *resultText;
+				size_t resultTextLen;
+				int err = 0;
+				if (!getLatestScpiResult(&resultText, &resultTextLen, &err)) {
+					char errorMessage[300];
+					snprintf(errorMessage, sizeof(errorMessage), "%s\n", SCPI_ErrorTranslate(err));
 
-				throwError(flowState, componentIndex, errorMessage);
+					throwError(flowState, componentIndex, errorMessage);
 
-				ObjectAllocator<ScpiComponentExecutionState>::deallocate(scpiComponentExecutionState);
-				flowState->componenentExecutionStates[componentIndex] = nullptr;
+					ObjectAllocator<ScpiComponentExecutionState>::deallocate(scpiComponentExecutionState);
+					flowState->componenentExecutionStates[componentIndex] = nullptr;
 
-				return;
-			}
+					return;
+				}
 
-			logScpiQueryResult(flowState, componentIndex, resultText, resultTextLen);
+				logScpiQueryResult(flowState, componentIndex, resultText, resultTextLen);
+
+				if (parseScpiString(resultText, resultTextLen)) {
+					srcValue = Value::makeStringRef(resultText, resultTextLen, 0x09143fa4);
+				} else {
+					char *strEnd;
+					long num = strtol(resultText, &strEnd, 10);
+					if (strEnd == resultText + resultTextLen) {
+						srcValue = Value((int)num, VALUE_TYPE_INT32);
+					} else {
+						float fnum = strtof(resultText, &strEnd);
+						if (strEnd == resultText + resultTextLen) {
+							srcValue = Value(fnum, VALUE_TYPE_FLOAT);
+						} else {
+							srcValue = Value::makeStringRef(resultText, resultTextLen, 0x09143fa4);
+						}
+					}
+				}
+			}
 
 			Value dstValue;
 			int numInstructionBytes;
@@ -339,51 +384,36 @@ void executeScpiComponent(FlowState *flowState, unsigned componentIndex) {
 
 			scpiComponentExecutionState->commandOrQueryText[0] = 0;
 
-			Value srcValue;
-			if (parseScpiString(resultText, resultTextLen)) {
-				srcValue = Value::makeStringRef(resultText, resultTextLen, 0x09143fa4);
-			} else {
-				char *strEnd;
-				long num = strtol(resultText, &strEnd, 10);
-				if (strEnd == resultText + resultTextLen) {
-					srcValue = Value((int)num, VALUE_TYPE_INT32);
-				} else {
-					float fnum = strtof(resultText, &strEnd);
-					if (strEnd == resultText + resultTextLen) {
-						srcValue = Value(fnum, VALUE_TYPE_FLOAT);
-					} else {
-						srcValue = Value::makeStringRef(resultText, resultTextLen, 0x09143fa4);
-					}
-				}
-			}
-
 			assignValue(flowState, componentIndex, dstValue, srcValue);
 		} else if (scpiComponentExecutionState->op == SCPI_PART_QUERY) {
 			if (!scpiComponentExecutionState->g_waitingForScpiResult) {
 				logScpiQuery(flowState, componentIndex, scpiComponentExecutionState->commandOrQueryText);
 			}
 
-            auto scpiResultStatus = scpiComponentExecutionState->scpi();
-			if (scpiResultStatus != SCPI_RESULT_STATUS_READY) {
-				if (!addToQueue(flowState, componentIndex, -1, -1, -1, scpiResultStatus == SCPI_RESULT_STATUS_NOT_READY)) {
-					throwError(flowState, componentIndex, "Execution queue is full\n");
+			Value queryResult;
+			if (!executeNatively(scpiComponentExecutionState, &queryResult)) {
+				auto scpiResultStatus = scpiComponentExecutionState->scpi();
+				if (scpiResultStatus != SCPI_RESULT_STATUS_READY) {
+					if (!addToQueue(flowState, componentIndex, -1, -1, -1, scpiResultStatus == SCPI_RESULT_STATUS_NOT_READY)) {
+						throwError(flowState, componentIndex, "Execution queue is full\n");
+					}
+					return;
 				}
-				return;
-			}
 
-			const char *resultText;
-			size_t resultTextLen;
-			int err = 0;
-			if (!getLatestScpiResult(&resultText, &resultTextLen, &err)) {
-				char errorMessage[300];
-				snprintf(errorMessage, sizeof(errorMessage), "%s\n", SCPI_ErrorTranslate(err));
+				const char *resultText;
+				size_t resultTextLen;
+				int err = 0;
+				if (!getLatestScpiResult(&resultText, &resultTextLen, &err)) {
+					char errorMessage[300];
+					snprintf(errorMessage, sizeof(errorMessage), "%s\n", SCPI_ErrorTranslate(err));
 
-				throwError(flowState, componentIndex, errorMessage);
+					throwError(flowState, componentIndex, errorMessage);
 
-				ObjectAllocator<ScpiComponentExecutionState>::deallocate(scpiComponentExecutionState);
-				flowState->componenentExecutionStates[componentIndex] = nullptr;
+					ObjectAllocator<ScpiComponentExecutionState>::deallocate(scpiComponentExecutionState);
+					flowState->componenentExecutionStates[componentIndex] = nullptr;
 
-				return;
+					return;
+				}
 			}
 
 			scpiComponentExecutionState->commandOrQueryText[0] = 0;
@@ -392,27 +422,29 @@ void executeScpiComponent(FlowState *flowState, unsigned componentIndex) {
 				logScpiCommand(flowState, componentIndex, scpiComponentExecutionState->commandOrQueryText);
 			}
 
-            auto scpiResultStatus = scpiComponentExecutionState->scpi();
-			if (scpiResultStatus != SCPI_RESULT_STATUS_READY) {
-				if (!addToQueue(flowState, componentIndex, -1, -1, -1, scpiResultStatus == SCPI_RESULT_STATUS_NOT_READY)) {
-					throwError(flowState, componentIndex, "Execution queue is full\n");
+			if (!executeNatively(scpiComponentExecutionState, nullptr)) {
+				auto scpiResultStatus = scpiComponentExecutionState->scpi();
+				if (scpiResultStatus != SCPI_RESULT_STATUS_READY) {
+					if (!addToQueue(flowState, componentIndex, -1, -1, -1, scpiResultStatus == SCPI_RESULT_STATUS_NOT_READY)) {
+						throwError(flowState, componentIndex, "Execution queue is full\n");
+					}
+					return;
 				}
-				return;
-			}
 
-			const char *resultText;
-			size_t resultTextLen;
-			int err = 0;
-			if (!getLatestScpiResult(&resultText, &resultTextLen, &err)) {
-				char errorMessage[300];
-				snprintf(errorMessage, sizeof(errorMessage), "%s\n", SCPI_ErrorTranslate(err));
+				const char *resultText;
+				size_t resultTextLen;
+				int err = 0;
+				if (!getLatestScpiResult(&resultText, &resultTextLen, &err)) {
+					char errorMessage[300];
+					snprintf(errorMessage, sizeof(errorMessage), "%s\n", SCPI_ErrorTranslate(err));
 
-				throwError(flowState, componentIndex, errorMessage);
+					throwError(flowState, componentIndex, errorMessage);
 
-				ObjectAllocator<ScpiComponentExecutionState>::deallocate(scpiComponentExecutionState);
-				flowState->componenentExecutionStates[componentIndex] = nullptr;
+					ObjectAllocator<ScpiComponentExecutionState>::deallocate(scpiComponentExecutionState);
+					flowState->componenentExecutionStates[componentIndex] = nullptr;
 
-				return;
+					return;
+				}
 			}
 
 			scpiComponentExecutionState->commandOrQueryText[0] = 0;
@@ -36,11 +36,14 @@
 #include <bb3/psu/channel_dispatcher.h>
 #include <bb3/psu/profile.h>
 #include <bb3/psu/trigger.h>
+#include <bb3/psu/sd_card.h>
 #include <bb3/psu/gui/psu.h>
 #include <bb3/psu/gui/edit_mode.h>
 
 #include <bb3/psu/scpi/psu.h>
 
+#include <eez/fs/fs.h>
+
 #define M_PI_F ((float)M_PI)
 
 using namespace eez::function_generator;
@@ -172,8 +175,6 @@ SelectedResources g_selectedResources;
 
 ////////////////////////////////////////////////////////////////////////////////
 
-typedef float(*WaveformFunction)(float);
-
 bool g_active;
 
 FunctionGeneratorOptions g_options = {
@@ -189,114 +190,180 @@ float g_previewPeriod = PREVIEW_PERIOD_DEF;
 int g_funcGenChannelIndex;
 uint64_t g_tickCountAtStart;
 
-WaveformFunction g_waveFormFuncU[CH_MAX];
-float g_phiU[CH_MAX];
-float g_dphiU[CH_MAX];
-float g_amplitudeU[CH_MAX];
-float g_offsetU[CH_MAX];
-float g_dutyCycleU[CH_MAX];
-float g_freqU[CH_MAX];
-bool g_isDcSetU[CH_MAX];
-
-WaveformFunction g_waveFormFuncI[CH_MAX];
-float g_phiI[CH_MAX];
-float g_dphiI[CH_MAX];
-float g_amplitudeI[CH_MAX];
-float g_offsetI[CH_MAX];
-float g_dutyCycleI[CH_MAX];
-bool g_isDcSetI[CH_MAX];
+// Waveform is synthesized from the 32-bit phase accumulator, full uint32_t range
+// is one period. Phase at tick N is phaseAtStart + N * phaseIncrement, it wraps
+// around by itself and doesn't drift however long the generator runs.
+enum SynthesizerShape {
+	SHAPE_DC,
+	SHAPE_TABLE,
+	SHAPE_HALF_RECTIFIED,
+	SHAPE_FULL_RECTIFIED,
+	SHAPE_TRIANGLE,
+	SHAPE_SAWTOOTH,
+	SHAPE_PULSE
+};
+
+struct Synthesizer {
+	SynthesizerShape shape;
+	const float *table;
+	int tableSizeBits;
+	uint32_t phaseAtStart;
+	uint32_t phaseIncrement;
+	uint32_t dutyPhase; // SHAPE_PULSE is high while phase < dutyPhase
+	float amplitude;
+	float offset;
+	float frequency;
+	bool isDcSet;
+};
+
+Synthesizer g_synthesizersU[CH_MAX];
+Synthesizer g_synthesizersI[CH_MAX];
+
+// values of all channels calculated in the current tick
+float g_valuesU[CH_MAX];
+float g_valuesI[CH_MAX];
+
+// one period of the sine, with the guard point at the end for the interpolation
+static const int SINE_TABLE_SIZE_BITS = 10;
+static float g_sineTable[(1 << SINE_TABLE_SIZE_BITS) + 1];
+static bool g_sineTableInitialized;
+
+static const int ARBITRARY_TABLE_SIZE_BITS = 8;
+static const int ARBITRARY_TABLE_SIZE = 1 << ARBITRARY_TABLE_SIZE_BITS;
+static float g_arbitraryTablesU[CH_MAX][ARBITRARY_TABLE_SIZE + 1];
+static float g_arbitraryTablesI[CH_MAX][ARBITRARY_TABLE_SIZE + 1];
+static bool g_arbitraryLoadedU[CH_MAX];
+static bool g_arbitraryLoadedI[CH_MAX];
 
 bool g_dprogStateModified[CH_MAX];
 bool g_currentRangeModified[CH_MAX];
 float g_savedCurrentLimit[CH_MAX];
 
 static const float PERIOD = 0.0002f;
+static const uint32_t PERIOD_US = 200;
 
 static void reloadWaveformParameters();
 
 ////////////////////////////////////////////////////////////////////////////////
 
-float dcf(float t) {
-	return 0.0f;
-}
+static void initSineTable() {
+	if (g_sineTableInitialized) {
+		return;
+	}
 
-float sineHalfRectifiedf(float t) {
-	if (t < M_PI_F) {
-		return 2.0f * sinf(t);
+	static const int SINE_TABLE_SIZE = 1 << SINE_TABLE_SIZE_BITS;
+	for (int i = 0; i < SINE_TABLE_SIZE; i++) {
+		g_sineTable[i] = (float)sin(2.0 * M_PI * i / SINE_TABLE_SIZE);
 	}
+	g_sineTable[SINE_TABLE_SIZE] = g_sineTable[0];
 
-	return 0.0f;
+	g_sineTableInitialized = true;
 }
 
-float sineFullRectifiedf(float t) {
-	return 2.0f * sinf(t / 2.0f);
+inline float lookup(const float *table, int tableSizeBits, uint32_t phase) {
+	uint32_t index = phase >> (32 - tableSizeBits);
+	float fraction = (phase << tableSizeBits) * (1.0f / 4294967296.0f);
+	return table[index] + (table[index + 1] - table[index]) * fraction;
 }
 
-float trianglef(float t) {
-	float a, b, c;
+// returns value in the same range as WaveformFunction
+inline float synthesize(const Synthesizer &synthesizer, uint32_t phase) {
+	switch (synthesizer.shape) {
+	case SHAPE_TABLE:
+		return lookup(synthesizer.table, synthesizer.tableSizeBits, phase);
 
-	if (t < M_PI_F / 2.0f) {
-		a = 0;
-		b = 1;
-		c = 0;
-	} else if (t < 3.0f * M_PI_F / 2.0f) {
-		a = 1;
-		b = -1;
-		c = M_PI_F / 2.0f;
-	} else {
-		a = -1;
-		b = 1;
-		c = 3.0f * M_PI_F / 2.0f;
-	}
+	case SHAPE_HALF_RECTIFIED:
+		return phase < 0x80000000 ? 2.0f * lookup(g_sineTable, SINE_TABLE_SIZE_BITS, phase) : 0.0f;
 
-	return a + b * (t - c) / (M_PI_F / 2.0f);
-}
+	case SHAPE_FULL_RECTIFIED:
+		return 2.0f * lookup(g_sineTable, SINE_TABLE_SIZE_BITS, phase >> 1);
 
-float squaref(float t) {
-	if (t < M_PI_F) {
-		return 1.0f;
+	case SHAPE_TRIANGLE: {
+		float t = phase * (1.0f / 4294967296.0f);
+		if (t < 0.25f) {
+			return 4.0f * t;
+		}
+		if (t < 0.75f) {
+			return 2.0f - 4.0f * t;
+		}
+		return 4.0f * t - 4.0f;
 	}
-	return -1.0f;
-}
 
-static float g_dutyCycle;
+	case SHAPE_SAWTOOTH:
+		return -1.0f + phase * (2.0f / 4294967296.0f);
 
-float pulsef(float t) {
-	if (t < g_dutyCycle * 2.0f * M_PI_F / 100.0f) {
-		return 1.0f;
+	case SHAPE_PULSE:
+		return phase < synthesizer.dutyPhase ? 1.0f : -1.0f;
+
+	default:
+		return 0.0f;
 	}
-	return -1.0f;
 }
 
-float sawtoothf(float t) {
-	return -1.0f + t / M_PI_F;
+static float *getArbitraryTable(int iChannel, FunctionGeneratorResourceType resourceType) {
+	return resourceType == FUNCTION_GENERATOR_RESOURCE_TYPE_U ? g_arbitraryTablesU[iChannel] : g_arbitraryTablesI[iChannel];
 }
 
-float arbitraryf(float t) {
-	return 0.0f;
+static bool isArbitraryLoaded(int iChannel, FunctionGeneratorResourceType resourceType) {
+	return resourceType == FUNCTION_GENERATOR_RESOURCE_TYPE_U ? g_arbitraryLoadedU[iChannel] : g_arbitraryLoadedI[iChannel];
 }
 
-WaveformFunction getWaveformFunction(WaveformParameters &waveformParameters) {
+static void setupSynthesizer(Synthesizer &synthesizer, int iChannel, WaveformParameters &waveformParameters) {
+	synthesizer.table = nullptr;
+	synthesizer.tableSizeBits = 0;
+	synthesizer.dutyPhase = 0;
+	synthesizer.isDcSet = false;
+
 	if (waveformParameters.waveform == WAVEFORM_DC) {
-		return dcf;
-	} else if (waveformParameters.waveform == WAVEFORM_SINE) {
-		return sinf;
+		synthesizer.shape = SHAPE_DC;
+		synthesizer.phaseAtStart = 0;
+		synthesizer.phaseIncrement = 0;
+		synthesizer.amplitude = 0.0f;
+		synthesizer.offset = waveformParameters.amplitude;
+		return;
+	}
+
+	if (waveformParameters.waveform == WAVEFORM_SINE) {
+		synthesizer.shape = SHAPE_TABLE;
+		synthesizer.table = g_sineTable;
+		synthesizer.tableSizeBits = SINE_TABLE_SIZE_BITS;
 	} else if (waveformParameters.waveform == WAVEFORM_HALF_RECTIFIED) {
-		return sineHalfRectifiedf;
+		synthesizer.shape = SHAPE_HALF_RECTIFIED;
 	} else if (waveformParameters.waveform == WAVEFORM_FULL_RECTIFIED) {
-		return sineFullRectifiedf;
+		synthesizer.shape = SHAPE_FULL_RECTIFIED;
 	} else if (waveformParameters.waveform == WAVEFORM_TRIANGLE) {
-		return trianglef;
+		synthesizer.shape = SHAPE_TRIANGLE;
 	} else if (waveformParameters.waveform == WAVEFORM_SQUARE) {
-		return squaref;
+		synthesizer.shape = SHAPE_PULSE;
+		synthesizer.dutyPhase = 0x80000000;
 	} else if (waveformParameters.waveform == WAVEFORM_PULSE) {
-		g_dutyCycle = waveformParameters.dutyCycle;
-		return pulsef;
+		synthesizer.shape = SHAPE_PULSE;
+		synthesizer.dutyPhase = waveformParameters.dutyCycle >= 100.0f ? 0xFFFFFFFF : (uint32_t)(waveformParameters.dutyCycle / 100.0 * 4294967296.0);
 	} else if (waveformParameters.waveform == WAVEFORM_SAWTOOTH) {
-		return sawtoothf;
+		synthesizer.shape = SHAPE_SAWTOOTH;
+	} else if (iChannel != -1 && isArbitraryLoaded(iChannel, waveformParameters.resourceType)) {
+		synthesizer.shape = SHAPE_TABLE;
+		synthesizer.table = getArbitraryTable(iChannel, waveformParameters.resourceType);
+		synthesizer.tableSizeBits = ARBITRARY_TABLE_SIZE_BITS;
 	} else {
-		return arbitraryf;
+		synthesizer.shape = SHAPE_DC;
 	}
+
+	synthesizer.phaseAtStart = (uint32_t)(fmod(waveformParameters.phaseShift / 360.0, 1.0) * 4294967296.0);
+	synthesizer.phaseIncrement = (uint32_t)(fmod(waveformParameters.frequency * (double)PERIOD, 1.0) * 4294967296.0 + 0.5);
+	synthesizer.amplitude = waveformParameters.amplitude;
+	synthesizer.offset = waveformParameters.offset;
+	synthesizer.frequency = waveformParameters.frequency;
+}
+
+static uint64_t getTickCount() {
+#if defined(EEZ_PLATFORM_STM32)
+	return g_tickCount;
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+	return micros64() / PERIOD_US;
+#endif
 }
 
 float getMin(WaveformParameters &waveformParameters) {
@@ -591,7 +658,10 @@ public:
 		hmi::g_selectedSlotIndex = tmpSlotIndex;
 		hmi::g_selectedSubchannelIndex = tmpSubchannelIndex;
 
-		auto func = getWaveformFunction(waveformParameters);
+		initSineTable();
+		auto channel = Channel::getBySlotIndex(slotIndex, subchannelIndex);
+		Synthesizer synthesizer;
+		setupSynthesizer(synthesizer, channel ? channel->channelIndex : -1, waveformParameters);
 
 		float range = max - min;
 
@@ -621,7 +691,7 @@ public:
 					int k = floorf(fi / (2 * M_PI));
 					fi = fi - k * (2 * M_PI);
 
-					float yt = offset + amplitude * func(fi) / 2.0f;
+					float yt = offset + amplitude * synthesize(synthesizer, (uint32_t)(fi / (2 * M_PI) * 4294967296.0)) / 2.0f;
 					if (yt < lower) {
 						yt = lower;
 					} else if (yt > upper) {
@@ -1566,6 +1636,129 @@ bool setDutyCycle(int slotIndex, int subchannelIndex, int resourceIndex, float d
 	return true;
 }
 
+bool hasArbitraryWaveform(int slotIndex, int subchannelIndex, int resourceIndex) {
+	Channel *channel = Channel::getBySlotIndex(slotIndex, subchannelIndex);
+	if (!channel || resourceIndex > 1) {
+		return false;
+	}
+	return isArbitraryLoaded(channel->channelIndex, resourceIndex == 0 ? FUNCTION_GENERATOR_RESOURCE_TYPE_U : FUNCTION_GENERATOR_RESOURCE_TYPE_I);
+}
+
+bool setArbitraryWaveform(int slotIndex, int subchannelIndex, int resourceIndex, const float *points, int numPoints, int *err) {
+	Channel *channel = Channel::getBySlotIndex(slotIndex, subchannelIndex);
+	if (!channel || resourceIndex > 1) {
+		if (err) {
+			*err = SCPI_ERROR_HARDWARE_MISSING;
+		}
+		return false;
+	}
+
+	if (numPoints < 2 || numPoints > ARBITRARY_WAVEFORM_MAX_POINTS) {
+		if (err) {
+			*err = SCPI_ERROR_DATA_OUT_OF_RANGE;
+		}
+		return false;
+	}
+
+	// points are normalized to -1 ... 1, same as amplitude of other waveforms
+	for (int i = 0; i < numPoints; i++) {
+		if (!(points[i] >= -1.0f && points[i] <= 1.0f)) {
+			if (err) {
+				*err = SCPI_ERROR_DATA_OUT_OF_RANGE;
+			}
+			return false;
+		}
+	}
+
+	// resample points, that are equally spaced over one period, to the table size
+	float table[ARBITRARY_TABLE_SIZE + 1];
+	for (int i = 0; i < ARBITRARY_TABLE_SIZE; i++) {
+		float x = 1.0f * i * numPoints / ARBITRARY_TABLE_SIZE;
+		int j = (int)x;
+		float a = points[j];
+		float b = points[(j + 1) % numPoints];
+		table[i] = a + (b - a) * (x - j);
+	}
+	table[ARBITRARY_TABLE_SIZE] = table[0];
+
+	auto resourceType = resourceIndex == 0 ? FUNCTION_GENERATOR_RESOURCE_TYPE_U : FUNCTION_GENERATOR_RESOURCE_TYPE_I;
+
+#if defined(EEZ_PLATFORM_STM32)
+	__disable_irq();
+#endif
+	memcpy(getArbitraryTable(channel->channelIndex, resourceType), table, sizeof(table));
+	if (resourceType == FUNCTION_GENERATOR_RESOURCE_TYPE_U) {
+		g_arbitraryLoadedU[channel->channelIndex] = true;
+	} else {
+		g_arbitraryLoadedI[channel->channelIndex] = true;
+	}
+#if defined(EEZ_PLATFORM_STM32)
+	__enable_irq();
+#endif
+
+	g_functionGeneratorPage.init();
+
+	if (g_active) {
+		reloadWaveformParameters();
+	}
+
+	return true;
+}
+
+bool loadArbitraryWaveform(int slotIndex, int subchannelIndex, int resourceIndex, const char *filePath, int *err) {
+	if (!sd_card::isMounted(filePath, err)) {
+		return false;
+	}
+
+	if (!sd_card::exists(filePath, err)) {
+		if (err) {
+			*err = SCPI_ERROR_FILE_NOT_FOUND;
+		}
+		return false;
+	}
+
+	File file;
+	if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+		if (err) {
+			*err = SCPI_ERROR_MASS_STORAGE_ERROR;
+		}
+		return false;
+	}
+
+	sd_card::BufferedFileRead bufferedFile(file);
+
+	// one value per line or values separated with CSV_SEPARATOR
+	float points[ARBITRARY_WAVEFORM_MAX_POINTS];
+	int numPoints = 0;
+	bool success = true;
+
+	while (true) {
+		sd_card::matchZeroOrMoreSpaces(bufferedFile);
+		if (!bufferedFile.available()) {
+			break;
+		}
+
+		if (numPoints == ARBITRARY_WAVEFORM_MAX_POINTS || !sd_card::match(bufferedFile, points[numPoints])) {
+			success = false;
+			break;
+		}
+		numPoints++;
+
+		sd_card::match(bufferedFile, CSV_SEPARATOR);
+	}
+
+	file.close();
+
+	if (!success) {
+		if (err) {
+			*err = SCPI_ERROR_EXECUTION_ERROR;
+		}
+		return false;
+	}
+
+	return setArbitraryWaveform(slotIndex, subchannelIndex, resourceIndex, points, numPoints, err);
+}
+
 bool getResourceType(int slotIndex, int subchannelIndex, int resourceIndex, FunctionGeneratorResourceType &resourceType, int *err) {
 	WaveformParameters *waveformParameters = getWaveformParameters(slotIndex, subchannelIndex, resourceIndex);
 
@@ -1763,23 +1956,16 @@ void executionStart() {
 void reloadWaveformParameters() {
 	int trackingChannel= -1;
 
+	initSineTable();
+
 	for (int i = 0; i < CH_MAX; i++) {
-		g_waveFormFuncU[i] = dcf;
-		if (!g_active) {
-			g_phiU[i] = 0;
-		}
-		g_dphiU[i] = 0;
-		g_amplitudeU[i] = 0;
-		g_offsetU[i] = 0;
-		g_freqU[i] = 0;
+		memset(&g_synthesizersU[i], 0, sizeof(Synthesizer));
+		g_synthesizersU[i].shape = SHAPE_DC;
+		g_synthesizersU[i].isDcSet = true;
 
-		g_waveFormFuncI[i] = dcf;
-		if (!g_active) {
-			g_phiI[i] = 0;
-		}
-		g_dphiI[i] = 0;
-		g_amplitudeI[i] = 0;
-		g_offsetI[i] = 0;
+		memset(&g_synthesizersI[i], 0, sizeof(Synthesizer));
+		g_synthesizersI[i].shape = SHAPE_DC;
+		g_synthesizersI[i].isDcSet = true;
 	}
 
 	for (int i = 0; i < g_selectedResources.m_numResources; i++) {
@@ -1819,38 +2005,9 @@ void reloadWaveformParameters() {
 			__disable_irq();
 #endif
 			if (waveformParameters.resourceType == FUNCTION_GENERATOR_RESOURCE_TYPE_U) {
-				g_waveFormFuncU[channel->channelIndex] = getWaveformFunction(waveformParameters);
-
-				if (waveformParameters.waveform == WAVEFORM_DC) {
-					g_phiU[channel->channelIndex] = 0.0f;
-					g_dphiU[channel->channelIndex] = 1.0f;
-					g_amplitudeU[channel->channelIndex] = 0.0f;
-					g_offsetU[channel->channelIndex] = waveformParameters.amplitude;
-					g_isDcSetU[channel->channelIndex] = false;
-				} else {
-					g_dutyCycleU[channel->channelIndex] = g_dutyCycle;
-					g_phiU[channel->channelIndex] = 2.0 * M_PI * waveformParameters.phaseShift / 360.0f;
-					g_dphiU[channel->channelIndex] = 2.0 * M_PI * waveformParameters.frequency * PERIOD;
-					g_amplitudeU[channel->channelIndex] = waveformParameters.amplitude;
-					g_offsetU[channel->channelIndex] = waveformParameters.offset;
-					g_freqU[channel->channelIndex] = waveformParameters.frequency;
-				}
+				setupSynthesizer(g_synthesizersU[channel->channelIndex], channel->channelIndex, waveformParameters);
 			} else {
-				g_waveFormFuncI[channel->channelIndex] = getWaveformFunction(waveformParameters);
-
-				if (waveformParameters.waveform == WAVEFORM_DC) {
-					g_phiI[channel->channelIndex] = 0.0f;
-					g_dphiI[channel->channelIndex] = 1.0f;
-					g_amplitudeI[channel->channelIndex] = 0.0f;
-					g_offsetI[channel->channelIndex] = waveformParameters.amplitude;
-					g_isDcSetI[channel->channelIndex] = false;
-				} else {
-					g_dutyCycleI[channel->channelIndex] = g_dutyCycle;
-					g_phiI[channel->channelIndex] = 2.0 * M_PI * waveformParameters.phaseShift / 360.0f;
-					g_dphiI[channel->channelIndex] = 2.0 * M_PI * waveformParameters.frequency * PERIOD;
-					g_amplitudeI[channel->channelIndex] = waveformParameters.amplitude;
-					g_offsetI[channel->channelIndex] = waveformParameters.offset;
-				}
+				setupSynthesizer(g_synthesizersI[channel->channelIndex], channel->channelIndex, waveformParameters);
 
 				if (g_slots[slotIndex]->moduleType == MODULE_TYPE_DCP405) {
 					Channel *channel = Channel::getBySlotIndex(slotIndex, subchannelIndex);
@@ -1877,13 +2034,7 @@ void reloadWaveformParameters() {
 
 	g_funcGenChannelIndex = 0;
 
-#if defined(EEZ_PLATFORM_STM32)
-	g_tickCountAtStart = g_tickCount;
-#endif
-
-#if defined(EEZ_PLATFORM_SIMULATOR)
-	g_tickCountAtStart = millis() * 1 / (1000 * PERIOD);
-#endif
+	g_tickCountAtStart = getTickCount();
 }
 
 void tick() {
@@ -1895,22 +2046,23 @@ void tick() {
 		return;
 	}
 
-	int trackingChannel = -1;
-
-	uint64_t tickCount;
+	// phase difference is calculated modulo 2^32, same as the phase accumulator
+	uint32_t tickDiff = (uint32_t)(getTickCount() - g_tickCountAtStart);
 
-#if defined(EEZ_PLATFORM_STM32)
-	tickCount = g_tickCount;
-#endif
+	// calculate values for all channels in one pass, ...
+	for (int i = 0; i < CH_NUM; i++) {
+		Synthesizer &synthesizerU = g_synthesizersU[i];
+		g_valuesU[i] = synthesizerU.offset + synthesizerU.amplitude * synthesize(synthesizerU, synthesizerU.phaseAtStart + tickDiff * synthesizerU.phaseIncrement) / 2.0f;
 
-#if defined(EEZ_PLATFORM_SIMULATOR)
-	tickCount = millis() * 1 / (1000 * PERIOD);
-#endif
+		Synthesizer &synthesizerI = g_synthesizersI[i];
+		g_valuesI[i] = synthesizerI.offset + synthesizerI.amplitude * synthesize(synthesizerI, synthesizerI.phaseAtStart + tickDiff * synthesizerI.phaseIncrement) / 2.0f;
+	}
 
-	uint64_t tickDiff = tickCount - g_tickCountAtStart;
+	// ... and then set them, number of value changes per tick is limited
+	// because every change is a transfer to the module
+	int trackingChannel = -1;
 
-	static const int MAX_VALUE_CHANGES_PER_TICK = 2;
-	int n = MAX_VALUE_CHANGES_PER_TICK;
+	int n = CONF_FUNCTION_GENERATOR_MAX_VALUE_CHANGES_PER_TICK;
 	for (int j = 0; j < CH_NUM && n > 0; j++) {
 		int i = g_funcGenChannelIndex;
 		g_funcGenChannelIndex = (g_funcGenChannelIndex + 1) % CH_NUM;
@@ -1927,10 +2079,8 @@ void tick() {
 		}
 
 		if (channel.flags.voltageTriggerMode == TRIGGER_MODE_FUNCTION_GENERATOR) {
-			if (g_waveFormFuncU[i] != dcf || !g_isDcSetU[i]) {
-				g_dutyCycle = g_dutyCycleU[i];
-				float phi = fmod(g_phiU[i] + tickDiff * g_dphiU[i], 2.0f * M_PI_F);
-				float value = g_offsetU[i] + g_amplitudeU[i] * g_waveFormFuncU[i](phi) / 2.0f;
+			if (g_synthesizersU[i].shape != SHAPE_DC || !g_synthesizersU[i].isDcSet) {
+				float value = g_valuesU[i];
 
 				if (channel_dispatcher::getUSet(channel) != value) {
 					if (!io_pins::isInhibited()) {
@@ -1950,20 +2100,18 @@ void tick() {
 						}
 
 						channel_dispatcher::setVoltage(channel, value);
-						g_isDcSetU[i] = true;
+						g_synthesizersU[i].isDcSet = true;
 						n--;
 					}
 				} else {
-					g_isDcSetU[i] = true;
+					g_synthesizersU[i].isDcSet = true;
 				}
 			}
 		}
 
 		if (channel.flags.currentTriggerMode == TRIGGER_MODE_FUNCTION_GENERATOR) {
-			if (g_waveFormFuncI[i] != dcf || !g_isDcSetI[i]) {
-				g_dutyCycle = g_dutyCycleI[i];
-				float phi = fmod(g_phiI[i] + tickDiff * g_dphiI[i], 2.0f * M_PI_F);
-				float value = g_offsetI[i] + g_amplitudeI[i] * g_waveFormFuncI[i](phi) / 2.0f;
+			if (g_synthesizersI[i].shape != SHAPE_DC || !g_synthesizersI[i].isDcSet) {
+				float value = g_valuesI[i];
 
 				if (channel_dispatcher::getISet(channel) != value) {
 					if (!io_pins::isInhibited()) {
@@ -1983,17 +2131,17 @@ void tick() {
 						}
 
 						channel_dispatcher::setCurrent(channel, value);
-						g_isDcSetI[i] = true;
+						g_synthesizersI[i].isDcSet = true;
 						n--;
 					}
 				} else {
-					g_isDcSetI[i] = true;
+					g_synthesizersI[i].isDcSet = true;
 				}
 			}
 		}
 
 		// If DCP405 is selected, for 100 Hz or more, and measured current of 0.5 A or more, DP has to be disabled
-		if (g_slots[channel.slotIndex]->moduleType == MODULE_TYPE_DCP405 && g_freqU[i] >= 100.0f) {
+		if (g_slots[channel.slotIndex]->moduleType == MODULE_TYPE_DCP405 && g_synthesizersU[i].frequency >= 100.0f) {
 			if (channel.i.mon >= 0.5f) {
 				if (channel.flags.dprogState) {
 					channel.setDprogState(DPROG_STATE_OFF);
@@ -2353,7 +2501,18 @@ bool disabledCallback(uint16_t value) {
 	if (g_functionGeneratorPage.m_selectedResources.m_waveformParameters[g_functionGeneratorPage.m_selectedItem].resourceType == FUNCTION_GENERATOR_RESOURCE_TYPE_DIGITAL) {
 		return value == WAVEFORM_SINE || value == WAVEFORM_HALF_RECTIFIED || value == WAVEFORM_FULL_RECTIFIED || value == WAVEFORM_TRIANGLE || value == WAVEFORM_SAWTOOTH || value == WAVEFORM_ARBITRARY;
 	}
-	return value == WAVEFORM_ARBITRARY;
+
+	if (value == WAVEFORM_ARBITRARY) {
+		int slotIndex;
+		int subchannelIndex;
+		int resourceIndex;
+		AllResources::findResource(
+			g_functionGeneratorPage.m_selectedResources.m_waveformParameters[g_functionGeneratorPage.m_selectedItem].absoluteResourceIndex,
+			slotIndex, subchannelIndex, resourceIndex);
+		return !hasArbitraryWaveform(slotIndex, subchannelIndex, resourceIndex);
+	}
+
+	return false;
 }
 
 void action_function_generator_select_waveform() {
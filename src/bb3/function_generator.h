@@ -53,6 +53,9 @@ struct WaveformParameters {
 	float dutyCycle;
 };
 
+// max. number of points of the user supplied arbitrary waveform
+static const int ARBITRARY_WAVEFORM_MAX_POINTS = 256;
+
 WaveformParameters *getWaveformParameters(int slotIndex, int subchannelIndex, int resourceIndex);
 
 void resetProfileParameters(psu::profile::Parameters &profileParams);
@@ -91,6 +94,10 @@ bool setOffset(int slotIndex, int subchannelIndex, int resourceIndex, float offs
 bool getDutyCycle(int slotIndex, int subchannelIndex, int resourceIndex, float &dutyCycle, int *err);
 bool setDutyCycle(int slotIndex, int subchannelIndex, int resourceIndex, float dutyCycle, int *err);
 
+bool hasArbitraryWaveform(int slotIndex, int subchannelIndex, int resourceIndex);
+bool setArbitraryWaveform(int slotIndex, int subchannelIndex, int resourceIndex, const float *points, int numPoints, int *err);
+bool loadArbitraryWaveform(int slotIndex, int subchannelIndex, int resourceIndex, const char *filePath, int *err);
+
 bool getResourceType(int slotIndex, int subchannelIndex, int resourceIndex, FunctionGeneratorResourceType &resourceType, int *err);
 bool setResourceType(int slotIndex, int subchannelIndex, int resourceIndex, FunctionGeneratorResourceType resourceType, int *err);
 
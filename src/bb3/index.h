@@ -125,6 +125,30 @@ struct CalibrationValueConfiguration {
     CalibrationValuePointConfiguration points[MAX_CALIBRATION_POINTS];
 };
 
+/// CalibrationValueConfiguration compiled to the table of segments
+/// (see calibration::compileTables), so remapping doesn't have to
+/// search over the points.
+/// Value in the segment `s` is remapped as `y1[s] + (value - x1[s]) * dy[s] / dx[s]`,
+/// exactly the same operations as in remap(), so the result is bit-identical.
+struct CalibrationValueTable {
+    uint8_t numSegments;
+    /// If breakpoints are not in ascending order linear search is used instead of binary search.
+    bool sorted;
+    /// Segment `s + 1` starts when value is greater then `breakpoints[s]`.
+    float breakpoints[MAX_CALIBRATION_POINTS - 2];
+    float x1[MAX_CALIBRATION_POINTS - 1];
+    float y1[MAX_CALIBRATION_POINTS - 1];
+    float dy[MAX_CALIBRATION_POINTS - 1];
+    float dx[MAX_CALIBRATION_POINTS - 1];
+};
+
+struct CalibrationValueTables {
+    /// Real value -> DAC value
+    CalibrationValueTable dac;
+    /// ADC value -> real value
+    CalibrationValueTable adc;
+};
+
 /// A structure where calibration parameters for the channel are stored.
 struct CalibrationConfiguration {
     /// Used by the persist_conf.
@@ -57,6 +57,7 @@ extern ip4_addr_t gw;
 #include <memory.h>
 #include <netinet/in.h>
 #include <stdio.h>
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -91,6 +92,18 @@ using namespace eez::gui;
 
 #define STALE_CONNECTION_TIMEOUT 10000
 
+#define WRITE_TIMEOUT 1000
+
+// max. time spent in one iteration of the ethernet thread while idle
+#define ONE_ITER_TIMEOUT 10
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+// simulator waits for the socket input in onIdle
+#define MESSAGE_QUEUE_TIMEOUT 1
+#else
+#define MESSAGE_QUEUE_TIMEOUT ONE_ITER_TIMEOUT
+#endif
+
 namespace eez {
 namespace mcu {
 namespace ethernet {
@@ -150,9 +163,18 @@ enum ConnectionState {
 static ConnectionState g_connectionState = CONNECTION_STATE_INITIALIZED;
 static uint16_t g_scpiPort;
 
+struct ScpiClient {
+    struct netconn *connection;
+    netbuf *inbuf;
+    uint32_t lastActivity;
+    // incremented from the netconn callback for every received netbuf,
+    // isScpiInputAvailable compares it with the number of netbufs taken
+    volatile uint32_t numReceived;
+    uint32_t numTaken;
+};
+
 struct netconn *g_scpiListenConnection;
-struct netconn *g_scpiClientConnection;
-static netbuf *g_scpiInbuf;
+static ScpiClient g_scpiClients[MAX_SCPI_CLIENTS];
 static bool g_acceptScpiClientIsDone;
 
 struct netconn *g_debuggerListenConnection;
@@ -162,10 +184,20 @@ static bool g_acceptDebuggerClientIsDone;
 
 static bool g_checkLinkWhileIdle = false;
 
-static uint32_t g_scpiClientConnectionLastActivity;
 static uint32_t g_numRefusedIncomingConnections;
 
+static int findScpiClient(struct netconn *conn) {
+    for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+        if (g_scpiClients[clientIndex].connection == conn) {
+            return clientIndex;
+        }
+    }
+    return -1;
+}
+
 static void netconnCallback(struct netconn *conn, enum netconn_evt evt, u16_t len) {
+    int clientIndex;
+
 	switch (evt) {
 	case NETCONN_EVT_RCVPLUS:
 		if (conn == g_scpiListenConnection) {
@@ -181,9 +213,11 @@ static void netconnCallback(struct netconn *conn, enum netconn_evt evt, u16_t le
                 }
                 osDelay(1);
             }
-		} else if (conn == g_scpiClientConnection) {
-			g_scpiClientConnectionLastActivity = millis();
-			sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE);
+		} else if (conn && (clientIndex = findScpiClient(conn)) != -1) {
+            auto &client = g_scpiClients[clientIndex];
+			client.lastActivity = millis();
+            client.numReceived++;
+			sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE, clientIndex);
 		} else if (conn == g_debuggerListenConnection) {
             g_acceptDebuggerClientIsDone = false;
 
@@ -315,12 +349,14 @@ static void onEvent(uint8_t eventType) {
 		break;
 
 	case QUEUE_MESSAGE_CREATE_TCP_SERVER:
-	    if (g_scpiClientConnection) {
-	        auto tmp = g_scpiClientConnection;
-		    g_scpiClientConnection = nullptr;
-		    netconn_delete(tmp);
-		    sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED);
-	    }
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+	        if (g_scpiClients[clientIndex].connection) {
+	            auto tmp = g_scpiClients[clientIndex].connection;
+		        g_scpiClients[clientIndex].connection = nullptr;
+		        netconn_delete(tmp);
+		        sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED, clientIndex);
+	        }
+        }
 
 	    if (g_debuggerClientConnection) {
 	        auto tmp = g_debuggerClientConnection;
@@ -367,27 +403,40 @@ static void onEvent(uint8_t eventType) {
 			struct netconn *newConnection;
 			if (netconn_accept(g_scpiListenConnection, &newConnection) == ERR_OK) {
                 netconn *existingConnection = nullptr;
-                if (g_scpiClientConnection) {
-                    auto stale = (millis() - g_scpiClientConnectionLastActivity) > STALE_CONNECTION_TIMEOUT;
+                int clientIndex = findScpiClient(nullptr);
+                if (clientIndex == -1) {
+                    // all clients are taken, replace the least recently active one if it is stale
+                    int lruClientIndex = 0;
+                    for (int i = 1; i < MAX_SCPI_CLIENTS; i++) {
+                        if ((int32_t)(g_scpiClients[i].lastActivity - g_scpiClients[lruClientIndex].lastActivity) < 0) {
+                            lruClientIndex = i;
+                        }
+                    }
+
+                    auto stale = (millis() - g_scpiClients[lruClientIndex].lastActivity) > STALE_CONNECTION_TIMEOUT;
                     if (stale || g_numRefusedIncomingConnections >= 2) {
-                        existingConnection = g_scpiClientConnection;
-                        g_scpiClientConnection = nullptr;
-                        sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED);
+                        clientIndex = lruClientIndex;
+                        existingConnection = g_scpiClients[clientIndex].connection;
+                        g_scpiClients[clientIndex].connection = nullptr;
+                        sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED, clientIndex);
                     } else {
                         g_numRefusedIncomingConnections++;
                     }
                 }
 				
-				if (g_scpiClientConnection) {
-					// there is a client already connected, close this connection
+				if (clientIndex == -1) {
+					// all clients are connected, close this connection
                     g_acceptScpiClientIsDone = true;
                     osDelay(10);
 					netconn_delete(newConnection);
 				} else {
 					// connection with the client established
-					g_scpiClientConnection = newConnection;
-                    g_scpiClientConnectionLastActivity = millis();
-					sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED);
+                    auto &client = g_scpiClients[clientIndex];
+                    client.numReceived = 0;
+                    client.numTaken = 0;
+                    client.lastActivity = millis();
+					client.connection = newConnection;
+					sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED, clientIndex);
                     g_acceptScpiClientIsDone = true;
                     g_numRefusedIncomingConnections = 0;                    
 				}
@@ -453,8 +502,6 @@ void onIdle() {
 #define INPUT_BUFFER_SIZE 1024
 
 static uint16_t g_scpiPort;
-static char g_scpiInputBuffer[INPUT_BUFFER_SIZE];
-static uint32_t g_scpiInputBufferLength;
 
 static char g_debuggerInputBuffer[INPUT_BUFFER_SIZE];
 static uint32_t g_debuggerInputBufferLength;
@@ -462,21 +509,28 @@ static uint32_t g_debuggerInputBufferLength;
 ////////////////////////////////////////////////////////////////////////////////
 
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-static SOCKET g_scpiListenSocket = INVALID_SOCKET;
-static SOCKET g_scpiClientSocket = INVALID_SOCKET;
-
-static SOCKET g_debuggerListenSocket = INVALID_SOCKET;
-static SOCKET g_debuggerClientSocket = INVALID_SOCKET;
-
 typedef SOCKET SocketType;
+#define NO_SOCKET INVALID_SOCKET
 #else
-static int g_scpiListenSocket = -1;
-static int g_scpiClientSocket = -1;
+typedef int SocketType;
+#define NO_SOCKET -1
+#endif
+
+struct ScpiClient {
+    SocketType socket = NO_SOCKET;
+    bool wasConnected = false;
+    char inputBuffer[INPUT_BUFFER_SIZE];
+    // set by the ethernet thread, cleared by releaseScpiInputBuffer
+    volatile uint32_t inputBufferLength = 0;
+};
 
-static int g_debuggerListenSocket = -1;
-static int g_debuggerClientSocket = -1;
+static SocketType g_scpiListenSocket = NO_SOCKET;
+static ScpiClient g_scpiClients[MAX_SCPI_CLIENTS];
 
-typedef int SocketType;
+static SocketType g_debuggerListenSocket = NO_SOCKET;
+static SocketType g_debuggerClientSocket = NO_SOCKET;
+
+#ifndef EEZ_PLATFORM_SIMULATOR_WIN32
 
 bool enable_non_blocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
@@ -492,9 +546,8 @@ bool enable_non_blocking(int fd) {
 #endif
 
 bool bind(int port, SocketType &listenSocket);
-bool client_available(SocketType &listenSocket, SocketType &clientSocket);
+bool accept_client(SocketType &listenSocket, SocketType &clientSocket);
 bool connected(SocketType &listenSocket);
-int available(SocketType &listenSocket);
 int read(SocketType &listenSocket, char *buffer, int buffer_size);
 int write(SocketType &listenSocket, const char *buffer, int buffer_size);
 void stop(SocketType &listenSocket);
@@ -609,11 +662,8 @@ bool bind(int port, SocketType &listenSocket) {
 #endif    
 }
 
-bool client_available(SocketType &listenSocket, SocketType &clientSocket) {
+bool accept_client(SocketType &listenSocket, SocketType &clientSocket) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    if (connected(clientSocket))
-        return true;
-
     if (listenSocket == INVALID_SOCKET) {
         return false;
     }
@@ -633,9 +683,6 @@ bool client_available(SocketType &listenSocket, SocketType &clientSocket) {
 
     return true;
 #else
-    if (connected(clientSocket))
-        return true;
-
     if (listenSocket == -1) {
         return 0;
     }
@@ -657,7 +704,7 @@ bool client_available(SocketType &listenSocket, SocketType &clientSocket) {
     if (!enable_non_blocking(clientSocket)) {
         DebugTrace("EHTERNET: ioctl on client socket failed with error %d", errno);
         close(clientSocket);
-        listenSocket = -1;
+        clientSocket = -1;
         return false;
     }
 
@@ -673,43 +720,6 @@ bool connected(SocketType &clientSocket) {
 #endif    
 }
 
-int available(SocketType &clientSocket, char *inputBuffer) {
-#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    if (clientSocket == INVALID_SOCKET)
-        return 0;
-
-    int iResult = ::recv(clientSocket, inputBuffer, INPUT_BUFFER_SIZE, MSG_PEEK);
-    if (iResult > 0) {
-        return iResult;
-    }
-
-    if (iResult < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
-        return 0;
-    }
-
-    stop(clientSocket);
-
-    return 0;
-#else
-    if (clientSocket == -1)
-        return 0;
-
-    char buffer[1000];
-    int iResult = ::recv(clientSocket, buffer, 1000, MSG_PEEK);
-    if (iResult > 0) {
-        return iResult;
-    }
-
-    if (iResult < 0 && errno == EWOULDBLOCK) {
-        return 0;
-    }
-
-    stop(clientSocket);
-
-    return 0;
-#endif        
-}
-
 int read(SocketType &clientSocket, char *buffer, int buffer_size) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     int iResult = ::recv(clientSocket, buffer, buffer_size, 0);
@@ -740,32 +750,52 @@ int read(SocketType &clientSocket, char *buffer, int buffer_size) {
 #endif    
 }
 
+// client sockets are non-blocking, wait until socket can accept more data
+static bool waitUntilWritable(SocketType &clientSocket) {
+    fd_set writeSet;
+    FD_ZERO(&writeSet);
+    FD_SET(clientSocket, &writeSet);
+    timeval timeout = { WRITE_TIMEOUT / 1000, 0 };
+    return select((int)clientSocket + 1, nullptr, &writeSet, nullptr, &timeout) > 0;
+}
+
 int write(SocketType &clientSocket, const char *buffer, int buffer_size) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    int iSendResult;
-
     if (clientSocket != INVALID_SOCKET) {
-        // Echo the buffer back to the sender
-        iSendResult = ::send(clientSocket, buffer, buffer_size, 0);
-        if (iSendResult == SOCKET_ERROR) {
-            DebugTrace("send failed with error: %d\n", WSAGetLastError());
-            closesocket(clientSocket);
-            clientSocket = INVALID_SOCKET;
-            return 0;
+        int numWritten = 0;
+        while (numWritten < buffer_size) {
+            int iSendResult = ::send(clientSocket, buffer + numWritten, buffer_size - numWritten, 0);
+            if (iSendResult == SOCKET_ERROR) {
+                if (WSAGetLastError() == WSAEWOULDBLOCK && waitUntilWritable(clientSocket)) {
+                    continue;
+                }
+                DebugTrace("send failed with error: %d\n", WSAGetLastError());
+                closesocket(clientSocket);
+                clientSocket = INVALID_SOCKET;
+                return numWritten;
+            }
+            numWritten += iSendResult;
         }
-        return iSendResult;
+        return numWritten;
     }
 
     return 0;
 #else
     if (clientSocket != -1) {
-        int n = ::write(clientSocket, buffer, buffer_size);
-        if (n < 0) {
-            close(clientSocket);
-            clientSocket = -1;
-            return 0;
+        int numWritten = 0;
+        while (numWritten < buffer_size) {
+            int n = ::write(clientSocket, buffer + numWritten, buffer_size - numWritten);
+            if (n < 0) {
+                if (errno == EWOULDBLOCK && waitUntilWritable(clientSocket)) {
+                    continue;
+                }
+                close(clientSocket);
+                clientSocket = -1;
+                return numWritten;
+            }
+            numWritten += n;
         }
-        return n;
+        return numWritten;
     }
 
     return 0;
@@ -825,44 +855,124 @@ void onEvent(uint8_t eventType) {
     }
 }
 
+static void addToReadSet(SocketType socket, fd_set &readSet, int &maxSocket) {
+    if (socket != NO_SOCKET) {
+        FD_SET(socket, &readSet);
+        if ((int)socket > maxSocket) {
+            maxSocket = (int)socket;
+        }
+    }
+}
+
+static bool isInReadSet(SocketType socket, fd_set &readSet) {
+    return socket != NO_SOCKET && FD_ISSET(socket, &readSet);
+}
+
 void onIdle() {
-    static bool wasScpiConnected = false;
+    // Wait on all the sockets at once instead of peeking every client.
+    // Client with unconsumed input buffer is not polled until the buffer
+    // is released from the low priority thread.
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    int maxSocket = -1;
+
+    // wait here instead of in the message queue, so input is picked up as soon as it arrives
+    uint32_t timeoutMs = ONE_ITER_TIMEOUT - MESSAGE_QUEUE_TIMEOUT;
+
+    addToReadSet(g_scpiListenSocket, readSet, maxSocket);
+    for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+        auto &client = g_scpiClients[clientIndex];
+        if (!client.inputBufferLength) {
+            addToReadSet(client.socket, readSet, maxSocket);
+        } else if (connected(client.socket)) {
+            // buffer will be released soon, poll again
+            timeoutMs = 1;
+        }
+    }
 
-    if (wasScpiConnected) {
-        if (connected(g_scpiClientSocket)) {
-            if (!g_scpiInputBufferLength && available(g_scpiClientSocket, g_scpiInputBuffer)) {
-                g_scpiInputBufferLength = read(g_scpiClientSocket, g_scpiInputBuffer, INPUT_BUFFER_SIZE);
-                sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE);
-            }
-        } else {
-            sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED);
-            wasScpiConnected = false;
+    if (connected(g_debuggerClientSocket)) {
+        if (!g_debuggerInputBufferLength) {
+            addToReadSet(g_debuggerClientSocket, readSet, maxSocket);
         }
     } else {
-        if (client_available(g_scpiListenSocket, g_scpiClientSocket)) {
-            wasScpiConnected = true;
-            sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED);
+        addToReadSet(g_debuggerListenSocket, readSet, maxSocket);
+    }
+
+    int numReady = 0;
+    if (maxSocket != -1) {
+        timeval timeout = { 0, (long)timeoutMs * 1000 };
+        numReady = select(maxSocket + 1, &readSet, nullptr, nullptr, &timeout);
+        if (numReady < 0) {
+            numReady = 0;
         }
+    } else {
+        osDelay(timeoutMs);
     }
 
-    static bool wasDebuggerConnected = false;
+    if (numReady > 0) {
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            auto &client = g_scpiClients[clientIndex];
+            if (isInReadSet(client.socket, readSet)) {
+                // read returns 0 and closes the socket if client is disconnected
+                auto numRead = read(client.socket, client.inputBuffer, INPUT_BUFFER_SIZE);
+                if (numRead > 0) {
+                    client.inputBufferLength = numRead;
+                    sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE, clientIndex);
+                }
+            }
+        }
 
-    if (wasDebuggerConnected) {
-        if (connected(g_debuggerClientSocket)) {
-            if (!g_debuggerInputBufferLength && available(g_debuggerClientSocket, g_debuggerInputBuffer)) {
-                g_debuggerInputBufferLength = read(g_debuggerClientSocket, g_debuggerInputBuffer, INPUT_BUFFER_SIZE);
+        if (isInReadSet(g_scpiListenSocket, readSet)) {
+            SocketType newSocket = NO_SOCKET;
+            if (accept_client(g_scpiListenSocket, newSocket)) {
+                int clientIndex;
+                for (clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+                    if (!g_scpiClients[clientIndex].wasConnected && !connected(g_scpiClients[clientIndex].socket)) {
+                        break;
+                    }
+                }
+
+                if (clientIndex < MAX_SCPI_CLIENTS) {
+                    auto &client = g_scpiClients[clientIndex];
+                    client.socket = newSocket;
+                    client.wasConnected = true;
+                    sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED, clientIndex);
+                } else {
+                    // all clients are connected, close this connection
+                    stop(newSocket);
+                }
+            }
+        }
+
+        if (isInReadSet(g_debuggerClientSocket, readSet)) {
+            auto numRead = read(g_debuggerClientSocket, g_debuggerInputBuffer, INPUT_BUFFER_SIZE);
+            if (numRead > 0) {
+                g_debuggerInputBufferLength = numRead;
                 sendMessageToGuiThread(GUI_QUEUE_MESSAGE_DEBUGGER_INPUT_AVAILABLE);
             }
-        } else {
-            sendMessageToGuiThread(GUI_QUEUE_MESSAGE_DEBUGGER_CLIENT_DISCONNECTED);
-            wasDebuggerConnected = false;
+        } else if (isInReadSet(g_debuggerListenSocket, readSet)) {
+            if (accept_client(g_debuggerListenSocket, g_debuggerClientSocket)) {
+                sendMessageToGuiThread(GUI_QUEUE_MESSAGE_DEBUGGER_CLIENT_CONNECTED);
+            }
         }
-    } else {
-        if (client_available(g_debuggerListenSocket, g_debuggerClientSocket)) {
-            wasDebuggerConnected = true;
-            sendMessageToGuiThread(GUI_QUEUE_MESSAGE_DEBUGGER_CLIENT_CONNECTED);
+    }
+
+    // report clients disconnected by read, write or disconnectClients
+    for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+        auto &client = g_scpiClients[clientIndex];
+        if (client.wasConnected && !connected(client.socket)) {
+            client.wasConnected = false;
+            sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED, clientIndex);
         }
     }
+
+    static bool wasDebuggerConnected = false;
+    if (connected(g_debuggerClientSocket)) {
+        wasDebuggerConnected = true;
+    } else if (wasDebuggerConnected) {
+        wasDebuggerConnected = false;
+        sendMessageToGuiThread(GUI_QUEUE_MESSAGE_DEBUGGER_CLIENT_DISCONNECTED);
+    }
 }
 #endif // EEZ_PLATFORM_SIMULATOR && !__EMSCRIPTEN__
 
@@ -962,7 +1072,7 @@ void doWriteDebuggerBuffer(const char *buffer, uint32_t length) {
 
 void oneIter() {
     ethernetMessageQueueObject obj;
-    if (EEZ_MESSAGE_QUEUE_GET(ethernet, obj, 10)) {
+    if (EEZ_MESSAGE_QUEUE_GET(ethernet, obj, MESSAGE_QUEUE_TIMEOUT)) {
         if (obj.type == QUEUE_MESSAGE_PUSH_EVENT) {
             mqtt::pushEvent(obj.pushEvent.eventId, obj.pushEvent.channelIndex);
         } else if (obj.type == QUEUE_MESSAGE_NTP_STATE_TRANSITION) {
@@ -1053,28 +1163,20 @@ void endServer() {
 	EEZ_MESSAGE_QUEUE_PUT(ethernet, obj, osWaitForever);
 }
 
-void getInputBuffer(
 #if defined(EEZ_PLATFORM_STM32)
-	netbuf *&inbuf,
-	netconn *&clientConnection,
-#else
-	char *inputBuffer, uint32_t &inputBufferLength, 
-#endif
-    char **buffer, uint32_t *length
-) {
-#if defined(EEZ_PLATFORM_STM32)
-	if (!clientConnection) {
-        *buffer = nullptr;
-    	*length = 0;
-		return;
-	}
+// returns false if connection is broken
+static bool recvInputBuffer(netconn *clientConnection, netbuf *&inbuf, char **buffer, uint32_t *length) {
+    *buffer = nullptr;
+    *length = 0;
 
 	if (netconn_recv(clientConnection, &inbuf) != ERR_OK) {
-		goto fail1;
+		return false;
 	}
 
 	if (netconn_err(clientConnection) != ERR_OK) {
-		goto fail2;
+    	netbuf_delete(inbuf);
+	    inbuf = nullptr;
+		return false;
 	}
 
 	uint8_t* data;
@@ -1087,87 +1189,88 @@ void getInputBuffer(
     } else {
         netbuf_delete(inbuf);
         inbuf = nullptr;
-    	*buffer = nullptr;
-    	*length = 0;
     }
 
-    return;
-
-fail2:
-	netbuf_delete(inbuf);
-	inbuf = nullptr;
+    return true;
+}
+#endif
 
-fail1:
-	netconn_delete(clientConnection);
-	clientConnection = nullptr;
-	if (clientConnection == g_scpiClientConnection) {
-		sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED);
-	} else if (clientConnection == g_debuggerClientConnection) {
-        sendMessageToGuiThread(GUI_QUEUE_MESSAGE_DEBUGGER_CLIENT_DISCONNECTED);
-    }
+bool isScpiInputAvailable(int clientIndex) {
+#if defined(EEZ_PLATFORM_STM32)
+    auto &client = g_scpiClients[clientIndex];
+    return client.connection && client.numReceived != client.numTaken;
+#endif
 
-	*buffer = nullptr;
-	length = 0;
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+    return g_scpiClients[clientIndex].inputBufferLength > 0;
 #endif
 
-#if defined(EEZ_PLATFORM_SIMULATOR)
-    *buffer = inputBuffer;
-    *length = inputBufferLength;
+#if defined(__EMSCRIPTEN__)
+    return clientIndex == 0 && g_scpiInputBuffer != nullptr;
 #endif
 }
 
-void releaseInputBuffer(
+void getScpiInputBuffer(int clientIndex, char **buffer, uint32_t *length) {
 #if defined(EEZ_PLATFORM_STM32)
-	netbuf *&inbuf
-#else
-	char *inputBuffer, uint32_t &inputBufferLength
-#endif
-) {
-#if defined(EEZ_PLATFORM_STM32)
-	netbuf_delete(inbuf);
-	inbuf = nullptr;
+    auto &client = g_scpiClients[clientIndex];
+    auto clientConnection = client.connection;
+	if (!clientConnection) {
+        *buffer = nullptr;
+    	*length = 0;
+		return;
+	}
+
+    client.numTaken++;
+
+    if (!recvInputBuffer(clientConnection, client.inbuf, buffer, length)) {
+        client.connection = nullptr;
+    	netconn_delete(clientConnection);
+		sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED, clientIndex);
+    }
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
-    inputBufferLength = 0;
+    auto &client = g_scpiClients[clientIndex];
+    *buffer = client.inputBuffer;
+    *length = client.inputBufferLength;
 #endif
 
 #if defined(__EMSCRIPTEN__)
-    doRelaseInputBuffer(inputBuffer);
+    *buffer = g_scpiInputBuffer;
+    *length = g_scpiInputBufferLength;
 #endif
 }
 
-void getScpiInputBuffer(char **buffer, uint32_t *length) {
-	getInputBuffer(
+void releaseScpiInputBuffer(int clientIndex) {
 #if defined(EEZ_PLATFORM_STM32)
-		g_scpiInbuf,
-		g_scpiClientConnection,
-#else
-		g_scpiInputBuffer, g_scpiInputBufferLength,
+    auto &client = g_scpiClients[clientIndex];
+    if (client.inbuf) {
+	    netbuf_delete(client.inbuf);
+	    client.inbuf = nullptr;
+    }
 #endif
-        buffer, length);
-}
 
-void releaseScpiInputBuffer() {
-    releaseInputBuffer(
-#if defined(EEZ_PLATFORM_STM32)
-		g_scpiInbuf
-#else
-		g_scpiInputBuffer, g_scpiInputBufferLength
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+    g_scpiClients[clientIndex].inputBufferLength = 0;
+#endif
+
+#if defined(__EMSCRIPTEN__)
+    doRelaseInputBuffer(g_scpiInputBuffer);
 #endif
-    );
 }
 
-int writeScpiBuffer(const char *buffer, uint32_t length) {
+int writeScpiBuffer(int clientIndex, const char *buffer, uint32_t length) {
 #if defined(EEZ_PLATFORM_STM32)
-    netconn_write(g_scpiClientConnection, (void *)buffer, (uint16_t)length, NETCONN_COPY);
+    auto clientConnection = g_scpiClients[clientIndex].connection;
+    if (!clientConnection) {
+        return 0;
+    }
+    netconn_write(clientConnection, (void *)buffer, (uint16_t)length, NETCONN_COPY);
     return length;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
-    int numWritten = write(g_scpiClientSocket, buffer, length);
-    osDelay(1);
-    return numWritten;
+    return write(g_scpiClients[clientIndex].socket, buffer, length);
 #endif
 
 #if defined(__EMSCRIPTEN__)
@@ -1177,24 +1280,42 @@ int writeScpiBuffer(const char *buffer, uint32_t length) {
 }
 
 void getDebuggerInputBuffer(char **buffer, uint32_t *length) {
-	getInputBuffer(
 #if defined(EEZ_PLATFORM_STM32)
-		g_debuggerInbuf,
-		g_debuggerClientConnection,
-#else
-		g_debuggerInputBuffer, g_debuggerInputBufferLength,
+    auto clientConnection = g_debuggerClientConnection;
+	if (!clientConnection) {
+        *buffer = nullptr;
+    	*length = 0;
+		return;
+	}
+
+    if (!recvInputBuffer(clientConnection, g_debuggerInbuf, buffer, length)) {
+        g_debuggerClientConnection = nullptr;
+    	netconn_delete(clientConnection);
+        sendMessageToGuiThread(GUI_QUEUE_MESSAGE_DEBUGGER_CLIENT_DISCONNECTED);
+    }
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    *buffer = g_debuggerInputBuffer;
+    *length = g_debuggerInputBufferLength;
 #endif
-        buffer, length);
 }
 
 void releaseDebuggerInputBuffer() {
-    releaseInputBuffer(
 #if defined(EEZ_PLATFORM_STM32)
-		g_debuggerInbuf
-#else
-		g_debuggerInputBuffer, g_debuggerInputBufferLength
+    if (g_debuggerInbuf) {
+	    netbuf_delete(g_debuggerInbuf);
+	    g_debuggerInbuf = nullptr;
+    }
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+    g_debuggerInputBufferLength = 0;
+#endif
+
+#if defined(__EMSCRIPTEN__)
+    doRelaseInputBuffer(g_debuggerInputBuffer);
 #endif
-    );
 }
 
 int writeDebuggerBuffer(const char *buffer, uint32_t length) {
@@ -1217,15 +1338,24 @@ int writeDebuggerBuffer(const char *buffer, uint32_t length) {
 
 void disconnectClients() {
 #if defined(EEZ_PLATFORM_STM32)
-	netconn_delete(g_scpiClientConnection);
-	g_scpiClientConnection = nullptr;
+    for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+        auto clientConnection = g_scpiClients[clientIndex].connection;
+        if (clientConnection) {
+            g_scpiClients[clientIndex].connection = nullptr;
+	        netconn_delete(clientConnection);
+        }
+    }
 
 	netconn_delete(g_debuggerClientConnection);
 	g_debuggerClientConnection = nullptr;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
-    stop(g_scpiClientSocket);
+    for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+        if (connected(g_scpiClients[clientIndex].socket)) {
+            stop(g_scpiClients[clientIndex].socket);
+        }
+    }
     stop(g_debuggerClientSocket);
 #endif    
 }
@@ -24,6 +24,10 @@
 
 #define DEBUGGER_TCP_PORT 3333
 
+// max. number of concurrent SCPI client connections,
+// every client has its own SCPI parser context
+#define MAX_SCPI_CLIENTS 4
+
 namespace eez {
 namespace mcu {
 namespace ethernet {
@@ -60,10 +64,11 @@ IPAddress dnsServerIP();
 void beginServer(uint16_t port);
 void endServer();
 
-void getScpiInputBuffer(char **buffer, uint32_t *length);
-void releaseScpiInputBuffer();
+bool isScpiInputAvailable(int clientIndex);
+void getScpiInputBuffer(int clientIndex, char **buffer, uint32_t *length);
+void releaseScpiInputBuffer(int clientIndex);
 
-int writeScpiBuffer(const char *buffer, uint32_t length);
+int writeScpiBuffer(int clientIndex, const char *buffer, uint32_t length);
 
 void getDebuggerInputBuffer(char **buffer, uint32_t *length);
 void releaseDebuggerInputBuffer();
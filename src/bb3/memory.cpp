@@ -29,6 +29,8 @@ uint8_t *DLOG_RECORD_SAVE_BUFFER;
 uint8_t *FILE_VIEW_BUFFER;
 uint8_t *SOUND_TUNES_MEMORY;
 uint8_t *FILE_MANAGER_MEMORY;
+uint8_t *MMEM_DOWNLOAD_BUFFER;
+uint8_t *MMEM_UPLOAD_BUFFER;
 uint8_t *UART_BUFFER_MEMORY;
 uint8_t *VRAM_SCREENSHOOT_JPEG_OUT_BUFFER;
     
@@ -42,6 +44,8 @@ void initMemory() {
     FILE_VIEW_BUFFER = allocBuffer(FILE_VIEW_BUFFER_SIZE);
     SOUND_TUNES_MEMORY = allocBuffer(SOUND_TUNES_MEMORY_SIZE);
     FILE_MANAGER_MEMORY = allocBuffer(FILE_MANAGER_MEMORY_SIZE);
+    MMEM_DOWNLOAD_BUFFER = allocBuffer(MMEM_DOWNLOAD_BUFFER_SIZE);
+    MMEM_UPLOAD_BUFFER = allocBuffer(MMEM_UPLOAD_BUFFER_SIZE);
     UART_BUFFER_MEMORY = allocBuffer(UART_BUFFER_MEMORY_SIZE);
     VRAM_SCREENSHOOT_JPEG_OUT_BUFFER = allocBuffer(VRAM_SCREENSHOOT_JPEG_OUT_BUFFER_SIZE);
 
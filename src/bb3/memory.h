@@ -46,6 +46,12 @@ static const uint32_t SOUND_TUNES_MEMORY_SIZE = 32 * 1024;
 extern uint8_t *FILE_MANAGER_MEMORY;
 static const uint32_t FILE_MANAGER_MEMORY_SIZE = 256 * 1024;
 
+extern uint8_t *MMEM_DOWNLOAD_BUFFER;
+static const uint32_t MMEM_DOWNLOAD_BUFFER_SIZE = 64 * 1024;
+
+extern uint8_t *MMEM_UPLOAD_BUFFER;
+static const uint32_t MMEM_UPLOAD_BUFFER_SIZE = 32 * 1024;
+
 extern uint8_t *UART_BUFFER_MEMORY;
 static const uint32_t UART_BUFFER_MEMORY_SIZE = 256 * 1024;
 
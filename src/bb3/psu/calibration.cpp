@@ -755,6 +755,7 @@ bool CalibrationEditor::save() {
 
     if (channel) {
         memcpy(&channel->cal_conf, &calConf, sizeof(CalibrationConfiguration));
+        channel->compileCalibrationTables();
     } else {
         if (!g_slots[m_slotIndex]->setCalibrationConfiguration(m_subchannelIndex, calConf, nullptr)) {
             return false;
@@ -785,6 +786,7 @@ bool clear(int slotIndex, int subchannelIndex, int *err) {
         channel_dispatcher::calibrationEnable(*channel, false);
 
 		memcpy(&channel->cal_conf, &calConf, sizeof(CalibrationConfiguration));
+		channel->compileCalibrationTables();
     } else {
         g_slots[slotIndex]->enableVoltageCalibration(subchannelIndex, false);
         g_slots[slotIndex]->enableCurrentCalibration(subchannelIndex, false);
@@ -837,6 +839,75 @@ float remapValue(float value, CalibrationValueConfiguration &cal) {
         cal.points[j].dac);
 }
 
+static void compileTable(const float *x, const float *y, unsigned int numPoints, CalibrationValueTable &table) {
+    table.sorted = true;
+
+    if (numPoints < 2) {
+        table.numSegments = 1;
+        table.x1[0] = 0.0f;
+        table.y1[0] = 0.0f;
+        table.dy[0] = 1.0f;
+        table.dx[0] = 1.0f;
+        return;
+    }
+
+    table.numSegments = numPoints - 1;
+
+    for (unsigned int s = 0; s < numPoints - 1; s++) {
+        if (s > 0) {
+            table.breakpoints[s - 1] = x[s];
+            if (s > 1 && x[s] < x[s - 1]) {
+                table.sorted = false;
+            }
+        }
+
+        if (x[s] == x[s + 1]) {
+            // same as remapValue, value is not changed
+            table.x1[s] = 0.0f;
+            table.y1[s] = 0.0f;
+            table.dy[s] = 1.0f;
+            table.dx[s] = 1.0f;
+        } else {
+            table.x1[s] = x[s];
+            table.y1[s] = y[s];
+            table.dy[s] = y[s + 1] - y[s];
+            table.dx[s] = x[s + 1] - x[s];
+        }
+    }
+}
+
+void compileTables(const CalibrationValueConfiguration &cal, CalibrationValueTables &tables) {
+    float value[MAX_CALIBRATION_POINTS];
+    float dac[MAX_CALIBRATION_POINTS];
+    float adc[MAX_CALIBRATION_POINTS];
+
+    unsigned int numPoints = MIN(cal.numPoints, MAX_CALIBRATION_POINTS);
+    for (unsigned int i = 0; i < numPoints; i++) {
+        value[i] = cal.points[i].value;
+        dac[i] = cal.points[i].dac;
+        adc[i] = cal.points[i].adc;
+    }
+
+    compileTable(value, dac, numPoints, tables.dac);
+    compileTable(adc, value, numPoints, tables.adc);
+}
+
+void remapValues(const CalibrationValueTable &table, const float *values, float *result, int count) {
+    if (table.numSegments == 1) {
+        float x1 = table.x1[0];
+        float y1 = table.y1[0];
+        float dy = table.dy[0];
+        float dx = table.dx[0];
+        for (int i = 0; i < count; i++) {
+            result[i] = y1 + (values[i] - x1) * dy / dx;
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            result[i] = remapValue(values[i], table);
+        }
+    }
+}
+
 bool onHighPriorityThreadMessage(uint8_t type, uint32_t param) {
     if (type == PSU_MESSAGE_CALIBRATION_START) {
         int slotIndex = param >> 8;
@@ -169,6 +169,39 @@ void clearCalibrationConf(CalibrationConfiguration *calConf);
 
 float remapValue(float value, CalibrationValueConfiguration &cal);
 
+/// Compile calibration value configuration to the tables used for DAC and ADC remapping.
+void compileTables(const CalibrationValueConfiguration &cal, CalibrationValueTables &tables);
+
+inline int findSegment(const CalibrationValueTable &table, float value) {
+    int lo = 0;
+    int hi = table.numSegments - 1;
+
+    if (table.sorted) {
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (value > table.breakpoints[mid]) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+    } else {
+        while (lo < hi && value > table.breakpoints[lo]) {
+            lo++;
+        }
+    }
+
+    return lo;
+}
+
+inline float remapValue(float value, const CalibrationValueTable &table) {
+    int s = findSegment(table, value);
+    return table.y1[s] + (value - table.x1[s]) * table.dy[s] / table.dx[s];
+}
+
+/// Remap block of values, `values` and `result` can be the same array.
+void remapValues(const CalibrationValueTable &table, const float *values, float *result, int count);
+
 bool onHighPriorityThreadMessage(uint8_t type, uint32_t param);
 
 inline bool isChannelCalibrating(const Channel& channel) {
@@ -30,6 +30,7 @@
 #include <bb3/system.h>
 #include <bb3/psu/board.h>
 #include <bb3/psu/calibration.h>
+#include <bb3/psu/scheduler.h>
 #include <bb3/psu/channel_dispatcher.h>
 #include <bb3/psu/event_queue.h>
 #include <bb3/psu/io_pins.h>
@@ -328,6 +329,10 @@ void Channel::initParams(uint16_t moduleRevision) {
     flags.ccMode = 0;
 }
 
+const uint32_t PROTECTION_LATENCY_HISTOGRAM_LIMITS_US[PROTECTION_LATENCY_HISTOGRAM_SIZE - 1] = {
+    100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000
+};
+
 int Channel::reg_get_ques_isum_bit_mask_for_channel_protection_value(ProtectionValue &cpv) {
     if (IS_OVP_VALUE(this, cpv))
         return QUES_ISUM_OVP;
@@ -415,45 +420,52 @@ float Channel::getSwOvpProtectionLevel() {
     return channel_dispatcher::getUProtectionLevel(*this);
 }
 
-bool Channel::checkSwOvpCondition() {
-    float uProtectionLevel = getSwOvpProtectionLevel();
-    return channel_dispatcher::getUMonLast(*this) > uProtectionLevel || (flags.rprogEnabled && channel_dispatcher::getUMonDacLast(*this) > uProtectionLevel);
+static uint32_t getProtectionDelayUs(float delay) {
+    return delay > 0 ? (uint32_t)(delay * 1000000.0f) : 0;
 }
 
-void Channel::protectionCheck(ProtectionValue &cpv) {
-    bool state;
-    bool condition;
-    float delay;
+// Levels are used for every ADC sample, so they are calculated in advance:
+// when set values are changed and on every channel tick (for the changes
+// of protection configuration and coupling).
+void Channel::updateProtectionLevels() {
+    ovp.level = getSwOvpProtectionLevel();
+    ovp.delayUs = getProtectionDelayUs(prot_conf.u_delay - PROT_DELAY_CORRECTION);
 
-    if (IS_OVP_VALUE(this, cpv)) {
-        state = (flags.rprogEnabled || isOvpEnabled()) && !((params.features & CH_FEATURE_HW_OVP) && (prot_conf.flags.u_type && !flags.rprogEnabled) && !prot_conf.flags.u_hwOvpDeactivated);
-        condition = checkSwOvpCondition();
-        delay = prot_conf.u_delay;
-        delay -= PROT_DELAY_CORRECTION;
-    } else if (IS_OCP_VALUE(this, cpv)) {
-        state = prot_conf.flags.i_state;
-        condition = channel_dispatcher::getIMonLast(*this) >= getITrip();
-        delay = prot_conf.i_delay;
-        delay -= PROT_DELAY_CORRECTION;
-    } else {
-        state = prot_conf.flags.p_state;
-        condition = channel_dispatcher::getUMonLast(*this) * channel_dispatcher::getIMonLast(*this) > channel_dispatcher::getPowerProtectionLevel(*this);
-        delay = prot_conf.p_delay;
-    }
+    ocp.level = getITrip();
+    ocp.delayUs = getProtectionDelayUs(prot_conf.i_delay - PROT_DELAY_CORRECTION);
 
+    opp.level = channel_dispatcher::getPowerProtectionLevel(*this);
+    opp.delayUs = getProtectionDelayUs(prot_conf.p_delay);
+}
+
+void Channel::protectionCheck(ProtectionValue &cpv, bool state, bool condition, uint32_t timeUs, uint32_t prevTimeUs) {
     if (state && isOutputEnabled() && condition) {
-        if (delay > 0) {
-            if (cpv.flags.alarmed) {
-                if (millis() - cpv.alarmStartedMs >= delay * 1000UL) {
-                    cpv.flags.alarmed = 0;
-                    protectionEnter(cpv, false);
-                }
-            } else {
-                cpv.flags.alarmed = 1;
-                cpv.alarmStartedMs = millis();
-            }
-        } else {
+        if (!cpv.flags.alarmed) {
+            cpv.flags.alarmed = 1;
+            cpv.alarmStartedUs = timeUs;
+            cpv.conditionStartUs = prevTimeUs;
+        }
+
+        if (timeUs - cpv.alarmStartedUs >= cpv.delayUs) {
+            cpv.flags.alarmed = 0;
             protectionEnter(cpv, false);
+
+            int32_t latencyUs = (int32_t)(scheduler::getTimeUs() - cpv.conditionStartUs - cpv.delayUs);
+            if (latencyUs < 0) {
+                latencyUs = 0;
+            }
+
+            protectionLatency.numTrips++;
+            protectionLatency.lastLatencyUs = latencyUs;
+            if ((uint32_t)latencyUs > protectionLatency.maxLatencyUs) {
+                protectionLatency.maxLatencyUs = latencyUs;
+            }
+
+            int bucket = 0;
+            while (bucket < PROTECTION_LATENCY_HISTOGRAM_SIZE - 1 && (uint32_t)latencyUs > PROTECTION_LATENCY_HISTOGRAM_LIMITS_US[bucket]) {
+                bucket++;
+            }
+            protectionLatency.histogram[bucket]++;
         }
     } else {
         cpv.flags.alarmed = 0;
@@ -620,6 +632,8 @@ void Channel::tick() {
         return;
     }
 
+    updateProtectionLevels();
+
     tickSpecific();
 
     if (params.features & CH_FEATURE_RPOL) {
@@ -710,40 +724,16 @@ float Channel::roundChannelValue(Unit unit, float value) const {
     return roundPrec(value, getValuePrecision(unit, value));
 }
 
-float remapAdcValue(float value, CalibrationValueConfiguration &cal) {
-    unsigned i;
-    unsigned j;
-
-    if (cal.numPoints == 2) {
-        i = 0;
-        j = 1;
-    } else {
-        for (j = 1; j < cal.numPoints - 1 && value > cal.points[j].adc; j++) {
-        }
-        i = j - 1;
-    }
-
-    if (cal.points[i].adc == cal.points[j].adc) {
-    	return value;
-    }
-
-    return remap(value,
-        cal.points[i].adc,
-        cal.points[i].value,
-        cal.points[j].adc,
-        cal.points[j].value);
-}
-
 void Channel::addUMonAdcValue(float value) {
     if (isVoltageCalibrationEnabled()) {
-        value = remapAdcValue(value, cal_conf.u);
+        value = calibration::remapValue(value, cal_tables_u.adc);
     }
     u.addMonValue(value, getVoltageResolution());
 }
 
 void Channel::addIMonAdcValue(float value) {
     if (isCurrentCalibrationEnabled()) {
-        value = remapAdcValue(value, cal_conf.i[flags.currentCurrentRange]);
+        value = calibration::remapValue(value, cal_tables_i[flags.currentCurrentRange].adc);
     }
 
     // if (g_slots[slotIndex]->moduleType == MODULE_TYPE_DCP405 && value < 0 && isCvMode() &&  u.set >= 0.1f) {
@@ -801,10 +791,24 @@ void Channel::setCvMode(bool cv_mode) {
     }
 }
 
+// Called for every ADC sample, so the trip latency doesn't depend on the PSU thread load.
 void Channel::protectionCheck() {
-    protectionCheck(ovp);
-    protectionCheck(ocp);
-    protectionCheck(opp);
+    uint32_t timeUs = scheduler::getTimeUs();
+
+    // condition could start anywhere after the previous sample
+    uint32_t prevTimeUs = protectionCheckTimeUs != 0 ? protectionCheckTimeUs : timeUs;
+    protectionCheckTimeUs = isOutputEnabled() ? timeUs : 0;
+
+    float uMon = channel_dispatcher::getUMonLast(*this);
+    float iMon = channel_dispatcher::getIMonLast(*this);
+
+    bool ovpState = (flags.rprogEnabled || isOvpEnabled()) && !((params.features & CH_FEATURE_HW_OVP) && (prot_conf.flags.u_type && !flags.rprogEnabled) && !prot_conf.flags.u_hwOvpDeactivated);
+    bool ovpCondition = uMon > ovp.level || (flags.rprogEnabled && channel_dispatcher::getUMonDacLast(*this) > ovp.level);
+    protectionCheck(ovp, ovpState, ovpCondition, timeUs, prevTimeUs);
+
+    protectionCheck(ocp, prot_conf.flags.i_state, iMon >= ocp.level, timeUs, prevTimeUs);
+
+    protectionCheck(opp, prot_conf.flags.p_state, uMon * iMon > opp.level, timeUs, prevTimeUs);
 }
 
 void Channel::updateAllChannels() {
@@ -1071,6 +1075,8 @@ bool Channel::isOutputEnabled() {
 void Channel::doCalibrationEnable(bool enable) {
     flags.calEnabled = enable;
 
+    compileCalibrationTables();
+
     if (g_isBooted) {
     	setVoltage(u.set);
     	setCurrent(i.set);
@@ -1085,6 +1091,12 @@ void Channel::calibrationEnable(bool enabled) {
     }
 }
 
+void Channel::compileCalibrationTables() {
+    calibration::compileTables(cal_conf.u, cal_tables_u);
+    calibration::compileTables(cal_conf.i[0], cal_tables_i[0]);
+    calibration::compileTables(cal_conf.i[1], cal_tables_i[1]);
+}
+
 void Channel::calibrationEnableNoEvent(bool enabled) {
     if (enabled != isCalibrationEnabled()) {
         doCalibrationEnable(enabled);
@@ -1140,7 +1152,7 @@ bool Channel::isRemoteProgrammingEnabled() {
 
 float Channel::getCalibratedVoltage(float value) {
     if (isVoltageCalibrationEnabled()) {
-        value = calibration::remapValue(value, cal_conf.u);
+        value = calibration::remapValue(value, cal_tables_u.dac);
     }
 
 #if !defined(EEZ_PLATFORM_SIMULATOR)
@@ -1152,7 +1164,7 @@ float Channel::getCalibratedVoltage(float value) {
 
 float Channel::getCalibratedCurrent(float value) {
     if (isCurrentCalibrationEnabled()) {
-        value = calibration::remapValue(value, cal_conf.i[flags.currentCurrentRange]);
+        value = calibration::remapValue(value, cal_tables_i[flags.currentCurrentRange].dac);
     }
 
     value += getDualRangeGndOffset();
@@ -1168,11 +1180,23 @@ void Channel::doSetVoltage(float value) {
         prot_conf.u_level = u.set;
     }
 
+    onSetValueChanged();
+
 	value = getCalibratedVoltage(value);
 
     setDacVoltageFloat(value);
 }
 
+void Channel::onSetValueChanged() {
+    // protection levels of the coupled channels depend on both channels
+    if (channelIndex < 2 && channel_dispatcher::getCouplingType() != channel_dispatcher::COUPLING_TYPE_NONE) {
+        Channel::get(0).updateProtectionLevels();
+        Channel::get(1).updateProtectionLevels();
+    } else {
+        updateProtectionLevels();
+    }
+}
+
 void Channel::setVoltage(float value) {
     if (!calibration::isChannelCalibrating(*this)) {
         value = roundPrec(value, getVoltageResolution());
@@ -1197,6 +1221,8 @@ void Channel::doSetCurrent(float value) {
     i.set = value;
     i.mon_dac = 0;
 
+    onSetValueChanged();
+
     value = getCalibratedCurrent(value);
 
     setDacCurrentFloat(value);
@@ -211,7 +211,26 @@ struct ProtectionFlags {
 /// Runtime protection values
 struct ProtectionValue {
     ProtectionFlags flags;
-    uint32_t alarmStartedMs;
+    uint32_t alarmStartedUs;
+    /// Time of the previous ADC sample when condition was detected,
+    /// i.e. condition didn't exist before that moment. Used for the latency statistics.
+    uint32_t conditionStartUs;
+    /// Trip level and delay, precomputed by Channel::updateProtectionLevels()
+    float level;
+    uint32_t delayUs;
+};
+
+static const int PROTECTION_LATENCY_HISTOGRAM_SIZE = 10;
+
+/// Upper limits of the histogram buckets, last bucket is for everything above.
+extern const uint32_t PROTECTION_LATENCY_HISTOGRAM_LIMITS_US[PROTECTION_LATENCY_HISTOGRAM_SIZE - 1];
+
+/// Latency between protection condition and output off, without programmed protection delay.
+struct ProtectionLatencyStatistics {
+    uint32_t numTrips;
+    uint32_t lastLatencyUs;
+    uint32_t maxLatencyUs;
+    uint32_t histogram[PROTECTION_LATENCY_HISTOGRAM_SIZE];
 };
 
 enum ChannelMode {
@@ -419,12 +438,17 @@ public:
     float p_limit;
 
     CalibrationConfiguration cal_conf;
+    /// cal_conf compiled by compileCalibrationTables()
+    CalibrationValueTables cal_tables_u;
+    CalibrationValueTables cal_tables_i[2];
     ChannelProtectionConfiguration prot_conf;
 
     ProtectionValue ovp;
     ProtectionValue ocp;
     ProtectionValue opp;
 
+    ProtectionLatencyStatistics protectionLatency;
+
     DisplayValue displayValues[2];
     float ytViewRate;
 
@@ -474,6 +498,9 @@ public:
     /// Is channel calibration enabled?
     bool isCalibrationEnabled();
 
+    /// Must be called every time cal_conf is changed.
+    void compileCalibrationTables();
+
     /// Enable/disable remote sensing.
     void remoteSensingEnable(bool enable);
 
@@ -730,10 +757,11 @@ private:
     int reg_get_ques_isum_bit_mask_for_channel_protection_value(ProtectionValue &cpv);
 
     void clearProtectionConf();
-    void protectionCheck(ProtectionValue &cpv);
+    void updateProtectionLevels();
+    void onSetValueChanged();
+    void protectionCheck(ProtectionValue &cpv, bool state, bool condition, uint32_t timeUs, uint32_t prevTimeUs);
     void protectionCheck();
 
-    bool checkSwOvpCondition();
     float getSwOvpProtectionLevel();
 
     void doCalibrationEnable(bool enable);
@@ -752,6 +780,9 @@ private:
     static void executeOutputEnable(bool inhibited);
 
     uint32_t autoRangeCheckLastTickCountMs;
+
+    /// Time of the last protection check while output was enabled, 0 if unknown.
+    uint32_t protectionCheckTimeUs;
     void doAutoSelectCurrentRange();
 };
 
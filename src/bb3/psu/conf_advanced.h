@@ -84,6 +84,15 @@
 /// Temperature reading interval.
 #define TEMP_SENSOR_READ_EVERY_MS 1000
 
+/// Interval at which the PSU thread scheduler runs temperature tick.
+#define TEMPERATURE_TICK_INTERVAL_MS 100
+
+/// Interval at which the PSU thread scheduler runs fan tick (speed measurement and PID).
+#define FAN_TICK_INTERVAL_MS 100
+
+/// Interval at which the PSU thread scheduler runs date/time tick (DST check).
+#define DATETIME_TICK_INTERVAL_MS 500
+
 /// Minimum OTP delay
 #define OTP_AUX_MIN_DELAY 0.0f
 
@@ -213,8 +222,27 @@
 #define LIST_DWELL_MAX 65535.0f
 #define LIST_DWELL_DEF 0.01f
 
+// list point set later then this is counted as late
+#define CONF_LIST_LATE_POINT_THRESHOLD_US 500
+
 #define MAX_LIST_COUNT 65535
 
+// Function generator calculates new values every 200 us tick, this is max. number
+// of values (U or I) set in one tick. Every value change is transfer to the module,
+// so this limits update rate per channel to 5000 * N / (number of active resources) Hz.
+#define CONF_FUNCTION_GENERATOR_MAX_VALUE_CHANGES_PER_TICK 2
+
+// Event log is written in two segments (Logs/events0.bin and Logs/events1.bin) of this max. size,
+// so at most 2 * CONF_EVENT_LOG_SEGMENT_SIZE bytes are used on the SD card.
+#define CONF_EVENT_LOG_SEGMENT_SIZE (128 * 1024)
+
+// Number of the newest events, for each filter level, which are indexed in RAM and
+// can be browsed on the Event queue page.
+#define CONF_EVENT_LOG_INDEX_SIZE 500
+
+// Events from the write queue are collected in this buffer before written to the SD card.
+#define CONF_EVENT_LOG_WRITE_BUFFER_SIZE 2048
+
 #define LISTS_DIR (PATH_SEPARATOR "Lists")
 #define PROFILES_DIR (PATH_SEPARATOR "Profiles")
 #define RECORDINGS_DIR (PATH_SEPARATOR "Recordings")
@@ -262,6 +290,10 @@
 #define CONF_LIST_COUNDOWN_DISPLAY_THRESHOLD 5 // 5 seconds
 #define CONF_RAMP_COUNDOWN_DISPLAY_THRESHOLD 5 // 5 seconds
 
+/// During MMEM:DOWNload file is synced after this many bytes were written,
+/// and at the end of download
+#define CONF_MMEM_DOWNLOAD_SYNC_INTERVAL (1024 * 1024)
+
 #define CONF_SURVIVE_MODE 0
 
 #if CONF_SURVIVE_MODE
@@ -60,8 +60,21 @@ namespace dlog_record {
 #define CONF_DLOG_SYNC_FILE_TIME_MS 10000
 
 #define CONF_WRITE_TIMEOUT_MS 1000
+// max. time spent in one fileWrite call while draining, after that ring buffer overflow check takes over
+#define CONF_WRITE_DRAIN_TIMEOUT_MS (4 * CONF_WRITE_TIMEOUT_MS)
 #define CONF_WRITE_FLUSH_TIMEOUT_MS 10000
 
+// SD card sector size, chunks are written in multiples of this size (except when flushing)
+#define CONF_WRITE_ALIGN 512
+
+// minimum chunk size written when buffer fill level is below high watermark
+#define CONF_WRITE_CHUNK_MIN_SIZE (16 * 1024)
+
+// When buffer fill level reaches high watermark, writer stops yielding to the other
+// low priority thread tasks and drains the buffer until fill level drops below low watermark.
+#define CONF_HIGH_WATERMARK (DLOG_RECORD_BUFFER_SIZE / 2)
+#define CONF_LOW_WATERMARK (DLOG_RECORD_BUFFER_SIZE / 8)
+
 enum Event {
     EVENT_INITIATE,
     EVENT_INITIATE_TRACE,
@@ -95,6 +108,11 @@ static double g_nextTime;
 
 static unsigned int g_lastSavedBufferIndex;
 static uint32_t g_lastSavedBufferTickCount;
+static uint32_t g_lastSyncTickCount;
+static bool g_draining;
+
+static uint32_t g_peakFillLevel;
+static uint32_t g_peakWriteLatency;
 
 dlog_file::Writer g_writer;
 
@@ -130,6 +148,8 @@ static File g_bookmarksIndexFile;
 static File g_bookmarksTextFile;
 
 static int fileOpen() {
+    dlog_view::deleteMinMaxIndex(g_recordingParameters.filePath);
+
     if (!g_file.open(g_recordingParameters.filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
         event_queue::pushEvent(event_queue::EVENT_ERROR_DLOG_FILE_OPEN_ERROR);
         // TODO replace with more specific error
@@ -141,6 +161,21 @@ static int fileOpen() {
     return SCPI_RES_OK;
 }
 
+uint32_t getBufferFillLevel() {
+    return g_writer.getBufferIndex() - g_lastSavedBufferIndex;
+}
+
+uint32_t getBufferPeakFillLevel() {
+    return g_peakFillLevel;
+}
+
+uint32_t getPeakWriteLatency() {
+    return g_peakWriteLatency;
+}
+
+// Copies the next chunk of unsaved data from the DLOG_RECORD_BUFFER ring into the save buffer.
+// Chunk size adapts to the fill level: the more data is waiting, the larger the chunk
+// (up to DLOG_RECORD_SAVE_BUFFER_SIZE). Returns false if ring buffer overflowed.
 bool getNextWriteBuffer(const uint8_t *&buffer, uint32_t &bufferSize, bool flush) {
     buffer = nullptr;
     bufferSize = 0;
@@ -149,35 +184,40 @@ bool getNextWriteBuffer(const uint8_t *&buffer, uint32_t &bufferSize, bool flush
     taskENTER_CRITICAL();
 #endif
 	int32_t timeDiff = millis() - g_lastSavedBufferTickCount;
-	uint32_t indexDiff = (g_writer.getBufferIndex() - g_lastSavedBufferIndex);
+	uint32_t indexDiff = getBufferFillLevel();
 
-	if (indexDiff > 0 && (flush || timeDiff >= CONF_DLOG_SYNC_FILE_TIME_MS || indexDiff >= CHUNK_SIZE)) {
-		bufferSize = MIN(indexDiff, CHUNK_SIZE);
-		buffer = g_saveBuffer;
-
-		int32_t i = g_writer.getBufferIndex() - (g_lastSavedBufferIndex + DLOG_RECORD_BUFFER_SIZE);
+	if (indexDiff > g_peakFillLevel) {
+		g_peakFillLevel = indexDiff;
+	}
 
-		if (i <= 0) {
-			i = 0;
-		} else {
+	if (indexDiff > DLOG_RECORD_BUFFER_SIZE) {
+		// unsaved data is overwritten, ring buffer is truly full
 #if defined(EEZ_PLATFORM_STM32)
-            taskEXIT_CRITICAL();
+		taskEXIT_CRITICAL();
 #endif
-			abortAfterBufferOverflowError(0);
-			return false;
+		abortAfterBufferOverflowError(0);
+		return false;
+	}
+
+	uint32_t minChunkSize = g_draining ? CONF_WRITE_ALIGN : CONF_WRITE_CHUNK_MIN_SIZE;
+
+	if (indexDiff > 0 && (flush || timeDiff >= CONF_DLOG_SYNC_FILE_TIME_MS || indexDiff >= minChunkSize)) {
+		bufferSize = MIN(indexDiff, DLOG_RECORD_SAVE_BUFFER_SIZE);
+		if (!flush && bufferSize > CONF_WRITE_ALIGN) {
+			bufferSize -= bufferSize % CONF_WRITE_ALIGN;
 		}
 
-		if ((uint32_t)i < bufferSize) {
-			uint32_t tail = (g_lastSavedBufferIndex + i) % DLOG_RECORD_BUFFER_SIZE;
-			uint32_t head = (g_lastSavedBufferIndex + bufferSize) % DLOG_RECORD_BUFFER_SIZE;
-			if (tail < head) {
-				memcpy(g_saveBuffer + i, DLOG_RECORD_BUFFER + tail, head - tail);
-			} else {
-				uint32_t n = DLOG_RECORD_BUFFER_SIZE - tail;
-				memcpy(g_saveBuffer, DLOG_RECORD_BUFFER + tail, n);
-				if (head > 0) {
-					memcpy(g_saveBuffer + n, DLOG_RECORD_BUFFER, head);
-				}
+		buffer = g_saveBuffer;
+
+		uint32_t tail = g_lastSavedBufferIndex % DLOG_RECORD_BUFFER_SIZE;
+		uint32_t head = (g_lastSavedBufferIndex + bufferSize) % DLOG_RECORD_BUFFER_SIZE;
+		if (tail < head) {
+			memcpy(g_saveBuffer, DLOG_RECORD_BUFFER + tail, head - tail);
+		} else {
+			uint32_t n = DLOG_RECORD_BUFFER_SIZE - tail;
+			memcpy(g_saveBuffer, DLOG_RECORD_BUFFER + tail, n);
+			if (head > 0) {
+				memcpy(g_saveBuffer + n, DLOG_RECORD_BUFFER, head);
 			}
 		}
 	}
@@ -188,7 +228,17 @@ bool getNextWriteBuffer(const uint8_t *&buffer, uint32_t &bufferSize, bool flush
     return true;
 }
 
-// returns true if there is more data to write
+static void updateDraining() {
+    uint32_t fillLevel = getBufferFillLevel();
+    if (fillLevel >= CONF_HIGH_WATERMARK) {
+        g_draining = true;
+    } else if (fillLevel < CONF_LOW_WATERMARK) {
+        g_draining = false;
+    }
+}
+
+// Writer stage, drains the DLOG_RECORD_BUFFER ring filled by the PSU thread.
+// Called from the low priority thread.
 void fileWrite(bool flush) {
     if (!flush && g_state != STATE_EXECUTING) {
         return;
@@ -198,8 +248,11 @@ void fileWrite(bool flush) {
         return;
     }
 
-    uint32_t timeout = millis() + CONF_WRITE_TIMEOUT_MS;
-    while (millis() < timeout) {
+    uint32_t startTickCount = millis();
+
+    updateDraining();
+
+    while (true) {
         const uint8_t *buffer = nullptr;
         uint32_t bufferSize = 0;
 
@@ -208,30 +261,42 @@ void fileWrite(bool flush) {
         }
 
         if (!buffer) {
-            return;
+            break;
         }
 
-        int err = 0;
+#if defined(EEZ_PLATFORM_SIMULATOR)
+        simulator::injectSdCardWriteLatency();
+#endif
 
-        //g_debugVar3 = g_lastSavedBufferIndex;
+        uint32_t writeStartTickCount = millis();
         size_t written = g_file.write(buffer, bufferSize);
-        //g_debugVar3 = 0;
-
-        if (written != bufferSize) {
-            err = event_queue::EVENT_ERROR_DLOG_WRITE_ERROR;
-        }
-
-        if (!err) {
-            g_file.sync();
-            g_lastSavedBufferIndex += bufferSize;
-            g_lastSavedBufferTickCount = millis();
+        uint32_t writeLatency = millis() - writeStartTickCount;
+        if (writeLatency > g_peakWriteLatency) {
+            g_peakWriteLatency = writeLatency;
         }
 
-        if (err) {
+        if (written != bufferSize) {
             //DebugTrace("write error\n");
             sd_card::reinitialize();
             return;
         }
+
+        g_lastSavedBufferIndex += bufferSize;
+        g_lastSavedBufferTickCount = millis();
+
+        updateDraining();
+
+        // while draining, don't yield until fill level drops below low watermark
+        // or the card is too slow to get there in reasonable time
+        if (millis() - startTickCount >= (g_draining ? CONF_WRITE_DRAIN_TIMEOUT_MS : CONF_WRITE_TIMEOUT_MS)) {
+            break;
+        }
+    }
+
+    // sync periodically instead of after every chunk
+    if (flush || millis() - g_lastSyncTickCount >= CONF_DLOG_SYNC_FILE_TIME_MS) {
+        g_file.sync();
+        g_lastSyncTickCount = millis();
     }
 }
 
@@ -386,6 +451,10 @@ static int doStartImmediately() {
     g_currentTime = 0;
     g_nextTime = 0;
     g_lastSavedBufferIndex = 0;
+    g_lastSyncTickCount = millis();
+    g_draining = false;
+    g_peakFillLevel = 0;
+    g_peakWriteLatency = 0;
 
     memcpy(&g_activeRecording.parameters, &g_recordingParameters, sizeof(dlog_view::Parameters));
 
@@ -855,15 +924,78 @@ void tick() {
     }
 }
 
+static int32_t toTraceInt(const dlog_file::YAxis &yAxis, float value, int32_t minValue, int32_t maxValue) {
+    double rawValue = round((value - yAxis.transformOffset) / yAxis.transformScale);
+    if (isNaN(rawValue) || rawValue < minValue) {
+        return minValue;
+    }
+    if (rawValue > maxValue) {
+        return maxValue;
+    }
+    return (int32_t)rawValue;
+}
+
 void log(float *values) {
 	if (g_state == STATE_EXECUTING && g_nextTime < g_activeRecording.parameters.duration && !g_inStateTransition) {
+        if (g_activeRecording.parameters.dataContainsSampleValidityBit) {
+            g_writer.writeBit(1); // mark as valid sample
+            g_writer.flushBits();
+        }
+
         for (int yAxisIndex = 0; yAxisIndex < g_activeRecording.parameters.numYAxes; yAxisIndex++) {
-            g_writer.writeFloat(*values++);
+            auto &yAxis = g_activeRecording.parameters.yAxes[yAxisIndex];
+            if (yAxis.dataType == dlog_file::DATA_TYPE_INT16_BE) {
+                int32_t value = toTraceInt(yAxis, *values++, -32768, 32767);
+                uint8_t bytes[2] = { (uint8_t)(value >> 8), (uint8_t)value };
+                g_writer.writeInt16(bytes);
+            } else if (yAxis.dataType == dlog_file::DATA_TYPE_INT24_BE) {
+                int32_t value = toTraceInt(yAxis, *values++, -8388608, 8388607);
+                uint8_t bytes[3] = { (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+                g_writer.writeInt24(bytes);
+            } else {
+                g_writer.writeFloat(*values++);
+            }
         }
         ++g_activeRecording.size;
     }
 }
 
+uint32_t getTraceBlockRowSize() {
+    uint32_t rowSize = 0;
+    for (int yAxisIndex = 0; yAxisIndex < g_activeRecording.parameters.numYAxes; yAxisIndex++) {
+        auto dataType = g_activeRecording.parameters.yAxes[yAxisIndex].dataType;
+        if (dataType == dlog_file::DATA_TYPE_INT16_BE) {
+            rowSize += 2;
+        } else if (dataType == dlog_file::DATA_TYPE_INT24_BE) {
+            rowSize += 3;
+        } else {
+            rowSize += 4;
+        }
+    }
+    return rowSize;
+}
+
+// Rows are already encoded as they are stored in the file (FLOAT little endian,
+// INT16/INT24 big endian), only the validity byte has to be inserted.
+void logTraceBlock(const uint8_t *data, uint32_t numRows) {
+	if (g_state == STATE_EXECUTING && g_nextTime < g_activeRecording.parameters.duration && !g_inStateTransition) {
+        uint32_t rowSize = getTraceBlockRowSize();
+
+        if (g_activeRecording.parameters.dataContainsSampleValidityBit) {
+            for (uint32_t rowIndex = 0; rowIndex < numRows; rowIndex++) {
+                g_writer.writeBit(1); // mark as valid sample
+                g_writer.flushBits();
+                g_writer.writeBlock(data, rowSize);
+                data += rowSize;
+            }
+        } else {
+            g_writer.writeBlock(data, numRows * rowSize);
+        }
+
+        g_activeRecording.size += numRows;
+    }
+}
+
 void log(uint32_t bits) {
 	if (g_state == STATE_EXECUTING && g_nextTime < g_activeRecording.parameters.duration && !g_inStateTransition) {
         g_writer.writeBit(1); // mark as valid sample
@@ -72,6 +72,8 @@ void reset();
 void init();
 void tick();
 void log(float *values);
+uint32_t getTraceBlockRowSize();
+void logTraceBlock(const uint8_t *data, uint32_t numRows);
 void log(uint32_t bits);
 void logInt16(uint8_t *values, uint32_t bits);
 void logInt24(uint8_t *values, uint32_t bits);
@@ -79,6 +81,11 @@ void logInvalid();
 void logBookmark(const char *text, size_t textLen);
 
 void fileWrite(bool flush = false);
+
+// writer statistics, reset when recording is started
+uint32_t getBufferFillLevel();
+uint32_t getBufferPeakFillLevel();
+uint32_t getPeakWriteLatency();
 void stateTransition(int event, int *perr = nullptr);
 
 const char *getLatestFilePath();
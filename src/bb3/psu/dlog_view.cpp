@@ -33,6 +33,7 @@
 #include <bb3/psu/dlog_view.h>
 #include <bb3/psu/dlog_record.h>
 #include <bb3/psu/scpi/psu.h>
+#include <bb3/psu/sd_card.h>
 #include <bb3/psu/serial_psu.h>
 #include <bb3/psu/gui/psu.h>
 #include <bb3/psu/gui/animations.h>
@@ -105,6 +106,49 @@ static bool g_fileIsOpen;
 File g_file;
 uint32_t g_cacheRowIndexStart;
 uint32_t g_cacheRowIndexEnd;
+static int g_cacheLevel = -1;
+
+// Min/max pyramid index of the opened file. It is built lazily, after file is opened,
+// and stored next to the DLOG file as hidden ".<file name>.mmx" file.
+// Level 0 element holds min/max of MIN_MAX_INDEX_BASE_FACTOR rows and each next level
+// element holds min/max of MIN_MAX_INDEX_LEVEL_FACTOR elements from the previous level.
+// When zoomed out, block elements are loaded from the coarsest level that fits,
+// so number of rows touched doesn't depend on the zoom level.
+static const uint32_t MIN_MAX_INDEX_MAGIC = 0x584D4E4DL; // "MNMX"
+static const uint16_t MIN_MAX_INDEX_VERSION = 2;
+static const uint32_t MIN_MAX_INDEX_BASE_FACTOR = 16;
+static const uint32_t MIN_MAX_INDEX_LEVEL_FACTOR = 4;
+static const int MIN_MAX_INDEX_MAX_LEVELS = 12;
+static const uint32_t MIN_MAX_INDEX_BUILD_INPUT_BUFFER_SIZE = 32 * 1024;
+static const uint32_t MIN_MAX_INDEX_BUILD_OUTPUT_BUFFER_SIZE = 16 * 1024;
+
+struct MinMaxIndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t numLevels;
+    uint8_t numYAxes;
+    uint32_t fileSize;
+    uint32_t fileModifiedTime;
+    uint32_t dataOffset;
+    uint32_t numBytesPerRow;
+    uint32_t numSamples;
+    uint32_t levelOffset[MIN_MAX_INDEX_MAX_LEVELS];
+    uint32_t levelSize[MIN_MAX_INDEX_MAX_LEVELS];
+};
+
+static enum {
+    MIN_MAX_INDEX_STATE_NONE,
+    MIN_MAX_INDEX_STATE_BUILDING,
+    MIN_MAX_INDEX_STATE_READY
+} g_minMaxIndexState;
+static MinMaxIndexHeader g_minMaxIndexHeader;
+static char g_minMaxIndexFilePath[MAX_PATH_LENGTH + 1];
+static int g_minMaxIndexBuildLevel;
+static uint32_t g_minMaxIndexBuildPosition;
+static uint8_t *g_minMaxIndexBuildInputBuffer;
+static BlockElement *g_minMaxIndexBuildOutputBuffer;
+static void initMinMaxIndex();
+static void buildMinMaxIndex();
 
 static bool g_isLoading;
 static bool g_refreshed;
@@ -143,6 +187,8 @@ void init() {
     g_visibleBookmarksBuffer = g_bookmarksDataStart + BOOKMARKS_DATA_SIZE;
     g_visibleBookmarkIndexesBuffer = (uint32_t *)(g_visibleBookmarksBuffer + 2 * 480);
     g_blockElements = (BlockElement *)(g_visibleBookmarkIndexesBuffer + 2 * 480);
+    g_minMaxIndexBuildInputBuffer = (uint8_t *)(g_blockElements + 480 * MAX_NUM_OF_Y_AXES);
+    g_minMaxIndexBuildOutputBuffer = (BlockElement *)(g_minMaxIndexBuildInputBuffer + MIN_MAX_INDEX_BUILD_INPUT_BUFFER_SIZE);
 }
 
 void tick() {
@@ -152,6 +198,11 @@ void tick() {
 		if (g_bookmarksScrollPosition != g_loadedBookmarksScrollPosition) {
 			loadBookmarks();
 		}
+
+		// build min/max index only when visible samples are fully loaded
+		if (g_minMaxIndexState == MIN_MAX_INDEX_STATE_BUILDING && g_loadedRowIndex >= g_rowIndexEnd - g_rowIndexStart) {
+			buildMinMaxIndex();
+		}
 	}
 }
 
@@ -301,6 +352,58 @@ float getSample(Recording &recording, uint8_t *rowData, unsigned columnIndex) {
 	return value;
 }
 
+template <dlog_file::DataType DATA_TYPE>
+static void decodeColumn(const Recording &recording, unsigned columnIndex, const uint8_t *rowData, uint32_t numRows, float *values);
+
+template <>
+void decodeColumn<dlog_file::DATA_TYPE_BIT>(const Recording &recording, unsigned columnIndex, const uint8_t *rowData, uint32_t numRows, float *values) {
+	auto columnData = rowData + recording.columnDataIndexes[columnIndex];
+	auto bitMask = recording.columnBitMask[columnIndex];
+	auto numBytesPerRow = recording.numBytesPerRow;
+	for (uint32_t i = 0; i < numRows; i++, columnData += numBytesPerRow) {
+		values[i] = *columnData & bitMask ? 1.0f : 0.0f;
+	}
+}
+
+template <>
+void decodeColumn<dlog_file::DATA_TYPE_INT16_BE>(const Recording &recording, unsigned columnIndex, const uint8_t *rowData, uint32_t numRows, float *values) {
+	auto columnData = rowData + recording.columnDataIndexes[columnIndex];
+	auto transformOffset = recording.parameters.yAxes[columnIndex].transformOffset;
+	auto transformScale = recording.parameters.yAxes[columnIndex].transformScale;
+	auto numBytesPerRow = recording.numBytesPerRow;
+	for (uint32_t i = 0; i < numRows; i++, columnData += numBytesPerRow) {
+		auto iValue = int16_t((columnData[0] << 8) | columnData[1]);
+		values[i] = float(transformOffset + transformScale * iValue);
+	}
+}
+
+template <>
+void decodeColumn<dlog_file::DATA_TYPE_INT24_BE>(const Recording &recording, unsigned columnIndex, const uint8_t *rowData, uint32_t numRows, float *values) {
+	auto columnData = rowData + recording.columnDataIndexes[columnIndex];
+	auto transformOffset = recording.parameters.yAxes[columnIndex].transformOffset;
+	auto transformScale = recording.parameters.yAxes[columnIndex].transformScale;
+	auto numBytesPerRow = recording.numBytesPerRow;
+	for (uint32_t i = 0; i < numRows; i++, columnData += numBytesPerRow) {
+		auto iValue = ((int32_t)((columnData[0] << 24) | (columnData[1] << 16) | (columnData[2] << 8))) >> 8;
+		values[i] = float(transformOffset + transformScale * iValue);
+	}
+}
+
+template <>
+void decodeColumn<dlog_file::DATA_TYPE_FLOAT>(const Recording &recording, unsigned columnIndex, const uint8_t *rowData, uint32_t numRows, float *values) {
+	auto columnData = rowData + recording.columnDataIndexes[columnIndex];
+	auto numBytesPerRow = recording.numBytesPerRow;
+	for (uint32_t i = 0; i < numRows; i++, columnData += numBytesPerRow) {
+		memcpy(values + i, columnData, sizeof(float));
+	}
+}
+
+static void decodeColumnUnsupported(const Recording &recording, unsigned columnIndex, const uint8_t *rowData, uint32_t numRows, float *values) {
+	for (uint32_t i = 0; i < numRows; i++) {
+		values[i] = NAN;
+	}
+}
+
 static uint8_t *readMoreSamples(uint32_t rowIndex) {
 	if (!g_fileIsOpen) {
 		if (!g_file.open(g_filePath, FILE_OPEN_EXISTING | FILE_READ)) {
@@ -326,12 +429,316 @@ static uint8_t *readMoreSamples(uint32_t rowIndex) {
 		return nullptr;
 	}
 
+	g_cacheLevel = -1;
 	g_cacheRowIndexStart = rowIndex;
 	g_cacheRowIndexEnd = rowIndex + bytesRead / g_dlogFile.numBytesPerRow;
 
 	return g_rowDataStart;
 }
 
+static inline void updateBlockElement(BlockElement &blockElement, float min, float max) {
+	if (isnan(blockElement.min) || min < blockElement.min) {
+		blockElement.min = min;
+	}
+	if (isnan(blockElement.max) || max > blockElement.max) {
+		blockElement.max = max;
+	}
+}
+
+static const uint32_t DECODE_CHUNK_SIZE = 256;
+
+// Decodes column of numRows consecutive rows, using the kernel from the recording decode plan,
+// and updates block element min/max. Samples without validity bit are skipped.
+static void decodeColumnMinMax(Recording &recording, unsigned columnIndex, const uint8_t *rowData, uint32_t numRows, BlockElement &blockElement) {
+	float values[DECODE_CHUNK_SIZE];
+
+	auto numBytesPerRow = recording.numBytesPerRow;
+	auto decodeColumn = recording.decodeColumn[columnIndex];
+
+	while (numRows > 0) {
+		uint32_t n = MIN(numRows, DECODE_CHUNK_SIZE);
+
+		decodeColumn(recording, columnIndex, rowData, n, values);
+
+		if (recording.parameters.dataContainsSampleValidityBit) {
+			for (uint32_t i = 0; i < n; i++) {
+				if (!(rowData[i * numBytesPerRow] & 0x80)) {
+					values[i] = NAN;
+				}
+			}
+		}
+
+		// NAN values are skipped because comparison with NAN is always false
+		float min = INFINITY;
+		float max = -INFINITY;
+		for (uint32_t i = 0; i < n; i++) {
+			float value = values[i];
+			min = value < min ? value : min;
+			max = value > max ? value : max;
+		}
+
+		if (min <= max) {
+			updateBlockElement(blockElement, min, max);
+		}
+
+		rowData += n * numBytesPerRow;
+		numRows -= n;
+	}
+}
+
+static uint32_t getMinMaxIndexElementSize() {
+	return g_minMaxIndexHeader.numYAxes * sizeof(BlockElement);
+}
+
+static uint32_t getMinMaxIndexLevelFactor(int level) {
+	uint32_t factor = MIN_MAX_INDEX_BASE_FACTOR;
+	for (int i = 0; i < level; i++) {
+		factor *= MIN_MAX_INDEX_LEVEL_FACTOR;
+	}
+	return factor;
+}
+
+// returns the coarsest index level with at least one element per block, or -1 if raw rows must be used
+static int getMinMaxIndexLevel(unsigned numSamplesPerBlock) {
+	if (g_minMaxIndexState != MIN_MAX_INDEX_STATE_READY) {
+		return -1;
+	}
+
+	int level = -1;
+	uint32_t factor = MIN_MAX_INDEX_BASE_FACTOR;
+	for (int i = 0; i < g_minMaxIndexHeader.numLevels && factor <= numSamplesPerBlock; i++) {
+		level = i;
+		factor *= MIN_MAX_INDEX_LEVEL_FACTOR;
+	}
+	return level;
+}
+
+bool getMinMaxIndexFilePath(const char *filePath, char *indexFilePath, size_t indexFilePathSize) {
+	const char *fileName = strrchr(filePath, '/');
+	fileName = fileName ? fileName + 1 : filePath;
+	size_t dirLen = fileName - filePath;
+	if (dirLen + 1 + strlen(fileName) + 4 >= indexFilePathSize) {
+		return false;
+	}
+	memcpy(indexFilePath, filePath, dirLen);
+	snprintf(indexFilePath + dirLen, indexFilePathSize - dirLen, ".%s.mmx", fileName);
+	return true;
+}
+
+void deleteMinMaxIndex(const char *filePath) {
+	if (getFileTypeFromExtension(filePath) != FILE_TYPE_DLOG) {
+		return;
+	}
+
+	char indexFilePath[MAX_PATH_LENGTH + 1];
+	if (getMinMaxIndexFilePath(filePath, indexFilePath, sizeof(indexFilePath)) && sd_card::exists(indexFilePath, nullptr)) {
+		sd_card::deleteFile(indexFilePath, nullptr);
+	}
+}
+
+static void initMinMaxIndex() {
+	g_minMaxIndexState = MIN_MAX_INDEX_STATE_NONE;
+
+	// index is needed only if view can be zoomed out beyond MIN_MAX_INDEX_BASE_FACTOR samples per pixel
+	if (g_dlogFile.numSamples <= MIN_MAX_INDEX_BASE_FACTOR * 480) {
+		return;
+	}
+
+	if (!getMinMaxIndexFilePath(g_filePath, g_minMaxIndexFilePath, sizeof(g_minMaxIndexFilePath))) {
+		return;
+	}
+
+	// size and modification time identifies the file index is built for,
+	// index is also deleted when file is recorded or overwritten
+	FileInfo fileInfo;
+	if (fileInfo.fstat(g_filePath) != SD_FAT_RESULT_OK) {
+		return;
+	}
+
+	auto &header = g_minMaxIndexHeader;
+	memset(&header, 0, sizeof(header));
+	header.magic = MIN_MAX_INDEX_MAGIC;
+	header.version = MIN_MAX_INDEX_VERSION;
+	header.numYAxes = g_dlogFile.parameters.numYAxes;
+	header.fileSize = fileInfo.getSize();
+	header.fileModifiedTime = datetime::makeTime(
+		fileInfo.getModifiedYear(), fileInfo.getModifiedMonth(), fileInfo.getModifiedDay(),
+		fileInfo.getModifiedHour(), fileInfo.getModifiedMinute(), fileInfo.getModifiedSecond()
+	);
+	header.dataOffset = g_dlogFile.dataOffset;
+	header.numBytesPerRow = g_dlogFile.numBytesPerRow;
+	header.numSamples = g_dlogFile.numSamples;
+
+	uint32_t offset = sizeof(MinMaxIndexHeader);
+	uint32_t levelSize = (g_dlogFile.numSamples + MIN_MAX_INDEX_BASE_FACTOR - 1) / MIN_MAX_INDEX_BASE_FACTOR;
+	while (header.numLevels < MIN_MAX_INDEX_MAX_LEVELS) {
+		header.levelOffset[header.numLevels] = offset;
+		header.levelSize[header.numLevels] = levelSize;
+		header.numLevels++;
+
+		if (levelSize <= 480) {
+			break;
+		}
+
+		offset += levelSize * getMinMaxIndexElementSize();
+		levelSize = (levelSize + MIN_MAX_INDEX_LEVEL_FACTOR - 1) / MIN_MAX_INDEX_LEVEL_FACTOR;
+	}
+
+	// use existing index if it is complete and built for this file
+	File file;
+	if (file.open(g_minMaxIndexFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+		MinMaxIndexHeader existingHeader;
+		bool valid = file.read(&existingHeader, sizeof(existingHeader)) == sizeof(existingHeader) && memcmp(&existingHeader, &header, sizeof(header)) == 0;
+		file.close();
+		if (valid) {
+			g_minMaxIndexState = MIN_MAX_INDEX_STATE_READY;
+			return;
+		}
+	}
+
+	// write header with invalid magic, it is replaced with valid one when all levels are built
+	if (!file.open(g_minMaxIndexFilePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+		return;
+	}
+	header.magic = 0;
+	bool result = file.write(&header, sizeof(header)) == sizeof(header);
+	header.magic = MIN_MAX_INDEX_MAGIC;
+	file.close();
+	if (!result) {
+		return;
+	}
+
+	g_minMaxIndexBuildLevel = 0;
+	g_minMaxIndexBuildPosition = 0;
+	g_minMaxIndexState = MIN_MAX_INDEX_STATE_BUILDING;
+}
+
+// reduce the next chunk of rows (level 0) or previous level elements into the current level
+static bool buildMinMaxIndexChunk() {
+	auto &header = g_minMaxIndexHeader;
+	int level = g_minMaxIndexBuildLevel;
+	uint32_t elementSize = getMinMaxIndexElementSize();
+
+	uint32_t factor = level == 0 ? MIN_MAX_INDEX_BASE_FACTOR : MIN_MAX_INDEX_LEVEL_FACTOR;
+	uint32_t inputSize = level == 0 ? header.numBytesPerRow : elementSize;
+	uint32_t numInputs = level == 0 ? header.numSamples : header.levelSize[level - 1];
+
+	uint32_t numOutputs = MIN(MIN_MAX_INDEX_BUILD_INPUT_BUFFER_SIZE / inputSize / factor, MIN_MAX_INDEX_BUILD_OUTPUT_BUFFER_SIZE / elementSize);
+	numOutputs = MIN(numOutputs, header.levelSize[level] - g_minMaxIndexBuildPosition);
+
+	uint32_t inputIndex = g_minMaxIndexBuildPosition * factor;
+	uint32_t numInputsToRead = MIN(numOutputs * factor, numInputs - inputIndex);
+
+	File file;
+	if (!file.open(level == 0 ? g_filePath : g_minMaxIndexFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+		return false;
+	}
+	uint32_t inputOffset = (level == 0 ? header.dataOffset : header.levelOffset[level - 1]) + inputIndex * inputSize;
+	uint32_t bytesToRead = numInputsToRead * inputSize;
+	bool result = file.seek(inputOffset) && file.read(g_minMaxIndexBuildInputBuffer, bytesToRead) == bytesToRead;
+	file.close();
+	if (!result) {
+		return false;
+	}
+
+	for (uint32_t outputIndex = 0; outputIndex < numOutputs; outputIndex++) {
+		BlockElement *output = g_minMaxIndexBuildOutputBuffer + outputIndex * header.numYAxes;
+		for (uint32_t columnIndex = 0; columnIndex < header.numYAxes; columnIndex++) {
+			output[columnIndex].min = NAN;
+			output[columnIndex].max = NAN;
+		}
+
+		uint32_t i = outputIndex * factor;
+		uint32_t iEnd = MIN(i + factor, numInputsToRead);
+		if (level == 0) {
+			uint8_t *rowData = g_minMaxIndexBuildInputBuffer + i * inputSize;
+			for (uint32_t columnIndex = 0; columnIndex < header.numYAxes; columnIndex++) {
+				decodeColumnMinMax(g_dlogFile, columnIndex, rowData, iEnd - i, output[columnIndex]);
+			}
+		} else {
+			for (; i < iEnd; i++) {
+				BlockElement *input = (BlockElement *)(g_minMaxIndexBuildInputBuffer + i * inputSize);
+				for (uint32_t columnIndex = 0; columnIndex < header.numYAxes; columnIndex++) {
+					updateBlockElement(output[columnIndex], input[columnIndex].min, input[columnIndex].max);
+				}
+			}
+		}
+	}
+
+	if (!file.open(g_minMaxIndexFilePath, FILE_OPEN_ALWAYS | FILE_WRITE)) {
+		return false;
+	}
+	uint32_t bytesToWrite = numOutputs * elementSize;
+	result = file.seek(header.levelOffset[level] + g_minMaxIndexBuildPosition * elementSize) &&
+		file.write(g_minMaxIndexBuildOutputBuffer, bytesToWrite) == bytesToWrite;
+	file.close();
+	if (!result) {
+		return false;
+	}
+
+	g_minMaxIndexBuildPosition += numOutputs;
+	if (g_minMaxIndexBuildPosition == header.levelSize[level]) {
+		g_minMaxIndexBuildLevel++;
+		g_minMaxIndexBuildPosition = 0;
+	}
+
+	return true;
+}
+
+static void buildMinMaxIndex() {
+	uint32_t startTime = millis();
+
+	while (g_minMaxIndexBuildLevel < g_minMaxIndexHeader.numLevels) {
+		if (!buildMinMaxIndexChunk()) {
+			g_minMaxIndexState = MIN_MAX_INDEX_STATE_NONE;
+			return;
+		}
+
+		if (millis() - startTime > 50) {
+			return;
+		}
+	}
+
+	// all levels are built, write valid header
+	File file;
+	if (!file.open(g_minMaxIndexFilePath, FILE_OPEN_ALWAYS | FILE_WRITE)) {
+		g_minMaxIndexState = MIN_MAX_INDEX_STATE_NONE;
+		return;
+	}
+	bool result = file.seek(0) && file.write(&g_minMaxIndexHeader, sizeof(MinMaxIndexHeader)) == sizeof(MinMaxIndexHeader);
+	file.close();
+
+	g_minMaxIndexState = result ? MIN_MAX_INDEX_STATE_READY : MIN_MAX_INDEX_STATE_NONE;
+}
+
+static uint8_t *readMoreMinMaxIndexElements(int level, uint32_t elementIndex) {
+	if (!g_fileIsOpen) {
+		if (!g_file.open(g_minMaxIndexFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+			return nullptr;
+		}
+		g_fileIsOpen = true;
+	}
+
+	uint32_t elementSize = getMinMaxIndexElementSize();
+
+	if (!g_file.seek(g_minMaxIndexHeader.levelOffset[level] + elementIndex * elementSize)) {
+		return nullptr;
+	}
+
+	uint32_t numElements = MIN(ROW_DATA_BUFFER_SIZE / elementSize, g_minMaxIndexHeader.levelSize[level] - elementIndex);
+	uint32_t bytesToRead = numElements * elementSize;
+
+	if (g_file.read(g_rowDataStart, bytesToRead) != bytesToRead) {
+		return nullptr;
+	}
+
+	g_cacheLevel = level;
+	g_cacheRowIndexStart = elementIndex;
+	g_cacheRowIndexEnd = elementIndex + numElements;
+
+	return g_rowDataStart;
+}
+
 uint32_t g_liveBookmarkPoisition[480];
 
 void appendLiveBookmark(uint32_t position, const char *bookmarkText, size_t bookmarkTextLen) {
@@ -399,12 +806,73 @@ uint8_t *getLiveVisibleBookmarks() {
     return visibleBookmarks;
 }
 
+static void loadBlockElementsFromMinMaxIndex(int level, unsigned numSamplesPerBlock) {
+	uint32_t startTime = millis();
+
+	if (g_loadedRowIndex == 0 || g_cacheLevel != level) {
+		g_cacheRowIndexStart = 0;
+		g_cacheRowIndexEnd = 0;
+	}
+
+	uint32_t factor = getMinMaxIndexLevelFactor(level);
+	uint32_t levelSize = g_minMaxIndexHeader.levelSize[level];
+	uint32_t elementSize = getMinMaxIndexElementSize();
+
+	uint32_t n = g_rowIndexEnd - g_rowIndexStart;
+	while (g_loadedRowIndex < n) {
+		BlockElement *blockElementStart = g_blockElements + g_loadedRowIndex * g_dlogFile.parameters.numYAxes;
+
+		auto rowIndex = (uint32_t)round((g_rowIndexStart + g_loadedRowIndex) * g_loadScale);
+
+		uint32_t elementIndex = rowIndex / factor;
+		uint32_t elementIndexEnd = (rowIndex + numSamplesPerBlock) / factor;
+		if (elementIndexEnd <= elementIndex) {
+			elementIndexEnd = elementIndex + 1;
+		}
+		if (elementIndexEnd > levelSize) {
+			elementIndexEnd = levelSize;
+		}
+
+		for (; elementIndex < elementIndexEnd; elementIndex++) {
+			if (elementIndex < g_cacheRowIndexStart || elementIndex >= g_cacheRowIndexEnd) {
+				if (!readMoreMinMaxIndexElements(level, elementIndex)) {
+					goto Exit;
+				}
+			}
+
+			BlockElement *element = (BlockElement *)(g_rowDataStart + (elementIndex - g_cacheRowIndexStart) * elementSize);
+			for (uint32_t columnIndex = 0; columnIndex < g_dlogFile.parameters.numYAxes; columnIndex++) {
+				updateBlockElement(blockElementStart[columnIndex], element[columnIndex].min, element[columnIndex].max);
+			}
+		}
+
+		g_loadedRowIndex++;
+		g_refreshed = true;
+
+		if (millis() - startTime > 50) {
+			break;
+		}
+	}
+
+Exit:
+	if (g_fileIsOpen) {
+		g_file.close();
+		g_fileIsOpen = false;
+	}
+}
+
 static void loadBlockElements() {
 	auto numSamplesPerBlock = (unsigned)round(g_loadScale);
 
+	int level = getMinMaxIndexLevel(numSamplesPerBlock);
+	if (level != -1) {
+		loadBlockElementsFromMinMaxIndex(level, numSamplesPerBlock);
+		return;
+	}
+
 	uint32_t startTime = millis();
 
-	if (g_loadedRowIndex == 0) {
+	if (g_loadedRowIndex == 0 || g_cacheLevel != -1) {
 		g_cacheRowIndexStart = 0;
 		g_cacheRowIndexEnd = 0;
 	}
@@ -415,33 +883,28 @@ static void loadBlockElements() {
 
 		auto rowIndex = (uint32_t)round((g_rowIndexStart + g_loadedRowIndex) * g_loadScale);
 
-        uint8_t *rowData = g_rowDataStart + (rowIndex - g_cacheRowIndexStart) * g_dlogFile.numBytesPerRow;
+		uint32_t rowIndexEnd = rowIndex + numSamplesPerBlock;
 
-		for (unsigned blockSampleIndex = 0; blockSampleIndex < numSamplesPerBlock; blockSampleIndex++) {
+		while (rowIndex < rowIndexEnd) {
 			if (rowIndex < g_cacheRowIndexStart || rowIndex >= g_cacheRowIndexEnd) {
-				rowData = readMoreSamples(rowIndex);
-				if (!rowData) {
+				if (!readMoreSamples(rowIndex)) {
 					goto Exit;
 				}
+				if (rowIndex >= g_cacheRowIndexEnd) {
+					// no more rows in the file
+					break;
+				}
 			}
 
-            if (IS_VALID_SAMPLE(g_dlogFile, rowData)) {
-				BlockElement *blockElement = blockElementStart;
-				
-				for (uint32_t columnIndex = 0; columnIndex < g_dlogFile.parameters.numYAxes; columnIndex++, blockElement++) {
-					GET_SAMPLE(g_dlogFile, rowData, columnIndex);
-                    if (blockSampleIndex == 0) {
-                        blockElement->min = blockElement->max = value;
-                    } else if (value < blockElement->min) {
-                        blockElement->min = value;
-                    } else if (value > blockElement->max) {
-                        blockElement->max = value;
-                    }
-                }
-            }
+			// decode all the cached rows of this block column by column
+			uint32_t numRows = MIN(rowIndexEnd, g_cacheRowIndexEnd) - rowIndex;
+			uint8_t *rowData = g_rowDataStart + (rowIndex - g_cacheRowIndexStart) * g_dlogFile.numBytesPerRow;
+
+			for (uint32_t columnIndex = 0; columnIndex < g_dlogFile.parameters.numYAxes; columnIndex++) {
+				decodeColumnMinMax(g_dlogFile, columnIndex, rowData, numRows, blockElementStart[columnIndex]);
+			}
 
-			rowIndex++;
-            rowData += g_dlogFile.numBytesPerRow;
+			rowIndex += numRows;
 		}
 
 		g_loadedRowIndex++;
@@ -688,6 +1151,7 @@ void calcColumnIndexes(Recording &recording) {
 
             recording.columnDataIndexes[yAxisIndex] = columnDataIndex;
             recording.columnBitMask[yAxisIndex] = bitMask;
+            recording.decodeColumn[yAxisIndex] = decodeColumn<dlog_file::DATA_TYPE_BIT>;
 
             if (bitMask == 1) {
                 columnDataIndex += 1;
@@ -703,12 +1167,16 @@ void calcColumnIndexes(Recording &recording) {
 
             if (yAxis.dataType == dlog_file::DATA_TYPE_INT16_BE) {
                 columnDataIndex += 2;
+                recording.decodeColumn[yAxisIndex] = decodeColumn<dlog_file::DATA_TYPE_INT16_BE>;
             } else if (yAxis.dataType == dlog_file::DATA_TYPE_INT24_BE) {
                 columnDataIndex += 3;
+                recording.decodeColumn[yAxisIndex] = decodeColumn<dlog_file::DATA_TYPE_INT24_BE>;
             } else if (yAxis.dataType == dlog_file::DATA_TYPE_FLOAT) {
                 columnDataIndex += 4;
+                recording.decodeColumn[yAxisIndex] = decodeColumn<dlog_file::DATA_TYPE_FLOAT>;
             } else {
                 assert(false);
+                recording.decodeColumn[yAxisIndex] = decodeColumnUnsupported;
             }
         }
     }
@@ -1126,6 +1594,8 @@ bool openFile(const char *filePath, int *err) {
 	g_bookmarksScrollPosition = 0;
 	g_visibleBookmarks = 0;
 
+	g_minMaxIndexState = MIN_MAX_INDEX_STATE_NONE;
+
     File file;
     if (file.open(g_filePath, FILE_OPEN_EXISTING | FILE_READ)) {
         uint8_t *buffer = FILE_VIEW_BUFFER;
@@ -1261,6 +1731,8 @@ bool openFile(const char *filePath, int *err) {
 		g_loadScale = 1.0;
 
         loadBookmarks();
+
+        initMinMaxIndex();
     } else {
         g_state = STATE_ERROR;
     }
@@ -1301,8 +1773,8 @@ void uploadFile() {
 #endif
 
 #if OPTION_ETHERNET
-    if (!context && psu::ethernet::isConnected()) {
-        context = &psu::ethernet::g_scpiContext;
+    if (!context) {
+        context = psu::ethernet::getFirstConnectedScpiContext();
     }
 #endif
 
@@ -119,6 +119,11 @@ struct DlogValueParams {
     double div;
 };
 
+struct Recording;
+
+// decodes column values of numRows consecutive rows into values array
+typedef void (*DecodeColumnFunction)(const Recording &recording, unsigned columnIndex, const uint8_t *rowData, uint32_t numRows, float *values);
+
 struct Recording {
     Parameters parameters;
 
@@ -144,6 +149,9 @@ struct Recording {
     uint32_t columnDataIndexes[MAX_NUM_OF_Y_AXES];
     uint8_t columnBitMask[MAX_NUM_OF_Y_AXES];
     uint32_t numBytesPerRow;
+
+    // decode plan, kernel per column selected by data type in calcColumnIndexes
+    DecodeColumnFunction decodeColumn[MAX_NUM_OF_Y_AXES];
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -189,6 +197,12 @@ float getSample(Recording &recording, uint8_t *rowData, unsigned columnIndex);
 
 void appendLiveBookmark(uint32_t position, const char *bookmarkText, size_t bookmarkTextLen);
 
+// path of the hidden min/max index file built for the given DLOG file
+bool getMinMaxIndexFilePath(const char *filePath, char *indexFilePath, size_t indexFilePathSize);
+
+// deletes min/max index of the DLOG file, must be called when file is (re)created
+void deleteMinMaxIndex(const char *filePath);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // namespace dlog_view
@@ -44,33 +44,61 @@ namespace ethernet {
 
 TestResult g_testResult = TEST_FAILED;
 
-static bool g_isConnected = false;
+////////////////////////////////////////////////////////////////////////////////
+
+// Every client has its own parser context, input/output buffers and error queue.
+// Input is fed to the parsers one command line at the time in round robin
+// order, so a client sending a long batch of commands doesn't block the others.
+
+struct Client {
+    bool isConnected;
+    char *inputBuffer;
+    uint32_t inputBufferLength;
+    uint32_t inputBufferOffset;
+};
+
+static Client g_clients[MAX_SCPI_CLIENTS];
+static int g_nextClientIndex;
 
 ////////////////////////////////////////////////////////////////////////////////
 
 static const size_t OUTPUT_BUFFER_MAX_SIZE = 1024;
-static char g_outputBuffer[OUTPUT_BUFFER_MAX_SIZE];
+static char g_outputBuffers[MAX_SCPI_CLIENTS][OUTPUT_BUFFER_MAX_SIZE];
 
+template <int CLIENT_INDEX>
 size_t ethernetClientWrite(const char *data, size_t len) {
     g_messageAvailable = true;
-    return eez::mcu::ethernet::writeScpiBuffer(data, len);
+    return eez::mcu::ethernet::writeScpiBuffer(CLIENT_INDEX, data, len);
 }
 
-static OutputBufferWriter g_outputBufferWriter(&g_outputBuffer[0], OUTPUT_BUFFER_MAX_SIZE, ethernetClientWrite);
+static OutputBufferWriter g_outputBufferWriters[] = {
+    OutputBufferWriter(g_outputBuffers[0], OUTPUT_BUFFER_MAX_SIZE, ethernetClientWrite<0>),
+    OutputBufferWriter(g_outputBuffers[1], OUTPUT_BUFFER_MAX_SIZE, ethernetClientWrite<1>),
+    OutputBufferWriter(g_outputBuffers[2], OUTPUT_BUFFER_MAX_SIZE, ethernetClientWrite<2>),
+    OutputBufferWriter(g_outputBuffers[3], OUTPUT_BUFFER_MAX_SIZE, ethernetClientWrite<3>),
+};
+
+static_assert(sizeof(g_outputBufferWriters) / sizeof(OutputBufferWriter) == MAX_SCPI_CLIENTS, "one output buffer writer per client is required");
 
 ////////////////////////////////////////////////////////////////////////////////
 
+scpi_t g_scpiContexts[MAX_SCPI_CLIENTS];
+
+static int getClientIndex(scpi_t *context) {
+    return context - g_scpiContexts;
+}
+
 size_t SCPI_Write(scpi_t *context, const char *data, size_t len) {
-    return g_outputBufferWriter.write(data, len);
+    return g_outputBufferWriters[getClientIndex(context)].write(data, len);
 }
 
 scpi_result_t SCPI_Flush(scpi_t *context) {
-    g_outputBufferWriter.flush();
+    g_outputBufferWriters[getClientIndex(context)].flush();
     return SCPI_RES_OK;
 }
 
 int SCPI_Error(scpi_t *context, int_fast16_t err) {
-    return printError(context, err, g_outputBufferWriter);
+    return printError(context, err, g_outputBufferWriters[getClientIndex(context)]);
 }
 
 scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val) {
@@ -81,7 +109,7 @@ scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_
         snprintf(outputBuffer, sizeof(outputBuffer), "**CTRL %02x: 0x%X (%d)\r\n", ctrl, val, val);
     }
 
-    g_outputBufferWriter.write(outputBuffer, strlen(outputBuffer));
+    g_outputBufferWriters[getClientIndex(context)].write(outputBuffer, strlen(outputBuffer));
 
     return SCPI_RES_OK;
 }
@@ -96,17 +124,99 @@ scpi_result_t SCPI_Reset(scpi_t *context) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static scpi_reg_val_t g_scpiPsuRegs[SCPI_PSU_REG_COUNT];
-static scpi_psu_t g_scpiPsuContext = { g_scpiPsuRegs };
+static scpi_reg_val_t g_scpiPsuRegs[MAX_SCPI_CLIENTS][SCPI_PSU_REG_COUNT];
+static scpi_psu_t g_scpiPsuContexts[MAX_SCPI_CLIENTS];
 
 static scpi_interface_t g_scpiInterface = {
     SCPI_Error, SCPI_Write, SCPI_Control, SCPI_Flush, SCPI_Reset,
 };
 
-static char g_scpiInputBuffer[SCPI_PARSER_INPUT_BUFFER_LENGTH];
-static scpi_error_t g_errorQueueData[SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
+static char g_scpiInputBuffers[MAX_SCPI_CLIENTS][SCPI_PARSER_INPUT_BUFFER_LENGTH];
+static scpi_error_t g_errorQueueData[MAX_SCPI_CLIENTS][SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void initScpi(int clientIndex) {
+    g_scpiPsuContexts[clientIndex].registers = g_scpiPsuRegs[clientIndex];
+    scpi::init(g_scpiContexts[clientIndex], g_scpiPsuContexts[clientIndex], &g_scpiInterface,
+        g_scpiInputBuffers[clientIndex], SCPI_PARSER_INPUT_BUFFER_LENGTH,
+        g_errorQueueData[clientIndex], SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+}
+
+// registers and error queue of the disconnected client are not kept for the next client
+static void resetScpi(int clientIndex, bool isConnected) {
+    memset(g_scpiPsuRegs[clientIndex], 0, sizeof(g_scpiPsuRegs[clientIndex]));
+    initScpi(clientIndex);
+    if (isConnected) {
+        reg_init_conditions(&g_scpiContexts[clientIndex]);
+    }
+}
+
+static void releaseInputBuffer(int clientIndex) {
+    auto &client = g_clients[clientIndex];
+    if (client.inputBuffer) {
+        eez::mcu::ethernet::releaseScpiInputBuffer(clientIndex);
+        client.inputBuffer = nullptr;
+        client.inputBufferLength = 0;
+        client.inputBufferOffset = 0;
+    }
+}
+
+// returns false if client has no more input to process
+static bool inputCommand(int clientIndex) {
+    auto &client = g_clients[clientIndex];
+    if (!client.isConnected) {
+        return false;
+    }
 
-scpi_t g_scpiContext;
+    if (!client.inputBuffer) {
+        if (!eez::mcu::ethernet::isScpiInputAvailable(clientIndex)) {
+            return false;
+        }
+
+        char *buffer;
+        uint32_t length;
+        eez::mcu::ethernet::getScpiInputBuffer(clientIndex, &buffer, &length);
+        if (!buffer || !length) {
+            // connection is closed or empty buffer is received
+            return eez::mcu::ethernet::isScpiInputAvailable(clientIndex);
+        }
+
+        client.inputBuffer = buffer;
+        client.inputBufferLength = length;
+        client.inputBufferOffset = 0;
+    }
+
+    // up to and including the end of the line, or the rest of the buffer
+    const char *command = client.inputBuffer + client.inputBufferOffset;
+    uint32_t remaining = client.inputBufferLength - client.inputBufferOffset;
+    const char *endOfLine = (const char *)memchr(command, '\n', remaining);
+    uint32_t commandLength = endOfLine ? endOfLine - command + 1 : remaining;
+
+    client.inputBufferOffset += commandLength;
+
+    input(g_scpiContexts[clientIndex], command, commandLength);
+
+    if (client.inputBufferOffset == client.inputBufferLength) {
+        releaseInputBuffer(clientIndex);
+    }
+
+    return true;
+}
+
+static void processInput() {
+    bool busy;
+    do {
+        busy = false;
+        for (int i = 0; i < MAX_SCPI_CLIENTS; i++) {
+            int clientIndex = (g_nextClientIndex + i) % MAX_SCPI_CLIENTS;
+            if (inputCommand(clientIndex)) {
+                busy = true;
+            }
+        }
+        g_nextClientIndex = (g_nextClientIndex + 1) % MAX_SCPI_CLIENTS;
+    } while (busy);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -124,7 +234,9 @@ void init() {
 }
 
 void initScpi() {
-    scpi::init(g_scpiContext, g_scpiPsuContext, &g_scpiInterface, g_scpiInputBuffer, SCPI_PARSER_INPUT_BUFFER_LENGTH, g_errorQueueData, SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+    for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+        initScpi(clientIndex);
+    }
 }
 
 bool test() {
@@ -153,18 +265,18 @@ void onQueueMessage(uint32_t type, uint32_t param) {
         eez::mcu::ethernet::beginServer(persist_conf::devConf.ethernetScpiPort);
         //DebugTrace("Listening on port %d", (int)persist_conf::devConf.ethernetScpiPort);
     } else if (type == ETHERNET_CLIENT_CONNECTED) {
-        g_isConnected = true;
-        initScpi();
+        int clientIndex = param;
+        releaseInputBuffer(clientIndex);
+        g_clients[clientIndex].isConnected = true;
+        resetScpi(clientIndex, true);
     } else if (type == ETHERNET_CLIENT_DISCONNECTED) {
-        g_isConnected = false;
+        int clientIndex = param;
+        releaseInputBuffer(clientIndex);
+        g_clients[clientIndex].isConnected = false;
+        resetScpi(clientIndex, false);
     } else if (type == ETHERNET_INPUT_AVAILABLE) {
-        char *buffer;
-        uint32_t length;
-        eez::mcu::ethernet::getScpiInputBuffer(&buffer, &length);
-        if (buffer && length) {
-            input(g_scpiContext, (const char *)buffer, length);
-            eez::mcu::ethernet::releaseScpiInputBuffer();
-        }
+        // param is the client which received input, but all clients are served
+        processInput();
     }
 }
 
@@ -173,7 +285,30 @@ uint32_t getIpAddress() {
 }
 
 bool isConnected() {
-    return g_isConnected;
+    return getNumConnectedClients() > 0;
+}
+
+bool isClientConnected(int clientIndex) {
+    return g_clients[clientIndex].isConnected;
+}
+
+int getNumConnectedClients() {
+    int numConnectedClients = 0;
+    for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+        if (g_clients[clientIndex].isConnected) {
+            numConnectedClients++;
+        }
+    }
+    return numConnectedClients;
+}
+
+scpi_t *getFirstConnectedScpiContext() {
+    for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+        if (g_clients[clientIndex].isConnected) {
+            return &g_scpiContexts[clientIndex];
+        }
+    }
+    return nullptr;
 }
 
 void update() {
@@ -188,9 +323,13 @@ void update() {
             eez::mcu::ethernet::beginServer(persist_conf::devConf.ethernetScpiPort);
         }
     } else {
-        if (g_isConnected) {
+        if (isConnected()) {
             eez::mcu::ethernet::disconnectClients();
-            g_isConnected = false;
+            for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+                releaseInputBuffer(clientIndex);
+                g_clients[clientIndex].isConnected = false;
+                resetScpi(clientIndex, false);
+            }
         }
 
         eez::mcu::ethernet::endServer();
@@ -19,13 +19,14 @@
 #pragma once
 
 #include <bb3/psu/scpi/psu.h>
+#include <bb3/mcu/ethernet.h>
 
 namespace eez {
 namespace psu {
 namespace ethernet {
 
 extern TestResult g_testResult;
-extern scpi_t g_scpiContext;
+extern scpi_t g_scpiContexts[MAX_SCPI_CLIENTS];
 
 void init();
 void initScpi();
@@ -36,7 +37,13 @@ void onQueueMessage(uint32_t type, uint32_t param);
 
 uint32_t getIpAddress();
 
+// true if at least one client is connected
 bool isConnected();
+bool isClientConnected(int clientIndex);
+int getNumConnectedClients();
+
+// used when there is no SCPI command context, e.g. upload file initiated from GUI
+scpi_t *getFirstConnectedScpiContext();
 
 // this function is called when ethernet settings are changed,
 // and it should reconnect to the ethernet with these settings
@@ -59,12 +59,16 @@ static const int EVENTS_PER_PAGE = 8;
 
 static const int CONF_EVENT_LINE_WIDTH_PX = 448;
 
-static const char *LOG_FILE_NAME = "log.txt";
+// Log is written in two binary segments. When the active segment is full,
+// the other (older) one is truncated and becomes active.
+static const int NUM_LOG_SEGMENTS = 2;
+static const char *LOG_SEGMENT_FILE_NAMES[NUM_LOG_SEGMENTS] = {
+    "events0.bin",
+    "events1.bin"
+};
 
-static const char *LOG_DEBUG_INDEX_FILE_NAME   = "index1";
-static const char *LOG_INFO_INDEX_FILE_NAME    = "index2";
-static const char *LOG_WARNING_INDEX_FILE_NAME = "index3";
-static const char *LOG_ERROR_INDEX_FILE_NAME   = "index4";
+static const uint32_t LOG_SEGMENT_MAGIC = 0x474C5645; // "EVLG"
+static const uint32_t LOG_SEGMENT_VERSION = 1;
 
 static const char *EVENT_TYPE_NAMES[] = {
     "NONE",
@@ -77,6 +81,9 @@ static const char *EVENT_TYPE_NAMES[] = {
 static const int WRITE_QUEUE_MAX_SIZE = 50;
 static const size_t EVENT_MESSAGE_MAX_SIZE = 256;
 
+// max. number of events written in one batch, i.e. with one open/close of the log segment
+static const int WRITE_BATCH_MAX_SIZE = WRITE_QUEUE_MAX_SIZE;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 struct QueueEvent {
@@ -90,6 +97,45 @@ static uint8_t g_writeQueueHead = 0;
 static uint8_t g_writeQueueTail = 0;
 static bool g_writeQueueFull;
 
+static Statistics g_statistics;
+static uint32_t g_numLoggedDroppedEvents;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct LogSegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sequence;
+};
+
+// Record is followed by messageLength bytes of the message text,
+// message is stored only for the trace events.
+struct LogRecord {
+    uint32_t dateTime;
+    int16_t eventId;
+    int8_t channelIndex;
+    uint8_t messageLength;
+};
+
+static const size_t LOG_RECORD_MAX_SIZE = sizeof(LogRecord) + 255;
+
+static int g_activeLogSegment;
+static uint32_t g_activeLogSegmentSize;
+static bool g_isActiveLogSegmentOpen;
+static uint32_t g_logSegmentSequence;
+
+// Rolling index of the newest events for each filter level (DEBUG, INFO, WARNING and ERROR),
+// position of the event is log segment index in the highest bit and offset in the segment.
+struct LogIndex {
+    uint32_t positions[CONF_EVENT_LOG_INDEX_SIZE];
+    uint32_t head;
+    uint32_t count;
+};
+static LogIndex g_logIndex[EVENT_TYPE_ERROR];
+
+static uint8_t g_writeBatchBuffer[CONF_EVENT_LOG_WRITE_BUFFER_SIZE];
+static uint32_t g_writeBatchBufferSize;
+
 EEZ_MUTEX_DECLARE(eventQueue);
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -123,8 +169,8 @@ static int g_selectedEventIndex = -1;
 static void addEventToWriteQueue(int16_t eventId, char *message, int channelIndex);
 static bool getEventFromWriteQueue(QueueEvent *queueEvent);
 
-static void getIndexFilePath(int indexType, char *filePath);
-static void getLogFilePath(char *filePath);
+static void getLogSegmentFilePath(int segmentIndex, char *filePath);
+static void loadLog();
 
 static int getEventType(int16_t eventId);
 
@@ -132,7 +178,7 @@ static void setDisplayFromPosition(uint32_t position);
 
 static void refreshEvents();
 
-static void writeEvent(QueueEvent *event);
+static void writeEvents(int maxEvents);
 static void readEvents(uint32_t fromPosition);
 
 static Event *getEvent(uint32_t eventIndex);
@@ -147,16 +193,15 @@ void init() {
 void tick() {
     bool isSdCardMounted = sd_card::isMounted(nullptr, nullptr);
     if (isSdCardMounted != g_isSdCardMounted) {
+        if (isSdCardMounted) {
+            loadLog();
+        }
         g_refreshEvents = true;
     }
     g_isSdCardMounted = isSdCardMounted;
 
     if (g_isSdCardMounted) {
-        QueueEvent queueEvent;
-        if (getEventFromWriteQueue(&queueEvent)) {
-            writeEvent(&queueEvent);
-            g_previousDisplayFromPosition = -1;
-        }
+        writeEvents(WRITE_BATCH_MAX_SIZE);
     }
 
 #if OPTION_DISPLAY
@@ -175,10 +220,7 @@ void tick() {
 }
 
 void shutdownSave() {
-    QueueEvent queueEvent;
-    while (getEventFromWriteQueue(&queueEvent)) {
-        writeEvent(&queueEvent);
-    }
+    writeEvents(WRITE_QUEUE_MAX_SIZE);
 }
 
 int16_t getLastErrorEventId() {
@@ -350,6 +392,10 @@ void moveToTop() {
     setDisplayFromPosition(0);
 }
 
+const Statistics &getStatistics() {
+    return g_statistics;
+}
+
 void onEncoder(int counter) {
 #if defined(EEZ_PLATFORM_SIMULATOR)
     counter = -counter;
@@ -381,7 +427,11 @@ static bool getEventFromWriteQueue(QueueEvent *queueEvent) {
 }
 
 static void addEventToWriteQueue(int16_t eventId, char *message, int channelIndex) {
+    bool isWriteQueueHalfFull = false;
+
     if (EEZ_MUTEX_WAIT(eventQueue, 5)) {
+        g_statistics.numEvents++;
+
         g_writeQueue[g_writeQueueHead].dateTime = datetime::now();
         g_writeQueue[g_writeQueueHead].eventId = eventId;
         g_writeQueue[g_writeQueueHead].channelIndex = channelIndex;
@@ -394,6 +444,10 @@ static void addEventToWriteQueue(int16_t eventId, char *message, int channelInde
 
         if (g_writeQueueFull) {
             g_writeQueueTail = (g_writeQueueTail + 1) % WRITE_QUEUE_MAX_SIZE;    
+            if (g_isSdCardMounted) {
+                // oldest event is overwritten before it was written to the log
+                g_statistics.numDroppedEvents++;
+            }
         }
 
         g_writeQueueHead = (g_writeQueueHead + 1) % WRITE_QUEUE_MAX_SIZE;
@@ -402,6 +456,9 @@ static void addEventToWriteQueue(int16_t eventId, char *message, int channelInde
             g_writeQueueFull = true;
         }
 
+        int writeQueueSize = g_writeQueueFull ? WRITE_QUEUE_MAX_SIZE : (g_writeQueueHead - g_writeQueueTail + WRITE_QUEUE_MAX_SIZE) % WRITE_QUEUE_MAX_SIZE;
+        isWriteQueueHalfFull = writeQueueSize >= WRITE_QUEUE_MAX_SIZE / 2;
+
         if (!g_isSdCardMounted) {
             g_refreshEvents = true;
         }
@@ -409,22 +466,15 @@ static void addEventToWriteQueue(int16_t eventId, char *message, int channelInde
 		EEZ_MUTEX_RELEASE(eventQueue);
     }
 
-    if (isLowPriorityThread()) {
+    // Events are written in batches from the tick, but if low priority thread is
+    // pushing a lot of events without returning to the tick, write them now.
+    if (isLowPriorityThread() && isWriteQueueHalfFull) {
         tick();
     }
 }
 
-static void getIndexFilePath(int indexType, char *filePath) {
-    snprintf(filePath, MAX_PATH_LENGTH, "%s%s%s", LOGS_DIR, PATH_SEPARATOR,
-        indexType == EVENT_TYPE_DEBUG ? LOG_DEBUG_INDEX_FILE_NAME :
-        indexType == EVENT_TYPE_INFO ? LOG_INFO_INDEX_FILE_NAME :
-        indexType == EVENT_TYPE_WARNING ? LOG_WARNING_INDEX_FILE_NAME :
-        LOG_ERROR_INDEX_FILE_NAME
-    );
-}
-
-static void getLogFilePath(char *filePath) {
-    snprintf(filePath, MAX_PATH_LENGTH, "%s%s%s", LOGS_DIR, PATH_SEPARATOR, LOG_FILE_NAME);
+static void getLogSegmentFilePath(int segmentIndex, char *filePath) {
+    snprintf(filePath, MAX_PATH_LENGTH, "%s%s%s", LOGS_DIR, PATH_SEPARATOR, LOG_SEGMENT_FILE_NAMES[segmentIndex]);
 }
 
 static int getFilter() {
@@ -516,15 +566,7 @@ static void refreshEvents() {
     g_selectedEventIndex = -1;
 
     if (g_isSdCardMounted) {
-        char filePath[MAX_PATH_LENGTH];
-        getIndexFilePath(g_filter, filePath);
-
-        File file;
-        if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-            g_numEvents = file.size() / 4;
-            file.close();
-        }
-
+        g_numEvents = g_logIndex[g_filter - 1].count;
         g_refreshEvents = false;
     } else {
         g_numEvents = 0;
@@ -551,97 +593,317 @@ static void refreshEvents() {
     }
 }
 
-static bool writeToLog(QueueEvent *event, uint32_t &logOffset, int &eventType) {
-    char filePath[MAX_PATH_LENGTH];
-    getLogFilePath(filePath);
+static uint32_t makeLogPosition(int segmentIndex, uint32_t offset) {
+    return ((uint32_t)segmentIndex << 31) | offset;
+}
 
-    File file;
-    if (!file.open(filePath, FILE_OPEN_APPEND | FILE_WRITE)) {
+static int getLogPositionSegment(uint32_t position) {
+    return (int)(position >> 31);
+}
+
+static uint32_t getLogPositionOffset(uint32_t position) {
+    return position & 0x7FFFFFFF;
+}
+
+static void clearLogIndex() {
+    memset(g_logIndex, 0, sizeof(g_logIndex));
+}
+
+static void addToLogIndex(int eventType, uint32_t position) {
+    for (int filter = EVENT_TYPE_DEBUG; filter <= eventType; filter++) {
+        LogIndex &logIndex = g_logIndex[filter - 1];
+        logIndex.positions[logIndex.head] = position;
+        logIndex.head = (logIndex.head + 1) % CONF_EVENT_LOG_INDEX_SIZE;
+        if (logIndex.count < CONF_EVENT_LOG_INDEX_SIZE) {
+            logIndex.count++;
+        }
+    }
+}
+
+// Segment is about to be overwritten, events from it are the oldest ones in the index.
+static void removeSegmentFromLogIndex(int segmentIndex) {
+    for (int filter = EVENT_TYPE_DEBUG; filter <= EVENT_TYPE_ERROR; filter++) {
+        LogIndex &logIndex = g_logIndex[filter - 1];
+        while (logIndex.count > 0) {
+            uint32_t tail = (logIndex.head + CONF_EVENT_LOG_INDEX_SIZE - logIndex.count) % CONF_EVENT_LOG_INDEX_SIZE;
+            if (getLogPositionSegment(logIndex.positions[tail]) != segmentIndex) {
+                break;
+            }
+            logIndex.count--;
+
+            // displayed events moved, cached page and event count are stale
+            if (filter >= g_filter) {
+                g_refreshEvents = true;
+            }
+        }
+    }
+}
+
+// eventIndex 0 is the newest event
+static uint32_t getLogIndexPosition(int filter, uint32_t eventIndex) {
+    LogIndex &logIndex = g_logIndex[filter - 1];
+    return logIndex.positions[(logIndex.head + CONF_EVENT_LOG_INDEX_SIZE - 1 - eventIndex) % CONF_EVENT_LOG_INDEX_SIZE];
+}
+
+static bool isValidLogRecord(const LogRecord &record) {
+    if (getEventType(record.eventId) == EVENT_TYPE_NONE) {
         return false;
     }
+    bool isTrace = record.eventId == EVENT_DEBUG_TRACE || record.eventId == EVENT_INFO_TRACE || record.eventId == EVENT_ERROR_TRACE;
+    return isTrace || record.messageLength == 0;
+}
+
+static bool readLogSegmentHeader(File &file, LogSegmentHeader &header) {
+    return file.read(&header, sizeof(LogSegmentHeader)) == sizeof(LogSegmentHeader) &&
+        header.magic == LOG_SEGMENT_MAGIC && header.version == LOG_SEGMENT_VERSION;
+}
 
-    logOffset = file.size();
+// adds all the events from the segment to the index and returns the end of the last valid record
+static uint32_t scanLogSegment(File &file, int segmentIndex) {
+    uint32_t size = file.size();
+    uint32_t offset = sizeof(LogSegmentHeader);
 
     using namespace sd_card;
-    BufferedFileWrite bufferedFile(file);
+    BufferedFileRead bufferedFile(file);
 
-    int year, month, day, hour, minute, second;
-    datetime::breakTime(event->dateTime, year, month, day, hour, minute, second);
+    while (offset + sizeof(LogRecord) <= size) {
+        LogRecord record;
+        if (bufferedFile.read(&record, sizeof(LogRecord)) != sizeof(LogRecord) || !isValidLogRecord(record)) {
+            break;
+        }
+
+        uint32_t recordSize = sizeof(LogRecord) + record.messageLength;
+        if (offset + recordSize > size) {
+            break;
+        }
 
-    eventType = getEventType(event->eventId);
+        if (record.messageLength > 0) {
+            char message[EVENT_MESSAGE_MAX_SIZE];
+            if (bufferedFile.read(message, record.messageLength) != record.messageLength) {
+                break;
+            }
+        }
 
-    char dateTimeAndEventTypeStr[32];
-    snprintf(dateTimeAndEventTypeStr, sizeof(dateTimeAndEventTypeStr), "%04d-%02d-%02d %02d:%02d:%02d %s ", year, month, day, hour, minute, second, EVENT_TYPE_NAMES[eventType]);
-    bool result = bufferedFile.write((const uint8_t *)dateTimeAndEventTypeStr, strlen(dateTimeAndEventTypeStr));
+        addToLogIndex(getEventType(record.eventId), makeLogPosition(segmentIndex, offset));
 
-    if (result) {
-        if (event->eventId == EVENT_DEBUG_TRACE || event->eventId == EVENT_INFO_TRACE || event->eventId == EVENT_ERROR_TRACE) {
-            result = bufferedFile.write((const uint8_t *)event->message, strlen(event->message));
-        } else {
-            const char *message = getEventMessage(event->eventId);
-            if (event->channelIndex != -1) {
-                char buffer[128];
-                snprintf(buffer, sizeof(buffer), message, event->channelIndex + 1);
-                result = bufferedFile.write((const uint8_t *)buffer, strlen(buffer));
-            } else {
-                result = bufferedFile.write((const uint8_t *)message, strlen(message));
+        offset += recordSize;
+    }
+
+    return offset;
+}
+
+static void loadLog() {
+    clearLogIndex();
+
+    g_activeLogSegment = 0;
+    g_activeLogSegmentSize = 0;
+    g_logSegmentSequence = 0;
+
+    bool isValid[NUM_LOG_SEGMENTS];
+    uint32_t sequence[NUM_LOG_SEGMENTS];
+
+    for (int segmentIndex = 0; segmentIndex < NUM_LOG_SEGMENTS; segmentIndex++) {
+        isValid[segmentIndex] = false;
+
+        char filePath[MAX_PATH_LENGTH];
+        getLogSegmentFilePath(segmentIndex, filePath);
+
+        File file;
+        if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+            LogSegmentHeader header;
+            if (readLogSegmentHeader(file, header)) {
+                isValid[segmentIndex] = true;
+                sequence[segmentIndex] = header.sequence;
             }
+            file.close();
         }
+    }
+
+    if (!isValid[0] && !isValid[1]) {
+        return;
+    }
+
+    int newerSegment = isValid[1] && (!isValid[0] || (int32_t)(sequence[1] - sequence[0]) > 0) ? 1 : 0;
+    int olderSegment = 1 - newerSegment;
+
+    for (int segmentIndex = olderSegment, i = 0; i < NUM_LOG_SEGMENTS; segmentIndex = newerSegment, i++) {
+        if (!isValid[segmentIndex]) {
+            continue;
+        }
+
+        char filePath[MAX_PATH_LENGTH];
+        getLogSegmentFilePath(segmentIndex, filePath);
+
+        File file;
+        if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+            file.seek(sizeof(LogSegmentHeader));
+            uint32_t size = scanLogSegment(file, segmentIndex);
+            file.close();
 
-        if (result) {
-            result = bufferedFile.write((const uint8_t *)"\n", 1);
-            if (result) {
-                result = bufferedFile.flush();
+            if (segmentIndex == newerSegment) {
+                g_activeLogSegment = segmentIndex;
+                g_activeLogSegmentSize = size;
+                g_logSegmentSequence = sequence[segmentIndex];
             }
         }
     }
+}
+
+static bool openActiveLogSegment(File &file) {
+    char filePath[MAX_PATH_LENGTH];
+    getLogSegmentFilePath(g_activeLogSegment, filePath);
+
+    g_statistics.numFileOperations++;
+
+    if (g_activeLogSegmentSize == 0) {
+        if (!file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+            return false;
+        }
+        g_isActiveLogSegmentOpen = true;
+
+        LogSegmentHeader header;
+        header.magic = LOG_SEGMENT_MAGIC;
+        header.version = LOG_SEGMENT_VERSION;
+        header.sequence = ++g_logSegmentSequence;
+        memcpy(g_writeBatchBuffer, &header, sizeof(LogSegmentHeader));
+        g_writeBatchBufferSize = sizeof(LogSegmentHeader);
+        g_activeLogSegmentSize = sizeof(LogSegmentHeader);
+
+        return true;
+    }
+
+    if (!file.open(filePath, FILE_OPEN_ALWAYS | FILE_WRITE)) {
+        return false;
+    }
+    g_isActiveLogSegmentOpen = true;
+
+    // drop the partially written record, if any
+    if (file.size() > g_activeLogSegmentSize) {
+        file.truncate(g_activeLogSegmentSize);
+    }
 
-    file.close();
+    return file.seek(g_activeLogSegmentSize);
+}
+
+static bool flushWriteBatchBuffer(File &file) {
+    if (g_writeBatchBufferSize == 0) {
+        return true;
+    }
 
+    g_statistics.numFileOperations++;
+    bool result = file.write(g_writeBatchBuffer, g_writeBatchBufferSize) == g_writeBatchBufferSize;
+    g_writeBatchBufferSize = 0;
     return result;
 }
 
-static void writeToIndex(int indexType, uint32_t logOffset) {
-    char filePath[MAX_PATH_LENGTH];
-    getIndexFilePath(indexType, filePath);
+static bool closeActiveLogSegment(File &file) {
+    bool result = flushWriteBatchBuffer(file);
+    g_statistics.numFileOperations++;
+    g_isActiveLogSegmentOpen = false;
+    return file.close() && result;
+}
 
-    File file;
-    if (file.open(filePath, FILE_OPEN_APPEND | FILE_WRITE)) {
-        file.write((const uint8_t *)&logOffset, sizeof(uint32_t));
-        file.close();
+static bool rotateLog(File &file) {
+    if (!closeActiveLogSegment(file)) {
+        return false;
     }
+
+    g_activeLogSegment = (g_activeLogSegment + 1) % NUM_LOG_SEGMENTS;
+    g_activeLogSegmentSize = 0;
+    removeSegmentFromLogIndex(g_activeLogSegment);
+
+    g_statistics.numRotations++;
+
+    return openActiveLogSegment(file);
 }
 
-static void writeEvent(QueueEvent *event) {
-    uint32_t logOffset;
-    int eventType;
-    if (!writeToLog(event, logOffset, eventType)) {
-        return;
+static bool writeEvent(File &file, uint32_t dateTime, int16_t eventId, int channelIndex, const char *message) {
+    LogRecord record;
+    record.dateTime = dateTime;
+    record.eventId = eventId;
+    record.channelIndex = (int8_t)channelIndex;
+    size_t messageLength = message ? strlen(message) : 0;
+    record.messageLength = (uint8_t)MIN(messageLength, 255);
+
+    uint32_t recordSize = sizeof(LogRecord) + record.messageLength;
+
+    if (g_activeLogSegmentSize + recordSize > CONF_EVENT_LOG_SEGMENT_SIZE) {
+        if (!rotateLog(file)) {
+            return false;
+        }
+    }
+
+    if (g_writeBatchBufferSize + recordSize > sizeof(g_writeBatchBuffer)) {
+        if (!flushWriteBatchBuffer(file)) {
+            return false;
+        }
+    }
+
+    memcpy(g_writeBatchBuffer + g_writeBatchBufferSize, &record, sizeof(LogRecord));
+    if (record.messageLength > 0) {
+        memcpy(g_writeBatchBuffer + g_writeBatchBufferSize + sizeof(LogRecord), message, record.messageLength);
     }
+    g_writeBatchBufferSize += recordSize;
+
+    int eventType = getEventType(eventId);
+    addToLogIndex(eventType, makeLogPosition(g_activeLogSegment, g_activeLogSegmentSize));
+    g_activeLogSegmentSize += recordSize;
 
     if (eventType >= g_filter) {
         g_refreshEvents = true;
     }
 
-    writeToIndex(EVENT_TYPE_DEBUG, logOffset);
+    g_statistics.numWrittenEvents++;
+
+    return true;
+}
 
-    if (eventType == EVENT_TYPE_DEBUG) {
+// Writes events from the queue with one open, write and close of the log segment.
+static void writeEvents(int maxEvents) {
+    QueueEvent queueEvent;
+    if (!getEventFromWriteQueue(&queueEvent)) {
         return;
     }
 
-    writeToIndex(EVENT_TYPE_INFO, logOffset);
+    File file;
+    bool result = openActiveLogSegment(file);
 
-    if (eventType == EVENT_TYPE_INFO) {
-        return;
+    if (result) {
+        g_statistics.numBatches++;
     }
 
-    writeToIndex(EVENT_TYPE_WARNING, logOffset);
+    // mark the place in the log where some events are missing
+    uint32_t numDroppedEvents = g_statistics.numDroppedEvents;
+    if (result && numDroppedEvents != g_numLoggedDroppedEvents) {
+        g_numLoggedDroppedEvents = numDroppedEvents;
+        result = writeEvent(file, queueEvent.dateTime, EVENT_ERROR_TOO_MANY_LOG_EVENTS, -1, nullptr);
+    }
 
-    if (eventType == EVENT_TYPE_WARNING) {
-        return;
+    if (result) {
+        int numEvents = 0;
+        do {
+            bool isTrace = queueEvent.eventId == EVENT_DEBUG_TRACE || queueEvent.eventId == EVENT_INFO_TRACE || queueEvent.eventId == EVENT_ERROR_TRACE;
+            if (!writeEvent(file, queueEvent.dateTime, queueEvent.eventId, queueEvent.channelIndex, isTrace ? queueEvent.message : nullptr)) {
+                result = false;
+                break;
+            }
+        } while (++numEvents < maxEvents && getEventFromWriteQueue(&queueEvent));
     }
 
-    writeToIndex(EVENT_TYPE_ERROR, logOffset);
+    if (g_isActiveLogSegmentOpen) {
+        if (!closeActiveLogSegment(file)) {
+            result = false;
+        }
+    }
+
+    if (!result) {
+        // index and segment size could be out of sync with the file
+        g_writeBatchBufferSize = 0;
+        loadLog();
+        g_refreshEvents = true;
+    }
+
+    g_previousDisplayFromPosition = -1;
 }
 
 static void getEventInfoText(Event *e, char *text, int count) {
@@ -677,110 +939,81 @@ static void updateIsLongMessageText(Event &event) {
     event.isLongMessageText = display::measureStr(text, -1, font) > CONF_EVENT_LINE_WIDTH_PX;
 }
 
-static bool readEvent(File &indexFile, File &logFile, int eventIndex, Event &event) {
-    indexFile.seek(4 * (g_numEvents - 1 - eventIndex));
-    uint32_t logOffset;
-    if (indexFile.read(&logOffset, sizeof(uint32_t)) != sizeof(uint32_t)) {
-        return false;
+static void formatEventMessage(int16_t eventId, int channelIndex, const char *message, char *text, size_t count) {
+    if (message && message[0]) {
+        stringCopy(text, count, message);
+    } else {
+        const char *eventMessage = getEventMessage(eventId);
+        if (!eventMessage) {
+            text[0] = 0;
+        } else if (channelIndex == -1) {
+            stringCopy(text, count, eventMessage);
+        } else {
+            snprintf(text, count, eventMessage, channelIndex + 1);
+        }
     }
+}
 
-    logFile.seek(logOffset);
-    using namespace sd_card;
-    BufferedFileRead bufferedFile(logFile, 64);
-
-    unsigned int year;
-    if (!match(bufferedFile, year)) {
-        return false;
-    }
-    if (!match(bufferedFile, '-')) {
-        return false;
-    }
-    unsigned int month;
-    if (!match(bufferedFile, month)) {
-        return false;
-    }
-    if (!match(bufferedFile, '-')) {
-        return false;
-    }
-    unsigned int day;
-    if (!match(bufferedFile, day)) {
+static bool readEvent(File &logFile, uint32_t position, Event &event) {
+    if (!logFile.seek(getLogPositionOffset(position))) {
         return false;
     }
 
-    unsigned int hour;
-    if (!match(bufferedFile, hour)) {
+    uint8_t buffer[LOG_RECORD_MAX_SIZE];
+    uint32_t size = logFile.read(buffer, sizeof(buffer));
+    if (size < sizeof(LogRecord)) {
         return false;
     }
-    if (!match(bufferedFile, ':')) {
-        return false;
-    }
-    unsigned int minute;
-    if (!match(bufferedFile, minute)) {
-        return false;
-    }
-    if (!match(bufferedFile, ':')) {
-        return false;
-    }
-    unsigned int second;
-    if (!match(bufferedFile, second)) {
-        return false;
-    }
-
-    matchZeroOrMoreSpaces(bufferedFile);
-
-    char eventTypeStr[9];
-    matchUntil(bufferedFile, ' ', eventTypeStr, sizeof(eventTypeStr) - 1);
-    eventTypeStr[sizeof(eventTypeStr) - 1] = 0;
 
-    int eventType = EVENT_TYPE_NONE;
-
-    for (int i = EVENT_TYPE_DEBUG; i <= EVENT_TYPE_ERROR; i++) {
-        if (strcmp(eventTypeStr, EVENT_TYPE_NAMES[i]) == 0) {
-            eventType = i;
-            break;
-        }
-    }
-
-    if (eventType == EVENT_TYPE_NONE) {
+    LogRecord record;
+    memcpy(&record, buffer, sizeof(LogRecord));
+    if (!isValidLogRecord(record) || sizeof(LogRecord) + record.messageLength > size) {
         return false;
     }
 
     char message[EVENT_MESSAGE_MAX_SIZE];
-    matchUntil(bufferedFile, '\n', message, sizeof(message) - 1);
-    message[sizeof(message) - 1] = 0;
+    memcpy(message, buffer + sizeof(LogRecord), record.messageLength);
+    message[record.messageLength] = 0;
 
-    event.dateTime = datetime::makeTime(year, month, day, hour, minute, second);
-    event.eventType = eventType;
-    stringCopy(event.message, sizeof(event.message), message);
+    event.dateTime = record.dateTime;
+    event.eventType = getEventType(record.eventId);
+    formatEventMessage(record.eventId, record.channelIndex, message, event.message, sizeof(event.message));
 
     updateIsLongMessageText(event);
 
-    event.logOffset = logOffset;
+    event.logOffset = position;
 
     return true;
 }
 
 static void readEvents(uint32_t fromPosition) {
     if (g_isSdCardMounted) {
-        char filePath[MAX_PATH_LENGTH];
-        getIndexFilePath(g_filter, filePath);
-        File indexFile;
-        if (indexFile.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-            getLogFilePath(filePath);
-            File logFile;
-            if (logFile.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-                for (int i = 0; i < EVENTS_PER_PAGE; i++) {
-                    auto &event = g_events[i];
-                    if (fromPosition + i < g_numEvents) {
-                        if (readEvent(indexFile, logFile, fromPosition + i, event)) {
-                            continue;
-                        }
-                    }
-                    memset(&event, 0, sizeof(event));
+        File logFiles[NUM_LOG_SEGMENTS];
+        bool isOpen[NUM_LOG_SEGMENTS] = { false };
+
+        for (int i = 0; i < EVENTS_PER_PAGE; i++) {
+            auto &event = g_events[i];
+            if (fromPosition + i < g_numEvents) {
+                uint32_t position = getLogIndexPosition(g_filter, fromPosition + i);
+                int segmentIndex = getLogPositionSegment(position);
+
+                if (!isOpen[segmentIndex]) {
+                    char filePath[MAX_PATH_LENGTH];
+                    getLogSegmentFilePath(segmentIndex, filePath);
+                    isOpen[segmentIndex] = logFiles[segmentIndex].open(filePath, FILE_OPEN_EXISTING | FILE_READ);
+                }
+
+                if (isOpen[segmentIndex] && readEvent(logFiles[segmentIndex], position, event)) {
+                    continue;
                 }
-                logFile.close();
             }
-            indexFile.close();
+            memset(&event, 0, sizeof(event));
+        }
+
+        for (int segmentIndex = 0; segmentIndex < NUM_LOG_SEGMENTS; segmentIndex++) {
+            if (isOpen[segmentIndex]) {
+                logFiles[segmentIndex].close();
+            }
         }
     } else {
         if (EEZ_MUTEX_WAIT(eventQueue, 5)) {
@@ -801,17 +1034,7 @@ static void readEvents(uint32_t fromPosition) {
                             auto &event = g_events[k];
                             event.dateTime = g_writeQueue[i].dateTime;
                             event.eventType = eventType;
-                            if (g_writeQueue[i].channelIndex == -1 || g_writeQueue[i].message[0]) {
-                                stringCopy(event.message, sizeof(event.message),
-									g_writeQueue[i].eventId == EVENT_DEBUG_TRACE ||
-									g_writeQueue[i].eventId == EVENT_INFO_TRACE ||
-									g_writeQueue[i].eventId == EVENT_ERROR_TRACE ?
-										g_writeQueue[i].message : 
-										getEventMessage(g_writeQueue[i].eventId)
-								);
-                            } else {
-                                snprintf(event.message, sizeof(event.message), getEventMessage(g_writeQueue[i].eventId), g_writeQueue[i].channelIndex + 1);
-                            }
+                            formatEventMessage(g_writeQueue[i].eventId, g_writeQueue[i].channelIndex, g_writeQueue[i].message, event.message, sizeof(event.message));
                             updateIsLongMessageText(event);
                             event.logOffset = i;
                             if (++k == EVENTS_PER_PAGE) {
@@ -230,6 +230,17 @@ void pushChannelEvent(int16_t eventId, int channelIndex);
 void markAsRead();
 void moveToTop();
 
+struct Statistics {
+    uint32_t numEvents;         // pushed to the write queue
+    uint32_t numDroppedEvents;  // overwritten in the full write queue before written to the log
+    uint32_t numWrittenEvents;
+    uint32_t numBatches;
+    uint32_t numFileOperations; // open, write and close of the log segment
+    uint32_t numRotations;
+};
+
+const Statistics &getStatistics();
+
 void onEncoder(int couter);
 
 } // namespace event_queue
@@ -906,8 +906,8 @@ void uploadFile() {
 #endif
 
 #if OPTION_ETHERNET
-    if (!context && psu::ethernet::isConnected()) {
-        context = &psu::ethernet::g_scpiContext;
+    if (!context) {
+        context = psu::ethernet::getFirstConnectedScpiContext();
     }
 #endif
 
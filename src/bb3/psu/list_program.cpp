@@ -20,10 +20,18 @@
 
 #include <math.h>
 
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 #include <scpi/scpi.h>
 
 #include <bb3/system.h>
 #include <bb3/firmware.h>
+#include <bb3/tasks.h>
 
 #include <bb3/psu/psu.h>
 #include <bb3/psu/channel_dispatcher.h>
@@ -36,7 +44,6 @@
 
 #include <eez/fs/fs.h>
 
-#define CONF_COUNTER_THRESHOLD_IN_SECONDS 5
 #define CONF_SAVE_LIST_TIMEOUT_MS 2000
 
 namespace eez {
@@ -59,13 +66,30 @@ static struct {
     uint16_t count;
 } g_channelsLists[CH_MAX];
 
+// List precompiled at the execution start, values are rounded to the channel precision.
+struct ListPoint {
+    float voltage;
+    float current;
+    // in microseconds, or in milliseconds if DWELL_IN_MS_FLAG is set
+    uint32_t dwell;
+};
+
+static const uint32_t DWELL_IN_MS_FLAG = 0x80000000;
+
+static struct {
+    ListPoint points[MAX_LIST_LENGTH];
+    uint16_t numPoints;
+} g_schedules[CH_MAX];
+
 static struct {
     int32_t counter;
     int16_t it;
-    uint32_t nextPointTime;
-    int32_t currentRemainingDwellTime;
+    // absolute time (micros64) when the next point should be set
+    uint64_t nextPointTimeUs;
+    uint64_t lastTickTimeUs;
+    int32_t currentRemainingDwellTimeMs;
     float currentTotalDwellTime;
-    uint32_t lastTickCount;
+    TimingStatistics timingStatistics;
 } g_execution[CH_MAX];
 
 static bool g_active;
@@ -75,8 +99,74 @@ float g_savedCurrentLimit[CH_MAX];
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Timer is armed from the PSU thread with the time of the nearest point of all
+// the channels. When that time is reached PSU_MESSAGE_LIST_TICK is sent, so
+// the point is set without waiting for the next PSU thread pass.
+static volatile bool g_timerArmed;
+static volatile uint64_t g_timerDeadlineUs;
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+static std::mutex g_timerMutex;
+static std::condition_variable g_timerCondition;
+
+static void timerThread() {
+    using namespace std::chrono;
+
+    std::unique_lock<std::mutex> lock(g_timerMutex);
+    while (true) {
+        if (!g_timerArmed) {
+            g_timerCondition.wait(lock);
+            continue;
+        }
+
+        steady_clock::time_point deadline(duration_cast<steady_clock::duration>(microseconds(g_timerDeadlineUs)));
+        if (g_timerCondition.wait_until(lock, deadline) == std::cv_status::timeout) {
+            lock.unlock();
+            onTimerTick();
+            lock.lock();
+        }
+    }
+}
+#endif
+
+static void armTimer(uint64_t deadlineUs) {
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+    std::lock_guard<std::mutex> lock(g_timerMutex);
+#endif
+
+    // timer interrupt can come in between, deadline is valid only when armed
+    g_timerArmed = false;
+    g_timerDeadlineUs = deadlineUs;
+    g_timerArmed = true;
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+    g_timerCondition.notify_one();
+#endif
+}
+
+static void disarmTimer() {
+    g_timerArmed = false;
+}
+
+void onTimerTick() {
+    if (g_timerArmed && micros64() >= g_timerDeadlineUs) {
+        g_timerArmed = false;
+        sendMessageToPsu(PSU_MESSAGE_LIST_TICK, 0, 0);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void init() {
     reset();
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+    static bool g_timerThreadStarted;
+    if (!g_timerThreadStarted) {
+        std::thread(timerThread).detach();
+        g_timerThreadStarted = true;
+    }
+#endif
 }
 
 void resetChannelList(Channel &channel) {
@@ -533,9 +623,45 @@ void setActive(bool active, bool forceUpdate = false) {
     }
 }
 
+static ListPoint getListPoint(Channel &channel, int16_t it) {
+    auto &channelLists = g_channelsLists[channel.channelIndex];
+
+    ListPoint point;
+
+    point.voltage = channel_dispatcher::roundChannelValue(channel, UNIT_VOLT, channelLists.voltageList[it % channelLists.voltageListLength]);
+    point.current = channel_dispatcher::roundChannelValue(channel, UNIT_AMPER, channelLists.currentList[it % channelLists.currentListLength]);
+
+    uint64_t dwellUs = (uint64_t)round(channelLists.dwellList[it % channelLists.dwellListLength] * 1000000.0);
+    if (dwellUs < DWELL_IN_MS_FLAG) {
+        point.dwell = (uint32_t)dwellUs;
+    } else {
+        point.dwell = (uint32_t)(dwellUs / 1000) | DWELL_IN_MS_FLAG;
+    }
+
+    return point;
+}
+
+static uint64_t getDwellUs(const ListPoint &point) {
+    if (point.dwell & DWELL_IN_MS_FLAG) {
+        return (uint64_t)(point.dwell & ~DWELL_IN_MS_FLAG) * 1000;
+    }
+    return point.dwell;
+}
+
+static void buildSchedule(Channel &channel) {
+    auto &schedule = g_schedules[channel.channelIndex];
+    schedule.numPoints = maxListsSize(channel);
+    for (int16_t it = 0; it < schedule.numPoints; it++) {
+        schedule.points[it] = getListPoint(channel, it);
+    }
+}
+
 void executionStart(Channel &channel) {
+    buildSchedule(channel);
+
     g_execution[channel.channelIndex].it = -1;
     g_execution[channel.channelIndex].counter = g_channelsLists[channel.channelIndex].count;
+    memset(&g_execution[channel.channelIndex].timingStatistics, 0, sizeof(TimingStatistics));
 
     channel_dispatcher::setVoltage(channel, 0);
 
@@ -587,43 +713,59 @@ int maxListsSize(Channel &channel) {
     return maxSize;
 }
 
-bool setListValue(Channel &channel, int16_t it, int *err) {
-    float voltage = channel_dispatcher::roundChannelValue(channel, UNIT_VOLT, g_channelsLists[channel.channelIndex].voltageList[it % g_channelsLists[channel.channelIndex].voltageListLength]);
-    if (channel.isVoltageLimitExceeded(voltage)) {
+static bool setListPoint(Channel &channel, const ListPoint &point, int *err) {
+    if (channel.isVoltageLimitExceeded(point.voltage)) {
         g_errorChannelIndex = channel.channelIndex;
         *err = SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
         return false;
     }
 
-    float current = channel_dispatcher::roundChannelValue(channel, UNIT_AMPER, g_channelsLists[channel.channelIndex].currentList[it % g_channelsLists[channel.channelIndex].currentListLength]);
-    if (channel.isCurrentLimitExceeded(current)) {
+    if (channel.isCurrentLimitExceeded(point.current)) {
         g_errorChannelIndex = channel.channelIndex;
         *err = SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
         return false;
     }
 
-    if (channel.isPowerLimitExceeded(voltage, current, err)) {
+    if (channel.isPowerLimitExceeded(point.voltage, point.current, err)) {
         g_errorChannelIndex = channel.channelIndex;
         return false;
     }
 
-    if (channel_dispatcher::getUSet(channel) != voltage) {
-        channel_dispatcher::setVoltage(channel, voltage);
+    if (channel_dispatcher::getUSet(channel) != point.voltage) {
+        channel_dispatcher::setVoltage(channel, point.voltage);
     }
 
-    if (channel_dispatcher::getISet(channel) != current) {
-        channel_dispatcher::setCurrent(channel, current);
+    if (channel_dispatcher::getISet(channel) != point.current) {
+        channel_dispatcher::setCurrent(channel, point.current);
     }
 
     return true;
 }
 
+bool setListValue(Channel &channel, int16_t it, int *err) {
+    return setListPoint(channel, getListPoint(channel, it), err);
+}
+
+static void updateTimingStatistics(TimingStatistics &timingStatistics, uint32_t errorUs) {
+    timingStatistics.numPoints++;
+    if (errorUs > CONF_LIST_LATE_POINT_THRESHOLD_US) {
+        timingStatistics.numLatePoints++;
+    }
+    if (errorUs > timingStatistics.maxErrorUs) {
+        timingStatistics.maxErrorUs = errorUs;
+    }
+}
+
 void tick() {
     bool active = false;
 
+    uint64_t tickTimeUs = micros64();
+    uint64_t timerDeadlineUs = UINT64_MAX;
+
     for (int i = 0; i < CH_NUM; ++i) {
         Channel &channel = Channel::get(i);
-        if (g_execution[i].counter >= 0) {
+        auto &execution = g_execution[i];
+        if (execution.counter >= 0) {
             int channelIndex;
             if (channel_dispatcher::isTripped(channel, channelIndex)) {
                 setActive(false);
@@ -633,74 +775,71 @@ void tick() {
 
             active = true;
 
-            uint32_t tickCount;
-            bool tickCountInMillis = g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS;
-            if (tickCountInMillis) {
-                tickCount = millis();
-            } else {
-                tickCount = millis() * 1000;
-            }
-
             if (io_pins::isInhibited()) {
-                if (g_execution[i].it != -1) {
-                    g_execution[i].nextPointTime += tickCount - g_execution[i].lastTickCount;
+                if (execution.it != -1) {
+                    execution.nextPointTimeUs += tickTimeUs - execution.lastTickTimeUs;
                 }
-            } else {
-                bool set = false;
-
-                if (g_execution[i].it == -1) {
-                    set = true;
+            } else if (execution.it == -1 || tickTimeUs >= execution.nextPointTimeUs) {
+                uint64_t pointTimeUs;
+                if (execution.it == -1) {
+                    pointTimeUs = tickTimeUs;
                 } else {
-                    g_execution[i].currentRemainingDwellTime = g_execution[i].nextPointTime - tickCount;
-                    if (g_execution[i].currentRemainingDwellTime <= 0) {
-                        set = true;
-                    }
+                    pointTimeUs = execution.nextPointTimeUs;
                 }
 
-                if (set) {
-                    if (++g_execution[i].it == maxListsSize(channel)) {
-                        if (g_execution[i].counter > 0) {
-                            if (--g_execution[i].counter == 0) {
-                                g_execution[i].counter = -1;
-                                trigger::setTriggerFinished(channel);
-                                return;
-                            }
-                        }
+                auto &schedule = g_schedules[i];
 
-                        g_execution[i].it = 0;
+                if (++execution.it == schedule.numPoints) {
+                    if (execution.counter > 0) {
+                        if (--execution.counter == 0) {
+                            execution.counter = -1;
+                            trigger::setTriggerFinished(channel);
+                            continue;
+                        }
                     }
 
-                    int err;
-                    if (!setListValue(channel, g_execution[i].it, &err)) {
-						psu::gui::psuErrorMessage(channelIndex, MakeScpiErrorValue(err));
-                        setActive(false);
-                        trigger::abort();
-                        return;
-                    }
+                    execution.it = 0;
+                }
 
-                    g_execution[i].currentTotalDwellTime = g_channelsLists[i] .dwellList[g_execution[i].it % g_channelsLists[i].dwellListLength];
-                    // if dwell time is greater then CONF_COUNTER_THRESHOLD_IN_SECONDS ...
-                    if (g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
-                        // ... then count in milliseconds
-                        g_execution[i].currentRemainingDwellTime = (uint32_t)round(g_execution[i].currentTotalDwellTime * 1000L);
-                        if (!tickCountInMillis) {
-                            tickCount /= 1000;
-                        }
-                    } else {
-                        // ... else count in microseconds
-                        g_execution[i].currentRemainingDwellTime = (uint32_t)round(g_execution[i].currentTotalDwellTime * 1000000L);
-                        if (tickCountInMillis) {
-                            tickCount *= 1000;
-                        }
-                    }
-                    g_execution[i].nextPointTime = tickCount + g_execution[i].currentRemainingDwellTime;
+                auto &point = schedule.points[execution.it];
+
+                int err;
+                if (!setListPoint(channel, point, &err)) {
+                    psu::gui::psuErrorMessage(channelIndex, MakeScpiErrorValue(err));
+                    setActive(false);
+                    trigger::abort();
+                    return;
                 }
+
+                updateTimingStatistics(execution.timingStatistics, (uint32_t)MIN(tickTimeUs - pointTimeUs, UINT32_MAX));
+
+                execution.currentTotalDwellTime = g_channelsLists[i].dwellList[execution.it % g_channelsLists[i].dwellListLength];
+
+                // next point time is calculated from the time this point should be set
+                // and not from the time it was actually set, so the errors don't accumulate
+                execution.nextPointTimeUs = pointTimeUs + getDwellUs(point);
+            }
+
+            if (execution.nextPointTimeUs > tickTimeUs) {
+                execution.currentRemainingDwellTimeMs = (int32_t)((execution.nextPointTimeUs - tickTimeUs) / 1000);
+            } else {
+                execution.currentRemainingDwellTimeMs = 0;
             }
 
-            g_execution[i].lastTickCount = tickCount;
+            execution.lastTickTimeUs = tickTimeUs;
+
+            if (execution.nextPointTimeUs < timerDeadlineUs) {
+                timerDeadlineUs = execution.nextPointTimeUs;
+            }
         }
     }
 
+    if (timerDeadlineUs != UINT64_MAX) {
+        armTimer(timerDeadlineUs);
+    } else {
+        disarmTimer();
+    }
+
     if (active != g_active) {
         setActive(active);
     }
@@ -752,17 +891,19 @@ bool getCurrentDwellTime(Channel &channel, int32_t &remaining, uint32_t &total)
     int i = channel.flags.trackingEnabled ? getFirstTrackingChannel() : channel.channelIndex;
     if (g_execution[i].counter >= 0) {
         total = (uint32_t)ceilf(g_execution[i].currentTotalDwellTime);
-        if (g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
-            remaining = (uint32_t)ceil(g_execution[i].currentRemainingDwellTime / 1000L);
-        } else {
-            remaining = (uint32_t)ceil(g_execution[i].currentRemainingDwellTime / 1000000L);
-        }
+        remaining = (g_execution[i].currentRemainingDwellTimeMs + 999) / 1000;
         return true;
     }
     return false;
 }
 
+const TimingStatistics &getTimingStatistics(int channelIndex) {
+    return g_execution[channelIndex].timingStatistics;
+}
+
 void abort() {
+    disarmTimer();
+
     for (int i = 0; i < CH_NUM; ++i) {
         if (g_execution[i].counter >= 0) {
             g_execution[i].counter = -1;
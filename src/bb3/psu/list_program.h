@@ -35,6 +35,14 @@ class BufferedFileWrite;
 
 namespace list {
 
+// Timing of the list points, error is the difference between the time point
+// was set and the time it should be set.
+struct TimingStatistics {
+    uint32_t numPoints;
+    uint32_t numLatePoints;
+    uint32_t maxErrorUs;
+};
+
 void init();
 
 void resetChannelList(Channel &channel);
@@ -107,6 +115,11 @@ bool setListValue(Channel &channel, int16_t it, int *err);
 
 void tick();
 
+// called from the timer interrupt (in simulator from the timer thread)
+void onTimerTick();
+
+const TimingStatistics &getTimingStatistics(int channelIndex);
+
 bool isActive();
 bool isActive(Channel &channel);
 
@@ -469,6 +469,7 @@ void initChannels() {
     for (int i = 0; i < CH_NUM; ++i) {
         auto &channel = Channel::get(i);
         loadChannelCalibrationConfiguration(channel.slotIndex, channel.subchannelIndex, channel.cal_conf);
+        channel.compileCalibrationTables();
     }
 }
 
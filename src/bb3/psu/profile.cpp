@@ -45,6 +45,8 @@
 
 #define CONF_PROFILE_SAVE_TIMEOUT_MS 2000
 
+#define PROFILE_SNAPSHOT_EXT ".snapshot"
+
 namespace eez {
 namespace psu {
 namespace profile {
@@ -85,6 +87,9 @@ enum {
     LOAD_PROFILE_FROM_FILE_OPTION_ONLY_NAME = 0x01
 };
 static bool loadProfileFromFile(const char *filePath, Parameters &profile, List *lists, int options, bool showProgress, int *err);
+static bool loadProfileFromLocation(int location, Parameters &profile, List *lists, int options, bool showProgress, int *err);
+
+static void deleteProfileSnapshot(int location);
 
 static bool doSaveToLastLocation(int *err);
 static bool doRecallFromLastLocation(int *err);
@@ -153,12 +158,9 @@ bool recallFromLocation(int location, int recallOptions, bool showProgress, int
         return doRecallFromLastLocation(err);
     }
 
-    char filePath[MAX_PATH_LENGTH];
-    getProfileFilePath(location, filePath, sizeof(filePath));
-
     Parameters profile;
     resetProfileToDefaults(profile);
-    if (!loadProfileFromFile(filePath, profile, g_listsProfile0, 0, showProgress, err)) {
+    if (!loadProfileFromLocation(location, profile, g_listsProfile0, 0, showProgress, err)) {
         return false;
     }
 
@@ -315,6 +317,8 @@ bool deleteLocation(int location, bool showProgress, int *err) {
 
         g_profilesCache[location].flags.isValid = false;
 
+        deleteProfileSnapshot(location);
+
         char filePath[MAX_PATH_LENGTH];
         getProfileFilePath(location, filePath, sizeof(filePath));
         if (!sd_card::exists(filePath, err)) {
@@ -451,10 +455,8 @@ void loadProfileParametersToCache(int location) {
         
         sendMessageToLowPriorityThread(THREAD_MESSAGE_LOAD_PROFILE, location);
     } else {
-        char filePath[MAX_PATH_LENGTH];
-        getProfileFilePath(location, filePath, sizeof(filePath));
         int err;
-        if (!loadProfileFromFile(filePath, g_profilesCache[location], nullptr, 0, false, &err)) {
+        if (!loadProfileFromLocation(location, g_profilesCache[location], nullptr, 0, false, &err)) {
             if (err != SCPI_ERROR_FILE_NOT_FOUND && err != SCPI_ERROR_MISSING_MASS_MEDIA) {
                 generateError(err);
             }
@@ -499,6 +501,11 @@ static void getProfileFilePath(int location, char *filePath, size_t filePathStrL
         PROFILES_DIR, PATH_SEPARATOR, location, getExtensionFromFileType(FILE_TYPE_PROFILE));
 }
 
+static void getProfileSnapshotFilePath(int location, char *filePath, size_t filePathStrLength) {
+    snprintf(filePath, filePathStrLength, "%s%s%d%s",
+        PROFILES_DIR, PATH_SEPARATOR, location, PROFILE_SNAPSHOT_EXT);
+}
+
 static void resetProfileToDefaults(Parameters &profile) {
     memset(&profile, 0, sizeof(Parameters));
 
@@ -1172,6 +1179,8 @@ static bool saveProfileToFile(const char *filePath, Parameters &profile, List *l
         return false;
     }
 
+    deleteSnapshot(filePath);
+
     uint32_t timeout = millis() + CONF_PROFILE_SAVE_TIMEOUT_MS;
     while (millis() < timeout) {
         File file;
@@ -1220,7 +1229,11 @@ static void saveStateToProfile0(bool merge) {
 ReadContext::ReadContext(File &file_)
     : result(true)
     , file(file_)
+    , groupNamePrefixLength(0)
+    , groupNameIndex(0)
+    , propertyNameHash(0)
 {
+    groupName[0] = 0;
 }
 
 bool ReadContext::doRead(bool (*callback)(ReadContext &ctx, Parameters &parameters, List *lists), Parameters &parameters, List *lists, int options, bool showProgress) {
@@ -1244,10 +1257,12 @@ bool ReadContext::doRead(bool (*callback)(ReadContext &ctx, Parameters &paramete
             if (!sd_card::matchUntil(file, ']', groupName)) {
                 return false;
             }
+            onGroupName();
         } else {
             if (!sd_card::matchUntil(file, '=', propertyName)) {
                 return false;
             }
+            propertyNameHash = hashPropertyName(propertyName);
 
             if (callback(*this, parameters, lists)) {
                 if (!result) {
@@ -1275,19 +1290,37 @@ bool ReadContext::matchGroup(const char *groupName_) {
 }
 
 bool ReadContext::matchGroup(const char *groupNamePrefix, int &index) {
-    auto prefixLength = strlen(groupNamePrefix);
-    if (strncmp(groupName, groupNamePrefix, prefixLength) != 0) {
+    if (groupNamePrefixLength == 0 || strncmp(groupName, groupNamePrefix, groupNamePrefixLength) != 0 || groupNamePrefix[groupNamePrefixLength] != 0) {
         return false;
     }
 
-    const char *startptr = groupName + prefixLength;
-    char *endptr;
-    index = strtol(startptr, &endptr, 10);
-    return endptr > startptr;
+    index = groupNameIndex;
+    return true;
+}
+
+void ReadContext::onGroupName() {
+    // index is at the end of the group name
+    size_t length = strlen(groupName);
+    size_t prefixLength = length;
+    while (prefixLength > 0 && groupName[prefixLength - 1] >= '0' && groupName[prefixLength - 1] <= '9') {
+        prefixLength--;
+    }
+
+    if (prefixLength < length) {
+        groupNamePrefixLength = prefixLength;
+        groupNameIndex = strtol(groupName + prefixLength, nullptr, 10);
+    } else {
+        groupNamePrefixLength = 0;
+        groupNameIndex = 0;
+    }
 }
 
-bool ReadContext::property(const char *name, int &value) {
-	if (strcmp(propertyName, name) != 0) {
+bool ReadContext::matchProperty(const PropertyName &name) {
+    return name.hash == propertyNameHash && strcmp(propertyName, name.name) == 0;
+}
+
+bool ReadContext::property(const PropertyName &name, int &value) {
+	if (!matchProperty(name)) {
 		return false;
 	}
 
@@ -1301,8 +1334,8 @@ bool ReadContext::property(const char *name, int &value) {
 	return true;
 }
 
-bool ReadContext::property(const char *name, unsigned int &value) {
-    if (strcmp(propertyName, name) != 0) {
+bool ReadContext::property(const PropertyName &name, unsigned int &value) {
+    if (!matchProperty(name)) {
         return false;
     }
 
@@ -1316,8 +1349,8 @@ bool ReadContext::property(const char *name, unsigned int &value) {
     return true;
 }
 
-bool ReadContext::property(const char *name, uint16_t &value) {
-    if (strcmp(propertyName, name) != 0) {
+bool ReadContext::property(const PropertyName &name, uint16_t &value) {
+    if (!matchProperty(name)) {
         return false;
     }
 
@@ -1331,8 +1364,8 @@ bool ReadContext::property(const char *name, uint16_t &value) {
     return true;
 }
 
-bool ReadContext::property(const char *name, uint8_t &value) {
-    if (strcmp(propertyName, name) != 0) {
+bool ReadContext::property(const PropertyName &name, uint8_t &value) {
+    if (!matchProperty(name)) {
         return false;
     }
 
@@ -1346,8 +1379,8 @@ bool ReadContext::property(const char *name, uint8_t &value) {
     return true;
 }
 
-bool ReadContext::property(const char *name, bool &value) {
-    if (strcmp(propertyName, name) != 0) {
+bool ReadContext::property(const PropertyName &name, bool &value) {
+    if (!matchProperty(name)) {
         return false;
     }
 
@@ -1361,8 +1394,8 @@ bool ReadContext::property(const char *name, bool &value) {
     return true;
 }
 
-bool ReadContext::property(const char *name, float &value) {
-    if (strcmp(propertyName, name) != 0) {
+bool ReadContext::property(const PropertyName &name, float &value) {
+    if (!matchProperty(name)) {
         return false;
     }
 
@@ -1376,8 +1409,8 @@ bool ReadContext::property(const char *name, float &value) {
     return true;
 }
 
-bool ReadContext::property(const char *name, char *str, unsigned int strLength) {
-    if (strcmp(propertyName, name) != 0) {
+bool ReadContext::property(const PropertyName &name, char *str, unsigned int strLength) {
+    if (!matchProperty(name)) {
         return false;
     }
 
@@ -1388,8 +1421,8 @@ bool ReadContext::property(const char *name, char *str, unsigned int strLength)
     return true;
 }
 
-bool ReadContext::listProperty(const char *name, int channelIndex, List *lists) {
-    if (strcmp(propertyName, name) != 0) {
+bool ReadContext::listProperty(const PropertyName &name, int channelIndex, List *lists) {
+    if (!matchProperty(name)) {
         return false;
     }
 
@@ -1571,6 +1604,311 @@ static bool loadProfileFromFile(const char *filePath, Parameters &profile, List
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Binary snapshot is the result of parsing the text profile: Parameters and
+// lists as they are after loadProfileFromFile. It is saved next to the text
+// profile when it is recalled for the first time and used for the next
+// recalls as long as firmware build and modules are not changed.
+// Every writer of the profile file (save, copy, move, delete and MMEM download)
+// deletes the snapshot, see deleteSnapshot. Size and modification time of the
+// profile file are only checked for the changes made outside of the firmware,
+// i.e. when SD card is edited on PC.
+
+static const uint32_t PROFILE_SNAPSHOT_MAGIC = 0x50414E53; // "SNAP"
+static const uint32_t PROFILE_SNAPSHOT_VERSION = 3;
+
+struct ProfileSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t buildId;
+    uint32_t modulesId;
+    uint32_t profileFileSize;
+    uint32_t profileFileDateTime;
+    uint32_t parametersSize;
+    uint32_t parametersCrc;
+    uint32_t listsCrc;
+};
+
+// followed by dwell, voltage and current list values
+struct ProfileSnapshotList {
+    uint16_t dwellListLength;
+    uint16_t voltageListLength;
+    uint16_t currentListLength;
+    uint16_t reserved;
+};
+
+static bool isProfileSnapshotAllowed(int location) {
+    // profile 0 is saved too often and the last location is not saved to the file
+    return location > 0 && location < NUM_PROFILE_LOCATIONS - 1;
+}
+
+static uint32_t getBuildId() {
+    const char *build[] = { MCU_FIRMWARE, MCU_FIRMWARE_BUILD_DATE, MCU_FIRMWARE_BUILD_TIME };
+    uint32_t crcs[3];
+    for (int i = 0; i < 3; i++) {
+        crcs[i] = crc32((const uint8_t *)build[i], strlen(build[i]));
+    }
+    return crc32((const uint8_t *)crcs, sizeof(crcs));
+}
+
+// profile defaults depends on the installed modules
+static uint32_t getModulesId() {
+    uint16_t modules[2 * NUM_SLOTS];
+    for (int i = 0; i < NUM_SLOTS; i++) {
+        modules[2 * i] = g_slots[i]->moduleType;
+        modules[2 * i + 1] = g_slots[i]->moduleRevision;
+    }
+    return crc32((const uint8_t *)modules, sizeof(modules));
+}
+
+static bool getProfileFileInfo(const char *filePath, uint32_t &fileSize, uint32_t &fileDateTime) {
+    FileInfo fileInfo;
+    if (fileInfo.fstat(filePath) != SD_FAT_RESULT_OK) {
+        return false;
+    }
+
+    fileSize = fileInfo.getSize();
+    fileDateTime = datetime::makeTime(
+        fileInfo.getModifiedYear(), fileInfo.getModifiedMonth(), fileInfo.getModifiedDay(),
+        fileInfo.getModifiedHour(), fileInfo.getModifiedMinute(), fileInfo.getModifiedSecond()
+    );
+
+    return true;
+}
+
+static uint32_t getListsCrc(List *lists) {
+    // crc32 is calculated separately for every part (HW CRC on STM32 can't continue previous calculation)
+    uint32_t crcs[CH_MAX * 4];
+
+    for (int i = 0; i < CH_MAX; i++) {
+        auto &list = lists[i];
+
+        ProfileSnapshotList snapshotList;
+        snapshotList.dwellListLength = list.dwellListLength;
+        snapshotList.voltageListLength = list.voltageListLength;
+        snapshotList.currentListLength = list.currentListLength;
+        snapshotList.reserved = 0;
+
+        crcs[4 * i] = crc32((const uint8_t *)&snapshotList, sizeof(snapshotList));
+        crcs[4 * i + 1] = crc32((const uint8_t *)list.dwellList, list.dwellListLength * sizeof(float));
+        crcs[4 * i + 2] = crc32((const uint8_t *)list.voltageList, list.voltageListLength * sizeof(float));
+        crcs[4 * i + 3] = crc32((const uint8_t *)list.currentList, list.currentListLength * sizeof(float));
+    }
+
+    return crc32((const uint8_t *)crcs, sizeof(crcs));
+}
+
+static bool readProfileSnapshot(File &file, const ProfileSnapshotHeader &header, Parameters &profile, List *lists) {
+    if (file.read(&profile, sizeof(Parameters)) != sizeof(Parameters)) {
+        return false;
+    }
+
+    if (crc32((const uint8_t *)&profile, sizeof(Parameters)) != header.parametersCrc) {
+        return false;
+    }
+
+    if (!lists) {
+        return true;
+    }
+
+    for (int i = 0; i < CH_MAX; i++) {
+        auto &list = lists[i];
+
+        ProfileSnapshotList snapshotList;
+        if (file.read(&snapshotList, sizeof(snapshotList)) != sizeof(snapshotList)) {
+            return false;
+        }
+
+        if (
+            snapshotList.dwellListLength > MAX_LIST_LENGTH ||
+            snapshotList.voltageListLength > MAX_LIST_LENGTH ||
+            snapshotList.currentListLength > MAX_LIST_LENGTH
+        ) {
+            return false;
+        }
+
+        list.dwellListLength = snapshotList.dwellListLength;
+        list.voltageListLength = snapshotList.voltageListLength;
+        list.currentListLength = snapshotList.currentListLength;
+
+        uint32_t size = list.dwellListLength * sizeof(float);
+        if (file.read(list.dwellList, size) != size) {
+            return false;
+        }
+
+        size = list.voltageListLength * sizeof(float);
+        if (file.read(list.voltageList, size) != size) {
+            return false;
+        }
+
+        size = list.currentListLength * sizeof(float);
+        if (file.read(list.currentList, size) != size) {
+            return false;
+        }
+    }
+
+    return getListsCrc(lists) == header.listsCrc;
+}
+
+static bool loadProfileSnapshot(int location, const char *profileFilePath, Parameters &profile, List *lists, bool &profileChanged) {
+    profileChanged = false;
+
+    char filePath[MAX_PATH_LENGTH];
+    getProfileSnapshotFilePath(location, filePath, sizeof(filePath));
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    bool result = false;
+
+    uint32_t profileFileSize;
+    uint32_t profileFileDateTime;
+
+    ProfileSnapshotHeader header;
+    if (
+        file.read(&header, sizeof(header)) == sizeof(header) &&
+        header.magic == PROFILE_SNAPSHOT_MAGIC &&
+        header.version == PROFILE_SNAPSHOT_VERSION &&
+        header.buildId == getBuildId() &&
+        header.modulesId == getModulesId() &&
+        header.parametersSize == sizeof(Parameters) &&
+        getProfileFileInfo(profileFilePath, profileFileSize, profileFileDateTime) &&
+        header.profileFileSize == profileFileSize &&
+        header.profileFileDateTime == profileFileDateTime
+    ) {
+        auto loadStatus = profile.loadStatus;
+        profileChanged = true;
+        result = readProfileSnapshot(file, header, profile, lists);
+        profile.loadStatus = loadStatus;
+    }
+
+    file.close();
+
+    return result;
+}
+
+static void saveProfileSnapshot(int location, const char *profileFilePath, Parameters &profile, List *lists) {
+    ProfileSnapshotHeader header;
+    header.magic = PROFILE_SNAPSHOT_MAGIC;
+    header.version = PROFILE_SNAPSHOT_VERSION;
+    header.buildId = getBuildId();
+    header.modulesId = getModulesId();
+    if (!getProfileFileInfo(profileFilePath, header.profileFileSize, header.profileFileDateTime)) {
+        return;
+    }
+    header.parametersSize = sizeof(Parameters);
+    header.parametersCrc = crc32((const uint8_t *)&profile, sizeof(Parameters));
+    header.listsCrc = getListsCrc(lists);
+
+    char filePath[MAX_PATH_LENGTH];
+    getProfileSnapshotFilePath(location, filePath, sizeof(filePath));
+
+    File file;
+    if (!file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        return;
+    }
+
+    sd_card::BufferedFileWrite bufferedFile(file);
+
+    bool result = bufferedFile.write((const uint8_t *)&header, sizeof(header)) &&
+        bufferedFile.write((const uint8_t *)&profile, sizeof(Parameters));
+
+    for (int i = 0; result && i < CH_MAX; i++) {
+        auto &list = lists[i];
+
+        ProfileSnapshotList snapshotList;
+        snapshotList.dwellListLength = list.dwellListLength;
+        snapshotList.voltageListLength = list.voltageListLength;
+        snapshotList.currentListLength = list.currentListLength;
+        snapshotList.reserved = 0;
+
+        result = bufferedFile.write((const uint8_t *)&snapshotList, sizeof(snapshotList)) &&
+            bufferedFile.write((const uint8_t *)list.dwellList, list.dwellListLength * sizeof(float)) &&
+            bufferedFile.write((const uint8_t *)list.voltageList, list.voltageListLength * sizeof(float)) &&
+            bufferedFile.write((const uint8_t *)list.currentList, list.currentListLength * sizeof(float));
+    }
+
+    if (result) {
+        result = bufferedFile.flush();
+    }
+
+    file.close();
+
+    if (!result) {
+        // snapshot is optional, text profile will be used
+        sd_card::deleteFile(filePath, nullptr);
+        return;
+    }
+
+    onSdCardFileChangeHook(filePath);
+}
+
+static void deleteProfileSnapshot(int location) {
+    if (!isProfileSnapshotAllowed(location)) {
+        return;
+    }
+
+    char filePath[MAX_PATH_LENGTH];
+    getProfileSnapshotFilePath(location, filePath, sizeof(filePath));
+    if (sd_card::exists(filePath, nullptr)) {
+        sd_card::deleteFile(filePath, nullptr);
+    }
+}
+
+void deleteSnapshot(const char *filePath) {
+    if (getFileTypeFromExtension(filePath) != FILE_TYPE_PROFILE) {
+        return;
+    }
+
+    const char *profileExt = getExtensionFromFileType(FILE_TYPE_PROFILE);
+    size_t filePathLength = strlen(filePath) - strlen(profileExt);
+
+    char snapshotFilePath[MAX_PATH_LENGTH];
+    if (filePathLength + strlen(PROFILE_SNAPSHOT_EXT) >= sizeof(snapshotFilePath)) {
+        return;
+    }
+    memcpy(snapshotFilePath, filePath, filePathLength);
+    stringCopy(snapshotFilePath + filePathLength, sizeof(snapshotFilePath) - filePathLength, PROFILE_SNAPSHOT_EXT);
+
+    if (sd_card::exists(snapshotFilePath, nullptr)) {
+        sd_card::deleteFile(snapshotFilePath, nullptr);
+    }
+}
+
+static bool loadProfileFromLocation(int location, Parameters &profile, List *lists, int options, bool showProgress, int *err) {
+    char filePath[MAX_PATH_LENGTH];
+    getProfileFilePath(location, filePath, sizeof(filePath));
+
+    bool useSnapshot = isProfileSnapshotAllowed(location) && !(options & LOAD_PROFILE_FROM_FILE_OPTION_ONLY_NAME);
+
+    if (useSnapshot && sd_card::isMounted(filePath, nullptr)) {
+        bool profileChanged;
+        if (loadProfileSnapshot(location, filePath, profile, lists, profileChanged)) {
+            return true;
+        }
+
+        if (profileChanged) {
+            // partially loaded from the invalid snapshot
+            auto loadStatus = profile.loadStatus;
+            resetProfileToDefaults(profile);
+            profile.loadStatus = loadStatus;
+        }
+    }
+
+    if (!loadProfileFromFile(filePath, profile, lists, options, showProgress, err)) {
+        return false;
+    }
+
+    if (useSnapshot && lists) {
+        saveProfileSnapshot(location, filePath, profile, lists);
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 static bool doSaveToLastLocation(int *err) {
     memset(&g_profilesCache[NUM_PROFILE_LOCATIONS - 1], 0, sizeof(Parameters));
     saveState(g_profilesCache[NUM_PROFILE_LOCATIONS - 1], g_listsProfile10);
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <type_traits>
+
 #include <bb3/psu/temperature.h>
 #include <bb3/psu/io_pins.h>
 #include <bb3/psu/sd_card.h>
@@ -212,6 +214,9 @@ void setFreezeState(bool value);
 
 void loadProfileParametersToCache(int location);
 
+// deletes binary snapshot of the profile file, must be called before profile file is changed
+void deleteSnapshot(const char *filePath);
+
 class WriteContext {
 public:
     WriteContext(File &file_);
@@ -240,6 +245,25 @@ private:
 #define WRITE_PROPERTY(p1, p2) if (!ctx.property(p1, p2)) return false
 #define WRITE_LIST_PROPERTY(p1, p2, p3, p4, p5, p6, p7) if (!ctx.property(p1, p2, p3, p4, p5, p6, p7)) return false
 
+/// FNV-1a hash of the property name.
+constexpr uint32_t hashPropertyName(const char *name, uint32_t hash = 2166136261u) {
+    return *name ? hashPropertyName(name + 1, (hash ^ (uint8_t)*name) * 16777619u) : hash;
+}
+
+/// Property name with its hash, used to quickly skip not matching properties
+/// while profile is read.
+struct PropertyName {
+    PropertyName(const char *name_) : name(name_), hash(hashPropertyName(name_)) {}
+    constexpr PropertyName(const char *name_, uint32_t hash_) : name(name_), hash(hash_) {}
+
+    const char *name;
+    uint32_t hash;
+};
+
+/// Property name from the string literal, hash is calculated at compile time.
+#define PROFILE_PROPERTY_NAME(name) \
+    eez::psu::profile::PropertyName(name, std::integral_constant<uint32_t, eez::psu::profile::hashPropertyName(name)>::value)
+
 class ReadContext {
 public:
     ReadContext(File &file_);
@@ -249,16 +273,16 @@ public:
     bool matchGroup(const char *groupName);
     bool matchGroup(const char *groupNamePrefix, int &index);
 
-	bool property(const char *name, int &value);
-    bool property(const char *name, unsigned int &value);
-    bool property(const char *name, uint16_t &value);
-    bool property(const char *name, uint8_t &value);
-    bool property(const char *name, bool &value);
+	bool property(const PropertyName &name, int &value);
+    bool property(const PropertyName &name, unsigned int &value);
+    bool property(const PropertyName &name, uint16_t &value);
+    bool property(const PropertyName &name, uint8_t &value);
+    bool property(const PropertyName &name, bool &value);
 
-    bool property(const char *name, float &value);
-    bool property(const char *name, char *str, unsigned int strLength);
+    bool property(const PropertyName &name, float &value);
+    bool property(const PropertyName &name, char *str, unsigned int strLength);
 
-    bool listProperty(const char *name, int channelIndex, List *lists);
+    bool listProperty(const PropertyName &name, int channelIndex, List *lists);
 
     void skipPropertyValue();
 
@@ -268,29 +292,49 @@ private:
     sd_card::BufferedFileRead file;
     char groupName[100];
     char propertyName[100];
+
+    // group name is split into the prefix and index (e.g. "ch" and 1 for "ch1")
+    size_t groupNamePrefixLength;
+    int groupNameIndex;
+
+    uint32_t propertyNameHash;
+
+    void onGroupName();
+    bool matchProperty(const PropertyName &name);
 };
 
 #define READ_FLAG(name, value) \
     { \
         auto temp = value; \
-        if (ctx.property(name, temp)) { \
+        if (ctx.property(PROFILE_PROPERTY_NAME(name), temp)) { \
             value = temp; \
             return true; \
         } \
     }
 
 #define READ_PROPERTY(name, value) \
-    if (ctx.property(name, value)) { \
+    if (ctx.property(PROFILE_PROPERTY_NAME(name), value)) { \
         return true; \
     }
 
 #define READ_STRING_PROPERTY(name, str, strLength) \
-    if (ctx.property(name, str, strLength)) { \
+    if (ctx.property(PROFILE_PROPERTY_NAME(name), str, strLength)) { \
         return true; \
     }
 
 #define READ_LIST_PROPERTY(name, channelIndex, lists) \
-    if (ctx.listProperty(name, channelIndex, lists)) { \
+    if (ctx.listProperty(PROFILE_PROPERTY_NAME(name), channelIndex, lists)) { \
+        return true; \
+    }
+
+// same as above, but for the property name created at runtime
+#define READ_PROPERTY_BY_NAME(name, value) \
+    if (ctx.property(eez::psu::profile::PropertyName(name), value)) { \
+        return true; \
+    }
+
+#define READ_STRING_PROPERTY_BY_NAME(name, str, strLength) \
+    if (ctx.property(eez::psu::profile::PropertyName(name), str, strLength)) { \
         return true; \
     }
 
@@ -57,6 +57,7 @@
 #include <bb3/function_generator.h>
 #include <bb3/psu/trigger.h>
 #include <bb3/psu/ontime.h>
+#include <bb3/psu/scheduler.h>
 
 #if OPTION_DISPLAY
 #include <bb3/psu/gui/psu.h>
@@ -183,6 +184,9 @@ extern "C" void PSU_IncTick() {
 
     using namespace eez;
     using namespace eez::psu;
+
+    list::onTimerTick();
+
     if (g_fastTickEnabled) {
         sendMessageToPsu(PSU_MESSAGE_TICK, 0, 0);
     }
@@ -718,6 +722,7 @@ bool PsuModule::getCalibrationConfiguration(int subchannelIndex, CalibrationConf
 bool PsuModule::setCalibrationConfiguration(int subchannelIndex, const CalibrationConfiguration &calConf, int *err) {
     Channel *channel = Channel::getBySlotIndex(slotIndex, subchannelIndex);
     memcpy(&channel->cal_conf, &calConf, sizeof(CalibrationConfiguration));
+    channel->compileCalibrationTables();
     return true;
 }
 
@@ -859,15 +864,42 @@ bool PsuModule::isAmperAllowed(int subchannelIndex) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static void tick0();
-static void tick1();
-static void tick2();
-static void tick3();
-static void tick4();
+static void tickSlots();
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static void tickRamp();
+#endif
+static void tickTriggerAndList();
+static void tickChannels();
+static void tickDlogRecord();
+static void tickIoPins();
+static void tickTemperature();
+static void tickFan();
+static void tickDateTime();
+#if defined(EEZ_PLATFORM_STM32)
+static void tickTouch();
+#endif
+static void tickDiagCallback();
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void init() {
+    // Phases are kept as they were in the fast tick mode round robin, budgets
+    // are given in microseconds with respect to the 1 ms PSU tick.
+    scheduler::registerJob("slots", tickSlots, 0, 0, 300);
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    scheduler::registerJob("ramp", tickRamp, 0, 0, 100);
+#endif
+    scheduler::registerJob("trigger", tickTriggerAndList, 1, 0, 100);
+    scheduler::registerJob("channels", tickChannels, 2, 0, 300);
+    scheduler::registerJob("dlog", tickDlogRecord, 3, 0, 200);
+    scheduler::registerJob("io_pins", tickIoPins, 3, 0, 50);
+    scheduler::registerJob("temperature", tickTemperature, 3, TEMPERATURE_TICK_INTERVAL_MS, 500);
+    scheduler::registerJob("fan", tickFan, 3, FAN_TICK_INTERVAL_MS, 500);
+    scheduler::registerJob("datetime", tickDateTime, 4, DATETIME_TICK_INTERVAL_MS, 300);
+#if defined(EEZ_PLATFORM_STM32)
+    scheduler::registerJob("touch", tickTouch, 4, 10, 200);
+#endif
+    scheduler::registerJob("diag", tickDiagCallback, 4, 0, 1000);
 }
 
 void onThreadMessage(uint8_t type, uint32_t param) {
@@ -878,9 +910,7 @@ void onThreadMessage(uint8_t type, uint32_t param) {
         function_generator::tick();
 
         static uint32_t g_tick = 0;
-        typedef void (*TickFunc)();
-        static const TickFunc g_tickFuncs[] = { tick0, tick1, tick2, tick3, tick4 };
-        g_tickFuncs[g_tick++ % 5]();
+        scheduler::tickPhase(g_tick++ % scheduler::NUM_PHASES);
 #endif
     } else if (type == PSU_MESSAGE_CHANGE_POWER_STATE) {
         changePowerState(param ? true : false);
@@ -959,6 +989,8 @@ void onThreadMessage(uint8_t type, uint32_t param) {
         g_slots[param]->resync();
     } else if (type == PSU_MESSAGE_COPY_CHANNEL_TO_CHANNEL) {
         channel_dispatcher::copyChannelToChannel(param >> 8, param & 0xFF);
+    } else if (type == PSU_MESSAGE_LIST_TICK) {
+        list::tick();
     } else if (type == PSU_MESSAGE_RESET_CHANNELS_HISTORY) {
         Channel::resetHistoryForAllChannels();
     } else if (calibration::onHighPriorityThreadMessage(type, param)) {
@@ -1382,50 +1414,60 @@ void onProtectionTripped() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void tick0() {
+void tickSlots() {
     WATCHDOG_RESET(WATCHDOG_HIGH_PRIORITY_THREAD);
 
     for (int i = 0; i < NUM_SLOTS; i++) {
         g_slots[i]->tick();
     }
+}
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
+void tickRamp() {
 	ramp::tick();
 	dcp405::tickDacRamp();
 	function_generator::tick();
-#endif
 }
+#endif
 
-void tick1() {
+void tickTriggerAndList() {
     trigger::tick();
     list::tick();
 }
 
-void tick2() {
+void tickChannels() {
     for (int i = 0; i < CH_NUM; ++i) {
         Channel::get(i).tick();
     }
 }
 
-void tick3() {
+void tickDlogRecord() {
     dlog_record::tick();
+}
+
+void tickIoPins() {
     io_pins::tick();
+}
+
+void tickTemperature() {
     temperature::tick();
+}
+
+void tickFan() {
     aux_ps::fan::tick();
 }
 
-void tick4() {
+void tickDateTime() {
     datetime::tick();
+}
 
 #if defined(EEZ_PLATFORM_STM32)
-    // call every 10 ms
-    static int counter = 0;
-    if (++counter == 10) {
-        touch::tick();
-        counter = 0;
-    }
+void tickTouch() {
+    touch::tick();
+}
 #endif
 
+void tickDiagCallback() {
     if (g_diagCallback) {
         g_diagCallback();
         g_diagCallback = NULL;
@@ -1433,11 +1475,7 @@ void tick4() {
 }
 
 void tick() {
-    tick0();
-    tick1();
-    tick2();
-    tick3();
-    tick4();
+    scheduler::tick();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1529,6 +1567,28 @@ void setRPol(int pin, bool on) {
     g_rpol[pin] = on;
 }
 
+static uint32_t g_sdCardWriteLatencySpikeDurationMs;
+static uint32_t g_sdCardWriteLatencySpikeIntervalMs;
+static uint32_t g_sdCardWriteLatencyLastSpikeTickCount;
+
+void setSdCardWriteLatency(uint32_t spikeDurationMs, uint32_t spikeIntervalMs) {
+    g_sdCardWriteLatencySpikeDurationMs = spikeDurationMs;
+    g_sdCardWriteLatencySpikeIntervalMs = spikeIntervalMs;
+    g_sdCardWriteLatencyLastSpikeTickCount = millis();
+}
+
+void getSdCardWriteLatency(uint32_t &spikeDurationMs, uint32_t &spikeIntervalMs) {
+    spikeDurationMs = g_sdCardWriteLatencySpikeDurationMs;
+    spikeIntervalMs = g_sdCardWriteLatencySpikeIntervalMs;
+}
+
+void injectSdCardWriteLatency() {
+    if (g_sdCardWriteLatencySpikeDurationMs > 0 && millis() - g_sdCardWriteLatencyLastSpikeTickCount >= g_sdCardWriteLatencySpikeIntervalMs) {
+        osDelay(g_sdCardWriteLatencySpikeDurationMs);
+        g_sdCardWriteLatencyLastSpikeTickCount = millis();
+    }
+}
+
 bool getCV(int pin) {
     return g_cv[pin];
 }
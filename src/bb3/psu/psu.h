@@ -232,6 +232,11 @@ void setCV(int pin, bool on);
 bool getCC(int pin);
 void setCC(int pin, bool on);
 
+// SD card write latency spikes injected into DLOG writer, used for stress testing
+void setSdCardWriteLatency(uint32_t spikeDurationMs, uint32_t spikeIntervalMs);
+void getSdCardWriteLatency(uint32_t &spikeDurationMs, uint32_t &spikeIntervalMs);
+void injectSdCardWriteLatency();
+
 void exit();
 
 } // namespace simulator
@@ -0,0 +1,189 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <chrono>
+#endif
+
+#include <bb3/system.h>
+#include <bb3/psu/scheduler.h>
+
+namespace eez {
+namespace psu {
+namespace scheduler {
+
+// budgets of the pseudo jobs
+static const uint32_t PASS_BUDGET_US = PASS_PERIOD_US;
+static const uint32_t MESSAGE_BUDGET_US = PASS_PERIOD_US;
+
+static Job g_jobs[MAX_JOBS];
+static int g_numJobs;
+
+static JobStatistics g_passStats;
+static uint32_t g_passStartTimeUs;
+static uint32_t g_passTimeUs;
+
+static JobStatistics g_messageStats;
+
+// min. times of the pseudo jobs are initialized on the first pass
+static volatile bool g_resetStatisticsRequested = true;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void clearStatistics(JobStatistics &stats) {
+    memset(&stats, 0, sizeof(JobStatistics));
+    stats.minTimeUs = 0xFFFFFFFF;
+}
+
+static void doResetStatistics() {
+    for (int i = 0; i < g_numJobs; i++) {
+        clearStatistics(g_jobs[i].stats);
+    }
+    clearStatistics(g_passStats);
+    clearStatistics(g_messageStats);
+}
+
+static void recordRun(JobStatistics &stats, uint32_t startTimeUs, uint32_t timeUs, uint32_t periodUs, uint32_t budgetUs) {
+    if (stats.numRuns > 0 && periodUs > 0) {
+        int32_t jitterUs = (int32_t)(startTimeUs - stats.lastStartTimeUs - periodUs);
+        if (jitterUs < 0) {
+            jitterUs = -jitterUs;
+        }
+        if ((uint32_t)jitterUs > stats.maxJitterUs) {
+            stats.maxJitterUs = jitterUs;
+        }
+    }
+    stats.lastStartTimeUs = startTimeUs;
+
+    stats.numRuns++;
+    stats.totalTimeUs += timeUs;
+    if (timeUs < stats.minTimeUs) {
+        stats.minTimeUs = timeUs;
+    }
+    if (timeUs > stats.maxTimeUs) {
+        stats.maxTimeUs = timeUs;
+    }
+
+    if (timeUs > budgetUs) {
+        stats.numOverruns++;
+        stats.lastOverrunTimeUs = timeUs;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void registerJob(const char *name, JobFunc func, int phase, uint32_t periodMs, uint32_t budgetUs) {
+    assert(g_numJobs < MAX_JOBS);
+    assert(phase >= 0 && phase < NUM_PHASES);
+
+    Job &job = g_jobs[g_numJobs++];
+
+    job.name = name;
+    job.func = func;
+    job.phase = (uint8_t)phase;
+    job.periodMs = periodMs;
+    job.budgetUs = budgetUs;
+    job.lastRunTimeMs = millis() - periodMs;
+    clearStatistics(job.stats);
+}
+
+void tickPhase(int phase) {
+    if (g_resetStatisticsRequested) {
+        doResetStatistics();
+        g_resetStatisticsRequested = false;
+    }
+
+    uint32_t phaseStartTimeUs = getTimeUs();
+    if (phase == 0) {
+        g_passStartTimeUs = phaseStartTimeUs;
+        g_passTimeUs = 0;
+    }
+
+    for (int i = 0; i < g_numJobs; i++) {
+        Job &job = g_jobs[i];
+        if (job.phase != phase) {
+            continue;
+        }
+
+        if (job.periodMs > 0) {
+            uint32_t tickCountMs = millis();
+            if (tickCountMs - job.lastRunTimeMs < job.periodMs) {
+                continue;
+            }
+            job.lastRunTimeMs = tickCountMs;
+        }
+
+        uint32_t startTimeUs = getTimeUs();
+        job.func();
+        uint32_t timeUs = getTimeUs() - startTimeUs;
+
+        recordRun(job.stats, startTimeUs, timeUs, job.periodMs > 0 ? job.periodMs * 1000 : PASS_PERIOD_US, job.budgetUs);
+    }
+
+    g_passTimeUs += getTimeUs() - phaseStartTimeUs;
+    if (phase == NUM_PHASES - 1) {
+        recordRun(g_passStats, g_passStartTimeUs, g_passTimeUs, PASS_PERIOD_US, PASS_BUDGET_US);
+    }
+}
+
+void tick() {
+    for (int phase = 0; phase < NUM_PHASES; phase++) {
+        tickPhase(phase);
+    }
+}
+
+uint32_t getTimeUs() {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // micros() in simulator has only 1 ms resolution
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#else
+    return micros();
+#endif
+}
+
+void onMessageHandled(uint32_t startTimeUs) {
+    recordRun(g_messageStats, startTimeUs, getTimeUs() - startTimeUs, 0, MESSAGE_BUDGET_US);
+}
+
+int getNumJobs() {
+    return g_numJobs;
+}
+
+const Job &getJob(int jobIndex) {
+    return g_jobs[jobIndex];
+}
+
+const JobStatistics &getPassStatistics() {
+    return g_passStats;
+}
+
+const JobStatistics &getMessageStatistics() {
+    return g_messageStats;
+}
+
+void resetStatistics() {
+    g_resetStatisticsRequested = true;
+}
+
+} // namespace scheduler
+} // namespace psu
+} // namespace eez
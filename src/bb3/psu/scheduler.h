@@ -0,0 +1,88 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Cooperative scheduler for the PSU (high priority) thread.
+//
+// Every subsystem that has to be ticked from the PSU thread registers a job
+// with a period and a time budget. A job with period 0 runs on every pass,
+// others run when their period has elapsed. Jobs are split in phases, in
+// normal mode all phases are executed in one pass, in fast tick mode
+// (ramp, function generator) one phase is executed per PSU_MESSAGE_TICK.
+
+namespace eez {
+namespace psu {
+namespace scheduler {
+
+static const int NUM_PHASES = 5;
+static const int MAX_JOBS = 16;
+
+// nominal time between two passes
+static const uint32_t PASS_PERIOD_US = 1000;
+
+typedef void (*JobFunc)();
+
+struct JobStatistics {
+    uint32_t numRuns;
+    uint32_t numOverruns;
+    uint32_t minTimeUs;
+    uint32_t maxTimeUs;
+    uint64_t totalTimeUs;
+    uint32_t maxJitterUs;
+    uint32_t lastOverrunTimeUs;
+    uint32_t lastStartTimeUs;
+};
+
+struct Job {
+    const char *name;
+    JobFunc func;
+    uint8_t phase;
+    uint32_t periodMs;
+    uint32_t budgetUs;
+    uint32_t lastRunTimeMs;
+    JobStatistics stats;
+};
+
+void registerJob(const char *name, JobFunc func, int phase, uint32_t periodMs, uint32_t budgetUs);
+
+// execute all phases
+void tick();
+
+// execute a single phase, used in fast tick mode
+void tickPhase(int phase);
+
+// time source used for the statistics, in microseconds
+uint32_t getTimeUs();
+
+// accounts time spent in handling of the PSU thread message (other then PSU_MESSAGE_TICK)
+void onMessageHandled(uint32_t startTimeUs);
+
+int getNumJobs();
+const Job &getJob(int jobIndex);
+const JobStatistics &getPassStatistics();
+const JobStatistics &getMessageStatistics();
+
+// statistics are cleared from the PSU thread on the next pass
+void resetStatistics();
+
+} // namespace scheduler
+} // namespace psu
+} // namespace eez
@@ -20,12 +20,18 @@
 
 #include <bb3/system.h>
 #include <bb3/index.h>
+#include <bb3/bp3c/comm.h>
 
 #include <bb3/psu/psu.h>
 #include <bb3/psu/calibration.h>
 #include <bb3/psu/datetime.h>
 #include <bb3/psu/devices.h>
+#include <bb3/psu/dlog_record.h>
+#include <bb3/psu/event_queue.h>
+#include <bb3/psu/list_program.h>
+#include <bb3/memory.h>
 #include <bb3/psu/scpi/psu.h>
+#include <bb3/psu/scheduler.h>
 #include <bb3/psu/temperature.h>
 
 #if OPTION_FAN
@@ -240,8 +246,34 @@ scpi_result_t scpi_cmd_diagnosticInformationProtectionQ(scpi_t *context) {
         snprintf(buffer, sizeof(buffer), "CH%d p_level=", channelIndex);
         stringAppendPower(buffer, sizeof(buffer), channel->prot_conf.p_level);
         SCPI_ResultText(context, buffer);
+
+        const ProtectionLatencyStatistics &latency = channel->protectionLatency;
+
+        snprintf(buffer, sizeof(buffer), "CH%d trips=%lu", channelIndex, (unsigned long)latency.numTrips);
+        SCPI_ResultText(context, buffer);
+
+        snprintf(buffer, sizeof(buffer), "CH%d latency_last=%lu us", channelIndex, (unsigned long)latency.lastLatencyUs);
+        SCPI_ResultText(context, buffer);
+
+        snprintf(buffer, sizeof(buffer), "CH%d latency_max=%lu us", channelIndex, (unsigned long)latency.maxLatencyUs);
+        SCPI_ResultText(context, buffer);
+
+        snprintf(buffer, sizeof(buffer), "CH%d latency_histogram=", channelIndex);
+        for (int i = 0; i < PROTECTION_LATENCY_HISTOGRAM_SIZE; i++) {
+            size_t n = strlen(buffer);
+            snprintf(buffer + n, sizeof(buffer) - n, i == 0 ? "%lu" : ",%lu", (unsigned long)latency.histogram[i]);
+        }
+        SCPI_ResultText(context, buffer);
     }
 
+    snprintf(buffer, sizeof(buffer), "latency_buckets=");
+    for (int i = 0; i < PROTECTION_LATENCY_HISTOGRAM_SIZE - 1; i++) {
+        size_t n = strlen(buffer);
+        snprintf(buffer + n, sizeof(buffer) - n, "<%lu,", (unsigned long)PROTECTION_LATENCY_HISTOGRAM_LIMITS_US[i]);
+    }
+    stringAppendString(buffer, sizeof(buffer), "inf us");
+    SCPI_ResultText(context, buffer);
+
     for (int i = 0; i < temp_sensor::NUM_TEMP_SENSORS; ++i) {
         temp_sensor::TempSensor &sensor = temp_sensor::sensors[i];
         if (sensor.isInstalled()) {
@@ -361,6 +393,172 @@ scpi_result_t scpi_cmd_diagnosticInformationRegsQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_diagnosticInformationDlogQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+    snprintf(buffer, sizeof(buffer), "buffer_size=%u", (unsigned)DLOG_RECORD_BUFFER_SIZE);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "fill=%u", (unsigned)dlog_record::getBufferFillLevel());
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "peak_fill=%u", (unsigned)dlog_record::getBufferPeakFillLevel());
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "peak_write_latency_ms=%u", (unsigned)dlog_record::getPeakWriteLatency());
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationEventsQ(scpi_t *context) {
+    char buffer[64];
+
+    auto &stats = event_queue::getStatistics();
+
+    snprintf(buffer, sizeof(buffer), "events=%u", (unsigned)stats.numEvents);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "dropped=%u", (unsigned)stats.numDroppedEvents);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "written=%u", (unsigned)stats.numWrittenEvents);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "batches=%u", (unsigned)stats.numBatches);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "file_operations=%u", (unsigned)stats.numFileOperations);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "rotations=%u", (unsigned)stats.numRotations);
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationSpiQ(scpi_t *context) {
+    int32_t slotIndex;
+    if (!SCPI_ParamInt32(context, &slotIndex, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (slotIndex < 1 || slotIndex > NUM_SLOTS) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+    slotIndex--;
+
+    auto &stats = bp3c::comm::getTransferStatistics(slotIndex);
+
+    char buffer[128] = { 0 };
+
+    snprintf(buffer, sizeof(buffer), "fused_protocol=%d", stats.fusedProtocol ? 1 : 0);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "transfers=%u", (unsigned)stats.numTransfers);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "transfers_per_sec=%u", (unsigned)bp3c::comm::getTransfersPerSecond(slotIndex));
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "retries=%u", (unsigned)stats.numRetries);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "crc_errors=%u", (unsigned)stats.numCrcErrors);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "transfer_errors=%u", (unsigned)stats.numTransferErrors);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "commands=%u", (unsigned)stats.numCommands);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "failed_commands=%u", (unsigned)stats.numFailedCommands);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "fused_commands=%u", (unsigned)stats.numFusedCommands);
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+}
+
+static void resultSchedulerStatistics(scpi_t *context, const char *prefix, uint32_t periodMs, uint32_t budgetUs, const psu::scheduler::JobStatistics &stats) {
+    char buffer[128] = { 0 };
+
+    snprintf(buffer, sizeof(buffer), "%s_period_ms=%u", prefix, (unsigned)periodMs);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "%s_budget_us=%u", prefix, (unsigned)budgetUs);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "%s_runs=%u", prefix, (unsigned)stats.numRuns);
+    SCPI_ResultText(context, buffer);
+
+    if (stats.numRuns > 0) {
+        snprintf(buffer, sizeof(buffer), "%s_min_us=%u", prefix, (unsigned)stats.minTimeUs);
+        SCPI_ResultText(context, buffer);
+
+        snprintf(buffer, sizeof(buffer), "%s_avg_us=%u", prefix, (unsigned)(stats.totalTimeUs / stats.numRuns));
+        SCPI_ResultText(context, buffer);
+
+        snprintf(buffer, sizeof(buffer), "%s_max_us=%u", prefix, (unsigned)stats.maxTimeUs);
+        SCPI_ResultText(context, buffer);
+
+        snprintf(buffer, sizeof(buffer), "%s_jitter_us=%u", prefix, (unsigned)stats.maxJitterUs);
+        SCPI_ResultText(context, buffer);
+    }
+
+    snprintf(buffer, sizeof(buffer), "%s_overruns=%u", prefix, (unsigned)stats.numOverruns);
+    SCPI_ResultText(context, buffer);
+
+    if (stats.numOverruns > 0) {
+        snprintf(buffer, sizeof(buffer), "%s_last_overrun_us=%u", prefix, (unsigned)stats.lastOverrunTimeUs);
+        SCPI_ResultText(context, buffer);
+    }
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationSchedulerQ(scpi_t *context) {
+    // "pass" is one execution of all the jobs, "messages" is handling of
+    // the PSU thread messages that are not accounted by the jobs
+    resultSchedulerStatistics(context, "pass", 1, scheduler::PASS_PERIOD_US, scheduler::getPassStatistics());
+    resultSchedulerStatistics(context, "messages", 0, scheduler::PASS_PERIOD_US, scheduler::getMessageStatistics());
+
+    for (int i = 0; i < scheduler::getNumJobs(); i++) {
+        auto &job = scheduler::getJob(i);
+        resultSchedulerStatistics(context, job.name, job.periodMs, job.budgetUs, job.stats);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationSchedulerReset(scpi_t *context) {
+    scheduler::resetStatistics();
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationListQ(scpi_t *context) {
+    // timing of the last list execution for each channel
+    char buffer[64];
+
+    for (int i = 0; i < CH_NUM; i++) {
+        auto &stats = list::getTimingStatistics(i);
+        if (stats.numPoints == 0) {
+            continue;
+        }
+
+        snprintf(buffer, sizeof(buffer), "ch%d_points=%u", i + 1, (unsigned)stats.numPoints);
+        SCPI_ResultText(context, buffer);
+
+        snprintf(buffer, sizeof(buffer), "ch%d_late=%u", i + 1, (unsigned)stats.numLatePoints);
+        SCPI_ResultText(context, buffer);
+
+        snprintf(buffer, sizeof(buffer), "ch%d_max_error_us=%u", i + 1, (unsigned)stats.maxErrorUs);
+        SCPI_ResultText(context, buffer);
+    }
+
+    return SCPI_RES_OK;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
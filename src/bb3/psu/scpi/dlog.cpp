@@ -617,6 +617,140 @@ scpi_result_t scpi_cmd_senseDlogTraceYUnitQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_choice_def_t dataTypeChoice[] = {
+    { "FLOAT", dlog_file::DATA_TYPE_FLOAT },
+    { "INT16", dlog_file::DATA_TYPE_INT16_BE },
+    { "INT24", dlog_file::DATA_TYPE_INT24_BE },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+scpi_result_t scpi_cmd_senseDlogTraceYDataType(scpi_t *context) {
+    if (!dlog_record::isIdle()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+        return SCPI_RES_ERR;
+    }
+
+    int32_t yAxisIndex = 0;
+    SCPI_CommandNumbers(context, &yAxisIndex, 1, 0);
+    yAxisIndex--;
+
+    if (yAxisIndex < -1 || yAxisIndex >= MAX_NUM_OF_Y_AXES) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HEADER_SUFFIX_OUTOFRANGE);
+        return SCPI_RES_ERR;
+    }
+
+    int32_t dataType;
+    if (!SCPI_ParamChoice(context, dataTypeChoice, &dataType, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (yAxisIndex >= dlog_record::g_recordingParameters.numYAxes) {
+        dlog_record::g_recordingParameters.numYAxes = yAxisIndex + 1;
+        dlog_record::g_recordingParameters.initYAxis(yAxisIndex);
+    }
+
+    if (yAxisIndex == -1) {
+        dlog_record::g_recordingParameters.yAxis.dataType = (dlog_file::DataType)dataType;
+        for (yAxisIndex = 0; yAxisIndex < dlog_record::g_recordingParameters.numYAxes; yAxisIndex++) {
+            dlog_record::g_recordingParameters.yAxes[yAxisIndex].dataType = (dlog_file::DataType)dataType;
+        }
+    } else {
+        dlog_record::g_recordingParameters.yAxes[yAxisIndex].dataType = (dlog_file::DataType)dataType;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseDlogTraceYDataTypeQ(scpi_t *context) {
+    int32_t yAxisIndex = 0;
+    SCPI_CommandNumbers(context, &yAxisIndex, 1, 0);
+    yAxisIndex--;
+
+    if (yAxisIndex < -1 || yAxisIndex >= dlog_record::g_recordingParameters.numYAxes) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HEADER_SUFFIX_OUTOFRANGE);
+        return SCPI_RES_ERR;
+    }
+
+    if (yAxisIndex == -1) {
+        resultChoiceName(context, dataTypeChoice, dlog_record::g_recordingParameters.yAxis.dataType);
+    } else {
+        resultChoiceName(context, dataTypeChoice, dlog_record::g_recordingParameters.yAxes[yAxisIndex].dataType);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseDlogTraceYTransform(scpi_t *context) {
+    if (!dlog_record::isIdle()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+        return SCPI_RES_ERR;
+    }
+
+    int32_t yAxisIndex = 0;
+    SCPI_CommandNumbers(context, &yAxisIndex, 1, 0);
+    yAxisIndex--;
+
+    if (yAxisIndex < -1 || yAxisIndex >= MAX_NUM_OF_Y_AXES) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HEADER_SUFFIX_OUTOFRANGE);
+        return SCPI_RES_ERR;
+    }
+
+    double offset;
+    if (!SCPI_ParamDouble(context, &offset, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    double scale;
+    if (!SCPI_ParamDouble(context, &scale, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (scale == 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    if (yAxisIndex >= dlog_record::g_recordingParameters.numYAxes) {
+        dlog_record::g_recordingParameters.numYAxes = yAxisIndex + 1;
+        dlog_record::g_recordingParameters.initYAxis(yAxisIndex);
+    }
+
+    if (yAxisIndex == -1) {
+        dlog_record::g_recordingParameters.yAxis.transformOffset = offset;
+        dlog_record::g_recordingParameters.yAxis.transformScale = scale;
+        for (yAxisIndex = 0; yAxisIndex < dlog_record::g_recordingParameters.numYAxes; yAxisIndex++) {
+            dlog_record::g_recordingParameters.yAxes[yAxisIndex].transformOffset = offset;
+            dlog_record::g_recordingParameters.yAxes[yAxisIndex].transformScale = scale;
+        }
+    } else {
+        dlog_record::g_recordingParameters.yAxes[yAxisIndex].transformOffset = offset;
+        dlog_record::g_recordingParameters.yAxes[yAxisIndex].transformScale = scale;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseDlogTraceYTransformQ(scpi_t *context) {
+    int32_t yAxisIndex = 0;
+    SCPI_CommandNumbers(context, &yAxisIndex, 1, 0);
+    yAxisIndex--;
+
+    if (yAxisIndex < -1 || yAxisIndex >= dlog_record::g_recordingParameters.numYAxes) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HEADER_SUFFIX_OUTOFRANGE);
+        return SCPI_RES_ERR;
+    }
+
+    if (yAxisIndex == -1) {
+        SCPI_ResultDouble(context, dlog_record::g_recordingParameters.yAxis.transformOffset);
+        SCPI_ResultDouble(context, dlog_record::g_recordingParameters.yAxis.transformScale);
+    } else {
+        SCPI_ResultDouble(context, dlog_record::g_recordingParameters.yAxes[yAxisIndex].transformOffset);
+        SCPI_ResultDouble(context, dlog_record::g_recordingParameters.yAxes[yAxisIndex].transformScale);
+    }
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_senseDlogTraceYLabel(scpi_t *context) {
     if (!dlog_record::isIdle()) {
         SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
@@ -882,6 +1016,30 @@ scpi_result_t scpi_cmd_senseDlogTraceData(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_senseDlogTraceDataBlock(scpi_t *context) {
+    if (!dlog_record::isTraceExecuting()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    const char *buffer;
+    size_t size;
+    if (!SCPI_ParamArbitraryBlock(context, &buffer, &size, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    // block contains whole rows, each Y value encoded as declared by Y#:DATA:TYPE
+    uint32_t rowSize = dlog_record::getTraceBlockRowSize();
+    if (rowSize == 0 || size % rowSize != 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_INVALID_BLOCK_DATA);
+        return SCPI_RES_ERR;
+    }
+
+    dlog_record::logTraceBlock((const uint8_t *)buffer, size / rowSize);
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_senseDlogClear(scpi_t *context) {
     dlog_record::reset();
 
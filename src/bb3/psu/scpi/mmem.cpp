@@ -35,6 +35,7 @@
 #endif
 
 #include <bb3/system.h>
+#include <bb3/function_generator.h>
 
 namespace eez {
 
@@ -261,6 +262,12 @@ scpi_result_t scpi_cmd_mmemoryDownloadFname(scpi_t *context) {
     }
 
     if (g_downloading) {
+        int err;
+        if (!sd_card::downloadFlush(&err)) {
+            finishDownloading(event_queue::EVENT_ERROR_FILE_DOWNLOAD_FAILED);
+            SCPI_ErrorPush(context, err);
+            return SCPI_RES_ERR;
+        }
         finishDownloading(event_queue::EVENT_INFO_FILE_DOWNLOAD_SUCCEEDED);
         return SCPI_RES_OK;
     }
@@ -568,6 +575,34 @@ scpi_result_t scpi_cmd_mmemoryLoadList(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+static scpi_result_t loadArbitraryWaveform(scpi_t *context, int resourceIndex) {
+    Channel *channel = getPowerChannelFromCommandNumber(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    if (!getFilePath(context, filePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int err;
+    if (!function_generator::loadArbitraryWaveform(channel->slotIndex, channel->subchannelIndex, resourceIndex, filePath, &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_mmemoryLoadArbitraryVoltage(scpi_t *context) {
+    return loadArbitraryWaveform(context, 0);
+}
+
+scpi_result_t scpi_cmd_mmemoryLoadArbitraryCurrent(scpi_t *context) {
+    return loadArbitraryWaveform(context, 1);
+}
+
 scpi_result_t scpi_cmd_mmemoryStoreList(scpi_t *context) {
     if (persist_conf::isSdLocked()) {
         SCPI_ErrorPush(context, SCPI_ERROR_MEDIA_PROTECTED);
@@ -45,6 +45,13 @@ SCPI_COMMANDS
 #define SCPI_COMMAND(P, C) { P, C },
 static const scpi_command_t scpi_commands[] = { SCPI_COMMANDS SCPI_CMD_LIST_END };
 
+static const size_t NUM_SCPI_COMMANDS = sizeof(scpi_commands) / sizeof(scpi_command_t) - 1;
+
+// shared by all SCPI contexts, built on first init which is done from boot()
+static scpi_command_index_t g_commandIndex;
+static uint16_t g_commandIndexEntries[2 * NUM_SCPI_COMMANDS];
+static bool g_commandIndexInitialized;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool g_messageAvailable = false;
@@ -59,6 +66,12 @@ void init(scpi_t &scpi_context, scpi_psu_t &scpi_psu_context, scpi_interface_t *
               getSerialNumber(), MCU_FIRMWARE, input_buffer, input_buffer_length,
               error_queue_data, error_queue_size);
 
+    if (!g_commandIndexInitialized) {
+        SCPI_InitCommandIndex(&g_commandIndex, scpi_commands, g_commandIndexEntries, sizeof(g_commandIndexEntries) / sizeof(uint16_t));
+        g_commandIndexInitialized = true;
+    }
+    SCPI_SetCommandIndex(&scpi_context, &g_commandIndex);
+
     if (CH_NUM > 0) {
         auto &channel = Channel::get(0);
         scpi_psu_context.selectedChannels.numChannels = 1;
@@ -409,6 +409,38 @@ scpi_result_t scpi_cmd_simulatorUart(scpi_t *context) {
 	return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_simulatorSdcardLatency(scpi_t *context) {
+    int32_t spikeDuration;
+    if (!SCPI_ParamInt32(context, &spikeDuration, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t spikeInterval;
+    if (!SCPI_ParamInt32(context, &spikeInterval, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (spikeDuration < 0 || spikeInterval < 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    simulator::setSdCardWriteLatency(spikeDuration, spikeInterval);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorSdcardLatencyQ(scpi_t *context) {
+    uint32_t spikeDuration;
+    uint32_t spikeInterval;
+    simulator::getSdCardWriteLatency(spikeDuration, spikeInterval);
+
+    SCPI_ResultUInt32(context, spikeDuration);
+    SCPI_ResultUInt32(context, spikeInterval);
+
+    return SCPI_RES_OK;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
@@ -524,6 +556,16 @@ scpi_result_t scpi_cmd_simulatorUart(scpi_t *context) {
 	return SCPI_RES_ERR;
 }
 
+scpi_result_t scpi_cmd_simulatorSdcardLatency(scpi_t *context) {
+	SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+	return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorSdcardLatencyQ(scpi_t *context) {
+	SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+	return SCPI_RES_ERR;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
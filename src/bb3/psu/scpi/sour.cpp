@@ -1826,6 +1826,7 @@ static scpi_choice_def_t g_waveformChoice[] = {
     { "SQUare", WAVEFORM_SQUARE },
     { "PULSe", WAVEFORM_PULSE },
     { "SAWTooth", WAVEFORM_SAWTOOTH },
+    { "ARBitrary", WAVEFORM_ARBITRARY },
     SCPI_CHOICE_LIST_END /* termination of option list */
 };
 
@@ -2494,6 +2495,51 @@ scpi_result_t scpi_cmd_sourceCurrentFunctionDutyQ(scpi_t *context) {
 	return SCPI_RES_OK;
 }
 
+static scpi_result_t setArbitraryWaveformFromBlock(scpi_t *context, SlotAndSubchannelIndex &slotAndSubchannelIndex, int resourceIndex) {
+    const char *buffer;
+    size_t size;
+    if (!SCPI_ParamArbitraryBlock(context, &buffer, &size, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    // block is array of little endian 32-bit floats
+    if (size % sizeof(float) != 0 || size > ARBITRARY_WAVEFORM_MAX_POINTS * sizeof(float)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    float points[ARBITRARY_WAVEFORM_MAX_POINTS];
+    memcpy(points, buffer, size);
+
+    int err;
+    if (!setArbitraryWaveform(slotAndSubchannelIndex.slotIndex, slotAndSubchannelIndex.subchannelIndex, resourceIndex, points, size / sizeof(float), &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceVoltageFunctionArbitrary(scpi_t *context) {
+	SlotAndSubchannelIndex slotAndSubchannelIndex;
+    int resourceIndex;
+	if (getVoltageFunctionChannel(context, slotAndSubchannelIndex, resourceIndex) == SCPI_RES_ERR) {
+		return SCPI_RES_ERR;
+	}
+
+    return setArbitraryWaveformFromBlock(context, slotAndSubchannelIndex, resourceIndex);
+}
+
+scpi_result_t scpi_cmd_sourceCurrentFunctionArbitrary(scpi_t *context) {
+	SlotAndSubchannelIndex slotAndSubchannelIndex;
+    int resourceIndex;
+	if (getCurrentFunctionChannel(context, slotAndSubchannelIndex, resourceIndex) == SCPI_RES_ERR) {
+		return SCPI_RES_ERR;
+	}
+
+    return setArbitraryWaveformFromBlock(context, slotAndSubchannelIndex, resourceIndex);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 scpi_result_t getFunctionParamDigital(scpi_t *context, SlotAndSubchannelIndex &slotAndSubchannelIndex, int32_t &pin, float &param) {
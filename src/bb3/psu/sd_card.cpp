@@ -26,6 +26,7 @@
 #endif
 
 #include <bb3/firmware.h>
+#include <bb3/memory.h>
 #include <bb3/usb.h>
 #include <bb3/fs_driver.h>
 
@@ -34,6 +35,7 @@
 #include <scpi/scpi.h>
 
 #include <bb3/psu/datetime.h>
+#include <bb3/psu/dlog_view.h>
 #include <bb3/psu/event_queue.h>
 #include <bb3/psu/list_program.h>
 #include <bb3/psu/profile.h>
@@ -83,6 +85,8 @@ int g_lastError;
 
 static File g_downloadFile;
 static uint32_t g_downloadedFileOffset;
+static uint32_t g_downloadSyncedFileOffset;
+static uint32_t g_downloadBufferLength;
 static char g_downloadFilePath[MAX_PATH_LENGTH + 1];
 
 static uint16_t g_getInfoVersion[1 + NUM_SLOTS];
@@ -315,8 +319,10 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
 
     callback(param, NULL, totalSize);
 
-    const int CHUNK_SIZE = 512;
-    uint8_t buffer[CHUNK_SIZE];
+    // File is read in large chunks, while one chunk is read the previous one
+    // is still being sent from the socket (or lwIP) send buffer.
+    const int CHUNK_SIZE = MMEM_UPLOAD_BUFFER_SIZE;
+    uint8_t *buffer = MMEM_UPLOAD_BUFFER;
 
     while (true) {
         int size = file.read(buffer, CHUNK_SIZE);
@@ -359,40 +365,34 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
     return result;
 }
 
-bool download(const char *filePath, bool truncate, const void *buffer, size_t size, int *perr) {
-    if (!sd_card::isMounted(filePath, perr)) {
-        return false;
-    }
-
-	if (truncate) {
-	    if (!g_downloadFile.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
-			if (perr) {
-				*perr = SCPI_ERROR_FILE_NAME_NOT_FOUND;
-            }
-			return false;
-		}
-        stringCopy(g_downloadFilePath, sizeof(g_downloadFilePath), filePath);
-        g_downloadedFileOffset = 0;
-	}
-
-    int err = 0;
-
+// Writes data staged in MMEM_DOWNLOAD_BUFFER to the file. On failure SD card
+// is reinitialized and file is reopened at the last written position, this is
+// possible only if everything written before was also synced.
+static bool writeDownloadBuffer(bool sync) {
     uint32_t timeout = millis() + CONF_DOWNLOAD_TIMEOUT_MS;
     while (millis() < timeout) {
-        size_t written = g_downloadFile.write((const uint8_t *)buffer, size);
-        if (written == size) {
-            if (g_downloadFile.sync()) {
-                g_downloadedFileOffset += size;
+        size_t written = g_downloadFile.write(MMEM_DOWNLOAD_BUFFER, g_downloadBufferLength);
+        if (written == g_downloadBufferLength) {
+            if (!sync || g_downloadFile.sync()) {
+                g_downloadedFileOffset += g_downloadBufferLength;
+                g_downloadBufferLength = 0;
+                if (sync) {
+                    g_downloadSyncedFileOffset = g_downloadedFileOffset;
+                }
                 return true;
             }
         }
 
+        if (g_downloadedFileOffset != g_downloadSyncedFileOffset) {
+            break;
+        }
+
         sd_card::reinitialize();
 
         bool ropened = false;
 
         while (millis() < timeout) {
-            if (g_downloadFile.open(filePath, FILE_OPEN_EXISTING | FILE_WRITE)) {
+            if (g_downloadFile.open(g_downloadFilePath, FILE_OPEN_EXISTING | FILE_WRITE)) {
                 if (g_downloadFile.seek(g_downloadedFileOffset)) {
                     ropened = true;
                     break;
@@ -409,14 +409,66 @@ bool download(const char *filePath, bool truncate, const void *buffer, size_t si
 
     sd_card::reinitialize();
 
-    if (perr) {
-        *perr = err;
-    }
     return false;
 }
 
+bool download(const char *filePath, bool truncate, const void *buffer, size_t size, int *perr) {
+    if (!sd_card::isMounted(filePath, perr)) {
+        return false;
+    }
+
+	if (truncate) {
+        dlog_view::deleteMinMaxIndex(filePath);
+        profile::deleteSnapshot(filePath);
+	    if (!g_downloadFile.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+			if (perr) {
+				*perr = SCPI_ERROR_FILE_NAME_NOT_FOUND;
+            }
+			return false;
+		}
+        stringCopy(g_downloadFilePath, sizeof(g_downloadFilePath), filePath);
+        g_downloadedFileOffset = 0;
+        g_downloadSyncedFileOffset = 0;
+        g_downloadBufferLength = 0;
+	}
+
+    // Data is staged and written in MMEM_DOWNLOAD_BUFFER_SIZE chunks, so all
+    // writes are sector aligned and from the aligned buffer.
+    const uint8_t *data = (const uint8_t *)buffer;
+    while (size > 0) {
+        size_t n = MIN(size, MMEM_DOWNLOAD_BUFFER_SIZE - g_downloadBufferLength);
+        memcpy(MMEM_DOWNLOAD_BUFFER + g_downloadBufferLength, data, n);
+        g_downloadBufferLength += n;
+        data += n;
+        size -= n;
+
+        if (g_downloadBufferLength == MMEM_DOWNLOAD_BUFFER_SIZE) {
+            bool sync = g_downloadedFileOffset + g_downloadBufferLength - g_downloadSyncedFileOffset >= CONF_MMEM_DOWNLOAD_SYNC_INTERVAL;
+            if (!writeDownloadBuffer(sync)) {
+                if (perr) {
+                    *perr = SCPI_ERROR_MASS_STORAGE_ERROR;
+                }
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool downloadFlush(int *err) {
+    if (!writeDownloadBuffer(true)) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+    return true;
+}
+
 void downloadFinished() {
     g_downloadFile.close();
+    g_downloadBufferLength = 0;
     onSdCardFileChangeHook(g_downloadFilePath);
 }
 
@@ -435,6 +487,9 @@ bool moveFile(const char *sourcePath, const char *destinationPath, int *err) {
         return false;
     }
 
+    profile::deleteSnapshot(sourcePath);
+    profile::deleteSnapshot(destinationPath);
+
     if (!SD.rename(sourcePath, destinationPath)) {
         if (err)
             *err = SCPI_ERROR_MASS_STORAGE_ERROR;
@@ -458,6 +513,9 @@ bool copyFile(const char *sourcePath, const char *destinationPath, bool showProg
         return false;
     }
 
+    dlog_view::deleteMinMaxIndex(destinationPath);
+    profile::deleteSnapshot(destinationPath);
+
     File destinationFile;
     if (!destinationFile.open(destinationPath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
         sourceFile.close();
@@ -540,6 +598,9 @@ bool deleteFile(const char *filePath, int *err) {
         return false;
     }
 
+    dlog_view::deleteMinMaxIndex(filePath);
+    profile::deleteSnapshot(filePath);
+
     onSdCardFileChangeHook(filePath);
 
     return true;
@@ -58,6 +58,8 @@ bool catalog(const char *dirPath, void *param, void (*callback)(void *param, con
 bool catalogLength(const char *dirPath, size_t *length, int *err);
 bool upload(const char *filePath, void *param, void (*callback)(void *param, const void *buffer, int size), int *err);
 bool download(const char *filePath, bool truncate, const void *buffer, size_t size, int *err);
+// writes the rest of the staged data and syncs the file, must be called before downloadFinished
+bool downloadFlush(int *err);
 void downloadFinished();
 bool moveFile(const char *sourcePath, const char *destinationPath, int *err);
 bool copyFile(const char *sourcePath, const char *destinationPath, bool showProgress, int *err);
@@ -61,6 +61,12 @@
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROTection?", scpi_cmd_diagnosticInformationProtectionQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:TEST?", scpi_cmd_diagnosticInformationTestQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:REGS?", scpi_cmd_diagnosticInformationRegsQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:DLOG?", scpi_cmd_diagnosticInformationDlogQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:EVENts?", scpi_cmd_diagnosticInformationEventsQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SPI?", scpi_cmd_diagnosticInformationSpiQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SCHeduler?", scpi_cmd_diagnosticInformationSchedulerQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SCHeduler:RESet", scpi_cmd_diagnosticInformationSchedulerReset) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:LIST?", scpi_cmd_diagnosticInformationListQ) \
     SCPI_COMMAND("DISPlay:BRIGhtness", scpi_cmd_displayBrightness) \
     SCPI_COMMAND("DISPlay:BRIGhtness?", scpi_cmd_displayBrightnessQ) \
     SCPI_COMMAND("DISPlay:VIEW", scpi_cmd_displayView) \
@@ -134,6 +140,8 @@
     SCPI_COMMAND("MMEMory:DOWNload:SIZE", scpi_cmd_mmemoryDownloadSize) \
     SCPI_COMMAND("MMEMory:INFOrmation?", scpi_cmd_mmemoryInformationQ) \
     SCPI_COMMAND("MMEMory:LOAD:LIST#", scpi_cmd_mmemoryLoadList) \
+    SCPI_COMMAND("MMEMory:LOAD:ARBitrary:VOLTage#", scpi_cmd_mmemoryLoadArbitraryVoltage) \
+    SCPI_COMMAND("MMEMory:LOAD:ARBitrary:CURRent#", scpi_cmd_mmemoryLoadArbitraryCurrent) \
     SCPI_COMMAND("MMEMory:LOAD:PROFile", scpi_cmd_mmemoryLoadProfile) \
     SCPI_COMMAND("MMEMory:LOCK", scpi_cmd_mmemoryLock) \
     SCPI_COMMAND("MMEMory:LOCK?", scpi_cmd_mmemoryLockQ) \
@@ -215,6 +223,8 @@
     SCPI_COMMAND("SENSe:DLOG:TRACe:X[:RANGe]:MIN?", scpi_cmd_senseDlogTraceXRangeMinQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y:SCALe", scpi_cmd_senseDlogTraceYScale) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y:SCALe?", scpi_cmd_senseDlogTraceYScaleQ) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:DATA:TYPE", scpi_cmd_senseDlogTraceYDataType) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:DATA:TYPE?", scpi_cmd_senseDlogTraceYDataTypeQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:LABel", scpi_cmd_senseDlogTraceYLabel) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:LABel?", scpi_cmd_senseDlogTraceYLabelQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:UNIT", scpi_cmd_senseDlogTraceYUnit) \
@@ -223,7 +233,10 @@
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#[:RANGe]:MAX?", scpi_cmd_senseDlogTraceYRangeMaxQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#[:RANGe]:MIN", scpi_cmd_senseDlogTraceYRangeMin) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#[:RANGe]:MIN?", scpi_cmd_senseDlogTraceYRangeMinQ) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:TRANsform", scpi_cmd_senseDlogTraceYTransform) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:TRANsform?", scpi_cmd_senseDlogTraceYTransformQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe[:DATA]", scpi_cmd_senseDlogTraceData) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe[:DATA]:BLOCk", scpi_cmd_senseDlogTraceDataBlock) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:BOOKmark", scpi_cmd_senseDlogTraceBookmark) \
     SCPI_COMMAND("SENSe:DLOG:CLEar", scpi_cmd_senseDlogClear) \
     SCPI_COMMAND("SENSe:DIGital:RANGe", scpi_cmd_senseDigitalRange) \
@@ -259,6 +272,7 @@
     SCPI_COMMAND("[SOURce#]:CURRent:FUNCtion:OFFSet?", scpi_cmd_sourceCurrentFunctionOffsetQ) \
     SCPI_COMMAND("[SOURce#]:CURRent:FUNCtion:DUTY", scpi_cmd_sourceCurrentFunctionDuty) \
     SCPI_COMMAND("[SOURce#]:CURRent:FUNCtion:DUTY?", scpi_cmd_sourceCurrentFunctionDutyQ) \
+    SCPI_COMMAND("[SOURce#]:CURRent:FUNCtion:ARBitrary", scpi_cmd_sourceCurrentFunctionArbitrary) \
     SCPI_COMMAND("[SOURce#]:LIST:COUNt", scpi_cmd_sourceListCount) \
     SCPI_COMMAND("[SOURce#]:LIST:COUNt?", scpi_cmd_sourceListCountQ) \
     SCPI_COMMAND("[SOURce#]:LIST:CURRent[:LEVel]", scpi_cmd_sourceListCurrentLevel) \
@@ -313,6 +327,7 @@
     SCPI_COMMAND("[SOURce#]:VOLTage:FUNCtion:OFFSet?", scpi_cmd_sourceVoltageFunctionOffsetQ) \
     SCPI_COMMAND("[SOURce#]:VOLTage:FUNCtion:DUTY", scpi_cmd_sourceVoltageFunctionDuty) \
     SCPI_COMMAND("[SOURce#]:VOLTage:FUNCtion:DUTY?", scpi_cmd_sourceVoltageFunctionDutyQ) \
+    SCPI_COMMAND("[SOURce#]:VOLTage:FUNCtion:ARBitrary", scpi_cmd_sourceVoltageFunctionArbitrary) \
     SCPI_COMMAND("SOURce:FUNCtion[:ON]", scpi_cmd_sourceFunctionOn) \
     SCPI_COMMAND("SOURce:FUNCtion[:ON]?", scpi_cmd_sourceFunctionOnQ) \
     SCPI_COMMAND("SOURce:CURRent[:DC]:RANGe", scpi_cmd_sourceCurrentDcRange) \
@@ -535,6 +550,8 @@
     SCPI_COMMAND("SIMUlator:VOLTage:PROGram:EXTernal?", scpi_cmd_simulatorVoltageProgramExternalQ) \
     SCPI_COMMAND("SIMUlator:DIGital:DATA[:BYTE]", scpi_cmd_simulatorDigitalDataByte) \
     SCPI_COMMAND("SIMUlator:UART", scpi_cmd_simulatorUart) \
+    SCPI_COMMAND("SIMUlator:SDCard:LATency", scpi_cmd_simulatorSdcardLatency) \
+    SCPI_COMMAND("SIMUlator:SDCard:LATency?", scpi_cmd_simulatorSdcardLatencyQ) \
     SCPI_COMMAND("DEBUg", scpi_cmd_debug) \
     SCPI_COMMAND("DEBUg:ONTime?", scpi_cmd_debugOntimeQ) \
     SCPI_COMMAND("DEBUg:VOLTage", scpi_cmd_debugVoltage) \
@@ -596,6 +613,12 @@
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROTection?", scpi_cmd_diagnosticInformationProtectionQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:TEST?", scpi_cmd_diagnosticInformationTestQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:REGS?", scpi_cmd_diagnosticInformationRegsQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:DLOG?", scpi_cmd_diagnosticInformationDlogQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:EVENts?", scpi_cmd_diagnosticInformationEventsQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SPI?", scpi_cmd_diagnosticInformationSpiQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SCHeduler?", scpi_cmd_diagnosticInformationSchedulerQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SCHeduler:RESet", scpi_cmd_diagnosticInformationSchedulerReset) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:LIST?", scpi_cmd_diagnosticInformationListQ) \
     SCPI_COMMAND("DISPlay:BRIGhtness", scpi_cmd_displayBrightness) \
     SCPI_COMMAND("DISPlay:BRIGhtness?", scpi_cmd_displayBrightnessQ) \
     SCPI_COMMAND("DISPlay:VIEW", scpi_cmd_displayView) \
@@ -669,6 +692,8 @@
     SCPI_COMMAND("MMEMory:DOWNload:SIZE", scpi_cmd_mmemoryDownloadSize) \
     SCPI_COMMAND("MMEMory:INFOrmation?", scpi_cmd_mmemoryInformationQ) \
     SCPI_COMMAND("MMEMory:LOAD:LIST#", scpi_cmd_mmemoryLoadList) \
+    SCPI_COMMAND("MMEMory:LOAD:ARBitrary:VOLTage#", scpi_cmd_mmemoryLoadArbitraryVoltage) \
+    SCPI_COMMAND("MMEMory:LOAD:ARBitrary:CURRent#", scpi_cmd_mmemoryLoadArbitraryCurrent) \
     SCPI_COMMAND("MMEMory:LOAD:PROFile", scpi_cmd_mmemoryLoadProfile) \
     SCPI_COMMAND("MMEMory:LOCK", scpi_cmd_mmemoryLock) \
     SCPI_COMMAND("MMEMory:LOCK?", scpi_cmd_mmemoryLockQ) \
@@ -750,6 +775,8 @@
     SCPI_COMMAND("SENSe:DLOG:TRACe:X[:RANGe]:MIN?", scpi_cmd_senseDlogTraceXRangeMinQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y:SCALe", scpi_cmd_senseDlogTraceYScale) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y:SCALe?", scpi_cmd_senseDlogTraceYScaleQ) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:DATA:TYPE", scpi_cmd_senseDlogTraceYDataType) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:DATA:TYPE?", scpi_cmd_senseDlogTraceYDataTypeQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:LABel", scpi_cmd_senseDlogTraceYLabel) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:LABel?", scpi_cmd_senseDlogTraceYLabelQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:UNIT", scpi_cmd_senseDlogTraceYUnit) \
@@ -758,7 +785,10 @@
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#[:RANGe]:MAX?", scpi_cmd_senseDlogTraceYRangeMaxQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#[:RANGe]:MIN", scpi_cmd_senseDlogTraceYRangeMin) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:Y#[:RANGe]:MIN?", scpi_cmd_senseDlogTraceYRangeMinQ) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:TRANsform", scpi_cmd_senseDlogTraceYTransform) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe:Y#:TRANsform?", scpi_cmd_senseDlogTraceYTransformQ) \
     SCPI_COMMAND("SENSe:DLOG:TRACe[:DATA]", scpi_cmd_senseDlogTraceData) \
+    SCPI_COMMAND("SENSe:DLOG:TRACe[:DATA]:BLOCk", scpi_cmd_senseDlogTraceDataBlock) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:BOOKmark", scpi_cmd_senseDlogTraceBookmark) \
     SCPI_COMMAND("SENSe:DLOG:CLEar", scpi_cmd_senseDlogClear) \
     SCPI_COMMAND("SENSe:DIGital:RANGe", scpi_cmd_senseDigitalRange) \
@@ -794,6 +824,7 @@
     SCPI_COMMAND("[SOURce#]:CURRent:FUNCtion:OFFSet?", scpi_cmd_sourceCurrentFunctionOffsetQ) \
     SCPI_COMMAND("[SOURce#]:CURRent:FUNCtion:DUTY", scpi_cmd_sourceCurrentFunctionDuty) \
     SCPI_COMMAND("[SOURce#]:CURRent:FUNCtion:DUTY?", scpi_cmd_sourceCurrentFunctionDutyQ) \
+    SCPI_COMMAND("[SOURce#]:CURRent:FUNCtion:ARBitrary", scpi_cmd_sourceCurrentFunctionArbitrary) \
     SCPI_COMMAND("[SOURce#]:LIST:COUNt", scpi_cmd_sourceListCount) \
     SCPI_COMMAND("[SOURce#]:LIST:COUNt?", scpi_cmd_sourceListCountQ) \
     SCPI_COMMAND("[SOURce#]:LIST:CURRent[:LEVel]", scpi_cmd_sourceListCurrentLevel) \
@@ -848,6 +879,7 @@
     SCPI_COMMAND("[SOURce#]:VOLTage:FUNCtion:OFFSet?", scpi_cmd_sourceVoltageFunctionOffsetQ) \
     SCPI_COMMAND("[SOURce#]:VOLTage:FUNCtion:DUTY", scpi_cmd_sourceVoltageFunctionDuty) \
     SCPI_COMMAND("[SOURce#]:VOLTage:FUNCtion:DUTY?", scpi_cmd_sourceVoltageFunctionDutyQ) \
+    SCPI_COMMAND("[SOURce#]:VOLTage:FUNCtion:ARBitrary", scpi_cmd_sourceVoltageFunctionArbitrary) \
     SCPI_COMMAND("SOURce:FUNCtion[:ON]", scpi_cmd_sourceFunctionOn) \
     SCPI_COMMAND("SOURce:FUNCtion[:ON]?", scpi_cmd_sourceFunctionOnQ) \
     SCPI_COMMAND("SOURce:CURRent[:DC]:RANGe", scpi_cmd_sourceCurrentDcRange) \
@@ -1070,6 +1102,8 @@
     SCPI_COMMAND("SIMUlator:VOLTage:PROGram:EXTernal?", scpi_cmd_simulatorVoltageProgramExternalQ) \
     SCPI_COMMAND("SIMUlator:DIGital:DATA[:BYTE]", scpi_cmd_simulatorDigitalDataByte) \
     SCPI_COMMAND("SIMUlator:UART", scpi_cmd_simulatorUart) \
+    SCPI_COMMAND("SIMUlator:SDCard:LATency", scpi_cmd_simulatorSdcardLatency) \
+    SCPI_COMMAND("SIMUlator:SDCard:LATency?", scpi_cmd_simulatorSdcardLatencyQ) \
     SCPI_COMMAND("DEBUg", scpi_cmd_debug) \
     SCPI_COMMAND("DEBUg:ONTime?", scpi_cmd_debugOntimeQ) \
     SCPI_COMMAND("DEBUg:VOLTage", scpi_cmd_debugVoltage) \
@@ -29,13 +29,55 @@ using namespace eez::psu::scpi;
 namespace eez {
 namespace scpi {
 
+// Condition registers are propagated only to the connected clients, so the
+// current conditions are also kept here for the context of a newly connected client.
+static scpi_reg_val_t g_quesCond;
+static scpi_reg_val_t g_operCond;
+static scpi_reg_val_t g_quesIsumCond[NUM_REG_INSTRUMENTS];
+static scpi_reg_val_t g_operIsumCond[NUM_REG_INSTRUMENTS];
+
+static void setConditionBits(scpi_reg_val_t &cond, int bit_mask, bool on) {
+    if (on) {
+        cond |= bit_mask;
+    } else {
+        cond &= ~bit_mask;
+    }
+}
+
+static void setCondition(scpi_psu_reg_name_t name, scpi_reg_val_t val) {
+    if (name == SCPI_PSU_REG_QUES_COND) {
+        g_quesCond = val;
+    } else if (name == SCPI_PSU_REG_OPER_COND) {
+        g_operCond = val;
+    } else if (name >= SCPI_PSU_CH_REG_QUES_INST_ISUM_COND1 && name < SCPI_PSU_CH_REG_QUES_INST_ISUM_COND1 + NUM_REG_INSTRUMENTS) {
+        g_quesIsumCond[name - SCPI_PSU_CH_REG_QUES_INST_ISUM_COND1] = val;
+    } else if (name >= SCPI_PSU_CH_REG_OPER_INST_ISUM_COND1 && name < SCPI_PSU_CH_REG_OPER_INST_ISUM_COND1 + NUM_REG_INSTRUMENTS) {
+        g_operIsumCond[name - SCPI_PSU_CH_REG_OPER_INST_ISUM_COND1] = val;
+    }
+}
+
+void reg_init_conditions(scpi_t *context) {
+    for (int i = 0; i < NUM_REG_INSTRUMENTS; i++) {
+        reg_set(context, (scpi_psu_reg_name_t)(SCPI_PSU_CH_REG_QUES_INST_ISUM_COND1 + i), g_quesIsumCond[i]);
+        reg_set(context, (scpi_psu_reg_name_t)(SCPI_PSU_CH_REG_OPER_INST_ISUM_COND1 + i), g_operIsumCond[i]);
+    }
+
+    // ISUM bits are already set from the instrument conditions
+    reg_set(context, SCPI_PSU_REG_QUES_COND, reg_get(context, SCPI_PSU_REG_QUES_COND) | g_quesCond);
+    reg_set(context, SCPI_PSU_REG_OPER_COND, reg_get(context, SCPI_PSU_REG_OPER_COND) | g_operCond);
+}
+
 void scpi_reg_set(scpi_reg_name_t name, scpi_reg_val_t val) {
     if (serial::g_testResult == TEST_OK) {
         SCPI_RegSet(&serial::g_scpiContext, name, val);
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        SCPI_RegSet(&ethernet::g_scpiContext, name, val);
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            if (ethernet::isClientConnected(clientIndex)) {
+                SCPI_RegSet(&ethernet::g_scpiContexts[clientIndex], name, val);
+            }
+        }
     }
 #endif
 }
@@ -196,12 +238,18 @@ void reg_set(scpi_t *context, scpi_psu_reg_name_t name, scpi_reg_val_t val) {
 }
 
 void reg_set(scpi_psu_reg_name_t name, scpi_reg_val_t val) {
+    setCondition(name, val);
+
     if (serial::g_testResult == TEST_OK) {
         reg_set(&serial::g_scpiContext, name, val);
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set(&ethernet::g_scpiContext, name, val);
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            if (ethernet::isClientConnected(clientIndex)) {
+                reg_set(&ethernet::g_scpiContexts[clientIndex], name, val);
+            }
+        }
     }
 #endif
 }
@@ -212,7 +260,11 @@ void reg_set_esr_bits(int bit_mask) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        SCPI_RegSetBits(&ethernet::g_scpiContext, SCPI_REG_ESR, bit_mask);
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            if (ethernet::isClientConnected(clientIndex)) {
+                SCPI_RegSetBits(&ethernet::g_scpiContexts[clientIndex], SCPI_REG_ESR, bit_mask);
+            }
+        }
     }
 #endif
 }
@@ -235,12 +287,18 @@ void reg_set_ques_bit(scpi_t *context, int bit_mask, bool on) {
 }
 
 void reg_set_ques_bit(int bit_mask, bool on) {
+    setConditionBits(g_quesCond, bit_mask, on);
+
     if (serial::g_testResult == TEST_OK) {
         reg_set_ques_bit(&serial::g_scpiContext, bit_mask, on);
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_ques_bit(&ethernet::g_scpiContext, bit_mask, on);
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            if (ethernet::isClientConnected(clientIndex)) {
+                reg_set_ques_bit(&ethernet::g_scpiContexts[clientIndex], bit_mask, on);
+            }
+        }
     }
 #endif
 }
@@ -269,12 +327,20 @@ void reg_set_ques_isum_bit(scpi_t *context, int iChannel, int bit_mask, bool on)
 }
 
 void reg_set_ques_isum_bit(int iChannel, int bit_mask, bool on) {
+    if (iChannel < NUM_REG_INSTRUMENTS) {
+        setConditionBits(g_quesIsumCond[iChannel], bit_mask, on);
+    }
+
     if (serial::g_testResult == TEST_OK) {
         reg_set_ques_isum_bit(&serial::g_scpiContext, iChannel, bit_mask, on);
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_ques_isum_bit(&ethernet::g_scpiContext, iChannel, bit_mask, on);
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            if (ethernet::isClientConnected(clientIndex)) {
+                reg_set_ques_isum_bit(&ethernet::g_scpiContexts[clientIndex], iChannel, bit_mask, on);
+            }
+        }
     }
 #endif
 }
@@ -288,9 +354,13 @@ bool is_ques_bit_enabled(int channelIndex, int bit_mask) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        scpi_reg_val_t val = reg_get(&ethernet::g_scpiContext, (scpi_psu_reg_name_t)(SCPI_PSU_CH_REG_QUES_INST_ISUM_EVENT1 + channelIndex));
-        if (!(val & bit_mask)) {
-            return false;
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            if (ethernet::isClientConnected(clientIndex)) {
+                scpi_reg_val_t val = reg_get(&ethernet::g_scpiContexts[clientIndex], (scpi_psu_reg_name_t)(SCPI_PSU_CH_REG_QUES_INST_ISUM_EVENT1 + channelIndex));
+                if (!(val & bit_mask)) {
+                    return false;
+                }
+            }
         }
     }
 #endif
@@ -316,12 +386,18 @@ void reg_set_oper_bit(scpi_t *context, int bit_mask, bool on) {
 }
 
 void reg_set_oper_bit(int bit_mask, bool on) {
+    setConditionBits(g_operCond, bit_mask, on);
+
     if (serial::g_testResult == TEST_OK) {
         reg_set_oper_bit(&serial::g_scpiContext, bit_mask, on);
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_oper_bit(&ethernet::g_scpiContext, bit_mask, on);
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            if (ethernet::isClientConnected(clientIndex)) {
+                reg_set_oper_bit(&ethernet::g_scpiContexts[clientIndex], bit_mask, on);
+            }
+        }
     }
 #endif
 }
@@ -351,12 +427,20 @@ void reg_set_oper_isum_bit(scpi_t *context, int iChannel, int bit_mask, bool on)
 }
 
 void reg_set_oper_isum_bit(int iChannel, int bit_mask, bool on) {
+    if (iChannel < NUM_REG_INSTRUMENTS) {
+        setConditionBits(g_operIsumCond[iChannel], bit_mask, on);
+    }
+
     if (serial::g_testResult == TEST_OK) {
         reg_set_oper_isum_bit(&serial::g_scpiContext, iChannel, bit_mask, on);
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_oper_isum_bit(&ethernet::g_scpiContext, iChannel, bit_mask, on);
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            if (ethernet::isClientConnected(clientIndex)) {
+                reg_set_oper_isum_bit(&ethernet::g_scpiContexts[clientIndex], iChannel, bit_mask, on);
+            }
+        }
     }
 #endif
 }
@@ -122,5 +122,8 @@ void reg_set_oper_bit(int bit_mask, bool on);
 
 void reg_set_oper_isum_bit(int iChannel /* zero based */, int bit_mask, bool on);
 
+// sets condition registers of the context to the current conditions
+void reg_init_conditions(scpi_t *context);
+
 } // namespace scpi
 } // namespace eez
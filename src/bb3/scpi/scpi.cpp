@@ -55,7 +55,9 @@ void resetContext() {
 
 #if OPTION_ETHERNET
     if (psu::ethernet::g_testResult == TEST_OK) {
-        scpi::resetContext(&psu::ethernet::g_scpiContext);
+        for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+            scpi::resetContext(&psu::ethernet::g_scpiContexts[clientIndex]);
+        }
     }
 #endif
 }
@@ -69,8 +71,12 @@ void generateError(int error) {
         }
 
 #if OPTION_ETHERNET
-        if (psu::ethernet::g_testResult == TEST_OK && psu::ethernet::isConnected()) {
-            SCPI_ErrorPush(&psu::ethernet::g_scpiContext, error);
+        if (psu::ethernet::g_testResult == TEST_OK) {
+            for (int clientIndex = 0; clientIndex < MAX_SCPI_CLIENTS; clientIndex++) {
+                if (psu::ethernet::isClientConnected(clientIndex)) {
+                    SCPI_ErrorPush(&psu::ethernet::g_scpiContexts[clientIndex], error);
+                }
+            }
         }
 #endif
 
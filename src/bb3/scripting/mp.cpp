@@ -93,20 +93,32 @@ void startMpScript() {
 	InfoTrace("Script ended: %s\n", scriptName);
 }
 
+// these are waiting for the user, so they are executed in the scripting thread
+static bool isExecutedInScriptingThread(const char *commandOrQueryText) {
+	return startsWithNoCase(commandOrQueryText, "DISP:INPUT?") || startsWithNoCase(commandOrQueryText, "DISP:DIALOG:ACTION?");
+}
+
+static void raiseScpiTimeout() {
+	static char g_scpiError[48];
+	snprintf(g_scpiError, sizeof(g_scpiError), "SCPI timeout");
+	mp_raise_ValueError(g_scpiError);
+}
+
+static void raiseScpiError(int err) {
+	static char g_scpiError[48];
+	snprintf(g_scpiError, sizeof(g_scpiError), "SCPI error %d, \"%s\"", err, SCPI_ErrorTranslate(err));
+	mp_raise_ValueError(g_scpiError);
+}
+
 bool executeScpiFromMP(const char *commandOrQueryText, const char **resultText, size_t *resultTextLen) {
 	// DebugTrace("> %s\n", commandOrQueryText);
 
-	bool executeInLowPriorityThread = true;
-	if (startsWithNoCase(commandOrQueryText, "DISP:INPUT?") || startsWithNoCase(commandOrQueryText, "DISP:DIALOG:ACTION?")) {
-		executeInLowPriorityThread = false;
-	}
+	bool executeInLowPriorityThread = !isExecutedInScriptingThread(commandOrQueryText);
 
 	if (executeInLowPriorityThread) {
 		executeScpi(commandOrQueryText, true);
 		if (!waitScpiResult()) {
-			static char g_scpiError[48];
-			snprintf(g_scpiError, sizeof(g_scpiError), "SCPI timeout");
-			mp_raise_ValueError(g_scpiError);
+			raiseScpiTimeout();
 		}
 	} else {
 		executeScpi(commandOrQueryText, false);
@@ -114,9 +126,33 @@ bool executeScpiFromMP(const char *commandOrQueryText, const char **resultText,
 
 	int err;
 	if (!getLatestScpiResult(resultText, resultTextLen, &err)) {
-		static char g_scpiError[48];
-		snprintf(g_scpiError, sizeof(g_scpiError), "SCPI error %d, \"%s\"", err, SCPI_ErrorTranslate(err));
-		mp_raise_ValueError(g_scpiError);
+		raiseScpiError(err);
+	}
+
+	return true;
+}
+
+bool executeScpiBatchFromMP(const char **commands, size_t numCommands, ScpiBatchResult *results, size_t *numExecuted) {
+	if (isExecutedInScriptingThread(commands[0])) {
+		executeScpiFromMP(commands[0], &results[0].text, &results[0].textLen);
+		*numExecuted = 1;
+		return true;
+	}
+
+	// batch is executed up to the first command that must be executed in the scripting thread
+	size_t numCommandsInBatch = 1;
+	while (numCommandsInBatch < numCommands && !isExecutedInScriptingThread(commands[numCommandsInBatch])) {
+		numCommandsInBatch++;
+	}
+
+	executeScpiBatch(commands, numCommandsInBatch, results);
+	if (!waitScpiResult()) {
+		raiseScpiTimeout();
+	}
+
+	int err;
+	if (!getLatestScpiBatchResult(numExecuted, &err)) {
+		raiseScpiError(err);
 	}
 
 	return true;
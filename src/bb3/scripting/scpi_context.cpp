@@ -33,12 +33,17 @@ namespace scripting {
 using namespace eez::scpi;
 using namespace eez::psu::scpi;
 
-static char g_scpiData[SCPI_PARSER_INPUT_BUFFER_LENGTH + 1];
+// Batch results are stored one after another, next command from the batch is
+// executed only if there is room left for the longest possible result.
+static const size_t SCPI_DATA_BUFFER_LENGTH = 2 * SCPI_PARSER_INPUT_BUFFER_LENGTH;
+
+static char g_scpiData[SCPI_DATA_BUFFER_LENGTH + 1];
+static size_t g_scpiDataStart;
 static size_t g_scpiDataLen;
 static int_fast16_t g_lastError;
 
 size_t SCPI_Write(scpi_t *context, const char *data, size_t len) {
-    len = MIN(len, SCPI_PARSER_INPUT_BUFFER_LENGTH - g_scpiDataLen);
+    len = MIN(len, g_scpiDataStart + SCPI_PARSER_INPUT_BUFFER_LENGTH - g_scpiDataLen);
     if (len > 0) {
         memcpy(g_scpiData + g_scpiDataLen, data, len);
         g_scpiDataLen += len;
@@ -98,6 +103,11 @@ scpi_t g_scpiContext;
 
 static const char *g_commandOrQueryText;
 
+static const char **g_batchCommands;
+static size_t g_batchNumCommands;
+static ScpiBatchResult *g_batchResults;
+static size_t g_batchNumExecuted;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void initScpiContext() {
@@ -123,34 +133,92 @@ void doExecuteScpi() {
 	scpiResultIsReady();
 }
 
-bool getLatestScpiResult(const char **resultText, size_t *resultTextLen, int *err) {
-	if (g_lastError != 0) {
-		if (err) {
-			*err = g_lastError;
-		}
-		return false;
-	}
+void executeScpiBatch(const char **commands, size_t numCommands, ScpiBatchResult *results) {
+    g_batchCommands = commands;
+    g_batchNumCommands = numCommands;
+    g_batchResults = results;
+    sendMessageToLowPriorityThread(MP_EXECUTE_SCPI_BATCH);
+}
 
-	if (g_scpiDataLen >= 2 && g_scpiData[g_scpiDataLen - 2] == '\r' && g_scpiData[g_scpiDataLen - 1] == '\n') {
-		g_scpiDataLen -= 2;
-		g_scpiData[g_scpiDataLen] = 0;
+static void normalizeResult(char *data, size_t &dataLen) {
+	if (dataLen >= 2 && data[dataLen - 2] == '\r' && data[dataLen - 1] == '\n') {
+		dataLen -= 2;
+		data[dataLen] = 0;
 	}
 
-	if (g_scpiDataLen >= 3 && g_scpiData[0] == '"' && g_scpiData[g_scpiDataLen - 1] == '"') {
+	if (dataLen >= 3 && data[0] == '"' && data[dataLen - 1] == '"') {
 		// replace "" with "
 		size_t j = 1;
 		size_t i;
-		for (i = 1; i < g_scpiDataLen - 2; i++, j++) {
-			g_scpiData[j] = g_scpiData[i];
-			if (g_scpiData[i] == '"' && g_scpiData[i + 1] == '"') {
+		for (i = 1; i < dataLen - 2; i++, j++) {
+			data[j] = data[i];
+			if (data[i] == '"' && data[i + 1] == '"') {
 				i++;
 			}
 		}
-		g_scpiData[j] = g_scpiData[i];
-		g_scpiData[j + 1] = '"';
-		g_scpiDataLen -= i - j;
+		data[j] = data[i];
+		data[j + 1] = '"';
+		dataLen -= i - j;
+	}
+}
+
+void doExecuteScpiBatch() {
+	g_scpiDataLen = 0;
+	g_lastError = 0;
+    g_batchNumExecuted = 0;
+
+    while (g_batchNumExecuted < g_batchNumCommands && SCPI_DATA_BUFFER_LENGTH - g_scpiDataLen >= SCPI_PARSER_INPUT_BUFFER_LENGTH) {
+        const char *commandOrQueryText = g_batchCommands[g_batchNumExecuted];
+
+        g_scpiDataStart = g_scpiDataLen;
+
+        input(g_scpiContext, commandOrQueryText, strlen(commandOrQueryText));
+        input(g_scpiContext, "\r\n", 2);
+
+        if (g_lastError != 0) {
+            break;
+        }
+
+        char *resultText = g_scpiData + g_scpiDataStart;
+        size_t resultTextLen = g_scpiDataLen - g_scpiDataStart;
+        normalizeResult(resultText, resultTextLen);
+        resultText[resultTextLen] = 0;
+
+        g_batchResults[g_batchNumExecuted].text = resultText;
+        g_batchResults[g_batchNumExecuted].textLen = resultTextLen;
+        g_batchNumExecuted++;
+
+        g_scpiDataLen = g_scpiDataStart + resultTextLen + 1;
+    }
+
+    g_scpiDataStart = 0;
+
+	scpiResultIsReady();
+}
+
+bool getLatestScpiBatchResult(size_t *numExecuted, int *err) {
+    *numExecuted = g_batchNumExecuted;
+
+	if (g_lastError != 0) {
+		if (err) {
+			*err = g_lastError;
+		}
+		return false;
 	}
 
+    return true;
+}
+
+bool getLatestScpiResult(const char **resultText, size_t *resultTextLen, int *err) {
+	if (g_lastError != 0) {
+		if (err) {
+			*err = g_lastError;
+		}
+		return false;
+	}
+
+	normalizeResult(g_scpiData, g_scpiDataLen);
+
 	// if (g_scpiDataLen > 0) {
 	//     DebugTrace("< %s\n", g_scpiData);
 	// }
@@ -24,6 +24,8 @@ namespace scripting {
 void initScpiContext();
 void executeScpi(const char *commandOrQueryText, bool executeInLowPriorityThread);
 void doExecuteScpi();
+void executeScpiBatch(const char **commands, size_t numCommands, ScpiBatchResult *results);
+void doExecuteScpiBatch();
 
 } // scripting
 } // eez
@@ -148,6 +148,8 @@ void onLowPriorityQueueMessage(uint32_t type, uint32_t param) {
         stopScript();
     } else if (type == MP_EXECUTE_SCPI) {
 		doExecuteScpi();
+	} else if (type == MP_EXECUTE_SCPI_BATCH) {
+		doExecuteScpiBatch();
 	}
 }
 
@@ -48,9 +48,20 @@ bool startScript(const char *filePath, int *err = nullptr);
 bool stopScript(int *err = nullptr);
 inline bool isIdle() { return g_state == STATE_IDLE; }
 
+struct ScpiBatchResult {
+    const char *text;
+    size_t textLen;
+};
+
 bool executeScpiFromMP(const char *commandOrQueryText, const char **resultText, size_t *resultTextLen);
 bool getLatestScpiResult(const char **resultText, size_t *resultTextLen, int *err);
 
+// Executes commands one after another with a single round trip to the low priority thread.
+// Stops when results buffer is full, *numExecuted is then less than numCommands and
+// the rest should be executed with another call. Result texts are valid until the next call.
+bool executeScpiBatchFromMP(const char **commands, size_t numCommands, ScpiBatchResult *results, size_t *numExecuted);
+bool getLatestScpiBatchResult(size_t *numExecuted, int *err);
+
 bool isFlowRunning();
 void executeFlowAction(const gui::WidgetCursor &widgetCursor, int16_t actionId);
 void dataOperation(int16_t dataId, gui::DataOperationEnum operation, const gui::WidgetCursor &widgetCursor, Value &value);
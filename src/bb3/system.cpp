@@ -18,6 +18,10 @@
 
 #include <stdio.h>
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <chrono>
+#endif
+
 #include <eez/core/os.h>
 
 #include <bb3/system.h>
@@ -108,6 +112,23 @@ uint32_t micros() {
 #endif
 }
 
+uint64_t micros64() {
+#if defined(EEZ_PLATFORM_STM32)
+    auto tc1 = g_tickCount;
+	auto cnt = TIM7->CNT;
+	auto tc2 = g_tickCount;
+	if (tc1 == tc2) {
+		return tc1 * 200 + 2 * cnt;
+	}
+	return tc2 * 200;
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
 void delayMicroseconds(uint32_t microseconds) {
 #if defined(EEZ_PLATFORM_STM32)
 	while (microseconds--) {
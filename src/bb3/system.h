@@ -37,6 +37,8 @@ void watchdogReset(int fromTask);
 namespace eez {
 
 uint32_t micros();
+// monotonic, doesn't wrap, resolution is 2 us in STM32 and 1 us in simulator
+uint64_t micros64();
 void delay(uint32_t millis);
 void delayMicroseconds(uint32_t microseconds);
 
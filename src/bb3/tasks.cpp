@@ -47,6 +47,7 @@
 #include <bb3/psu/sd_card.h>
 #include <bb3/psu/serial_psu.h>
 #include <bb3/psu/ramp.h>
+#include <bb3/psu/scheduler.h>
 #include <bb3/dib-dcp405/dib-dcp405.h>
 #include <bb3/function_generator.h>
 
@@ -160,7 +161,12 @@ void highPriorityThreadOneIter() {
 
     highPriorityMessageQueueObject obj;
 	if (EEZ_MESSAGE_QUEUE_GET(highPriority, obj, 1)) {
+        uint32_t messageStartTimeUs = psu::scheduler::getTimeUs();
         psu::onThreadMessage(obj.type, obj.param);
+        if (obj.type != PSU_MESSAGE_TICK) {
+            // PSU_MESSAGE_TICK is accounted by the scheduler jobs
+            psu::scheduler::onMessageHandled(messageStartTimeUs);
+        }
 
 #if defined(EEZ_PLATFORM_STM32)
         uint32_t diffMs = millis() - g_lastTickCountMs;
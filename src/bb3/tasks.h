@@ -64,6 +64,7 @@ enum HighPriorityThreadMessage {
     PSU_MESSAGE_SAVE_SERIAL_NO,
     PSU_MESSAGE_MODULE_RESYNC,
     PSU_MESSAGE_COPY_CHANNEL_TO_CHANNEL,
+    PSU_MESSAGE_LIST_TICK,
 
     // this must be at the end
     PSU_MESSAGE_MODULE_SPECIFIC,
@@ -84,6 +85,7 @@ enum LowPriorityThreadMessage {
 
     MP_LOAD_SCRIPT,
     MP_EXECUTE_SCPI,
+    MP_EXECUTE_SCPI_BATCH,
     MP_STOP_SCRIPT,
 
     MP_LAST_MESSAGE_TYPE,
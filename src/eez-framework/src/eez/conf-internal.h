@@ -27,6 +27,26 @@
     #define EEZ_OPTION_GUI 1
 #endif
 
+// fill freed memory with 0xCC to catch use after free
+#ifndef EEZ_OPTION_ALLOC_POISON
+    #define EEZ_OPTION_ALLOC_POISON 0
+#endif
+
+// let the flow execution queue grow into the heap when its static buffer is full
+#ifndef EEZ_OPTION_FLOW_QUEUE_SPILL
+    #define EEZ_OPTION_FLOW_QUEUE_SPILL 1
+#endif
+
+// cache results of flow expressions that depend only on constants and global variables,
+// off where global variables can be modified from outside of the flow engine
+#ifndef EEZ_OPTION_FLOW_EXPRESSION_CACHE
+    #if defined(__EMSCRIPTEN__) || EEZ_FOR_LVGL
+        #define EEZ_OPTION_FLOW_EXPRESSION_CACHE 0
+    #else
+        #define EEZ_OPTION_FLOW_EXPRESSION_CACHE 1
+    #endif
+#endif
+
 #ifdef __cplusplus
     #if EEZ_OPTION_GUI
         #ifdef __has_include
@@ -22,6 +22,7 @@
 #include <math.h>
 #include <assert.h>
 #include <string.h>
+#include <stddef.h>
 
 #if defined(EEZ_FOR_LVGL)
 #ifdef LV_LVGL_H_INCLUDE_SIMPLE
@@ -61,6 +62,33 @@ void getAllocInfo(uint32_t &free, uint32_t &alloc) {
 	alloc = mon.total_size - mon.free_size;
 }
 
+void getAllocInfo(AllocInfo &info) {
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+	memset(&info, 0, sizeof(info));
+	info.free = mon.free_size;
+	info.alloc = mon.total_size - mon.free_size;
+	info.peakAlloc = mon.max_used;
+	info.largestFreeBlock = mon.free_biggest_size;
+	info.numFreeBlocks = mon.free_cnt;
+	info.numAllocBlocks = mon.used_cnt;
+}
+
+void *poolAlloc(size_t size, uint32_t id) {
+    return alloc(size, id);
+}
+
+void poolFree(void *ptr) {
+    free(ptr);
+}
+
+void initObjectPools(uint32_t capacity) {
+}
+
+void getObjectPoolInfo(int poolIndex, ObjectPoolInfo &info) {
+	memset(&info, 0, sizeof(info));
+}
+
 #elif 0 && defined(__EMSCRIPTEN__)
 
 void initAllocHeap(uint8_t *heap, size_t heapSize) {
@@ -84,19 +112,91 @@ void getAllocInfo(uint32_t &free, uint32_t &alloc) {
 	alloc = 0;
 }
 
+void getAllocInfo(AllocInfo &info) {
+	memset(&info, 0, sizeof(info));
+}
+
+void *poolAlloc(size_t size, uint32_t id) {
+    return alloc(size, id);
+}
+
+void poolFree(void *ptr) {
+    free(ptr);
+}
+
+void initObjectPools(uint32_t capacity) {
+}
+
+void getObjectPoolInfo(int poolIndex, ObjectPoolInfo &info) {
+	memset(&info, 0, sizeof(info));
+}
+
 #else
 
-static const size_t ALIGNMENT = 64;
-static const size_t MIN_BLOCK_SIZE = 8;
+////////////////////////////////////////////////////////////////////////////////
+// TLSF (two level segregated fit) allocator
+//
+// Free blocks are kept in size class lists indexed by two bitmaps, so both
+// alloc and free are O(1). Every block header stores the previous physical
+// block (boundary tag) so free can merge with neighbours without walking the heap.
+
+static const size_t ALIGNMENT = 8;
+
+static const int SL_INDEX_COUNT_LOG2 = 4;
+static const int SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+static const int ALIGNMENT_LOG2 = 3;
+static const int FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGNMENT_LOG2;
+static const int FL_INDEX_MAX = 30;
+static const int FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+static const size_t SMALL_BLOCK_SIZE = (size_t)1 << FL_INDEX_SHIFT;
+
+static const size_t BLOCK_FREE_BIT = 1;
+static const size_t BLOCK_PREV_FREE_BIT = 2;
+static const size_t BLOCK_SIZE_MASK = ~(BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT);
 
 struct AllocBlock {
-	AllocBlock *next;
-	int free;
-	size_t size;
+	AllocBlock *prevPhys;
+	size_t sizeAndFlags; // payload size with BLOCK_FREE_BIT and BLOCK_PREV_FREE_BIT
 	uint32_t id;
+
+	// valid only when block is free, stored in payload
+	AllocBlock *nextFree;
+	AllocBlock *prevFree;
+
+	size_t size() { return sizeAndFlags & BLOCK_SIZE_MASK; }
+	void setSize(size_t size) { sizeAndFlags = size | (sizeAndFlags & ~BLOCK_SIZE_MASK); }
+
+	bool isFree() { return (sizeAndFlags & BLOCK_FREE_BIT) != 0; }
+	void setFree(bool free) { sizeAndFlags = free ? sizeAndFlags | BLOCK_FREE_BIT : sizeAndFlags & ~BLOCK_FREE_BIT; }
+
+	bool isPrevFree() { return (sizeAndFlags & BLOCK_PREV_FREE_BIT) != 0; }
+	void setPrevFree(bool free) { sizeAndFlags = free ? sizeAndFlags | BLOCK_PREV_FREE_BIT : sizeAndFlags & ~BLOCK_PREV_FREE_BIT; }
+
+	void *payload() { return (uint8_t *)this + HEADER_SIZE; }
+	AllocBlock *nextPhys() { return (AllocBlock *)((uint8_t *)payload() + size()); }
+
+	static AllocBlock *fromPayload(void *ptr) { return (AllocBlock *)((uint8_t *)ptr - HEADER_SIZE); }
+
+	static const size_t HEADER_SIZE;
 };
 
+const size_t AllocBlock::HEADER_SIZE = (offsetof(AllocBlock, nextFree) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+static const size_t MIN_BLOCK_SIZE = sizeof(AllocBlock) - AllocBlock::HEADER_SIZE;
+
 static uint8_t *g_heap;
+static size_t g_heapSize;
+
+static uint32_t g_flBitmap;
+static uint32_t g_slBitmap[FL_INDEX_COUNT];
+static AllocBlock *g_freeBlocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+static size_t g_freeSize;
+static size_t g_allocSize;
+static size_t g_peakAllocSize;
+static uint32_t g_numAllocBlocks;
+static uint32_t g_numFreeBlocks;
+static uint32_t g_numFailedAllocs;
 
 #if defined(EEZ_PLATFORM_STM32)
 #pragma GCC diagnostic push
@@ -109,13 +209,148 @@ EEZ_MUTEX_DECLARE(alloc);
 #pragma GCC diagnostic pop
 #endif
 
+// index of the most/least significant set bit, x must not be 0
+static inline int allocFls(size_t x) {
+#if defined(__GNUC__)
+	return (int)(sizeof(unsigned long) * 8) - 1 - __builtin_clzl((unsigned long)x);
+#else
+	int bit = 0;
+	while (x >>= 1) {
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+static inline int allocFfs(uint32_t x) {
+#if defined(__GNUC__)
+	return __builtin_ctz(x);
+#else
+	int bit = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+static void mappingInsert(size_t size, int &fl, int &sl) {
+	if (size < SMALL_BLOCK_SIZE) {
+		fl = 0;
+		sl = (int)(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+	} else {
+		fl = allocFls(size);
+		sl = (int)(size >> (fl - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+		fl -= FL_INDEX_SHIFT - 1;
+	}
+}
+
+// rounds size up to the next size class so any block in it is big enough
+static void mappingSearch(size_t size, int &fl, int &sl) {
+	if (size >= SMALL_BLOCK_SIZE) {
+		size += ((size_t)1 << (allocFls(size) - SL_INDEX_COUNT_LOG2)) - 1;
+	}
+	mappingInsert(size, fl, sl);
+}
+
+static void insertFreeBlock(AllocBlock *block) {
+	int fl, sl;
+	mappingInsert(block->size(), fl, sl);
+
+	AllocBlock *head = g_freeBlocks[fl][sl];
+	block->nextFree = head;
+	block->prevFree = nullptr;
+	if (head) {
+		head->prevFree = block;
+	}
+	g_freeBlocks[fl][sl] = block;
+
+	g_flBitmap |= 1u << fl;
+	g_slBitmap[fl] |= 1u << sl;
+
+	g_freeSize += block->size();
+	g_numFreeBlocks++;
+}
+
+static void removeFreeBlock(AllocBlock *block) {
+	int fl, sl;
+	mappingInsert(block->size(), fl, sl);
+
+	if (block->prevFree) {
+		block->prevFree->nextFree = block->nextFree;
+	} else {
+		g_freeBlocks[fl][sl] = block->nextFree;
+		if (!block->nextFree) {
+			g_slBitmap[fl] &= ~(1u << sl);
+			if (!g_slBitmap[fl]) {
+				g_flBitmap &= ~(1u << fl);
+			}
+		}
+	}
+
+	if (block->nextFree) {
+		block->nextFree->prevFree = block->prevFree;
+	}
+
+	g_freeSize -= block->size();
+	g_numFreeBlocks--;
+}
+
+static AllocBlock *findFreeBlock(size_t size) {
+	int fl, sl;
+	mappingSearch(size, fl, sl);
+	if (fl >= FL_INDEX_COUNT) {
+		return nullptr;
+	}
+
+	uint32_t slMap = g_slBitmap[fl] & (~0u << sl);
+	if (!slMap) {
+		uint32_t flMap = fl + 1 < FL_INDEX_COUNT ? g_flBitmap & (~0u << (fl + 1)) : 0;
+		if (!flMap) {
+			return nullptr;
+		}
+		fl = allocFfs(flMap);
+		slMap = g_slBitmap[fl];
+	}
+
+	return g_freeBlocks[fl][allocFfs(slMap)];
+}
+
 void initAllocHeap(uint8_t *heap, size_t heapSize) {
-    g_heap = heap;
+	// align heap start and leave room for the zero size sentinel block at the end
+	g_heap = (uint8_t *)(((uintptr_t)heap + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+	heapSize -= g_heap - heap;
+	heapSize &= ~(ALIGNMENT - 1);
+	g_heapSize = heapSize;
+
+	size_t maxBlockSize = ((size_t)1 << FL_INDEX_MAX) - 1;
+	size_t size = heapSize - 2 * AllocBlock::HEADER_SIZE;
+	if (size > maxBlockSize) {
+		size = maxBlockSize & ~(ALIGNMENT - 1);
+	}
+
+	g_flBitmap = 0;
+	memset(g_slBitmap, 0, sizeof(g_slBitmap));
+	memset(g_freeBlocks, 0, sizeof(g_freeBlocks));
+	g_freeSize = 0;
+	g_allocSize = 0;
+	g_peakAllocSize = 0;
+	g_numAllocBlocks = 0;
+	g_numFreeBlocks = 0;
+	g_numFailedAllocs = 0;
 
 	AllocBlock *first = (AllocBlock *)g_heap;
-	first->next = 0;
-	first->free = 1;
-	first->size = heapSize - sizeof(AllocBlock);
+	first->prevPhys = nullptr;
+	first->sizeAndFlags = size | BLOCK_FREE_BIT;
+	first->id = 0;
+
+	AllocBlock *sentinel = first->nextPhys();
+	sentinel->prevPhys = first;
+	sentinel->sizeAndFlags = BLOCK_PREV_FREE_BIT;
+	sentinel->id = 0;
+
+	insertFreeBlock(first);
 
 	EEZ_MUTEX_CREATE(alloc);
 }
@@ -126,43 +361,47 @@ void *alloc(size_t size, uint32_t id) {
 	}
 
 	if (EEZ_MUTEX_WAIT(alloc, osWaitForever)) {
-		AllocBlock *firstBlock = (AllocBlock *)g_heap;
-
-		AllocBlock *block = firstBlock;
 		size = ((size + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
-
-		// find free block with enough size
-		// TODO merge multiple free consecutive blocks into one that has enough size
-		while (block) {
-			if (block->free && block->size >= size) {
-				break;
-			}
-			block = block->next;
+		if (size < MIN_BLOCK_SIZE) {
+			size = MIN_BLOCK_SIZE;
 		}
 
+		AllocBlock *block = findFreeBlock(size);
 		if (!block) {
+			g_numFailedAllocs++;
 			EEZ_MUTEX_RELEASE(alloc);
 			return nullptr;
 		}
 
-		int remainingSize = block->size - size - sizeof(AllocBlock);
-		if (remainingSize >= (int)MIN_BLOCK_SIZE) {
-			// remainingSize is enough to create a new block
-			auto newBlock = (AllocBlock *)((uint8_t *)block + sizeof(AllocBlock) + size);
-			newBlock->next = block->next;
-			newBlock->free = 1;
-			newBlock->size = remainingSize;
+		removeFreeBlock(block);
+
+		if (block->size() >= size + AllocBlock::HEADER_SIZE + MIN_BLOCK_SIZE) {
+			// remaining size is enough to create a new free block
+			auto newBlock = (AllocBlock *)((uint8_t *)block->payload() + size);
+			newBlock->prevPhys = block;
+			newBlock->sizeAndFlags = (block->size() - size - AllocBlock::HEADER_SIZE) | BLOCK_FREE_BIT;
+			newBlock->id = 0;
+			newBlock->nextPhys()->prevPhys = newBlock;
 
-			block->next = newBlock;
-			block->size = size;
+			block->setSize(size);
+
+			insertFreeBlock(newBlock);
+		} else {
+			block->nextPhys()->setPrevFree(false);
 		}
 
-		block->free = 0;
+		block->setFree(false);
 		block->id = id;
 
+		g_allocSize += block->size();
+		if (g_allocSize > g_peakAllocSize) {
+			g_peakAllocSize = g_allocSize;
+		}
+		g_numAllocBlocks++;
+
 		EEZ_MUTEX_RELEASE(alloc);
 
-		return block + 1;
+		return block->payload();
 	}
 
 	return nullptr;
@@ -174,46 +413,44 @@ void free(void *ptr) {
 	}
 
 	if (EEZ_MUTEX_WAIT(alloc, osWaitForever)) {
-		AllocBlock *firstBlock = (AllocBlock *)g_heap;
-
-		AllocBlock *prevBlock = nullptr;
-		AllocBlock *block = firstBlock;
+		AllocBlock *block = AllocBlock::fromPayload(ptr);
 
-		while (block && block + 1 < ptr) {
-			prevBlock = block;
-			block = block->next;
-		}
-
-		if (!block || block + 1 != ptr || block->free) {
+		if ((uint8_t *)block < g_heap || (uint8_t *)ptr >= g_heap + g_heapSize || block->isFree()) {
 			assert(false);
 			EEZ_MUTEX_RELEASE(alloc);
 			return;
 		}
 
+		g_allocSize -= block->size();
+		g_numAllocBlocks--;
+
+#if EEZ_OPTION_ALLOC_POISON
 		// reset memory to catch errors when memory is used after free is called
-		memset(ptr, 0xCC, block->size);
-
-		auto nextBlock = block->next;
-		if (nextBlock && nextBlock->free) {
-			if (prevBlock && prevBlock->free) {
-				// both next and prev blocks are free, merge 3 blocks into one
-				prevBlock->next = nextBlock->next;
-				prevBlock->size += sizeof(AllocBlock) + block->size + sizeof(AllocBlock) + nextBlock->size;
-			} else {
-				// next block is free, merge 2 blocks into one
-				block->next = nextBlock->next;
-				block->size += sizeof(AllocBlock) + nextBlock->size;
-				block->free = 1;
-			}
-		} else if (prevBlock && prevBlock->free) {
+		memset(ptr, 0xCC, block->size());
+#endif
+
+		if (block->isPrevFree()) {
 			// prev block is free, merge 2 blocks into one
-			prevBlock->next = nextBlock;
-			prevBlock->size += sizeof(AllocBlock) + block->size;
-		} else {
-			// just free
-			block->free = 1;
+			AllocBlock *prevBlock = block->prevPhys;
+			removeFreeBlock(prevBlock);
+			prevBlock->setSize(prevBlock->size() + AllocBlock::HEADER_SIZE + block->size());
+			block = prevBlock;
 		}
 
+		AllocBlock *nextBlock = block->nextPhys();
+		if (nextBlock->isFree()) {
+			// next block is free, merge 2 blocks into one
+			removeFreeBlock(nextBlock);
+			block->setSize(block->size() + AllocBlock::HEADER_SIZE + nextBlock->size());
+			nextBlock = block->nextPhys();
+		}
+
+		block->setFree(true);
+		nextBlock->prevPhys = block;
+		nextBlock->setPrevFree(true);
+
+		insertFreeBlock(block);
+
 		EEZ_MUTEX_RELEASE(alloc);
 	}
 }
@@ -223,19 +460,56 @@ template<typename T> void freeObject(T *ptr) {
 	free(ptr);
 }
 
+static size_t getLargestFreeBlockSize() {
+	if (!g_flBitmap) {
+		return 0;
+	}
+
+	int fl = allocFls(g_flBitmap);
+	int sl = allocFls(g_slBitmap[fl]);
+
+	size_t largest = 0;
+	for (AllocBlock *block = g_freeBlocks[fl][sl]; block; block = block->nextFree) {
+		if (block->size() > largest) {
+			largest = block->size();
+		}
+	}
+	return largest;
+}
+
 #if OPTION_SCPI
 void dumpAlloc(scpi_t *context) {
-	AllocBlock *first = (AllocBlock *)g_heap;
-	AllocBlock *block = first;
-	while (block) {
-		char buffer[100];
-		if (block->free) {
-			snprintf(buffer, sizeof(buffer), "FREE: %d", (int)block->size);
+	char buffer[100];
+
+	AllocBlock *block = (AllocBlock *)g_heap;
+	while (block->size() > 0) {
+		if (block->isFree()) {
+			snprintf(buffer, sizeof(buffer), "FREE: %d", (int)block->size());
 		} else {
-			snprintf(buffer, sizeof(buffer), "ALOC (0x%08x): %d", (unsigned int)block->id, (int)block->size);
+			snprintf(buffer, sizeof(buffer), "ALOC (0x%08x): %d", (unsigned int)block->id, (int)block->size());
 		}
 		SCPI_ResultText(context, buffer);
-		block = block->next;
+		block = block->nextPhys();
+	}
+
+	AllocInfo info;
+	getAllocInfo(info);
+
+	snprintf(buffer, sizeof(buffer), "TOTAL FREE: %d in %d blocks, largest %d, fragmentation %d%%",
+		(int)info.free, (int)info.numFreeBlocks, (int)info.largestFreeBlock,
+		info.free > 0 ? (int)(100 - 100ULL * info.largestFreeBlock / info.free) : 0);
+	SCPI_ResultText(context, buffer);
+
+	snprintf(buffer, sizeof(buffer), "TOTAL ALOC: %d in %d blocks, peak %d, failed %d",
+		(int)info.alloc, (int)info.numAllocBlocks, (int)info.peakAlloc, (int)info.numFailedAllocs);
+	SCPI_ResultText(context, buffer);
+
+	for (int i = 0; i < NUM_OBJECT_POOLS; i++) {
+		ObjectPoolInfo poolInfo;
+		getObjectPoolInfo(i, poolInfo);
+		snprintf(buffer, sizeof(buffer), "POOL %d: capacity %d, in use %d, high water %d, hits %d, misses %d",
+			(int)poolInfo.objectSize, (int)poolInfo.capacity, (int)poolInfo.inUse, (int)poolInfo.highWater, (int)poolInfo.hits, (int)poolInfo.misses);
+		SCPI_ResultText(context, buffer);
 	}
 }
 #endif
@@ -244,16 +518,130 @@ void getAllocInfo(uint32_t &free, uint32_t &alloc) {
 	free = 0;
 	alloc = 0;
 	if (EEZ_MUTEX_WAIT(alloc, osWaitForever)) {
-		AllocBlock *first = (AllocBlock *)g_heap;
-		AllocBlock *block = first;
-		while (block) {
-			if (block->free) {
-				free += block->size;
-			} else {
-				alloc += block->size;
+		free = (uint32_t)g_freeSize;
+		alloc = (uint32_t)g_allocSize;
+		EEZ_MUTEX_RELEASE(alloc);
+	}
+}
+
+void getAllocInfo(AllocInfo &info) {
+	memset(&info, 0, sizeof(info));
+	if (EEZ_MUTEX_WAIT(alloc, osWaitForever)) {
+		info.free = (uint32_t)g_freeSize;
+		info.alloc = (uint32_t)g_allocSize;
+		info.peakAlloc = (uint32_t)g_peakAllocSize;
+		info.largestFreeBlock = (uint32_t)getLargestFreeBlockSize();
+		info.numFreeBlocks = g_numFreeBlocks;
+		info.numAllocBlocks = g_numAllocBlocks;
+		info.numFailedAllocs = g_numFailedAllocs;
+		EEZ_MUTEX_RELEASE(alloc);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Object pools
+//
+// Fixed size free lists for the small objects flow engine creates and destroys
+// all the time (refs, strings, component execution states). Pool memory is
+// taken from the heap once and never returned. Objects bigger than the largest
+// pool, or allocated while the pool is empty, go to the heap.
+
+static const size_t OBJECT_POOL_OBJECT_SIZES[NUM_OBJECT_POOLS] = { 32, 64, 128, 256 };
+
+struct ObjectPool {
+	uint8_t *begin;
+	uint8_t *end;
+	void *firstFree;
+	ObjectPoolInfo info;
+};
+
+static ObjectPool g_objectPools[NUM_OBJECT_POOLS];
+
+void initObjectPools(uint32_t capacity) {
+	for (int i = 0; i < NUM_OBJECT_POOLS; i++) {
+		ObjectPool &pool = g_objectPools[i];
+		if (pool.begin) {
+			continue;
+		}
+
+		size_t objectSize = OBJECT_POOL_OBJECT_SIZES[i];
+		uint8_t *buffer = (uint8_t *)alloc(objectSize * capacity, 0x9b1e4c70);
+		if (!buffer) {
+			continue;
+		}
+
+		for (uint32_t j = 0; j < capacity; j++) {
+			*(void **)(buffer + j * objectSize) = j + 1 < capacity ? buffer + (j + 1) * objectSize : nullptr;
+		}
+
+		if (EEZ_MUTEX_WAIT(alloc, osWaitForever)) {
+			pool.firstFree = buffer;
+			pool.end = buffer + objectSize * capacity;
+			pool.begin = buffer;
+			pool.info.objectSize = objectSize;
+			pool.info.capacity = capacity;
+			EEZ_MUTEX_RELEASE(alloc);
+		}
+	}
+}
+
+void *poolAlloc(size_t size, uint32_t id) {
+	for (int i = 0; i < NUM_OBJECT_POOLS; i++) {
+		if (size <= OBJECT_POOL_OBJECT_SIZES[i]) {
+			ObjectPool &pool = g_objectPools[i];
+			if (pool.begin && EEZ_MUTEX_WAIT(alloc, osWaitForever)) {
+				void *ptr = pool.firstFree;
+				if (ptr) {
+					pool.firstFree = *(void **)ptr;
+					pool.info.hits++;
+					if (++pool.info.inUse > pool.info.highWater) {
+						pool.info.highWater = pool.info.inUse;
+					}
+				} else {
+					pool.info.misses++;
+				}
+				EEZ_MUTEX_RELEASE(alloc);
+
+				if (ptr) {
+					return ptr;
+				}
 			}
-			block = block->next;
+			break;
 		}
+	}
+
+	return alloc(size, id);
+}
+
+void poolFree(void *ptr) {
+	if (ptr == 0) {
+		return;
+	}
+
+	for (int i = 0; i < NUM_OBJECT_POOLS; i++) {
+		ObjectPool &pool = g_objectPools[i];
+		if ((uint8_t *)ptr >= pool.begin && (uint8_t *)ptr < pool.end) {
+#if EEZ_OPTION_ALLOC_POISON
+			memset(ptr, 0xCC, pool.info.objectSize);
+#endif
+			if (EEZ_MUTEX_WAIT(alloc, osWaitForever)) {
+				*(void **)ptr = pool.firstFree;
+				pool.firstFree = ptr;
+				pool.info.inUse--;
+				EEZ_MUTEX_RELEASE(alloc);
+			}
+			return;
+		}
+	}
+
+	free(ptr);
+}
+
+void getObjectPoolInfo(int poolIndex, ObjectPoolInfo &info) {
+	memset(&info, 0, sizeof(info));
+	if (EEZ_MUTEX_WAIT(alloc, osWaitForever)) {
+		info = g_objectPools[poolIndex].info;
+		info.objectSize = OBJECT_POOL_OBJECT_SIZES[poolIndex];
 		EEZ_MUTEX_RELEASE(alloc);
 	}
 }
@@ -33,21 +33,53 @@ void initAllocHeap(uint8_t *heap, size_t heapSize);
 void *alloc(size_t size, uint32_t id);
 void free(void *ptr);
 
+// Small objects are served from fixed size pools when possible,
+// must be freed with poolFree.
+void *poolAlloc(size_t size, uint32_t id);
+void poolFree(void *ptr);
+
 template<class T> struct ObjectAllocator {
 	static T *allocate(uint32_t id) {
-		auto ptr = alloc(sizeof(T), id);
+		auto ptr = poolAlloc(sizeof(T), id);
 		return new (ptr) T;
 	}
 	static void deallocate(T* ptr) {
 		ptr->~T();
-		free(ptr);
+		poolFree(ptr);
 	}
 };
 
+static const int NUM_OBJECT_POOLS = 4;
+
+struct ObjectPoolInfo {
+	uint32_t objectSize;
+	uint32_t capacity;
+	uint32_t inUse;
+	uint32_t highWater;
+	uint32_t hits;
+	uint32_t misses;
+};
+
+// Pools are created once with the given number of objects per pool, later calls are ignored.
+void initObjectPools(uint32_t capacity);
+void getObjectPoolInfo(int poolIndex, ObjectPoolInfo &info);
+
 #if OPTION_SCPI
 void dumpAlloc(scpi_t *context);
 #endif
 
 void getAllocInfo(uint32_t &free, uint32_t &alloc);
 
+struct AllocInfo {
+	uint32_t free;
+	uint32_t alloc;
+	uint32_t peakAlloc;
+	uint32_t largestFreeBlock;
+	uint32_t numFreeBlocks;
+	uint32_t numAllocBlocks;
+	uint32_t numFailedAllocs;
+};
+
+void getAllocInfo(AllocInfo &info);
+
 } // eez
\ No newline at end of file
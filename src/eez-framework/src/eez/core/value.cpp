@@ -1199,7 +1199,7 @@ Value Value::makeStringRef(const char *str, int len, uint32_t id) {
 		len = strlen(str);
 	}
 
-    stringRef->str = (char *)alloc(len + 1, id + 1);
+    stringRef->str = (char *)poolAlloc(len + 1, id + 1);
     if (stringRef->str == nullptr) {
         ObjectAllocator<StringRef>::deallocate(stringRef);
         return Value(0, VALUE_TYPE_NULL);
@@ -1228,7 +1228,7 @@ Value Value::concatenateString(const Value &str1, const Value &str2) {
 	}
 
     auto newStrLen = strlen(str1.getString()) + strlen(str2.getString()) + 1;
-    stringRef->str = (char *)alloc(newStrLen, 0xb5320162);
+    stringRef->str = (char *)poolAlloc(newStrLen, 0xb5320162);
     if (stringRef->str == nullptr) {
         ObjectAllocator<StringRef>::deallocate(stringRef);
         return Value(0, VALUE_TYPE_NULL);
@@ -1251,7 +1251,7 @@ Value Value::concatenateString(const Value &str1, const Value &str2) {
 }
 
 Value Value::makeArrayRef(int arraySize, int arrayType, uint32_t id) {
-    auto ptr = alloc(sizeof(ArrayValueRef) + (arraySize > 0 ? arraySize - 1 : 0) * sizeof(Value), id);
+    auto ptr = poolAlloc(sizeof(ArrayValueRef) + (arraySize > 0 ? arraySize - 1 : 0) * sizeof(Value), id);
 	if (ptr == nullptr) {
 		return Value(0, VALUE_TYPE_NULL);
 	}
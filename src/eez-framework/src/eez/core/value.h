@@ -540,7 +540,7 @@ struct Value {
 struct StringRef : public Ref {
     ~StringRef() {
         if (str) {
-            eez::free(str);
+            eez::poolFree(str);
         }
     }
 	char *str;
@@ -59,7 +59,9 @@ enum MessagesToDebugger {
 	MESSAGE_TO_DEBUGGER_PAGE_CHANGED, // PAGE_ID
 
     MESSAGE_TO_DEBUGGER_COMPONENT_EXECUTION_STATE_CHANGED, // FLOW_STATE_INDEX, COMPONENT_INDEX, STATE
-    MESSAGE_TO_DEBUGGER_COMPONENT_ASYNC_STATE_CHANGED // FLOW_STATE_INDEX, COMPONENT_INDEX, STATE
+    MESSAGE_TO_DEBUGGER_COMPONENT_ASYNC_STATE_CHANGED, // FLOW_STATE_INDEX, COMPONENT_INDEX, STATE
+
+    MESSAGE_TO_DEBUGGER_OBJECT_POOL // POOL_INDEX, OBJECT_SIZE, CAPACITY, IN_USE, HIGH_WATER, HITS, MISSES
 };
 
 enum MessagesFromDebugger {
@@ -72,7 +74,9 @@ enum MessagesFromDebugger {
     MESSAGE_FROM_DEBUGGER_ENABLE_BREAKPOINT, // FLOW_INDEX, COMPONENT_INDEX
     MESSAGE_FROM_DEBUGGER_DISABLE_BREAKPOINT, // FLOW_INDEX, COMPONENT_INDEX
 
-    MESSAGE_FROM_DEBUGGER_MODE // MODE (0:RUN | 1:DEBUG)
+    MESSAGE_FROM_DEBUGGER_MODE, // MODE (0:RUN | 1:DEBUG)
+
+    MESSAGE_FROM_DEBUGGER_GET_OBJECT_POOLS // no params
 };
 
 enum LogItemType {
@@ -91,6 +95,8 @@ enum DebuggerState {
     DEBUGGER_STATE_STOPPED,
 };
 
+static void sendObjectPools();
+
 bool g_debuggerIsConnected;
 static uint32_t g_messageSubsciptionFilter = 0xFFFFFFFF;
 
@@ -190,6 +196,8 @@ void processDebuggerInput(char *buffer, uint32_t length) {
 #if EEZ_OPTION_GUI
                 gui::refreshScreen();
 #endif
+            } else if (messageFromDebugger == MESSAGE_FROM_DEBUGGER_GET_OBJECT_POOLS) {
+                sendObjectPools();
             }
 
 			g_inputFromDebuggerPosition = 0;
@@ -472,6 +480,28 @@ void onStarted(Assets *assets) {
     }
 }
 
+static void sendObjectPools() {
+    if (isSubscribedTo(MESSAGE_TO_DEBUGGER_OBJECT_POOL)) {
+        for (int i = 0; i < NUM_OBJECT_POOLS; i++) {
+            ObjectPoolInfo info;
+            getObjectPoolInfo(i, info);
+
+            char buffer[256];
+            snprintf(buffer, sizeof(buffer), "%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\n",
+                MESSAGE_TO_DEBUGGER_OBJECT_POOL,
+                i,
+                (int)info.objectSize,
+                (int)info.capacity,
+                (int)info.inUse,
+                (int)info.highWater,
+                (int)info.hits,
+                (int)info.misses
+            );
+            writeDebuggerBufferHook(buffer, strlen(buffer));
+        }
+    }
+}
+
 void onStopped() {
     setDebuggerState(DEBUGGER_STATE_STOPPED);
 }
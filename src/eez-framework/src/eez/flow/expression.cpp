@@ -20,8 +20,11 @@
 
 #include <stdio.h>
 
+#include <eez/core/alloc.h>
+
 #include <eez/flow/private.h>
 #include <eez/flow/operations.h>
+#include <eez/flow/flow_defs_v3.h>
 
 #if EEZ_OPTION_GUI
 #include <eez/gui/gui.h>
@@ -33,6 +36,287 @@ namespace flow {
 
 EvalStack g_stack;
 
+#if EEZ_OPTION_FLOW_EXPRESSION_CACHE
+
+// Properties which use only constants, global variables and side effect free
+// operations are evaluated once and the result is reused until one of the
+// global variables they depend on is changed. Dependencies are tracked per
+// bucket (global variable index modulo NUM_VARIABLE_BUCKETS) and each bucket
+// has a version which is incremented when any of its variables is changed.
+
+static const uint32_t NUM_VARIABLE_BUCKETS = 32;
+static const uint16_t NOT_CACHED = 0xFFFF;
+
+struct ExpressionCacheEntry {
+	Value value;
+	uint32_t dependencies;
+	uint32_t version;
+	uint16_t numInstructionBytes;
+	bool valid;
+};
+
+static Assets *g_expressionCacheAssets;
+// for each flow: first property slot of each component followed by the cache entry index of each property
+static uint16_t **g_expressionCacheTables;
+static ExpressionCacheEntry *g_expressionCacheEntries;
+static uint32_t g_numExpressionCacheEntries;
+
+static uint32_t g_variableVersions[NUM_VARIABLE_BUCKETS];
+static Value *g_firstGlobalVariable;
+static bool g_globalVariablesAreContiguous;
+
+static bool isCacheableOperation(uint16_t operation) {
+	if (operation <= defs_v3::OPERATION_TYPE_CONDITIONAL) {
+		return true;
+	}
+
+	switch (operation) {
+	case defs_v3::OPERATION_TYPE_FLOW_PARSE_INTEGER:
+	case defs_v3::OPERATION_TYPE_FLOW_PARSE_FLOAT:
+	case defs_v3::OPERATION_TYPE_FLOW_PARSE_DOUBLE:
+	case defs_v3::OPERATION_TYPE_FLOW_TO_INTEGER:
+	case defs_v3::OPERATION_TYPE_FLOW_GET_BITMAP_INDEX:
+	case defs_v3::OPERATION_TYPE_CRYPTO_SHA256:
+	case defs_v3::OPERATION_TYPE_MATH_SIN:
+	case defs_v3::OPERATION_TYPE_MATH_COS:
+	case defs_v3::OPERATION_TYPE_MATH_POW:
+	case defs_v3::OPERATION_TYPE_MATH_LOG:
+	case defs_v3::OPERATION_TYPE_MATH_LOG10:
+	case defs_v3::OPERATION_TYPE_MATH_ABS:
+	case defs_v3::OPERATION_TYPE_MATH_FLOOR:
+	case defs_v3::OPERATION_TYPE_MATH_CEIL:
+	case defs_v3::OPERATION_TYPE_MATH_ROUND:
+	case defs_v3::OPERATION_TYPE_MATH_MIN:
+	case defs_v3::OPERATION_TYPE_MATH_MAX:
+	case defs_v3::OPERATION_TYPE_STRING_LENGTH:
+	case defs_v3::OPERATION_TYPE_STRING_SUBSTRING:
+	case defs_v3::OPERATION_TYPE_STRING_FIND:
+	case defs_v3::OPERATION_TYPE_STRING_PAD_START:
+	case defs_v3::OPERATION_TYPE_STRING_FROM_CODE_POINT:
+	case defs_v3::OPERATION_TYPE_STRING_CODE_POINT_AT:
+	case defs_v3::OPERATION_TYPE_ARRAY_LENGTH:
+		return true;
+	}
+
+	// depends on time, iterators, flow state or language, or makes a new array
+	return false;
+}
+
+static bool analyzeExpression(FlowDefinition *flowDefinition, const uint8_t *instructions, uint32_t &dependencies, uint16_t &numInstructionBytes) {
+	dependencies = 0;
+
+	int i = 0;
+	while (true) {
+		uint16_t instruction = instructions[i] + (instructions[i + 1] << 8);
+		auto instructionType = instruction & EXPR_EVAL_INSTRUCTION_TYPE_MASK;
+		auto instructionArg = instruction & EXPR_EVAL_INSTRUCTION_PARAM_MASK;
+		i += 2;
+
+		if (instructionType == EXPR_EVAL_INSTRUCTION_TYPE_PUSH_CONSTANT || instructionType == EXPR_EVAL_INSTRUCTION_ARRAY_ELEMENT) {
+			continue;
+		} else if (instructionType == EXPR_EVAL_INSTRUCTION_TYPE_PUSH_GLOBAL_VAR) {
+			if ((uint32_t)instructionArg >= flowDefinition->globalVariables.count) {
+				// native variable
+				return false;
+			}
+			dependencies |= 1 << (instructionArg % NUM_VARIABLE_BUCKETS);
+		} else if (instructionType == EXPR_EVAL_INSTRUCTION_TYPE_OPERATION) {
+			if (!isCacheableOperation(instructionArg)) {
+				return false;
+			}
+		} else if (instructionType == EXPR_EVAL_INSTRUCTION_TYPE_END) {
+			break;
+		} else {
+			// component input, local variable or output
+			return false;
+		}
+	}
+
+	numInstructionBytes = (uint16_t)i;
+	return true;
+}
+
+static uint32_t getVariablesVersion(uint32_t dependencies) {
+	uint32_t version = 0;
+	for (uint32_t i = 0; dependencies; i++, dependencies >>= 1) {
+		if (dependencies & 1) {
+			version += g_variableVersions[i];
+		}
+	}
+	return version;
+}
+
+void initExpressionCache(Assets *assets) {
+	resetExpressionCache();
+
+	auto flowDefinition = static_cast<FlowDefinition *>(assets->flowDefinition);
+
+	uint32_t numEntries = 0;
+	for (uint32_t flowIndex = 0; flowIndex < flowDefinition->flows.count; flowIndex++) {
+		auto flow = flowDefinition->flows[flowIndex];
+		for (uint32_t componentIndex = 0; componentIndex < flow->components.count; componentIndex++) {
+			auto component = flow->components[componentIndex];
+			for (uint32_t propertyIndex = 0; propertyIndex < component->properties.count; propertyIndex++) {
+				uint32_t dependencies;
+				uint16_t numInstructionBytes;
+				if (analyzeExpression(flowDefinition, component->properties[propertyIndex]->evalInstructions, dependencies, numInstructionBytes)) {
+					numEntries++;
+				}
+			}
+		}
+	}
+
+	if (numEntries == 0 || numEntries >= NOT_CACHED) {
+		return;
+	}
+
+	g_expressionCacheTables = (uint16_t **)alloc(flowDefinition->flows.count * sizeof(uint16_t *), 0x1f7c2e95);
+	g_expressionCacheEntries = (ExpressionCacheEntry *)alloc(numEntries * sizeof(ExpressionCacheEntry), 0x6a0d53c1);
+	if (!g_expressionCacheTables || !g_expressionCacheEntries) {
+		free(g_expressionCacheTables);
+		free(g_expressionCacheEntries);
+		g_expressionCacheTables = nullptr;
+		g_expressionCacheEntries = nullptr;
+		return;
+	}
+
+	g_expressionCacheAssets = assets;
+
+	for (uint32_t flowIndex = 0; flowIndex < flowDefinition->flows.count; flowIndex++) {
+		auto flow = flowDefinition->flows[flowIndex];
+
+		uint32_t tableSize = flow->components.count;
+		for (uint32_t componentIndex = 0; componentIndex < flow->components.count; componentIndex++) {
+			tableSize += flow->components[componentIndex]->properties.count;
+		}
+
+		auto table = (uint16_t *)alloc(tableSize * sizeof(uint16_t), 0x3b95e0d7);
+		g_expressionCacheTables[flowIndex] = table;
+		if (!table) {
+			continue;
+		}
+
+		uint32_t slot = flow->components.count;
+		for (uint32_t componentIndex = 0; componentIndex < flow->components.count; componentIndex++) {
+			auto component = flow->components[componentIndex];
+			table[componentIndex] = (uint16_t)slot;
+			for (uint32_t propertyIndex = 0; propertyIndex < component->properties.count; propertyIndex++, slot++) {
+				uint32_t dependencies;
+				uint16_t numInstructionBytes;
+				if (analyzeExpression(flowDefinition, component->properties[propertyIndex]->evalInstructions, dependencies, numInstructionBytes)) {
+					auto entry = new (g_expressionCacheEntries + g_numExpressionCacheEntries) ExpressionCacheEntry();
+					entry->dependencies = dependencies;
+					entry->version = 0;
+					entry->numInstructionBytes = numInstructionBytes;
+					entry->valid = false;
+					table[slot] = (uint16_t)g_numExpressionCacheEntries++;
+				} else {
+					table[slot] = NOT_CACHED;
+				}
+			}
+		}
+	}
+
+	auto &globalVariables = flowDefinition->globalVariables;
+	g_firstGlobalVariable = globalVariables.count > 0 ? globalVariables[0] : nullptr;
+	g_globalVariablesAreContiguous = true;
+	for (uint32_t i = 1; i < globalVariables.count; i++) {
+		if (globalVariables[i] != g_firstGlobalVariable + i) {
+			g_globalVariablesAreContiguous = false;
+			break;
+		}
+	}
+}
+
+void resetExpressionCache() {
+	if (g_expressionCacheAssets) {
+		auto flowDefinition = static_cast<FlowDefinition *>(g_expressionCacheAssets->flowDefinition);
+		for (uint32_t flowIndex = 0; flowIndex < flowDefinition->flows.count; flowIndex++) {
+			free(g_expressionCacheTables[flowIndex]);
+		}
+		free(g_expressionCacheTables);
+
+		for (uint32_t i = 0; i < g_numExpressionCacheEntries; i++) {
+			g_expressionCacheEntries[i].~ExpressionCacheEntry();
+		}
+		free(g_expressionCacheEntries);
+	}
+
+	g_expressionCacheAssets = nullptr;
+	g_expressionCacheTables = nullptr;
+	g_expressionCacheEntries = nullptr;
+	g_numExpressionCacheEntries = 0;
+	g_firstGlobalVariable = nullptr;
+}
+
+void invalidateExpressionCache() {
+	for (uint32_t i = 0; i < NUM_VARIABLE_BUCKETS; i++) {
+		g_variableVersions[i]++;
+	}
+}
+
+void invalidateExpressionCache(const Value *pValue) {
+	if (!g_expressionCacheAssets) {
+		return;
+	}
+
+	auto &globalVariables = static_cast<FlowDefinition *>(g_expressionCacheAssets->flowDefinition)->globalVariables;
+
+	if (g_globalVariablesAreContiguous) {
+		if (pValue >= g_firstGlobalVariable && pValue < g_firstGlobalVariable + globalVariables.count) {
+			g_variableVersions[(pValue - g_firstGlobalVariable) % NUM_VARIABLE_BUCKETS]++;
+		}
+		return;
+	}
+
+	for (uint32_t i = 0; i < globalVariables.count; i++) {
+		if (globalVariables[i] == pValue) {
+			g_variableVersions[i % NUM_VARIABLE_BUCKETS]++;
+			return;
+		}
+	}
+}
+
+static ExpressionCacheEntry *getExpressionCacheEntry(FlowState *flowState, int componentIndex, int propertyIndex) {
+	if (flowState->assets != g_expressionCacheAssets) {
+		return nullptr;
+	}
+
+	auto table = g_expressionCacheTables[flowState->flowIndex];
+	if (!table) {
+		return nullptr;
+	}
+
+	auto entryIndex = table[table[componentIndex] + propertyIndex];
+	if (entryIndex == NOT_CACHED) {
+		return nullptr;
+	}
+
+	return g_expressionCacheEntries + entryIndex;
+}
+
+static bool evalCachedProperty(ExpressionCacheEntry *entry, FlowState *flowState, int componentIndex, const uint8_t *instructions, Value &result, const char *errorMessage, int *numInstructionBytes) {
+	auto version = getVariablesVersion(entry->dependencies);
+	if (!entry->valid || entry->version != version) {
+		if (!evalExpression(flowState, componentIndex, instructions, result, errorMessage)) {
+			return false;
+		}
+		entry->value = result;
+		entry->version = version;
+		entry->valid = true;
+	} else {
+		result = entry->value;
+	}
+
+	if (numInstructionBytes) {
+		*numInstructionBytes = entry->numInstructionBytes;
+	}
+
+	return true;
+}
+
+#endif // EEZ_OPTION_FLOW_EXPRESSION_CACHE
+
 static void evalExpression(FlowState *flowState, const uint8_t *instructions, int *numInstructionBytes, const char *errorMessage) {
 	auto flowDefinition = flowState->flowDefinition;
 	auto flow = flowState->flow;
@@ -207,6 +491,18 @@ bool evalProperty(FlowState *flowState, int componentIndex, int propertyIndex, V
         throwError(flowState, componentIndex, errorMessage, message);
         return false;
     }
+#if EEZ_OPTION_FLOW_EXPRESSION_CACHE
+#if EEZ_OPTION_GUI
+    if (operation == DATA_OPERATION_GET) {
+#endif
+        auto entry = getExpressionCacheEntry(flowState, componentIndex, propertyIndex);
+        if (entry) {
+            return evalCachedProperty(entry, flowState, componentIndex, component->properties[propertyIndex]->evalInstructions, result, errorMessage, numInstructionBytes);
+        }
+#if EEZ_OPTION_GUI
+    }
+#endif
+#endif
 #if EEZ_OPTION_GUI
     return evalExpression(flowState, componentIndex, component->properties[propertyIndex]->evalInstructions, result, errorMessage, numInstructionBytes, iterators, operation);
 #else
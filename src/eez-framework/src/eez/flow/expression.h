@@ -79,5 +79,19 @@ bool evalProperty(FlowState *flowState, int componentIndex, int propertyIndex, V
 #endif
 bool evalAssignableProperty(FlowState *flowState, int componentIndex, int propertyIndex, Value &result, const char *errorMessage, int *numInstructionBytes = nullptr, const int32_t *iterators = nullptr);
 
+#if EEZ_OPTION_FLOW_EXPRESSION_CACHE
+void initExpressionCache(Assets *assets);
+void resetExpressionCache();
+// invalidate all cached results, used when array element is modified in place
+void invalidateExpressionCache();
+// invalidate cached results depending on this value if it is a global variable
+void invalidateExpressionCache(const Value *pValue);
+#else
+inline void initExpressionCache(Assets *) {}
+inline void resetExpressionCache() {}
+inline void invalidateExpressionCache() {}
+inline void invalidateExpressionCache(const Value *) {}
+#endif
+
 } // flow
 } // eez
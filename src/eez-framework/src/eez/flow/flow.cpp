@@ -27,6 +27,7 @@
 #include <eez/flow/flow.h>
 #include <eez/flow/components.h>
 #include <eez/flow/queue.h>
+#include <eez/flow/expression.h>
 #include <eez/flow/flow_defs_v3.h>
 #include <eez/flow/debugger.h>
 #include <eez/flow/hooks.h>
@@ -53,6 +54,10 @@ uint32_t g_wasmModuleId = 0;
 
 static const uint32_t FLOW_TICK_MAX_DURATION_MS = 5;
 
+// number of objects per object pool, relative to the number of components in all flows
+static const uint32_t OBJECT_POOL_CAPACITY_MIN = 16;
+static const uint32_t OBJECT_POOL_CAPACITY_MAX = 128;
+
 int g_selectedLanguage = 0;
 FlowState *g_firstFlowState;
 FlowState *g_lastFlowState;
@@ -73,6 +78,14 @@ unsigned start(Assets *assets) {
     g_isStopped = false;
     g_isStopping = false;
 
+    uint32_t numComponents = 0;
+    for (uint32_t i = 0; i < flowDefinition->flows.count; i++) {
+        numComponents += flowDefinition->flows[i]->components.count;
+    }
+    initObjectPools(MIN(MAX(numComponents, OBJECT_POOL_CAPACITY_MIN), OBJECT_POOL_CAPACITY_MAX));
+
+    initExpressionCache(assets);
+
 	queueReset();
 
 	scpiComponentInitHook();
@@ -96,7 +109,7 @@ void tick() {
 
     auto n = getQueueSize();
 
-    for (size_t i = 0; i < n || g_numContinuousTaskInQueue > 0; i++) {
+    for (size_t i = 0; i < n || g_numNonContinuousTasksInQueue > 0; i++) {
 		FlowState *flowState;
 		unsigned componentIndex;
         bool continuousTask;
@@ -140,10 +153,8 @@ void tick() {
             freeFlowState(flowState);
         }
 
-        if ((i + 1) % 5 == 0) {
-            if (millis() - startTickCount >= FLOW_TICK_MAX_DURATION_MS) {
-                break;
-            }
+        if (millis() - startTickCount >= FLOW_TICK_MAX_DURATION_MS) {
+            break;
         }
 	}
 
@@ -166,6 +177,8 @@ void doStop() {
     g_isStopped = true;
 
 	queueReset();
+
+    resetExpressionCache();
 }
 
 bool isFlowStopped() {
@@ -261,6 +274,7 @@ void setGlobalVariable(uint32_t globalVariableIndex, const Value &value) {
 void setGlobalVariable(Assets *assets, uint32_t globalVariableIndex, const Value &value) {
     if (globalVariableIndex >= 0 && globalVariableIndex < assets->flowDefinition->globalVariables.count) {
         *assets->flowDefinition->globalVariables[globalVariableIndex] = value;
+        invalidateExpressionCache(assets->flowDefinition->globalVariables[globalVariableIndex]);
     }
 }
 
@@ -458,6 +472,7 @@ void dataOperation(int16_t dataId, DataOperationEnum operation, const WidgetCurs
                         newPosition = numItems - itemsPerPage;
                     }
                     array->values[defs_v3::SYSTEM_STRUCTURE_SCROLLBAR_STATE_FIELD_POSITION] = newPosition;
+                    invalidateExpressionCache();
                     onValueChanged(&array->values[defs_v3::SYSTEM_STRUCTURE_SCROLLBAR_STATE_FIELD_POSITION]);
                 } else {
                     value = 0;
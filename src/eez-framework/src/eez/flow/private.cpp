@@ -31,6 +31,7 @@ using namespace eez::gui;
 #include <eez/flow/flow.h>
 #include <eez/flow/operations.h>
 #include <eez/flow/queue.h>
+#include <eez/flow/expression.h>
 #include <eez/flow/debugger.h>
 #include <eez/flow/flow_defs_v3.h>
 #include <eez/flow/hooks.h>
@@ -123,6 +124,7 @@ static FlowState *initFlowState(Assets *assets, int flowIndex, FlowState *parent
 		sizeof(FlowState) +
         nValues * sizeof(Value) +
         flow->components.count * sizeof(ComponenentExecutionState *) +
+        flow->components.count * sizeof(uint16_t) +
         flow->components.count * sizeof(bool),
 		0x4c3b6ef5
 	);
@@ -178,7 +180,10 @@ static FlowState *initFlowState(Assets *assets, int flowIndex, FlowState *parent
 
 	flowState->values = (Value *)(flowState + 1);
 	flowState->componenentExecutionStates = (ComponenentExecutionState **)(flowState->values + nValues);
-    flowState->componenentAsyncStates = (bool *)(flowState->componenentExecutionStates + flow->components.count);
+    flowState->numQueuedComponentTasks = (uint16_t *)(flowState->componenentExecutionStates + flow->components.count);
+    flowState->componenentAsyncStates = (bool *)(flowState->numQueuedComponentTasks + flow->components.count);
+    flowState->numQueuedTasks = 0;
+    flowState->numQueuedWatchVariableTasks = 0;
 
 	for (unsigned i = 0; i < nValues; i++) {
 		new (flowState->values + i) Value();
@@ -197,6 +202,7 @@ static FlowState *initFlowState(Assets *assets, int flowIndex, FlowState *parent
 	for (unsigned i = 0; i < flow->components.count; i++) {
 		flowState->componenentExecutionStates[i] = nullptr;
 		flowState->componenentAsyncStates[i] = false;
+		flowState->numQueuedComponentTasks[i] = 0;
 	}
 
 	onFlowStateCreated(flowState);
@@ -306,6 +312,10 @@ void freeFlowState(FlowState *flowState) {
 
     freeAllChildrenFlowStates(flowState->firstChild);
 
+    if (flowState->numQueuedTasks > 0) {
+        removeTasksFromQueue(flowState);
+    }
+
 	onFlowStateDestroyed(flowState);
 
 	free(flowState);
@@ -466,6 +476,7 @@ void assignValue(FlowState *flowState, int componentIndex, Value &dstValue, cons
                     throwError(flowState, componentIndex, errorMessage);
                 } else {
                     blobRef->blob[arrayElementValue->elementIndex] = elementValue;
+                    invalidateExpressionCache();
                     // TODO: onValueChanged
                 }
                 return;
@@ -482,6 +493,11 @@ void assignValue(FlowState *flowState, int componentIndex, Value &dstValue, cons
         }
 
         if (assignValue(*pDstValue, srcValue)) {
+            if (dstValue.getType() == VALUE_TYPE_ARRAY_ELEMENT_VALUE) {
+                invalidateExpressionCache();
+            } else {
+                invalidateExpressionCache(pDstValue);
+            }
             onValueChanged(pDstValue);
         } else {
             char errorMessage[100];
@@ -58,6 +58,9 @@ struct FlowState {
 	Value *values;
 	ComponenentExecutionState **componenentExecutionStates;
     bool *componenentAsyncStates;
+    uint16_t *numQueuedComponentTasks;
+    uint32_t numQueuedTasks;
+    uint32_t numQueuedWatchVariableTasks;
     unsigned executingComponentIndex;
     float timelinePosition;
 #if defined(EEZ_FOR_LVGL)
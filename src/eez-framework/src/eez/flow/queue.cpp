@@ -18,6 +18,9 @@
 
 #include <eez/conf-internal.h>
 
+#include <eez/core/alloc.h>
+#include <eez/core/util.h>
+
 #include <eez/flow/queue.h>
 #include <eez/flow/debugger.h>
 #include <eez/flow/flow_defs_v3.h>
@@ -25,128 +28,250 @@
 namespace eez {
 namespace flow {
 
-static const unsigned QUEUE_SIZE = 1000;
-static struct {
+// One-shot tasks (data flow) and continuous tasks (watch variables, delays,
+// animations, widgets polling for a result, ...) are kept in separate lanes,
+// so a large number of continuous tasks can't delay data flow work and
+// vice versa. Each lane is a ring buffer that starts in a static buffer and,
+// if EEZ_OPTION_FLOW_QUEUE_SPILL is enabled, spills into a larger ring
+// allocated from the heap when the static buffer becomes full.
+
+struct QueueTask {
 	FlowState *flowState;
 	unsigned componentIndex;
-    bool continuousTask;
-} g_queue[QUEUE_SIZE];
-static unsigned g_queueHead;
-static unsigned g_queueTail;
-static bool g_queueIsFull = false;
-unsigned g_numContinuousTaskInQueue;
+};
 
-void queueReset() {
-	g_queueHead = 0;
-	g_queueTail = 0;
-	g_queueIsFull = false;
-    g_numContinuousTaskInQueue = 0;
-}
+struct QueueLane {
+	QueueTask *tasks;
+	unsigned capacity;
+	unsigned head;
+	unsigned size;
 
-size_t getQueueSize() {
-	if (g_queueHead == g_queueTail) {
-		if (g_queueIsFull) {
-			return QUEUE_SIZE;
-		}
-		return 0;
-	}
+	QueueTask *staticTasks;
+	unsigned staticCapacity;
+	unsigned maxCapacity;
+};
+
+static const unsigned ONE_SHOT_QUEUE_SIZE = 768;
+static const unsigned CONTINUOUS_QUEUE_SIZE = 256;
+
+#if EEZ_OPTION_FLOW_QUEUE_SPILL
+static const unsigned QUEUE_SPILL_FACTOR = 8;
+#else
+static const unsigned QUEUE_SPILL_FACTOR = 1;
+#endif
 
-	if (g_queueHead < g_queueTail) {
-		return g_queueTail - g_queueHead;
+// when both lanes are not empty, one continuous task is executed after this many one-shot tasks
+static const unsigned ONE_SHOT_TASKS_PER_CONTINUOUS_TASK = 8;
+
+static QueueTask g_oneShotTasks[ONE_SHOT_QUEUE_SIZE];
+static QueueTask g_continuousTasks[CONTINUOUS_QUEUE_SIZE];
+
+static QueueLane g_oneShotLane = {
+	g_oneShotTasks, ONE_SHOT_QUEUE_SIZE, 0, 0,
+	g_oneShotTasks, ONE_SHOT_QUEUE_SIZE, QUEUE_SPILL_FACTOR * ONE_SHOT_QUEUE_SIZE
+};
+
+static QueueLane g_continuousLane = {
+	g_continuousTasks, CONTINUOUS_QUEUE_SIZE, 0, 0,
+	g_continuousTasks, CONTINUOUS_QUEUE_SIZE, QUEUE_SPILL_FACTOR * CONTINUOUS_QUEUE_SIZE
+};
+
+static unsigned g_numOneShotTasksSinceContinuousTask;
+
+unsigned g_numNonContinuousTasksInQueue;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void laneReleaseSpill(QueueLane &lane) {
+	if (lane.tasks != lane.staticTasks) {
+		free(lane.tasks);
+		lane.tasks = lane.staticTasks;
+		lane.capacity = lane.staticCapacity;
+		lane.head = 0;
 	}
+}
 
-	return QUEUE_SIZE - g_queueHead + g_queueTail;
+static void laneReset(QueueLane &lane) {
+	laneReleaseSpill(lane);
+	lane.head = 0;
+	lane.size = 0;
 }
 
-bool addToQueue(FlowState *flowState, unsigned componentIndex, int sourceComponentIndex, int sourceOutputIndex, int targetInputIndex, bool continuousTask) {
-	if (g_queueIsFull) {
-        throwError(flowState, componentIndex, "Execution queue is full\n");
+static bool laneGrow(QueueLane &lane) {
+	if (lane.capacity >= lane.maxCapacity) {
 		return false;
 	}
 
-	g_queue[g_queueTail].flowState = flowState;
-	g_queue[g_queueTail].componentIndex = componentIndex;
-    g_queue[g_queueTail].continuousTask = continuousTask;
+	auto capacity = MIN(2 * lane.capacity, lane.maxCapacity);
+	auto tasks = (QueueTask *)alloc(capacity * sizeof(QueueTask), 0x8f1d6a3b);
+	if (!tasks) {
+		return false;
+	}
 
-	g_queueTail = (g_queueTail + 1) % QUEUE_SIZE;
+	for (unsigned i = 0; i < lane.size; i++) {
+		tasks[i] = lane.tasks[(lane.head + i) % lane.capacity];
+	}
 
-	if (g_queueHead == g_queueTail) {
-		g_queueIsFull = true;
+	if (lane.tasks != lane.staticTasks) {
+		free(lane.tasks);
 	}
 
-    if (!continuousTask) {
-        ++g_numContinuousTaskInQueue;
-	    onAddToQueue(flowState, sourceComponentIndex, sourceOutputIndex, componentIndex, targetInputIndex);
-    }
+	lane.tasks = tasks;
+	lane.capacity = capacity;
+	lane.head = 0;
 
 	return true;
 }
 
-bool peekNextTaskFromQueue(FlowState *&flowState, unsigned &componentIndex, bool &continuousTask) {
-	if (g_queueHead == g_queueTail && !g_queueIsFull) {
+static bool lanePush(QueueLane &lane, FlowState *flowState, unsigned componentIndex) {
+	if (lane.size == lane.capacity && !laneGrow(lane)) {
 		return false;
 	}
 
-	flowState = g_queue[g_queueHead].flowState;
-	componentIndex = g_queue[g_queueHead].componentIndex;
-    continuousTask = g_queue[g_queueHead].continuousTask;
+	auto &task = lane.tasks[(lane.head + lane.size) % lane.capacity];
+	task.flowState = flowState;
+	task.componentIndex = componentIndex;
+	lane.size++;
 
 	return true;
 }
 
-void removeNextTaskFromQueue() {
-    auto continuousTask = g_queue[g_queueHead].continuousTask;
+static void lanePop(QueueLane &lane) {
+	lane.head = (lane.head + 1) % lane.capacity;
+	if (--lane.size == 0) {
+		// go back to the static buffer as soon as the burst is over
+		laneReleaseSpill(lane);
+		lane.head = 0;
+	}
+}
 
-	g_queueHead = (g_queueHead + 1) % QUEUE_SIZE;
-	g_queueIsFull = false;
+static QueueLane *selectLane() {
+	if (g_oneShotLane.size > 0) {
+		if (g_continuousLane.size == 0 || g_numOneShotTasksSinceContinuousTask < ONE_SHOT_TASKS_PER_CONTINUOUS_TASK) {
+			return &g_oneShotLane;
+		}
+	}
 
-    if (!continuousTask) {
-        --g_numContinuousTaskInQueue;
-	    onRemoveFromQueue();
-    }
+	if (g_continuousLane.size > 0) {
+		return &g_continuousLane;
+	}
+
+	return nullptr;
 }
 
-bool isInQueue(FlowState *flowState, unsigned componentIndex) {
-	if (g_queueHead == g_queueTail && !g_queueIsFull) {
+static void markTask(FlowState *flowState, unsigned componentIndex, int delta) {
+	flowState->numQueuedComponentTasks[componentIndex] += delta;
+	flowState->numQueuedTasks += delta;
+	if (flowState->flow->components[componentIndex]->type == defs_v3::COMPONENT_TYPE_WATCH_VARIABLE_ACTION) {
+		flowState->numQueuedWatchVariableTasks += delta;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void queueReset() {
+	laneReset(g_oneShotLane);
+	laneReset(g_continuousLane);
+	g_numOneShotTasksSinceContinuousTask = 0;
+	g_numNonContinuousTasksInQueue = 0;
+}
+
+size_t getQueueSize() {
+	return g_oneShotLane.size + g_continuousLane.size;
+}
+
+bool addToQueue(FlowState *flowState, unsigned componentIndex, int sourceComponentIndex, int sourceOutputIndex, int targetInputIndex, bool continuousTask) {
+	if (!lanePush(continuousTask ? g_continuousLane : g_oneShotLane, flowState, componentIndex)) {
+		throwError(flowState, componentIndex, "Execution queue is full\n");
 		return false;
 	}
 
-    unsigned int it = g_queueHead;
-    while (true) {
-		if (g_queue[it].flowState == flowState && g_queue[it].componentIndex == componentIndex) {
-            return true;
-		}
+	markTask(flowState, componentIndex, 1);
 
-        it = (it + 1) % QUEUE_SIZE;
-        if (it == g_queueTail) {
-            break;
-        }
+	if (!continuousTask) {
+		++g_numNonContinuousTasksInQueue;
+		onAddToQueue(flowState, sourceComponentIndex, sourceOutputIndex, componentIndex, targetInputIndex);
 	}
 
-    return false;
+	return true;
 }
 
-bool isThereAnyTaskInQueueForFlowState(FlowState *flowState, bool includingWatchVariable) {
-	if (g_queueHead == g_queueTail && !g_queueIsFull) {
+bool peekNextTaskFromQueue(FlowState *&flowState, unsigned &componentIndex, bool &continuousTask) {
+	auto lane = selectLane();
+	if (!lane) {
 		return false;
 	}
 
-    unsigned int it = g_queueHead;
-    while (true) {
-		if (g_queue[it].flowState == flowState) {
-            auto component = flowState->flow->components[g_queue[it].componentIndex];
-            if (includingWatchVariable || component->type != defs_v3::COMPONENT_TYPE_WATCH_VARIABLE_ACTION) {
-			    return true;
-            }
+	auto &task = lane->tasks[lane->head];
+	flowState = task.flowState;
+	componentIndex = task.componentIndex;
+	continuousTask = lane == &g_continuousLane;
+
+	return true;
+}
+
+void removeNextTaskFromQueue() {
+	auto lane = selectLane();
+	if (!lane) {
+		return;
+	}
+
+	auto &task = lane->tasks[lane->head];
+	markTask(task.flowState, task.componentIndex, -1);
+
+	lanePop(*lane);
+
+	if (lane == &g_oneShotLane) {
+		++g_numOneShotTasksSinceContinuousTask;
+		--g_numNonContinuousTasksInQueue;
+		onRemoveFromQueue();
+	} else {
+		g_numOneShotTasksSinceContinuousTask = 0;
+	}
+}
+
+// returns number of removed tasks
+static unsigned laneRemoveFlowState(QueueLane &lane, FlowState *flowState) {
+	unsigned j = 0;
+	for (unsigned i = 0; i < lane.size; i++) {
+		auto &task = lane.tasks[(lane.head + i) % lane.capacity];
+		if (task.flowState == flowState) {
+			markTask(flowState, task.componentIndex, -1);
+		} else {
+			lane.tasks[(lane.head + j++) % lane.capacity] = task;
 		}
+	}
 
-        it = (it + 1) % QUEUE_SIZE;
-        if (it == g_queueTail) {
-            break;
-        }
+	unsigned numRemoved = lane.size - j;
+
+	lane.size = j;
+	if (lane.size == 0) {
+		laneReleaseSpill(lane);
+		lane.head = 0;
 	}
 
-    return false;
+	return numRemoved;
+}
+
+void removeTasksFromQueue(FlowState *flowState) {
+	laneRemoveFlowState(g_continuousLane, flowState);
+
+	auto numRemoved = laneRemoveFlowState(g_oneShotLane, flowState);
+	for (unsigned i = 0; i < numRemoved; i++) {
+		--g_numNonContinuousTasksInQueue;
+		onRemoveFromQueue();
+	}
+}
+
+bool isInQueue(FlowState *flowState, unsigned componentIndex) {
+	return flowState->numQueuedComponentTasks[componentIndex] > 0;
+}
+
+bool isThereAnyTaskInQueueForFlowState(FlowState *flowState, bool includingWatchVariable) {
+	if (includingWatchVariable) {
+		return flowState->numQueuedTasks > 0;
+	}
+	return flowState->numQueuedTasks > flowState->numQueuedWatchVariableTasks;
 }
 
 } // namespace flow
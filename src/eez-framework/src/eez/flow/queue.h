@@ -25,13 +25,17 @@ namespace flow {
 
 void queueReset();
 size_t getQueueSize();
-extern unsigned g_numContinuousTaskInQueue;
+extern unsigned g_numNonContinuousTasksInQueue;
 bool addToQueue(FlowState *flowState, unsigned componentIndex,
     int sourceComponentIndex, int sourceOutputIndex, int targetInputIndex,
     bool continuousTask);
 bool peekNextTaskFromQueue(FlowState *&flowState, unsigned &componentIndex, bool &continuousTask);
 void removeNextTaskFromQueue();
 
+// Called before flow state is freed. Usually only continuous tasks (e.g. watch variable)
+// are still in the queue, but user widget flow state can be freed with one-shot tasks queued.
+void removeTasksFromQueue(FlowState *flowState);
+
 bool isInQueue(FlowState *flowState, unsigned componentIndex);
 
 bool isThereAnyTaskInQueueForFlowState(FlowState *flowState, bool includingWatchVariable);
@@ -57,11 +57,32 @@ extern gui::font::Font g_font;
 void drawStrInit();
 void drawGlyph(const uint8_t *src, uint32_t srcLineOffset, int x, int y, int width, int height);
 
+// List of changed rectangles, touching rectangles are merged and when list
+// is full new rectangle is merged with the one giving the smallest bounding box.
+static const int MAX_DAMAGE_RECTS = 16;
+
+struct DamageRegion {
+    bool full;
+    int numRects;
+    gui::Rect rects[MAX_DAMAGE_RECTS];
+
+    void reset() { full = false; numRects = 0; }
+    void setFull() { full = true; numRects = 0; }
+    bool isEmpty() const { return !full && numRects == 0; }
+    void add(int x, int y, int w, int h);
+    void add(const DamageRegion &region);
+    uint32_t getArea() const;
+};
+
+// region of g_syncedBuffer changed since the previous syncBuffer()
+extern DamageRegion g_syncDamage;
+
 static const int NUM_BUFFERS = 6;
 
 struct RenderBuffer {
     VideoBuffer bufferPointer;
     VideoBuffer previousBuffer;
+    int previousBufferIndex;
     int x;
     int y;
     int width;
@@ -71,14 +92,27 @@ struct RenderBuffer {
     int xOffset;
     int yOffset;
     gui::Rect *backdrop;
+
+    // changed region inside this buffer, in buffer coordinates
+    DamageRegion damage;
 };
 extern RenderBuffer g_renderBuffers[NUM_BUFFERS];
 
 void setBufferPointer(VideoBuffer buffer);
 
 extern bool g_dirty;
+extern bool g_damageTracking;
+extern int g_widgetRenderingDepth;
+void addUntrackedDamage();
+
 inline void clearDirty() { g_dirty = false; }
-inline void setDirty() { g_dirty = true; }
+inline void setDirty() {
+    g_dirty = true;
+    if (g_damageTracking && g_widgetRenderingDepth == 0) {
+        // drawn outside of widget render, we don't know where
+        addUntrackedDamage();
+    }
+}
 inline bool isDirty() { return g_dirty; }
 
 extern bool g_screenshotAllocated;
@@ -86,6 +120,7 @@ extern bool g_screenshotAllocated;
 #ifdef GUI_CALC_FPS
 static const size_t NUM_FPS_VALUES = 60;
 extern uint32_t g_fpsValues[NUM_FPS_VALUES];
+extern uint32_t g_syncedBytesValues[NUM_FPS_VALUES];
 void calcFPS();
 #endif
 
@@ -79,9 +79,23 @@ static const uint16_t *g_colors;
 
 bool g_dirty;
 
+// Damage tracking: widgets report rectangles they rendered into the current
+// aux. buffer, these are translated to screen coordinates at the end of buffer
+// rendering. If nothing else (overlay blending, shadows, mouse cursor, ...) is
+// involved, endRendering only composes and syncs the damaged rectangles.
+bool g_damageTracking;
+int g_widgetRenderingDepth;
+DamageRegion g_syncDamage;
+static DamageRegion g_frameDamage;
+static DamageRegion g_previousFrameDamage;
+static int g_currentBufferIndex = -1;
+static bool g_decorationsVisible;
+
 RenderBuffer g_renderBuffers[NUM_BUFFERS];
 static VideoBuffer g_mainBufferPointer;
 static int g_numBuffersToDraw;
+static RenderBuffer g_previousRenderBuffers[NUM_BUFFERS];
+static int g_previousNumBuffersToDraw;
 
 bool g_screenshotAllocated;
 
@@ -116,6 +130,8 @@ void init() {
     g_animationBuffer = g_animationBuffer1;
 
     g_syncedBuffer = g_renderBuffer1;
+    g_syncDamage.setFull();
+    g_previousFrameDamage.reset();
     syncBuffer();
 }
 
@@ -146,15 +162,24 @@ uint32_t g_fpsValues[NUM_FPS_VALUES];
 uint32_t g_fpsAvg;
 static uint32_t g_fpsTotal;
 static uint32_t g_lastTimeFPS;
+uint32_t g_syncedBytesValues[NUM_FPS_VALUES];
+uint32_t g_syncedBytesAvg;
+static uint32_t g_syncedBytesTotal;
 
 void calcFPS() {
     // calculate last FPS value
 	g_fpsTotal -= g_fpsValues[0];
+    g_syncedBytesTotal -= g_syncedBytesValues[0];
 
 	for (size_t i = 1; i < NUM_FPS_VALUES; i++) {
 		g_fpsValues[i - 1] = g_fpsValues[i];
+        g_syncedBytesValues[i - 1] = g_syncedBytesValues[i];
 	}
 
+    g_syncedBytesValues[NUM_FPS_VALUES - 1] = g_syncDamage.getArea() * sizeof(g_syncedBuffer[0]);
+    g_syncedBytesTotal += g_syncedBytesValues[NUM_FPS_VALUES - 1];
+    g_syncedBytesAvg = g_syncedBytesTotal / NUM_FPS_VALUES;
+
 	uint32_t time = millis();
 	auto diff = time - g_lastTimeFPS;
 
@@ -204,6 +229,15 @@ void drawFpsGraph(int x, int y, int w, int h, const Style *style) {
 
 		display::drawVLine(x, y, y2 - y);
 	}
+
+    // bytes sent to the display, relative to the full frame
+    static const uint32_t FRAME_BYTES = DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof(g_syncedBuffer[0]);
+    display::setColor16(COLOR_GREEN);
+	x = x1;
+	for (size_t i = 0; i < NUM_FPS_VALUES && x <= x2; i++, x++) {
+		int y = y2 - (int)((uint64_t)g_syncedBytesValues[i] * (y2 - y1) / FRAME_BYTES);
+		display::fillRect(x, y, x, y);
+	}
 }
 #endif
 
@@ -220,7 +254,11 @@ static void finishAnimation() {
         bitBlt(g_renderBuffer2, 0, 0, getDisplayWidth() - 1, getDisplayHeight() - 1);
     }
 
+    // both render buffers have the same content now
+    g_previousFrameDamage.reset();
+
     g_syncedBuffer = g_renderBuffer1;
+    g_syncDamage.setFull();
     syncBuffer();
 }
 
@@ -261,6 +299,7 @@ static void animateStep() {
         }
 
         g_syncedBuffer = g_animationBuffer;
+        g_syncDamage.setFull();
         syncBuffer();
     } else {
     	finishAnimation();
@@ -353,12 +392,20 @@ void beginRendering() {
 
     g_mainBufferPointer = getBufferPointer();
     g_numBuffersToDraw = 0;
+
+    g_frameDamage.reset();
+    g_currentBufferIndex = -1;
+    g_widgetRenderingDepth = 0;
+    g_damageTracking = true;
 }
 
 int beginBufferRendering() {
     int bufferIndex = g_numBuffersToDraw++;
 	g_renderBuffers[bufferIndex].previousBuffer = getBufferPointer();
+    g_renderBuffers[bufferIndex].previousBufferIndex = g_currentBufferIndex;
+    g_renderBuffers[bufferIndex].damage.reset();
     setBufferPointer(g_renderBuffers[bufferIndex].bufferPointer);
+    g_currentBufferIndex = bufferIndex;
     return bufferIndex;
 }
 
@@ -375,31 +422,175 @@ void endBufferRendering(int bufferIndex, int x, int y, int width, int height, bo
 	renderBuffer.yOffset = yOffset;
 	renderBuffer.backdrop = backdrop;
 
+    // move buffer damage to the screen coordinates
+    int x1 = x + xOffset;
+    int y1 = y + yOffset;
+    if (renderBuffer.damage.full) {
+        g_frameDamage.add(x1, y1, width, height);
+    } else {
+        for (int i = 0; i < renderBuffer.damage.numRects; i++) {
+            const Rect &rect = renderBuffer.damage.rects[i];
+            int rx1 = MAX(rect.x, x);
+            int ry1 = MAX(rect.y, y);
+            int rx2 = MIN(rect.x + rect.w, x + width);
+            int ry2 = MIN(rect.y + rect.h, y + height);
+            g_frameDamage.add(rx1 + xOffset, ry1 + yOffset, rx2 - rx1, ry2 - ry1);
+        }
+    }
+
     setBufferPointer(renderBuffer.previousBuffer);
+    g_currentBufferIndex = renderBuffer.previousBufferIndex;
+}
+
+void beginWidgetRendering() {
+    g_widgetRenderingDepth++;
+}
+
+void endWidgetRendering(int x, int y, int width, int height) {
+    g_widgetRenderingDepth--;
+
+    if (g_damageTracking) {
+        if (g_currentBufferIndex != -1) {
+            g_renderBuffers[g_currentBufferIndex].damage.add(x, y, width, height);
+        } else {
+            g_frameDamage.add(x, y, width, height);
+        }
+    }
+}
+
+void addUntrackedDamage() {
+    if (g_currentBufferIndex != -1) {
+        g_renderBuffers[g_currentBufferIndex].damage.setFull();
+    } else {
+        g_frameDamage.setFull();
+    }
+}
+
+static bool canComposeDamage() {
+    // rendering on top of the animation buffer
+    if (g_syncedBuffer != g_renderBuffer1 && g_syncedBuffer != g_renderBuffer2) {
+        return false;
+    }
+
+    if (g_numBuffersToDraw != g_previousNumBuffersToDraw) {
+        return false;
+    }
+
+    for (int bufferIndex = 0; bufferIndex < g_numBuffersToDraw; bufferIndex++) {
+        const RenderBuffer &renderBuffer = g_renderBuffers[bufferIndex];
+        const RenderBuffer &previousRenderBuffer = g_previousRenderBuffers[bufferIndex];
+
+        // only opaque buffers can be composed part by part
+        if (renderBuffer.opacity != 255 || renderBuffer.withShadow || renderBuffer.backdrop) {
+            return false;
+        }
+
+        if (
+            renderBuffer.bufferPointer != previousRenderBuffer.bufferPointer ||
+            renderBuffer.x != previousRenderBuffer.x ||
+            renderBuffer.y != previousRenderBuffer.y ||
+            renderBuffer.width != previousRenderBuffer.width ||
+            renderBuffer.height != previousRenderBuffer.height ||
+            renderBuffer.xOffset != previousRenderBuffer.xOffset ||
+            renderBuffer.yOffset != previousRenderBuffer.yOffset
+        ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void copyFromSyncedBuffer(const DamageRegion &region) {
+    if (g_syncedBuffer != g_renderBuffer1 && g_syncedBuffer != g_renderBuffer2) {
+        return;
+    }
+
+    if (region.full) {
+        bitBlt(g_syncedBuffer, 0, 0, getDisplayWidth() - 1, getDisplayHeight() - 1);
+    } else {
+        for (int i = 0; i < region.numRects; i++) {
+            const Rect &rect = region.rects[i];
+            bitBlt(g_syncedBuffer, rect.x, rect.y, rect.x + rect.w - 1, rect.y + rect.h - 1);
+        }
+    }
+}
+
+static void composeDamage(const Rect &rect) {
+    for (int bufferIndex = 0; bufferIndex < g_numBuffersToDraw; bufferIndex++) {
+        RenderBuffer &renderBuffer = g_renderBuffers[bufferIndex];
+
+        int x1 = renderBuffer.x + renderBuffer.xOffset;
+        int y1 = renderBuffer.y + renderBuffer.yOffset;
+
+        int rx1 = MAX(rect.x, x1);
+        int ry1 = MAX(rect.y, y1);
+        int rx2 = MIN(rect.x + rect.w, x1 + renderBuffer.width);
+        int ry2 = MIN(rect.y + rect.h, y1 + renderBuffer.height);
+
+        if (rx1 < rx2 && ry1 < ry2) {
+            bitBlt(renderBuffer.bufferPointer, nullptr, rx1 - renderBuffer.xOffset, ry1 - renderBuffer.yOffset, rx2 - rx1, ry2 - ry1, rx1, ry1, 255);
+        }
+    }
 }
 
 void endRendering() {
     setBufferPointer(g_mainBufferPointer);
+    g_damageTracking = false;
+
+    // keyboard focus frame and mouse cursor are drawn over the whole frame
+    bool composeAll = g_decorationsVisible;
 
 #if OPTION_KEYBOARD
     if (keyboard::isDisplayDirty()) {
     	setDirty();
+        composeAll = true;
     }
 #endif
 
 #if OPTION_MOUSE
     if (mouse::isDisplayDirty()) {
     	setDirty();
+        composeAll = true;
     }
 #endif
 
 #if defined(GUI_CALC_FPS) && defined(STYLE_ID_FPS_GRAPH)
+    const int fpsGraphW = 64;
+    const int fpsGraphH = 32;
+    const int fpsGraphX = getDisplayWidth() - fpsGraphW - 4;
+    const int fpsGraphY = 4;
     if (g_drawFpsGraphEnabled) {
 	    setDirty();
+        g_frameDamage.add(fpsGraphX, fpsGraphY, fpsGraphW, fpsGraphH);
+    }
+#endif
+
+    if (!composeAll) {
+        composeAll = g_frameDamage.full || !canComposeDamage();
+    }
+
+    g_previousNumBuffersToDraw = g_numBuffersToDraw;
+    for (int bufferIndex = 0; bufferIndex < g_numBuffersToDraw; bufferIndex++) {
+        g_previousRenderBuffers[bufferIndex] = g_renderBuffers[bufferIndex];
     }
+
+    if (isDirty() && !composeAll) {
+        // bring render buffer to the state of the synced buffer and compose only what was changed
+        copyFromSyncedBuffer(g_previousFrameDamage);
+
+        for (int i = 0; i < g_frameDamage.numRects; i++) {
+            composeDamage(g_frameDamage.rects[i]);
+        }
+
+#if defined(GUI_CALC_FPS) && defined(STYLE_ID_FPS_GRAPH)
+        if (g_drawFpsGraphEnabled) {
+            drawFpsGraph(fpsGraphX, fpsGraphY, fpsGraphW, fpsGraphH, getStyle(STYLE_ID_FPS_GRAPH));
+        }
 #endif
 
-    if (isDirty()) {
+        g_syncDamage = g_frameDamage;
+    } else if (isDirty()) {
         for (int bufferIndex = 0; bufferIndex < g_numBuffersToDraw; bufferIndex++) {
             RenderBuffer &renderBuffer = g_renderBuffers[bufferIndex];
 
@@ -428,10 +619,13 @@ void endRendering() {
 
 #if defined(GUI_CALC_FPS) && defined(STYLE_ID_FPS_GRAPH)
         if (g_drawFpsGraphEnabled) {
-            drawFpsGraph(getDisplayWidth() - 64 - 4, 4, 64, 32, getStyle(STYLE_ID_FPS_GRAPH));
+            drawFpsGraph(fpsGraphX, fpsGraphY, fpsGraphW, fpsGraphH, getStyle(STYLE_ID_FPS_GRAPH));
         }
 #endif
 
+        // find out if keyboard or mouse has drawn something
+        clearDirty();
+
 #if OPTION_KEYBOARD
         keyboard::updateDisplay();
 #endif
@@ -439,15 +633,129 @@ void endRendering() {
 #if OPTION_MOUSE
         mouse::updateDisplay();
 #endif
+
+        g_decorationsVisible = isDirty();
+        setDirty();
+
+        g_syncDamage.setFull();
+    } else {
+        // nothing changed, render buffer only needs what was changed in the previous frame
+        copyFromSyncedBuffer(g_previousFrameDamage);
+
+        g_syncDamage.reset();
+    }
+
+    if (g_syncedBuffer != g_renderBuffer1 && g_syncedBuffer != g_renderBuffer2) {
+        g_previousFrameDamage.setFull();
+    } else {
+        g_previousFrameDamage = g_syncDamage;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool rectsTouch(const Rect &a, int x, int y, int w, int h) {
+    return a.x <= x + w && x <= a.x + a.w && a.y <= y + h && y <= a.y + a.h;
+}
+
+void DamageRegion::add(int x, int y, int w, int h) {
+    if (full) {
+        return;
+    }
+
+    // clip to the display
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if (x + w > getDisplayWidth()) {
+        w = getDisplayWidth() - x;
+    }
+    if (y + h > getDisplayHeight()) {
+        h = getDisplayHeight() - y;
+    }
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    while (true) {
+        // merge with touching rectangle
+        int i;
+        for (i = 0; i < numRects; i++) {
+            if (rectsTouch(rects[i], x, y, w, h)) {
+                break;
+            }
+        }
+
+        if (i == numRects) {
+            if (numRects < MAX_DAMAGE_RECTS) {
+                break;
+            }
+
+            // list is full, merge with the rectangle which gives the smallest bounding box
+            uint32_t minArea = 0xFFFFFFFF;
+            for (int j = 0; j < numRects; j++) {
+                int bx1 = MIN(rects[j].x, x);
+                int by1 = MIN(rects[j].y, y);
+                int bx2 = MAX(rects[j].x + rects[j].w, x + w);
+                int by2 = MAX(rects[j].y + rects[j].h, y + h);
+                uint32_t area = (bx2 - bx1) * (by2 - by1);
+                if (area < minArea) {
+                    minArea = area;
+                    i = j;
+                }
+            }
+        }
+
+        int x2 = MAX(rects[i].x + rects[i].w, x + w);
+        int y2 = MAX(rects[i].y + rects[i].h, y + h);
+        x = MIN(rects[i].x, x);
+        y = MIN(rects[i].y, y);
+        w = x2 - x;
+        h = y2 - y;
+
+        rects[i] = rects[--numRects];
+    }
+
+    // not worth to do it part by part
+    if ((uint32_t)w * h + getArea() > 3 * DISPLAY_WIDTH * DISPLAY_HEIGHT / 4) {
+        setFull();
+        return;
+    }
+
+    rects[numRects].x = x;
+    rects[numRects].y = y;
+    rects[numRects].w = w;
+    rects[numRects].h = h;
+    numRects++;
+}
+
+void DamageRegion::add(const DamageRegion &region) {
+    if (region.full) {
+        setFull();
     } else {
-        if (g_syncedBuffer == g_renderBuffer1) {
-            bitBlt(g_renderBuffer1, 0, 0, getDisplayWidth() - 1, getDisplayHeight() - 1);
-        } else if (g_syncedBuffer == g_renderBuffer2) {
-            bitBlt(g_renderBuffer2, 0, 0, getDisplayWidth() - 1, getDisplayHeight() - 1);
+        for (int i = 0; i < region.numRects; i++) {
+            add(region.rects[i].x, region.rects[i].y, region.rects[i].w, region.rects[i].h);
         }
     }
 }
 
+uint32_t DamageRegion::getArea() const {
+    if (full) {
+        return DISPLAY_WIDTH * DISPLAY_HEIGHT;
+    }
+
+    uint32_t area = 0;
+    for (int i = 0; i < numRects; i++) {
+        area += rects[i].w * rects[i].h;
+    }
+    return area;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 uint32_t color16to32(uint16_t color, uint8_t opacity) {
@@ -75,6 +75,8 @@ void animate(Buffer startBuffer, void (*callback)(float t, VideoBuffer bufferOld
 void beginRendering();
 int beginBufferRendering();
 void endBufferRendering(int bufferIndex, int x, int y, int width, int height, bool withShadow, uint8_t opacity, int xOffset, int yOffset, gui::Rect *backdrop);
+void beginWidgetRendering();
+void endWidgetRendering(int x, int y, int width, int height);
 void endRendering();
 
 VideoBuffer getBufferPointer();
@@ -88,6 +90,8 @@ extern bool g_calcFpsEnabled;
 extern bool g_drawFpsGraphEnabled;
 #endif
 extern uint32_t g_fpsAvg;
+// average number of bytes per frame sent to the display
+extern uint32_t g_syncedBytesAvg;
 void drawFpsGraph(int x, int y, int w, int h, const Style *style);
 #endif
 
@@ -0,0 +1,416 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <eez/conf-internal.h>
+
+#if EEZ_OPTION_GUI
+
+#include <string.h>
+
+#include <eez/gui/gui.h>
+#include <eez/gui/pixel_ops.h>
+
+#if EEZ_PIXEL_OPS_SSE2
+#include <emmintrin.h>
+#elif EEZ_PIXEL_OPS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace eez {
+namespace gui {
+namespace display {
+
+static const uint32_t ALPHA_MASK = 0xFF000000;
+
+////////////////////////////////////////////////////////////////////////////////
+// scalar
+
+// x / 255, exact for 0 <= x <= 255 * 255
+static inline uint32_t div255(uint32_t x) {
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+// Same as blendColor((fg & 0xFFFFFF) | (alpha << 24), bg), but with integer arithmetic
+// when bg is opaque. For opaque bg blendColor reduces to (fg * a + bg * (255 - a)) / 255
+// per channel and result alpha is 255.
+static inline uint32_t blendPixel(uint32_t fg, uint32_t alpha, uint32_t bg) {
+    if (alpha == 0) {
+        return bg;
+    }
+
+    if ((bg & ALPHA_MASK) != ALPHA_MASK) {
+        return blendColor((fg & ~ALPHA_MASK) | (alpha << 24), bg);
+    }
+
+    uint32_t invAlpha = 255 - alpha;
+
+    // red and blue channels are processed together
+    uint32_t rb = (fg & 0x00FF00FF) * alpha + (bg & 0x00FF00FF) * invAlpha;
+    rb = ((rb + 0x00010001 + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+
+    uint32_t g = ((fg >> 8) & 0xFF) * alpha + ((bg >> 8) & 0xFF) * invAlpha;
+    g = div255(g);
+
+    return rb | (g << 8) | ALPHA_MASK;
+}
+
+static inline void fillRow(uint32_t *dst, int width, uint32_t color) {
+    for (uint32_t *dstEnd = dst + width; dst != dstEnd; dst++) {
+        *dst = color;
+    }
+}
+
+static inline void fillBlendRow(uint32_t *dst, int width, uint32_t color, uint32_t alpha) {
+    for (uint32_t *dstEnd = dst + width; dst != dstEnd; dst++) {
+        *dst = blendPixel(color, alpha, *dst);
+    }
+}
+
+static inline void copyBlendRow(uint32_t *dst, const uint32_t *src, int width, uint32_t alpha) {
+    for (uint32_t *dstEnd = dst + width; dst != dstEnd; dst++, src++) {
+        *dst = blendPixel(*src, alpha, *dst);
+    }
+}
+
+static inline void bitmapBlendRow(uint32_t *dst, const uint32_t *src, int width, uint32_t opacity) {
+    for (uint32_t *dstEnd = dst + width; dst != dstEnd; dst++, src++) {
+        *dst = blendPixel(*src, (*src >> 24) * opacity / 255, *dst);
+    }
+}
+
+static inline void maskBlendRow(uint32_t *dst, const uint8_t *mask, int width, uint32_t color, uint32_t opacity) {
+    for (uint32_t *dstEnd = dst + width; dst != dstEnd; dst++, mask++) {
+        *dst = blendPixel(color, *mask * opacity / 255, *dst);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SSE2, 4 pixels at once
+
+#if EEZ_PIXEL_OPS_SSE2
+
+static inline __m128i div255(__m128i x) {
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+static inline bool isOpaque(__m128i bg) {
+    __m128i bgAlpha = _mm_or_si128(bg, _mm_set1_epi32(0x00FFFFFF));
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(bgAlpha, _mm_set1_epi32(-1))) == 0xFFFF;
+}
+
+// alphaLo and alphaHi are alpha values for pixels 0-1 and 2-3 in 16-bit lanes
+static inline __m128i blend(__m128i fg, __m128i bg, __m128i alphaLo, __m128i alphaHi) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi16(255);
+
+    __m128i lo = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpacklo_epi8(fg, zero), alphaLo),
+        _mm_mullo_epi16(_mm_unpacklo_epi8(bg, zero), _mm_sub_epi16(c255, alphaLo))
+    );
+
+    __m128i hi = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpackhi_epi8(fg, zero), alphaHi),
+        _mm_mullo_epi16(_mm_unpackhi_epi8(bg, zero), _mm_sub_epi16(c255, alphaHi))
+    );
+
+    return _mm_or_si128(_mm_packus_epi16(div255(lo), div255(hi)), _mm_set1_epi32((int)ALPHA_MASK));
+}
+
+// 4 alpha values in the lowest 16-bit lanes to per channel alpha for pixels 0-1 and 2-3
+static inline void spreadAlpha(__m128i alpha, __m128i &alphaLo, __m128i &alphaHi) {
+    alpha = _mm_unpacklo_epi16(alpha, alpha);
+    alphaLo = _mm_unpacklo_epi32(alpha, alpha);
+    alphaHi = _mm_unpackhi_epi32(alpha, alpha);
+}
+
+static void fillBlendRowSimd(uint32_t *dst, int width, uint32_t color, uint32_t alpha) {
+    __m128i color4 = _mm_set1_epi32(color);
+    __m128i alpha16 = _mm_set1_epi16((short)alpha);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        __m128i bg = _mm_loadu_si128((__m128i *)(dst + i));
+        if (isOpaque(bg)) {
+            _mm_storeu_si128((__m128i *)(dst + i), blend(color4, bg, alpha16, alpha16));
+        } else {
+            fillBlendRow(dst + i, 4, color, alpha);
+        }
+    }
+    fillBlendRow(dst + i, width - i, color, alpha);
+}
+
+static void copyBlendRowSimd(uint32_t *dst, const uint32_t *src, int width, uint32_t alpha) {
+    __m128i alpha16 = _mm_set1_epi16((short)alpha);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        __m128i bg = _mm_loadu_si128((__m128i *)(dst + i));
+        if (isOpaque(bg)) {
+            __m128i fg = _mm_loadu_si128((const __m128i *)(src + i));
+            _mm_storeu_si128((__m128i *)(dst + i), blend(fg, bg, alpha16, alpha16));
+        } else {
+            copyBlendRow(dst + i, src + i, 4, alpha);
+        }
+    }
+    copyBlendRow(dst + i, src + i, width - i, alpha);
+}
+
+static void bitmapBlendRowSimd(uint32_t *dst, const uint32_t *src, int width, uint32_t opacity) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i opacity16 = _mm_set1_epi16((short)opacity);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        __m128i fg = _mm_loadu_si128((const __m128i *)(src + i));
+
+        // source alpha to the lowest 16-bit lanes
+        __m128i alpha = _mm_srli_epi32(fg, 24);
+        alpha = _mm_packs_epi32(alpha, zero);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(alpha, zero)) == 0xFFFF) {
+            continue;
+        }
+
+        __m128i bg = _mm_loadu_si128((__m128i *)(dst + i));
+        if (isOpaque(bg)) {
+            if (opacity != 255) {
+                alpha = div255(_mm_mullo_epi16(alpha, opacity16));
+            }
+            __m128i alphaLo, alphaHi;
+            spreadAlpha(alpha, alphaLo, alphaHi);
+            _mm_storeu_si128((__m128i *)(dst + i), blend(fg, bg, alphaLo, alphaHi));
+        } else {
+            bitmapBlendRow(dst + i, src + i, 4, opacity);
+        }
+    }
+    bitmapBlendRow(dst + i, src + i, width - i, opacity);
+}
+
+static void maskBlendRowSimd(uint32_t *dst, const uint8_t *mask, int width, uint32_t color, uint32_t opacity) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i color4 = _mm_set1_epi32(color);
+    __m128i opacity16 = _mm_set1_epi16((short)opacity);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        int32_t mask4;
+        memcpy(&mask4, mask + i, 4);
+        if (mask4 == 0) {
+            continue;
+        }
+
+        __m128i bg = _mm_loadu_si128((__m128i *)(dst + i));
+        if (isOpaque(bg)) {
+            __m128i alpha = _mm_unpacklo_epi8(_mm_cvtsi32_si128(mask4), zero);
+            if (opacity != 255) {
+                alpha = div255(_mm_mullo_epi16(alpha, opacity16));
+            }
+            __m128i alphaLo, alphaHi;
+            spreadAlpha(alpha, alphaLo, alphaHi);
+            _mm_storeu_si128((__m128i *)(dst + i), blend(color4, bg, alphaLo, alphaHi));
+        } else {
+            maskBlendRow(dst + i, mask + i, 4, color, opacity);
+        }
+    }
+    maskBlendRow(dst + i, mask + i, width - i, color, opacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// NEON, 4 pixels at once
+
+#elif EEZ_PIXEL_OPS_NEON
+
+static inline uint8x8_t div255(uint16x8_t x) {
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+
+static inline bool isOpaque(uint8x16_t bg) {
+    uint32x4_t opaque = vcgeq_u32(vreinterpretq_u32_u8(bg), vdupq_n_u32(ALPHA_MASK));
+    uint32x2_t opaque2 = vand_u32(vget_low_u32(opaque), vget_high_u32(opaque));
+    return (vget_lane_u32(opaque2, 0) & vget_lane_u32(opaque2, 1)) == 0xFFFFFFFF;
+}
+
+// alphaLo and alphaHi are alpha values for pixels 0-1 and 2-3 in 8-bit lanes
+static inline uint8x16_t blend(uint8x16_t fg, uint8x16_t bg, uint8x8_t alphaLo, uint8x8_t alphaHi) {
+    const uint8x8_t c255 = vdup_n_u8(255);
+
+    uint16x8_t lo = vmull_u8(vget_low_u8(fg), alphaLo);
+    lo = vmlal_u8(lo, vget_low_u8(bg), vsub_u8(c255, alphaLo));
+
+    uint16x8_t hi = vmull_u8(vget_high_u8(fg), alphaHi);
+    hi = vmlal_u8(hi, vget_high_u8(bg), vsub_u8(c255, alphaHi));
+
+    uint8x16_t result = vcombine_u8(div255(lo), div255(hi));
+    return vreinterpretq_u8_u32(vorrq_u32(vreinterpretq_u32_u8(result), vdupq_n_u32(ALPHA_MASK)));
+}
+
+static void fillBlendRowSimd(uint32_t *dst, int width, uint32_t color, uint32_t alpha) {
+    uint8x16_t color4 = vreinterpretq_u8_u32(vdupq_n_u32(color));
+    uint8x8_t alpha8 = vdup_n_u8((uint8_t)alpha);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        uint8x16_t bg = vreinterpretq_u8_u32(vld1q_u32(dst + i));
+        if (isOpaque(bg)) {
+            vst1q_u32(dst + i, vreinterpretq_u32_u8(blend(color4, bg, alpha8, alpha8)));
+        } else {
+            fillBlendRow(dst + i, 4, color, alpha);
+        }
+    }
+    fillBlendRow(dst + i, width - i, color, alpha);
+}
+
+static void copyBlendRowSimd(uint32_t *dst, const uint32_t *src, int width, uint32_t alpha) {
+    uint8x8_t alpha8 = vdup_n_u8((uint8_t)alpha);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        uint8x16_t bg = vreinterpretq_u8_u32(vld1q_u32(dst + i));
+        if (isOpaque(bg)) {
+            uint8x16_t fg = vreinterpretq_u8_u32(vld1q_u32(src + i));
+            vst1q_u32(dst + i, vreinterpretq_u32_u8(blend(fg, bg, alpha8, alpha8)));
+        } else {
+            copyBlendRow(dst + i, src + i, 4, alpha);
+        }
+    }
+    copyBlendRow(dst + i, src + i, width - i, alpha);
+}
+
+static void bitmapBlendRowSimd(uint32_t *dst, const uint32_t *src, int width, uint32_t opacity) {
+    static const uint8_t ALPHA_INDEXES[8] = { 3, 3, 3, 3, 7, 7, 7, 7 };
+    const uint8x8_t alphaIndexes = vld1_u8(ALPHA_INDEXES);
+    const uint8x8_t opacity8 = vdup_n_u8((uint8_t)opacity);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        uint32x4_t fg32 = vld1q_u32(src + i);
+        uint32x2_t fgAlpha = vorr_u32(vget_low_u32(fg32), vget_high_u32(fg32));
+        if (((vget_lane_u32(fgAlpha, 0) | vget_lane_u32(fgAlpha, 1)) & ALPHA_MASK) == 0) {
+            continue;
+        }
+
+        uint8x16_t bg = vreinterpretq_u8_u32(vld1q_u32(dst + i));
+        if (isOpaque(bg)) {
+            uint8x16_t fg = vreinterpretq_u8_u32(fg32);
+            uint8x8_t alphaLo = vtbl1_u8(vget_low_u8(fg), alphaIndexes);
+            uint8x8_t alphaHi = vtbl1_u8(vget_high_u8(fg), alphaIndexes);
+            if (opacity != 255) {
+                alphaLo = div255(vmull_u8(alphaLo, opacity8));
+                alphaHi = div255(vmull_u8(alphaHi, opacity8));
+            }
+            vst1q_u32(dst + i, vreinterpretq_u32_u8(blend(fg, bg, alphaLo, alphaHi)));
+        } else {
+            bitmapBlendRow(dst + i, src + i, 4, opacity);
+        }
+    }
+    bitmapBlendRow(dst + i, src + i, width - i, opacity);
+}
+
+static void maskBlendRowSimd(uint32_t *dst, const uint8_t *mask, int width, uint32_t color, uint32_t opacity) {
+    static const uint8_t ALPHA_INDEXES_LO[8] = { 0, 0, 0, 0, 1, 1, 1, 1 };
+    static const uint8_t ALPHA_INDEXES_HI[8] = { 2, 2, 2, 2, 3, 3, 3, 3 };
+    const uint8x8_t alphaIndexesLo = vld1_u8(ALPHA_INDEXES_LO);
+    const uint8x8_t alphaIndexesHi = vld1_u8(ALPHA_INDEXES_HI);
+    const uint8x8_t opacity8 = vdup_n_u8((uint8_t)opacity);
+    uint8x16_t color4 = vreinterpretq_u8_u32(vdupq_n_u32(color));
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        uint32_t mask4;
+        memcpy(&mask4, mask + i, 4);
+        if (mask4 == 0) {
+            continue;
+        }
+
+        uint8x16_t bg = vreinterpretq_u8_u32(vld1q_u32(dst + i));
+        if (isOpaque(bg)) {
+            uint8x8_t alpha = vreinterpret_u8_u32(vdup_n_u32(mask4));
+            if (opacity != 255) {
+                alpha = div255(vmull_u8(alpha, opacity8));
+            }
+            uint8x8_t alphaLo = vtbl1_u8(alpha, alphaIndexesLo);
+            uint8x8_t alphaHi = vtbl1_u8(alpha, alphaIndexesHi);
+            vst1q_u32(dst + i, vreinterpretq_u32_u8(blend(color4, bg, alphaLo, alphaHi)));
+        } else {
+            maskBlendRow(dst + i, mask + i, 4, color, opacity);
+        }
+    }
+    maskBlendRow(dst + i, mask + i, width - i, color, opacity);
+}
+
+#else
+
+#define fillBlendRowSimd fillBlendRow
+#define copyBlendRowSimd copyBlendRow
+#define bitmapBlendRowSimd bitmapBlendRow
+#define maskBlendRowSimd maskBlendRow
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// same store loop as before pixel_ops, compiler vectorizes it in optimized builds
+void pixelsFill(uint32_t *dst, int dstStride, int width, int height, uint32_t color) {
+    for (int y = 0; y < height; y++, dst += dstStride) {
+        fillRow(dst, width, color);
+    }
+}
+
+void pixelsFillBlend(uint32_t *dst, int dstStride, int width, int height, uint32_t color) {
+    uint32_t alpha = color >> 24;
+    if (alpha == 0) {
+        return;
+    }
+    for (int y = 0; y < height; y++, dst += dstStride) {
+        fillBlendRowSimd(dst, width, color, alpha);
+    }
+}
+
+void pixelsCopy(uint32_t *dst, int dstStride, const uint32_t *src, int srcStride, int width, int height) {
+    if (width == dstStride && width == srcStride) {
+        memcpy(dst, src, width * height * sizeof(uint32_t));
+        return;
+    }
+    for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
+        memcpy(dst, src, width * sizeof(uint32_t));
+    }
+}
+
+void pixelsCopyBlend(uint32_t *dst, int dstStride, const uint32_t *src, int srcStride, int width, int height, uint8_t opacity) {
+    if (opacity == 0) {
+        return;
+    }
+    for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
+        copyBlendRowSimd(dst, src, width, opacity);
+    }
+}
+
+void pixelsBitmapBlend(uint32_t *dst, int dstStride, const uint32_t *src, int srcStride, int width, int height, uint8_t opacity) {
+    if (opacity == 0) {
+        return;
+    }
+    for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
+        bitmapBlendRowSimd(dst, src, width, opacity);
+    }
+}
+
+void pixelsMaskBlend(uint32_t *dst, int dstStride, const uint8_t *mask, int maskStride, int width, int height, uint32_t color, uint8_t opacity) {
+    if (opacity == 0) {
+        return;
+    }
+    for (int y = 0; y < height; y++, dst += dstStride, mask += maskStride) {
+        maskBlendRowSimd(dst, mask, width, color, opacity);
+    }
+}
+
+} // namespace display
+} // namespace gui
+} // namespace eez
+
+#endif // EEZ_OPTION_GUI
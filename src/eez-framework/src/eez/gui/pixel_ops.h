@@ -0,0 +1,60 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Pixel kernels for 32-bit (RGBA, R in the lowest byte) video buffers.
+//
+// Kernels are vectorized with SSE2 or NEON when the compiler targets it,
+// otherwise scalar code is used. Strides are in pixels. Blending gives the
+// same result as blendColor(), pixels with opaque destination are blended
+// with integer arithmetic, others go through blendColor().
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EEZ_PIXEL_OPS_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define EEZ_PIXEL_OPS_NEON 1
+#endif
+
+namespace eez {
+namespace gui {
+namespace display {
+
+// dst = color
+void pixelsFill(uint32_t *dst, int dstStride, int width, int height, uint32_t color);
+
+// dst = color over dst, color alpha is used as opacity
+void pixelsFillBlend(uint32_t *dst, int dstStride, int width, int height, uint32_t color);
+
+// dst = src
+void pixelsCopy(uint32_t *dst, int dstStride, const uint32_t *src, int srcStride, int width, int height);
+
+// dst = src over dst, src alpha is ignored and opacity is used instead
+void pixelsCopyBlend(uint32_t *dst, int dstStride, const uint32_t *src, int srcStride, int width, int height, uint8_t opacity);
+
+// dst = src over dst, src alpha is multiplied with opacity
+void pixelsBitmapBlend(uint32_t *dst, int dstStride, const uint32_t *src, int srcStride, int width, int height, uint8_t opacity);
+
+// dst = color over dst, alpha is mask value multiplied with opacity (used for glyphs)
+void pixelsMaskBlend(uint32_t *dst, int dstStride, const uint8_t *mask, int maskStride, int width, int height, uint32_t color, uint8_t opacity);
+
+} // namespace display
+} // namespace gui
+} // namespace eez
@@ -167,6 +167,7 @@ void WidgetCursor::popBackground() {
 ////////////////////////////////////////////////////////////////////////////////
 
 #define RENDER_WIDGET() \
+    display::beginWidgetRendering(); \
     if ((!widget->visible || widgetState->isVisible.toBool()) && widgetCursor.opacity > 0) { \
         auto savedOpacity = display::setOpacity(widgetCursor.opacity); \
         widgetState->render(); \
@@ -178,6 +179,7 @@ void WidgetCursor::popBackground() {
         int y2 = g_widgetCursor.y + g_widgetCursor.h - 1; \
         drawBorderAndBackground(x1, y1, x2, y2, nullptr, TRANSPARENT_COLOR_INDEX); \
     } \
+    display::endWidgetRendering(g_widgetCursor.x, g_widgetCursor.y, g_widgetCursor.w, g_widgetCursor.h);
 
 void enumWidget() {
     WidgetCursor &widgetCursor = g_widgetCursor;
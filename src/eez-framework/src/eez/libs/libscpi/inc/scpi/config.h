@@ -110,6 +110,14 @@ extern "C" {
 #define USE_COMMAND_TAGS 1
 #endif
 
+/**
+ * Number of hash buckets in the command index (see SCPI_InitCommandIndex),
+ * must be power of two
+ */
+#ifndef SCPI_COMMAND_INDEX_BUCKETS
+#define SCPI_COMMAND_INDEX_BUCKETS 128
+#endif
+
 #ifndef USE_DEPRECATED_FUNCTIONS
 #define USE_DEPRECATED_FUNCTIONS 1
 #endif
@@ -51,6 +51,8 @@ extern "C" {
             const char * idn1, const char * idn2, const char * idn3, const char * idn4,
             char * input_buffer, size_t input_buffer_length,
             scpi_error_t * error_queue_data, int16_t error_queue_size);
+    scpi_bool_t SCPI_InitCommandIndex(scpi_command_index_t * index, const scpi_command_t * commands, uint16_t * entries, size_t entries_length);
+    void SCPI_SetCommandIndex(scpi_t * context, const scpi_command_index_t * index);
 #if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
     void SCPI_InitHeap(scpi_t * context, char * error_info_heap, size_t error_info_heap_length);
 #endif
@@ -121,6 +121,14 @@ extern "C" {
 #endif
 
 
+    /* command index, commands bucketed by the first two header keywords */
+    struct _scpi_command_index_t {
+        const scpi_command_t * cmdlist;
+        uint16_t offsets[SCPI_COMMAND_INDEX_BUCKETS + 1];
+        const uint16_t * entries;
+    };
+    typedef struct _scpi_command_index_t scpi_command_index_t;
+
     /* scpi interface */
     typedef struct _scpi_t scpi_t;
     typedef struct _scpi_interface_t scpi_interface_t;
@@ -366,6 +374,7 @@ extern "C" {
 
     struct _scpi_t {
         const scpi_command_t * cmdlist;
+        const scpi_command_index_t * cmdindex;
         scpi_buffer_t buffer;
         scpi_param_list_t param_list;
         scpi_interface_t * interface;
@@ -172,6 +172,20 @@ static scpi_bool_t findCommandHeader(scpi_t * context, const char * header, int
     int32_t i;
     const scpi_command_t * cmd;
 
+    if (context->cmdindex) {
+        const scpi_command_index_t * index = context->cmdindex;
+        uint16_t bucket = commandIndexHeaderBucket(header, len);
+
+        for (i = index->offsets[bucket]; i < index->offsets[bucket + 1]; i++) {
+            cmd = &context->cmdlist[index->entries[i]];
+            if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
+                context->param_list.cmd = cmd;
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
     for (i = 0; context->cmdlist[i].pattern != NULL; i++) {
         cmd = &context->cmdlist[i];
         if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
@@ -284,6 +298,91 @@ void SCPI_Init(scpi_t * context,
     SCPI_ErrorInit(context, error_queue_data, error_queue_size);
 }
 
+/**
+ * Initialize command index. Index can be shared between contexts using the
+ * same command list.
+ * @param index
+ * @param commands - command list
+ * @param entries - storage for the index entries
+ * @param entries_length - number of elements in entries
+ * @return FALSE if entries storage is too small
+ */
+scpi_bool_t SCPI_InitCommandIndex(scpi_command_index_t * index,
+        const scpi_command_t * commands,
+        uint16_t * entries, size_t entries_length) {
+    uint16_t buckets[SCPI_COMMAND_INDEX_BUCKETS];
+    int num_buckets;
+    int32_t num_commands;
+    int32_t i;
+    int j;
+    size_t total = 0;
+
+    memset(index, 0, sizeof (*index));
+
+    /* count entries per bucket */
+    for (num_commands = 0; commands[num_commands].pattern != NULL; num_commands++) {
+        num_buckets = commandIndexPatternBuckets(commands[num_commands].pattern, buckets, SCPI_COMMAND_INDEX_BUCKETS);
+        if (num_buckets < 0) {
+            for (j = 0; j < SCPI_COMMAND_INDEX_BUCKETS; j++) {
+                index->offsets[j + 1]++;
+            }
+            total += SCPI_COMMAND_INDEX_BUCKETS;
+        } else {
+            for (j = 0; j < num_buckets; j++) {
+                index->offsets[buckets[j] + 1]++;
+            }
+            total += num_buckets;
+        }
+    }
+
+    if (total > entries_length || total > UINT16_MAX || num_commands > UINT16_MAX) {
+        return FALSE;
+    }
+
+    /* offsets[bucket + 1] is set to the end of the bucket ... */
+    for (j = 1; j <= SCPI_COMMAND_INDEX_BUCKETS; j++) {
+        index->offsets[j] += index->offsets[j - 1];
+    }
+
+    /* ... and moved back to the start of the bucket while filling it in reverse command order */
+    for (i = num_commands - 1; i >= 0; i--) {
+        num_buckets = commandIndexPatternBuckets(commands[i].pattern, buckets, SCPI_COMMAND_INDEX_BUCKETS);
+        if (num_buckets < 0) {
+            for (j = 0; j < SCPI_COMMAND_INDEX_BUCKETS; j++) {
+                entries[--index->offsets[j + 1]] = (uint16_t) i;
+            }
+        } else {
+            for (j = 0; j < num_buckets; j++) {
+                entries[--index->offsets[buckets[j] + 1]] = (uint16_t) i;
+            }
+        }
+    }
+
+    /* every bucket now starts at offsets[bucket + 1], shift to get [start, end) pairs */
+    for (j = 0; j < SCPI_COMMAND_INDEX_BUCKETS; j++) {
+        index->offsets[j] = index->offsets[j + 1];
+    }
+    index->offsets[SCPI_COMMAND_INDEX_BUCKETS] = (uint16_t) total;
+
+    index->cmdlist = commands;
+    index->entries = entries;
+
+    return TRUE;
+}
+
+/**
+ * Use command index for the header lookup
+ * @param context
+ * @param index - index initialized with SCPI_InitCommandIndex for the context's command list
+ */
+void SCPI_SetCommandIndex(scpi_t * context, const scpi_command_index_t * index) {
+    if (index && index->entries && index->cmdlist == context->cmdlist) {
+        context->cmdindex = index;
+    } else {
+        context->cmdindex = NULL;
+    }
+}
+
 #if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
 
 /**
@@ -715,6 +715,179 @@ scpi_bool_t composeCompoundCommand(const scpi_token_t * prev, scpi_token_t * cur
     return TRUE;
 }
 
+/*
+ * Command index key is made from the first two keywords of the header. Only
+ * the first COMMAND_INDEX_KEY_LEN characters of a keyword without numeric
+ * suffix are used, so the short and long form of the keyword usually give
+ * the same key.
+ */
+#define COMMAND_INDEX_KEY_LEN 3
+#define COMMAND_INDEX_MAX_NODES 16
+
+struct _command_index_node_t {
+    const char * ptr;
+    size_t len;
+    size_t short_len;
+    scpi_bool_t optional;
+};
+typedef struct _command_index_node_t command_index_node_t;
+
+static uint32_t commandIndexHashKeyword(uint32_t hash, const char * keyword, size_t len) {
+    size_t i;
+
+    while ((len > 0) && isdigit((unsigned char) keyword[len - 1])) {
+        len--;
+    }
+
+    if (len > COMMAND_INDEX_KEY_LEN) {
+        len = COMMAND_INDEX_KEY_LEN;
+    }
+
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t) toupper((unsigned char) keyword[i])) * 16777619u;
+    }
+
+    return (hash ^ ':') * 16777619u;
+}
+
+static uint16_t commandIndexBucket(const char * keyword1, size_t len1, const char * keyword2, size_t len2) {
+    uint32_t hash = 2166136261u;
+    hash = commandIndexHashKeyword(hash, keyword1, len1);
+    hash = commandIndexHashKeyword(hash, keyword2, len2);
+    return (uint16_t) (hash & (SCPI_COMMAND_INDEX_BUCKETS - 1));
+}
+
+/**
+ * Get command index bucket of the command header
+ * @param cmd - command header
+ * @param len - max search length
+ * @return bucket index
+ */
+uint16_t commandIndexHeaderBucket(const char * cmd, size_t len) {
+    size_t cmd_len = SCPIDEFINE_strnlen(cmd, len);
+    size_t sep_pos;
+
+    if ((cmd_len > 0) && (cmd[cmd_len - 1] == '?')) {
+        cmd_len--;
+    }
+
+    if ((cmd_len > 0) && (cmd[0] == ':')) {
+        cmd++;
+        cmd_len--;
+    }
+
+    sep_pos = cmdSeparatorPos(cmd, cmd_len);
+    if (sep_pos < cmd_len) {
+        return commandIndexBucket(cmd, sep_pos, cmd + sep_pos + 1, cmdSeparatorPos(cmd + sep_pos + 1, cmd_len - sep_pos - 1));
+    }
+
+    return commandIndexBucket(cmd, sep_pos, cmd + sep_pos, 0);
+}
+
+static int commandIndexAddBucket(uint16_t * buckets, int count, int buckets_len, const command_index_node_t * node1, const command_index_node_t * node2) {
+    int i, j, k, n;
+    uint16_t bucket;
+
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < (node2 ? 2 : 1); j++) {
+            bucket = commandIndexBucket(node1->ptr, i ? node1->short_len : node1->len,
+                    node2 ? node2->ptr : "", node2 ? (j ? node2->short_len : node2->len) : 0);
+
+            n = count;
+            for (k = 0; k < n; k++) {
+                if (buckets[k] == bucket) {
+                    break;
+                }
+            }
+
+            if (k == n) {
+                if (count == buckets_len) {
+                    return -1;
+                }
+                buckets[count++] = bucket;
+            }
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Get all command index buckets the header matching the pattern can fall into
+ * @param pattern eg. [SOURce#]:VOLTage[:LEVel][:IMMediate][:AMPLitude]
+ * @param buckets - output array
+ * @param buckets_len - size of output array
+ * @return number of buckets or -1 if pattern must be checked for every header
+ */
+int commandIndexPatternBuckets(const char * pattern, uint16_t * buckets, int buckets_len) {
+    command_index_node_t nodes[COMMAND_INDEX_MAX_NODES];
+    int num_nodes = 0;
+    int depth = 0;
+    int count = 0;
+    int i, j;
+    const char * end = pattern + strlen(pattern);
+    const char * start;
+
+    if ((end > pattern) && (end[-1] == '?')) {
+        end--;
+    }
+
+    while (pattern < end) {
+        if (*pattern == '[') {
+            depth++;
+            pattern++;
+        } else if (*pattern == ']') {
+            depth--;
+            pattern++;
+        } else if (*pattern == ':') {
+            pattern++;
+        } else {
+            if (num_nodes == COMMAND_INDEX_MAX_NODES) {
+                return -1;
+            }
+
+            start = pattern;
+            while ((pattern < end) && (*pattern != '[') && (*pattern != ']') && (*pattern != ':') && (*pattern != '#')) {
+                pattern++;
+            }
+
+            nodes[num_nodes].ptr = start;
+            nodes[num_nodes].len = pattern - start;
+            nodes[num_nodes].short_len = patternSeparatorShortPos(start, pattern - start);
+            nodes[num_nodes].optional = depth > 0;
+            num_nodes++;
+
+            if ((pattern < end) && (*pattern == '#')) {
+                pattern++;
+            }
+        }
+    }
+
+    if (num_nodes == 0) {
+        return -1;
+    }
+
+    /* optional keywords can be skipped, so the first two keywords of the header can be any of them */
+    for (i = 0; i < num_nodes; i++) {
+        for (j = i + 1; j <= num_nodes; j++) {
+            count = commandIndexAddBucket(buckets, count, buckets_len, &nodes[i], j < num_nodes ? &nodes[j] : NULL);
+            if (count < 0) {
+                return -1;
+            }
+
+            if ((j < num_nodes) && !nodes[j].optional) {
+                break;
+            }
+        }
+
+        if (!nodes[i].optional) {
+            break;
+        }
+    }
+
+    return count;
+}
+
 
 
 #if !HAVE_STRNLEN
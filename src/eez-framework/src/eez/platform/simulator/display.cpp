@@ -46,6 +46,7 @@
 #endif
 
 #include <eez/gui/display-private.h>
+#include <eez/gui/pixel_ops.h>
 
 namespace eez {
 namespace gui {
@@ -56,6 +57,7 @@ namespace display {
 #if !defined(__EMSCRIPTEN__)
 static SDL_Window *g_mainWindow;
 static SDL_Renderer *g_renderer;
+static SDL_Texture *g_texture;
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -99,6 +101,15 @@ void initDriver() {
 
     SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_BLEND);
 
+    // Texture is kept between frames so only damaged rectangles are uploaded
+    g_texture = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    if (g_texture == NULL) {
+		g_mainWindow = NULL;
+        printf("Texture could not be created! SDL Error: %s\n", SDL_GetError());
+        return;
+    }
+    SDL_SetTextureBlendMode(g_texture, SDL_BLENDMODE_BLEND);
+
     // Initialize PNG loading
     int imgFlags = IMG_INIT_PNG;
     if ((IMG_Init(imgFlags) & imgFlags) != imgFlags) {
@@ -133,24 +144,25 @@ void syncBuffer() {
 		return;
     }
 
-    SDL_Surface *rgbSurface = SDL_CreateRGBSurfaceFrom(
-        (uint32_t *)g_syncedBuffer, DISPLAY_WIDTH, DISPLAY_HEIGHT, 32, 4 * DISPLAY_WIDTH, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
-    if (rgbSurface != NULL) {
-        SDL_Texture *texture = SDL_CreateTextureFromSurface(g_renderer, rgbSurface);
-        if (texture != NULL) {
-            SDL_Rect srcRect = { 0, 0, (int)DISPLAY_WIDTH, (int)DISPLAY_HEIGHT };
-            SDL_Rect dstRect = { 0, 0, (int)DISPLAY_WIDTH, (int)DISPLAY_HEIGHT };
-
-            SDL_RenderCopyEx(g_renderer, texture, &srcRect, &dstRect, 0.0, NULL, SDL_FLIP_NONE);
-
-            SDL_DestroyTexture(texture);
-        } else {
-            printf("Unable to create texture from image buffer! SDL Error: %s\n", SDL_GetError());
+    if (g_syncDamage.full) {
+        if (SDL_UpdateTexture(g_texture, NULL, g_syncedBuffer, 4 * DISPLAY_WIDTH) != 0) {
+            printf("Unable to update texture! SDL Error: %s\n", SDL_GetError());
         }
-        SDL_FreeSurface(rgbSurface);
     } else {
-        printf("Unable to render text surface! SDL Error: %s\n", SDL_GetError());
+        for (int i = 0; i < g_syncDamage.numRects; i++) {
+            const Rect &rect = g_syncDamage.rects[i];
+            SDL_Rect textureRect = { rect.x, rect.y, rect.w, rect.h };
+            if (SDL_UpdateTexture(g_texture, &textureRect, g_syncedBuffer + rect.y * DISPLAY_WIDTH + rect.x, 4 * DISPLAY_WIDTH) != 0) {
+                printf("Unable to update texture! SDL Error: %s\n", SDL_GetError());
+                break;
+            }
+        }
     }
+
+    SDL_Rect srcRect = { 0, 0, (int)DISPLAY_WIDTH, (int)DISPLAY_HEIGHT };
+    SDL_Rect dstRect = { 0, 0, (int)DISPLAY_WIDTH, (int)DISPLAY_HEIGHT };
+    SDL_RenderCopyEx(g_renderer, g_texture, &srcRect, &dstRect, 0.0, NULL, SDL_FLIP_NONE);
+
     SDL_RenderPresent(g_renderer);
 
     sendMessageToGuiThread(GUI_QUEUE_MESSAGE_TYPE_DISPLAY_VSYNC, 0, 0);
@@ -208,19 +220,10 @@ void fillRect(int x1, int y1, int x2, int y2) {
 	uint32_t *dst = g_renderBuffer + y1 * DISPLAY_WIDTH + x1;
     int width = x2 - x1 + 1;
     int height = y2 - y1 + 1;
-    int nl = DISPLAY_WIDTH - width;
     if (g_opacity == 255) {
-        for (uint32_t *dstEnd = dst + height * DISPLAY_WIDTH; dst != dstEnd; dst += nl) {
-            for (uint32_t *lineEnd = dst + width; dst != lineEnd; dst++) {
-                *dst = color32;
-            }
-        }
+        pixelsFill(dst, DISPLAY_WIDTH, width, height, color32);
     } else {
-        for (uint32_t *dstEnd = dst + height * DISPLAY_WIDTH; dst != dstEnd; dst += nl) {
-            for (uint32_t *lineEnd = dst + width; dst != lineEnd; dst++) {
-                *dst = blendColor(color32, *dst);
-            }
-        }
+        pixelsFillBlend(dst, DISPLAY_WIDTH, width, height, color32);
     }
 
     setDirty();
@@ -229,13 +232,7 @@ void fillRect(int x1, int y1, int x2, int y2) {
 void fillRect(void *dstBuffer, int x1, int y1, int x2, int y2) {
     uint32_t color32 = color16to32(g_fc);
     uint32_t *dst = (uint32_t *)dstBuffer + y1 * DISPLAY_WIDTH + x1;
-    int nl = DISPLAY_WIDTH - (x2 - x1 + 1);
-    for (int y = y1; y <= y2; y++) {
-        for (int x = x1; x <= x2; x++) {
-            *dst++ = color32;
-        }
-        dst += nl;
-    }
+    pixelsFill(dst, DISPLAY_WIDTH, x2 - x1 + 1, y2 - y1 + 1, color32);
 
     setDirty();
 }
@@ -263,12 +260,8 @@ void bitBlt(void *src, int x1, int y1, int x2, int y2) {
 }
 
 void bitBlt(void *src, void *dst, int x1, int y1, int x2, int y2) {
-    for (int y = y1; y <= y2; ++y) {
-        for (int x = x1; x <= x2; ++x) {
-            int i = y * DISPLAY_WIDTH + x;
-            ((uint32_t *)dst)[i] = ((uint32_t *)src)[i];
-        }
-    }
+    int offset = y1 * DISPLAY_WIDTH + x1;
+    pixelsCopy((uint32_t *)dst + offset, DISPLAY_WIDTH, (uint32_t *)src + offset, DISPLAY_WIDTH, x2 - x1 + 1, y2 - y1 + 1);
 
     setDirty();
 }
@@ -278,23 +271,13 @@ void bitBlt(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy
         dst = g_renderBuffer;
     }
 
+    uint32_t *srcPixels = (uint32_t *)src + sy * DISPLAY_WIDTH + sx;
+    uint32_t *dstPixels = (uint32_t *)dst + dy * DISPLAY_WIDTH + dx;
+
     if (opacity == 255) {
-        for (int y = 0; y < sh; ++y) {
-            for (int x = 0; x < sw; ++x) {
-                ((uint32_t *)dst)[(dy + y) * DISPLAY_WIDTH + dx + x] = ((uint32_t *)src)[(sy + y) * DISPLAY_WIDTH + sx + x];
-            }
-        }
+        pixelsCopy(dstPixels, DISPLAY_WIDTH, srcPixels, DISPLAY_WIDTH, sw, sh);
     } else {
-        for (int y = 0; y < sh; ++y) {
-            for (int x = 0; x < sw; ++x) {
-                uint8_t *p = (uint8_t *)&((uint32_t *)src)[(sy + y) * DISPLAY_WIDTH + sx + x];
-                p[3] = opacity;
-                ((uint32_t *)dst)[(dy + y) * DISPLAY_WIDTH + dx + x] = blendColor(
-                    ((uint32_t *)src)[(sy + y) * DISPLAY_WIDTH + sx + x],
-                    ((uint32_t *)dst)[(dy + y) * DISPLAY_WIDTH + dx + x]
-                );
-            }
-        }
+        pixelsCopyBlend(dstPixels, DISPLAY_WIDTH, srcPixels, DISPLAY_WIDTH, sw, sh, opacity);
     }
 }
 
@@ -303,19 +286,7 @@ void drawBitmap(Image *image, int x, int y) {
     int nlDst = DISPLAY_WIDTH - image->width;
 
     if (image->bpp == 32) {
-        uint32_t *src = (uint32_t *)image->pixels;
-        int nlSrc = image->lineOffset;
-
-        uint32_t pixel;
-        uint8_t *pixelAlpha = ((uint8_t *)&pixel) + 3;
-
-        for (uint32_t *srcEnd = src + (image->width + nlSrc) * image->height; src != srcEnd; src += nlSrc, dst += nlDst) {
-            for (uint32_t *lineEnd = dst + image->width; dst != lineEnd; src++, dst++) {
-                pixel = *src;
-                *pixelAlpha = *pixelAlpha * g_opacity / 255;
-                *dst = blendColor(pixel, *dst);
-            }
-        }
+        pixelsBitmapBlend(dst, DISPLAY_WIDTH, (const uint32_t *)image->pixels, image->width + image->lineOffset, image->width, image->height, g_opacity);
     } else if (image->bpp == 24) {
         uint8_t *src = (uint8_t *)image->pixels;
         int nlSrc = 3 * image->lineOffset;
@@ -349,25 +320,8 @@ void drawGlyph(const uint8_t *src, uint32_t srcLineOffset, int x_glyph, int y_gl
     // glyph->pixels + offset + iStartByte, glyph->width - width, x_glyph, y_glyph, width,height
     // const gui::GlyphData &glyph, int x_glyph, int y_glyph, int width, int height, int offset, int iStartByte
 
-    uint32_t pixel;
-    ((uint8_t *)&pixel)[0] = COLOR_TO_R(g_fc);
-    ((uint8_t *)&pixel)[1] = COLOR_TO_G(g_fc);
-    ((uint8_t *)&pixel)[2] = COLOR_TO_B(g_fc);
-    uint8_t *pixelAlpha = ((uint8_t *)&pixel) + 3;
-
     uint32_t *dst = g_renderBuffer + y_glyph * DISPLAY_WIDTH + x_glyph;
-    int nlDst = DISPLAY_WIDTH - width;
-
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            *pixelAlpha = *src * g_opacity / 255;
-            *dst = blendColor(pixel, *dst);
-            src++;
-            dst++;
-        }
-        src += srcLineOffset;
-        dst += nlDst;
-    }
+    pixelsMaskBlend(dst, DISPLAY_WIDTH, src, width + srcLineOffset, width, height, color16to32(g_fc, 0), g_opacity);
 }
 
 } // namespace display
@@ -247,6 +247,8 @@ QDEF(MP_QSTR_pi, (const byte*)"\x1c\x02" "pi")
 QDEF(MP_QSTR_radians, (const byte*)"\x87\x07" "radians")
 QDEF(MP_QSTR_real, (const byte*)"\xbf\x04" "real")
 QDEF(MP_QSTR_scpi, (const byte*)"\xec\x04" "scpi")
+QDEF(MP_QSTR_scpiBatch, (const byte*)"\x70\x09" "scpiBatch")
+QDEF(MP_QSTR_scpiFloat, (const byte*)"\xdc\x09" "scpiFloat")
 QDEF(MP_QSTR_setI, (const byte*)"\x4e\x04" "setI")
 QDEF(MP_QSTR_setU, (const byte*)"\x52\x04" "setU")
 QDEF(MP_QSTR_sin, (const byte*)"\xb1\x03" "sin")
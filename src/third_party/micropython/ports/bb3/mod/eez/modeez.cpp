@@ -47,13 +47,7 @@ extern "C" {
 using namespace eez::scripting;
 using namespace eez::psu;
 
-mp_obj_t modeez_scpi(mp_obj_t commandOrQueryText) {
-    const char *resultText;
-    size_t resultTextLen;
-    if (!executeScpiFromMP(mp_obj_str_get_str(commandOrQueryText), &resultText, &resultTextLen)) {
-        return mp_const_false;
-    }
-
+static mp_obj_t scpiResultToObj(const char *resultText, size_t resultTextLen, bool realAsFloat) {
     if (resultTextLen == 0) {
         return mp_const_none;
     }
@@ -68,9 +62,78 @@ mp_obj_t modeez_scpi(mp_obj_t commandOrQueryText) {
         return mp_obj_new_int(num);
     }
 
+    if (realAsFloat) {
+        double value = strtod(resultText, &strEnd);
+        if (*strEnd == 0) {
+            return mp_obj_new_float((mp_float_t)value);
+        }
+    }
+
     return mp_obj_new_str(resultText, resultTextLen);
 }
 
+mp_obj_t modeez_scpi(mp_obj_t commandOrQueryText) {
+    const char *resultText;
+    size_t resultTextLen;
+    if (!executeScpiFromMP(mp_obj_str_get_str(commandOrQueryText), &resultText, &resultTextLen)) {
+        return mp_const_false;
+    }
+
+    return scpiResultToObj(resultText, resultTextLen, false);
+}
+
+mp_obj_t modeez_scpiBatch(mp_obj_t commandsOrQueriesObj) {
+    size_t numCommands;
+    mp_obj_t *commandsOrQueries;
+    mp_obj_get_array(commandsOrQueriesObj, &numCommands, &commandsOrQueries);
+
+    if (numCommands == 0) {
+        return mp_obj_new_list(0, NULL);
+    }
+
+    const char **commands = m_new(const char *, numCommands);
+    for (size_t i = 0; i < numCommands; i++) {
+        commands[i] = mp_obj_str_get_str(commandsOrQueries[i]);
+    }
+
+    ScpiBatchResult *results = m_new(ScpiBatchResult, numCommands);
+    mp_obj_t *items = m_new(mp_obj_t, numCommands);
+
+    for (size_t i = 0; i < numCommands; ) {
+        size_t numExecuted;
+        executeScpiBatchFromMP(commands + i, numCommands - i, results + i, &numExecuted);
+
+        // result texts are overwritten by the next batch
+        for (size_t j = i; j < i + numExecuted; j++) {
+            items[j] = scpiResultToObj(results[j].text, results[j].textLen, true);
+        }
+
+        i += numExecuted;
+    }
+
+    mp_obj_t list = mp_obj_new_list(numCommands, items);
+
+    m_del(mp_obj_t, items, numCommands);
+    m_del(ScpiBatchResult, results, numCommands);
+    m_del(const char *, commands, numCommands);
+
+    return list;
+}
+
+mp_obj_t modeez_scpiFloat(mp_obj_t queryText) {
+    const char *resultText;
+    size_t resultTextLen;
+    executeScpiFromMP(mp_obj_str_get_str(queryText), &resultText, &resultTextLen);
+
+    char *strEnd;
+    double value = strtod(resultText, &strEnd);
+    if (resultTextLen == 0 || *strEnd != 0) {
+        mp_raise_ValueError("Query result is not a number");
+    }
+
+    return mp_obj_new_float((mp_float_t)value);
+}
+
 mp_obj_t modeez_getU(mp_obj_t channelIndexObj) {
     int channelIndex = mp_obj_get_int(channelIndexObj) - 1;
     if (channelIndex < 0 || channelIndex >= CH_NUM) {
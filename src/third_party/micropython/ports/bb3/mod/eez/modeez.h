@@ -21,6 +21,8 @@
 #include <py/obj.h>
 
 mp_obj_t modeez_scpi(mp_obj_t commandOrQueryText);
+mp_obj_t modeez_scpiBatch(mp_obj_t commandsOrQueriesObj);
+mp_obj_t modeez_scpiFloat(mp_obj_t queryText);
 mp_obj_t modeez_getU(mp_obj_t channelIndexObj);
 mp_obj_t modeez_setU(mp_obj_t channelIndexObj, mp_obj_t value);
 mp_obj_t modeez_getI(mp_obj_t channelIndexObj);
@@ -19,6 +19,8 @@
 #include "modeez.h"
 
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(modeez_scpi_obj, modeez_scpi);
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(modeez_scpiBatch_obj, modeez_scpiBatch);
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(modeez_scpiFloat_obj, modeez_scpiFloat);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(modeez_getU_obj, modeez_getU);
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(modeez_setU_obj, modeez_setU);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(modeez_getI_obj, modeez_getI);
@@ -29,6 +31,8 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(modeez_dlogTraceData_obj, 1, 4, modee
 STATIC const mp_rom_map_elem_t modeez_module_globals_table[] = {
   { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_eez) },
   { MP_ROM_QSTR(MP_QSTR_scpi), (mp_obj_t)&modeez_scpi_obj },
+  { MP_ROM_QSTR(MP_QSTR_scpiBatch), (mp_obj_t)&modeez_scpiBatch_obj },
+  { MP_ROM_QSTR(MP_QSTR_scpiFloat), (mp_obj_t)&modeez_scpiFloat_obj },
   { MP_ROM_QSTR(MP_QSTR_getU), (mp_obj_t)&modeez_getU_obj },
   { MP_ROM_QSTR(MP_QSTR_setU), (mp_obj_t)&modeez_setU_obj },
   { MP_ROM_QSTR(MP_QSTR_getI), (mp_obj_t)&modeez_getI_obj },
@@ -129,7 +129,10 @@ void sntpSetSystemTimeUs(uint32_t t, uint32_t us);
 #define CHECKSUM_CHECK_ICMP6 0
 /*-----------------------------------------------------------------------------*/
 /* USER CODE BEGIN 1 */
-
+/* SCPI listen + up to 4 SCPI clients (MAX_SCPI_CLIENTS) + debugger listen and client */
+#define MEMP_NUM_NETCONN 8
+/* SCPI clients + debugger client + MQTT */
+#define MEMP_NUM_TCP_PCB 8
 /* USER CODE END 1 */
 
 #ifdef __cplusplus